@@ -0,0 +1,240 @@
+/*
+ * DMA.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <string.h>
+#include "DMA.h"
+#include "../../Middlewares/Console/Thread_Console.h"
+#include "../../Middlewares/Log/log.h"
+
+/* Channel index: DMA1 channel n is n - 1, DMA2 channel n is n + 6 */
+#define DMA1_CH(n)                      ((n) - 1)
+#define DMA2_CH(n)                      ((n) + 6)
+#define DMA_MAX_ROUTES                  2
+
+typedef struct {
+    DMA_Channel_TypeDef * Instance;
+    IRQn_Type IRQn;
+} tDMA_Channel_Info;
+
+typedef struct {
+    uint8_t Channel;
+    uint8_t Request;                    /* CSELR value, DMA_REQUEST_x */
+} tDMA_Route;
+
+typedef struct {
+    const char * Name;
+    uint32_t Direction;
+    uint32_t Alignment;                 /* peripheral and memory side */
+    uint8_t Route_Count;
+    tDMA_Route Routes[DMA_MAX_ROUTES];  /* tried in order */
+} tDMA_Request_Map;
+
+static const tDMA_Channel_Info dma_channels[DMA_CHANNEL_COUNT] = {
+    { DMA1_Channel1, DMA1_Channel1_IRQn }, { DMA1_Channel2, DMA1_Channel2_IRQn },
+    { DMA1_Channel3, DMA1_Channel3_IRQn }, { DMA1_Channel4, DMA1_Channel4_IRQn },
+    { DMA1_Channel5, DMA1_Channel5_IRQn }, { DMA1_Channel6, DMA1_Channel6_IRQn },
+    { DMA1_Channel7, DMA1_Channel7_IRQn },
+    { DMA2_Channel1, DMA2_Channel1_IRQn }, { DMA2_Channel2, DMA2_Channel2_IRQn },
+    { DMA2_Channel3, DMA2_Channel3_IRQn }, { DMA2_Channel4, DMA2_Channel4_IRQn },
+    { DMA2_Channel5, DMA2_Channel5_IRQn }, { DMA2_Channel6, DMA2_Channel6_IRQn },
+    { DMA2_Channel7, DMA2_Channel7_IRQn },
+};
+
+#define P2M(name, align, ...)   { name, DMA_PERIPH_TO_MEMORY, align, sizeof((tDMA_Route[]){ __VA_ARGS__ }) / sizeof(tDMA_Route), { __VA_ARGS__ } }
+#define M2P(name, align, ...)   { name, DMA_MEMORY_TO_PERIPH, align, sizeof((tDMA_Route[]){ __VA_ARGS__ }) / sizeof(tDMA_Route), { __VA_ARGS__ } }
+#define M2M(name, align, ...)   { name, DMA_MEMORY_TO_MEMORY, align, sizeof((tDMA_Route[]){ __VA_ARGS__ }) / sizeof(tDMA_Route), { __VA_ARGS__ } }
+
+/* RM0351 DMA1/DMA2 request mapping, for the peripherals this board uses */
+static const tDMA_Request_Map dma_requests[eDMA_Request_Count] = {
+    [eDMA_ADC1]      = P2M("ADC1", DMA_PDATAALIGN_HALFWORD, { DMA1_CH(1), DMA_REQUEST_0 }, { DMA2_CH(3), DMA_REQUEST_0 }),
+    [eDMA_SPI1_RX]   = P2M("SPI1_RX", DMA_PDATAALIGN_BYTE, { DMA1_CH(2), DMA_REQUEST_1 }, { DMA2_CH(3), DMA_REQUEST_4 }),
+    [eDMA_SPI1_TX]   = M2P("SPI1_TX", DMA_PDATAALIGN_BYTE, { DMA1_CH(3), DMA_REQUEST_1 }, { DMA2_CH(4), DMA_REQUEST_4 }),
+    [eDMA_SPI2_RX]   = P2M("SPI2_RX", DMA_PDATAALIGN_BYTE, { DMA1_CH(4), DMA_REQUEST_1 }),
+    [eDMA_SPI2_TX]   = M2P("SPI2_TX", DMA_PDATAALIGN_BYTE, { DMA1_CH(5), DMA_REQUEST_1 }),
+    [eDMA_SPI3_RX]   = P2M("SPI3_RX", DMA_PDATAALIGN_BYTE, { DMA2_CH(1), DMA_REQUEST_3 }),
+    [eDMA_SPI3_TX]   = M2P("SPI3_TX", DMA_PDATAALIGN_BYTE, { DMA2_CH(2), DMA_REQUEST_3 }),
+    [eDMA_USART1_RX] = P2M("USART1_RX", DMA_PDATAALIGN_BYTE, { DMA1_CH(5), DMA_REQUEST_2 }, { DMA2_CH(7), DMA_REQUEST_2 }),
+    [eDMA_USART1_TX] = M2P("USART1_TX", DMA_PDATAALIGN_BYTE, { DMA1_CH(4), DMA_REQUEST_2 }, { DMA2_CH(6), DMA_REQUEST_2 }),
+    [eDMA_USART2_RX] = P2M("USART2_RX", DMA_PDATAALIGN_BYTE, { DMA1_CH(6), DMA_REQUEST_2 }),
+    [eDMA_USART2_TX] = M2P("USART2_TX", DMA_PDATAALIGN_BYTE, { DMA1_CH(7), DMA_REQUEST_2 }),
+    [eDMA_I2C1_RX]   = P2M("I2C1_RX", DMA_PDATAALIGN_BYTE, { DMA1_CH(7), DMA_REQUEST_3 }, { DMA2_CH(6), DMA_REQUEST_5 }),
+    [eDMA_I2C1_TX]   = M2P("I2C1_TX", DMA_PDATAALIGN_BYTE, { DMA1_CH(6), DMA_REQUEST_3 }, { DMA2_CH(7), DMA_REQUEST_5 }),
+    [eDMA_I2C3_RX]   = P2M("I2C3_RX", DMA_PDATAALIGN_BYTE, { DMA1_CH(3), DMA_REQUEST_3 }),
+    [eDMA_I2C3_TX]   = M2P("I2C3_TX", DMA_PDATAALIGN_BYTE, { DMA1_CH(2), DMA_REQUEST_3 }),
+    /* any channel can copy memory; take ones no request above needs first */
+    [eDMA_MEM2MEM]   = M2M("MEM2MEM", DMA_PDATAALIGN_BYTE, { DMA2_CH(5), DMA_REQUEST_0 }, { DMA2_CH(4), DMA_REQUEST_0 }),
+};
+
+/* Handles for allocated channels; adopted channels point at their CubeMX handle instead */
+static DMA_HandleTypeDef dma_handles[DMA_CHANNEL_COUNT];
+static DMA_HandleTypeDef * volatile dma_owners[DMA_CHANNEL_COUNT];
+static const char * dma_owner_names[DMA_CHANNEL_COUNT];
+
+static int8_t DMA_Channel_Index(const DMA_Channel_TypeDef * Instance);
+static void DMA_Command(const char * args);
+
+CONSOLE_COMMAND("dma", "List DMA channels in use", NULL, .Args_Function = DMA_Command);
+
+/**
+ * @brief: Claims a free channel that maps Request, configures the handle (direction and alignment
+ * from the request table, memory increment on, peripheral increment off unless memory to memory),
+ * runs HAL_DMA_Init and enables the channel interrupt. Link the result to the peripheral handle with __HAL_LINKDMA.
+ *
+ * @params: Request, Mode DMA_NORMAL or DMA_CIRCULAR, Priority DMA_PRIORITY_xxx
+ *
+ * @return: the initialised handle, NULL if no channel is free or HAL_DMA_Init failed
+ */
+DMA_HandleTypeDef * DMA_Allocate(eDMA_Request Request, uint32_t Mode, uint32_t Priority)
+{
+    if (Request >= eDMA_Request_Count) {
+        return NULL;
+    }
+    const tDMA_Request_Map * map = &dma_requests[Request];
+
+    for (uint8_t r = 0; r < map->Route_Count; r++) {
+        uint8_t channel = map->Routes[r].Channel;
+        DMA_HandleTypeDef * handle = &dma_handles[channel];
+
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        bool claimed = (dma_owners[channel] == NULL);
+        if (claimed) {
+            dma_owners[channel] = handle;
+        }
+        __set_PRIMASK(primask);
+        if (!claimed) {
+            continue;
+        }
+
+        if (channel < DMA2_CH(1)) {
+            __HAL_RCC_DMA1_CLK_ENABLE();
+        } else {
+            __HAL_RCC_DMA2_CLK_ENABLE();
+        }
+        memset(handle, 0, sizeof(*handle));
+        handle->Instance = dma_channels[channel].Instance;
+        handle->Init.Request = map->Routes[r].Request;
+        handle->Init.Direction = map->Direction;
+        /* memory to memory reads the source through the peripheral port, which must increment too */
+        handle->Init.PeriphInc = (map->Direction == DMA_MEMORY_TO_MEMORY) ? DMA_PINC_ENABLE : DMA_PINC_DISABLE;
+        handle->Init.MemInc = DMA_MINC_ENABLE;
+        handle->Init.PeriphDataAlignment = map->Alignment;
+        /* the MDATAALIGN bits sit two above the PDATAALIGN bits */
+        handle->Init.MemDataAlignment = map->Alignment << 2;
+        handle->Init.Mode = Mode;
+        handle->Init.Priority = Priority;
+        if (HAL_DMA_Init(handle) != HAL_OK) {
+            LOG_ERROR(APP, "DMA: init failed on channel %u\r\n", channel);
+            dma_owners[channel] = NULL;
+            return NULL;
+        }
+        dma_owner_names[channel] = map->Name;
+        HAL_NVIC_SetPriority(dma_channels[channel].IRQn, DMA_IRQ_PRIORITY, 0);
+        HAL_NVIC_EnableIRQ(dma_channels[channel].IRQn);
+        return handle;
+    }
+    LOG_WARN(APP, "DMA: no free channel for request %u\r\n", Request);
+    return NULL;
+}
+
+/**
+ * @brief: Registers a handle configured elsewhere (CubeMX MSP init) as the owner of its channel so
+ * DMA_Allocate skips it.
+ *
+ * @params: Handle with Instance set
+ *
+ * @return: false if the channel is unknown or already owned
+ */
+bool DMA_Adopt(DMA_HandleTypeDef * Handle)
+{
+    int8_t channel = DMA_Channel_Index(Handle->Instance);
+    bool adopted = false;
+
+    if (channel < 0) {
+        return false;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (dma_owners[channel] == NULL) {
+        dma_owners[channel] = Handle;
+        dma_owner_names[channel] = "CubeMX";
+        adopted = true;
+    }
+    __set_PRIMASK(primask);
+    return adopted;
+}
+
+/* Stops and de-initialises the channel, then frees it. The interrupt stays off until reallocated. */
+void DMA_Release(DMA_HandleTypeDef * Handle)
+{
+    int8_t channel = DMA_Channel_Index(Handle->Instance);
+
+    if (channel < 0 || dma_owners[channel] != Handle) {
+        return;
+    }
+    HAL_NVIC_DisableIRQ(dma_channels[channel].IRQn);
+    HAL_DMA_Abort(Handle);
+    HAL_DMA_DeInit(Handle);
+    dma_owners[channel] = NULL;
+    dma_owner_names[channel] = NULL;
+}
+
+/* Channel interrupt: hand it to the owning handle, or clear it if the channel has no owner */
+void DMA_IRQ_Dispatch(uint8_t Channel)
+{
+    DMA_HandleTypeDef * owner = dma_owners[Channel];
+
+    if (owner != NULL) {
+        HAL_DMA_IRQHandler(owner);
+    } else if (Channel < DMA2_CH(1)) {
+        DMA1->IFCR = DMA_IFCR_CGIF1 << (Channel * 4U);
+    } else {
+        DMA2->IFCR = DMA_IFCR_CGIF1 << ((Channel - DMA2_CH(1)) * 4U);
+    }
+}
+
+static int8_t DMA_Channel_Index(const DMA_Channel_TypeDef * Instance)
+{
+    for (int8_t i = 0; i < DMA_CHANNEL_COUNT; i++) {
+        if (dma_channels[i].Instance == Instance) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Vector table entries for every channel except DMA1 channels 6/7, which CubeMX generates */
+void DMA1_Channel1_IRQHandler(void) { DMA_IRQ_Dispatch(DMA1_CH(1)); }
+void DMA1_Channel2_IRQHandler(void) { DMA_IRQ_Dispatch(DMA1_CH(2)); }
+void DMA1_Channel3_IRQHandler(void) { DMA_IRQ_Dispatch(DMA1_CH(3)); }
+void DMA1_Channel4_IRQHandler(void) { DMA_IRQ_Dispatch(DMA1_CH(4)); }
+void DMA1_Channel5_IRQHandler(void) { DMA_IRQ_Dispatch(DMA1_CH(5)); }
+void DMA2_Channel1_IRQHandler(void) { DMA_IRQ_Dispatch(DMA2_CH(1)); }
+void DMA2_Channel2_IRQHandler(void) { DMA_IRQ_Dispatch(DMA2_CH(2)); }
+void DMA2_Channel3_IRQHandler(void) { DMA_IRQ_Dispatch(DMA2_CH(3)); }
+void DMA2_Channel4_IRQHandler(void) { DMA_IRQ_Dispatch(DMA2_CH(4)); }
+void DMA2_Channel5_IRQHandler(void) { DMA_IRQ_Dispatch(DMA2_CH(5)); }
+void DMA2_Channel6_IRQHandler(void) { DMA_IRQ_Dispatch(DMA2_CH(6)); }
+void DMA2_Channel7_IRQHandler(void) { DMA_IRQ_Dispatch(DMA2_CH(7)); }
+
+static void DMA_Command(const char * args)
+{
+    (void)args;
+
+    for (uint8_t i = 0; i < DMA_CHANNEL_COUNT; i++) {
+        DMA_HandleTypeDef * owner = dma_owners[i];
+        if (owner == NULL) {
+            continue;
+        }
+        printd("DMA%u ch%u  %-9s req %lu  %s  %s  left %lu\r\n", (i < DMA2_CH(1)) ? 1U : 2U,
+               (i < DMA2_CH(1)) ? i + 1U : i - 6U, dma_owner_names[i], (unsigned long)owner->Init.Request,
+               (owner->Init.Mode == DMA_CIRCULAR) ? "circ" : "norm",
+               (owner->Init.Direction == DMA_PERIPH_TO_MEMORY) ? "P->M" :
+               (owner->Init.Direction == DMA_MEMORY_TO_PERIPH) ? "M->P" : "M->M",
+               (unsigned long)owner->Instance->CNDTR);
+    }
+}
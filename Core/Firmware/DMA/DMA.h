@@ -0,0 +1,72 @@
+/*
+ * DMA.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef DMA_DMA_H_
+#define DMA_DMA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../Inc/main.h"
+#include "DMA_Stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Runtime owner of the 14 DMA channels (DMA1 and DMA2, channels 1-7). A driver asks for a peripheral
+ * request instead of hard-coding a channel; the manager picks a free channel that can serve it (the
+ * RM0351 request mapping is in DMA.c), fills and initialises the handle and enables its interrupt.
+ * 1) Allocate and link, e.g. an SPI1 circular RX:
+ *      DMA_HandleTypeDef * rx = DMA_Allocate(eDMA_SPI1_RX, DMA_CIRCULAR, DMA_PRIORITY_HIGH);
+ *      if (rx != NULL) __HAL_LINKDMA(hspi, hdmarx, *rx);
+ *    NULL when every channel that maps the request is taken. DMA_Release gives the channel back.
+ * 2) Handles CubeMX sets up itself (USART2 on DMA1 channels 6/7, see stm32l4xx_hal_msp.c) are
+ *    registered with DMA_Adopt from main.c, so allocation routes around them - I2C1 then lands on
+ *    DMA2 channels 6/7. Their interrupt handlers stay in stm32l4xx_it.c; DMA.c defines the others.
+ * 3) Circular receptions are read through a tDMA_Stream (DMA_Stream.h) over the channel's CNDTR.
+ *    UART and Cloned SPI use it; an ADC does the same with Item_Size 2:
+ *      DMA_Stream_Init(&stream, (uint8_t *)samples, count, 2, &hadc->DMA_Handle->Instance->CNDTR);
+ *      HAL_ADC_Start_DMA(hadc, (uint32_t *)samples, count);
+ *    with HAL_ADC_ConvHalfCpltCallback / HAL_ADC_ConvCpltCallback calling the stream's half/full hooks.
+ * 4) Console "dma" lists the channels in use.
+ */
+
+#define DMA_CHANNEL_COUNT               14
+#define DMA_IRQ_PRIORITY                0   /* same as the CubeMX USART2 channels */
+
+typedef enum {
+    eDMA_ADC1 = 0,
+    eDMA_SPI1_RX,
+    eDMA_SPI1_TX,
+    eDMA_SPI2_RX,
+    eDMA_SPI2_TX,
+    eDMA_SPI3_RX,
+    eDMA_SPI3_TX,
+    eDMA_USART1_RX,
+    eDMA_USART1_TX,
+    eDMA_USART2_RX,
+    eDMA_USART2_TX,
+    eDMA_I2C1_RX,
+    eDMA_I2C1_TX,
+    eDMA_I2C3_RX,
+    eDMA_I2C3_TX,
+    eDMA_MEM2MEM,                       /* memory to memory, see DMA_Memcpy.h */
+    eDMA_Request_Count
+} eDMA_Request;
+
+DMA_HandleTypeDef * DMA_Allocate(eDMA_Request Request, uint32_t Mode, uint32_t Priority);
+bool DMA_Adopt(DMA_HandleTypeDef * Handle);
+void DMA_Release(DMA_HandleTypeDef * Handle);
+void DMA_IRQ_Dispatch(uint8_t Channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DMA_DMA_H_ */
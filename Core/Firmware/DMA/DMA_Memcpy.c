@@ -0,0 +1,436 @@
+/*
+ * DMA_Memcpy.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "DMA_Memcpy.h"
+#ifndef DMA_SIMULATION
+#include "DMA.h"
+#include "../../Middlewares/Defer/defer.h"
+#include "../../Middlewares/Console/Thread_Console.h"
+#include "../../Middlewares/Log/log.h"
+#endif
+
+#define DMA_MEMCPY_MAX_ITEMS            0xFFFFU     /* CNDTR is 16 bits */
+#define DMA_MEMCPY_EVENT_DONE           0x01U
+#define DMA_MEMCPY_BENCH_MAX            4096
+
+#ifdef DMA_SIMULATION
+#define DMA_MEMCPY_CYCLES()             0U
+#else
+#define DMA_MEMCPY_CYCLES()             (DWT->CYCCNT)
+#endif
+
+_Static_assert((DMA_MEMCPY_QUEUE_SIZE & (DMA_MEMCPY_QUEUE_SIZE - 1)) == 0, "DMA_MEMCPY_QUEUE_SIZE must be a power of two");
+
+typedef struct {
+    uint8_t * Dst;
+    const uint8_t * Src;
+    uint32_t Length;                    /* bytes not copied yet */
+    uint32_t Chunk;                     /* bytes in the transfer running now */
+    tDMA_Memcpy_Done Done;
+    void * Param;
+} tDMA_Memcpy_Job;
+
+/* Job n (handle n + 1) sits in slot n & (DMA_MEMCPY_QUEUE_SIZE - 1). Jobs finish in order, so a
+ * handle is done once memcpy_tail has reached it. */
+static tDMA_Memcpy_Job memcpy_queue[DMA_MEMCPY_QUEUE_SIZE];
+static volatile uint32_t memcpy_head = 0;      /* jobs submitted */
+static volatile uint32_t memcpy_tail = 0;      /* jobs finished */
+static volatile bool memcpy_running = false;
+
+static bool memcpy_ready = false;
+static tDMA_Memcpy_Stats memcpy_stats;
+static volatile uint32_t memcpy_isr_cycles = 0;
+
+#ifdef DMA_SIMULATION
+/* Host: chunks complete at once unless held back; the held one is finished by DMA_Memcpy_Sim_Step */
+static bool sim_hold = false;
+static bool sim_busy = false;
+static uint32_t sim_last_chunk = 0;
+#else
+static DMA_HandleTypeDef * memcpy_dma = NULL;
+static TX_EVENT_FLAGS_GROUP memcpy_events;
+#endif
+
+static void DMA_Memcpy_Start(tDMA_Memcpy_Job * Job);
+static void DMA_Memcpy_Finish(void);
+static void DMA_Memcpy_Chunk_Done(void);
+static void DMA_Memcpy_Notify(tDMA_Memcpy_Done Done, void * Param, uint32_t Handle);
+
+#ifndef DMA_SIMULATION
+static void DMA_Memcpy_Chunk_Error(void);
+static void DMA_Memcpy_Transfer_Done(DMA_HandleTypeDef * hdma);
+static void DMA_Memcpy_Transfer_Error(DMA_HandleTypeDef * hdma);
+static void DMA_Memcpy_Command(const char * args);
+
+CONSOLE_COMMAND("memcpy", "DMA copy statistics: memcpy [bench]", NULL,
+                .Args_Function = DMA_Memcpy_Command);
+#endif
+
+/* Interrupts off around queue updates; a host build has no interrupts */
+static inline uint32_t DMA_Memcpy_Lock(void)
+{
+#ifdef DMA_SIMULATION
+    return 0;
+#else
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+#endif
+}
+
+static inline void DMA_Memcpy_Unlock(uint32_t Primask)
+{
+#ifdef DMA_SIMULATION
+    (void)Primask;
+#else
+    __set_PRIMASK(Primask);
+#endif
+}
+
+/**
+ * @brief: Creates the completion event group and allocates the memory-to-memory channel. Without a
+ * channel every copy is done inline.
+ *
+ * @params: None
+ *
+ * @return: false if the event group could not be created
+ */
+bool DMA_Memcpy_Init(void)
+{
+    if (memcpy_ready) {
+        return true;
+    }
+#ifndef DMA_SIMULATION
+    if (tx_event_flags_create(&memcpy_events, "DMA_MEMCPY") != TX_SUCCESS) {
+        return false;
+    }
+    memcpy_dma = DMA_Allocate(eDMA_MEM2MEM, DMA_NORMAL, DMA_PRIORITY_LOW);
+    if (memcpy_dma != NULL) {
+        memcpy_dma->XferCpltCallback = DMA_Memcpy_Transfer_Done;
+        memcpy_dma->XferErrorCallback = DMA_Memcpy_Transfer_Error;
+    } else {
+        LOG_WARN(APP, "DMA memcpy: no channel, copying with the CPU\r\n");
+    }
+#endif
+    memcpy_ready = true;
+    return true;
+}
+
+/**
+ * @brief: Copies Length bytes from Src to Dst. Short copies, and any copy when the queue is full,
+ * are done here with memcpy; the rest are queued to the DMA channel and this returns at once.
+ * Either way Done is posted to the DEFER thread, never called from here. Thread context only.
+ *
+ * @params: Dst, Src (must not overlap and must stay valid until done), Length in bytes,
+ * Done called once the copy is finished (NULL for none), Param passed to Done
+ *
+ * @return: handle for DMA_Memcpy_Wait / DMA_Memcpy_Is_Done, DMA_MEMCPY_DONE if already finished
+ */
+tDMA_Memcpy_Handle DMA_Memcpy(void * Dst, const void * Src, uint32_t Length, tDMA_Memcpy_Done Done, void * Param)
+{
+    bool queue_full = false;
+
+    if (Length >= DMA_MEMCPY_THRESHOLD && memcpy_ready
+#ifndef DMA_SIMULATION
+        && memcpy_dma != NULL
+#endif
+        ) {
+        uint32_t primask = DMA_Memcpy_Lock();
+        uint32_t seq = memcpy_head;
+        queue_full = (seq - memcpy_tail) >= DMA_MEMCPY_QUEUE_SIZE;
+        if (!queue_full) {
+            tDMA_Memcpy_Job * job = &memcpy_queue[seq & (DMA_MEMCPY_QUEUE_SIZE - 1)];
+            job->Dst = (uint8_t *)Dst;
+            job->Src = (const uint8_t *)Src;
+            job->Length = Length;
+            job->Done = Done;
+            job->Param = Param;
+            memcpy_head = seq + 1;
+
+            memcpy_stats.DMA_Copies++;
+            memcpy_stats.DMA_Bytes += Length;
+            if (memcpy_head - memcpy_tail > memcpy_stats.High_Water) {
+                memcpy_stats.High_Water = memcpy_head - memcpy_tail;
+            }
+            bool start = !memcpy_running;
+            memcpy_running = true;
+            DMA_Memcpy_Unlock(primask);
+
+            if (start) {
+                DMA_Memcpy_Start(job);
+            }
+            return seq + 1;
+        }
+        memcpy_stats.Queue_Full++;
+        DMA_Memcpy_Unlock(primask);
+    }
+
+    memcpy(Dst, Src, Length);
+    if (!queue_full) {
+        uint32_t primask = DMA_Memcpy_Lock();
+        memcpy_stats.CPU_Copies++;
+        DMA_Memcpy_Unlock(primask);
+    }
+    DMA_Memcpy_Notify(Done, Param, DMA_MEMCPY_DONE);
+    return DMA_MEMCPY_DONE;
+}
+
+bool DMA_Memcpy_Is_Done(tDMA_Memcpy_Handle Handle)
+{
+    return Handle == DMA_MEMCPY_DONE || (int32_t)(memcpy_tail - Handle) >= 0;
+}
+
+/**
+ * @brief: Blocks until the copy is done. Every completion sets one shared event flag, so the wait
+ * re-checks its own handle and sleeps a tick at a time - a completion whose flag another waiter
+ * cleared costs at most one tick. On a host nothing completes while waiting, so it only checks.
+ *
+ * @params: Handle from DMA_Memcpy, Timeout_Ticks (TX_WAIT_FOREVER allowed)
+ *
+ * @return: false on timeout
+ */
+bool DMA_Memcpy_Wait(tDMA_Memcpy_Handle Handle, uint32_t Timeout_Ticks)
+{
+#ifdef DMA_SIMULATION
+    (void)Timeout_Ticks;
+    return DMA_Memcpy_Is_Done(Handle);
+#else
+    ULONG start = tx_time_get();
+    ULONG actual;
+
+    while (!DMA_Memcpy_Is_Done(Handle)) {
+        if (tx_time_get() - start >= Timeout_Ticks) {
+            return false;
+        }
+        tx_event_flags_get(&memcpy_events, DMA_MEMCPY_EVENT_DONE, TX_OR_CLEAR, &actual, 1);
+    }
+    return true;
+#endif
+}
+
+void DMA_Memcpy_Get_Stats(tDMA_Memcpy_Stats * Stats)
+{
+    uint32_t primask = DMA_Memcpy_Lock();
+    *Stats = memcpy_stats;
+    DMA_Memcpy_Unlock(primask);
+}
+
+/**
+ * @brief: Starts the next chunk of Job with the widest unit both addresses allow, at most
+ * DMA_MEMCPY_MAX_ITEMS units. Bytes left over that do not fill a unit are copied by the CPU and
+ * the job finishes.
+ */
+static void DMA_Memcpy_Start(tDMA_Memcpy_Job * Job)
+{
+    uint32_t address_bits = (uint32_t)(uintptr_t)Job->Dst | (uint32_t)(uintptr_t)Job->Src;
+    uint32_t unit = ((address_bits & 3U) == 0) ? 4U : ((address_bits & 1U) == 0) ? 2U : 1U;
+    uint32_t items = Job->Length / unit;
+
+    if (items > DMA_MEMCPY_MAX_ITEMS) {
+        items = DMA_MEMCPY_MAX_ITEMS;
+    }
+    if (items == 0) {
+        memcpy(Job->Dst, Job->Src, Job->Length);
+        Job->Length = 0;
+        DMA_Memcpy_Finish();
+        return;
+    }
+    Job->Chunk = items * unit;
+
+#ifdef DMA_SIMULATION
+    sim_last_chunk = Job->Chunk;
+    sim_busy = true;
+    if (!sim_hold) {
+        DMA_Memcpy_Sim_Step();
+    }
+#else
+    uint32_t size = (unit == 4U) ? DMA_PDATAALIGN_WORD : (unit == 2U) ? DMA_PDATAALIGN_HALFWORD : DMA_PDATAALIGN_BYTE;
+    memcpy_dma->Init.PeriphDataAlignment = size;
+    memcpy_dma->Init.MemDataAlignment = size << 2;
+    MODIFY_REG(memcpy_dma->Instance->CCR, DMA_CCR_PSIZE | DMA_CCR_MSIZE, size | (size << 2));
+    if (HAL_DMA_Start_IT(memcpy_dma, (uint32_t)Job->Src, (uint32_t)Job->Dst, items) != HAL_OK) {
+        DMA_Memcpy_Chunk_Error();
+    }
+#endif
+}
+
+/* Retires the oldest job: wakes waiters, posts its Done to the DEFER thread and starts the next one */
+static void DMA_Memcpy_Finish(void)
+{
+    tDMA_Memcpy_Job * job = &memcpy_queue[memcpy_tail & (DMA_MEMCPY_QUEUE_SIZE - 1)];
+    tDMA_Memcpy_Done done = job->Done;
+    void * param = job->Param;
+    uint32_t handle = memcpy_tail + 1;
+
+    /* the slot may be reused as soon as the tail moves */
+    uint32_t primask = DMA_Memcpy_Lock();
+    memcpy_tail = handle;
+    bool next = (memcpy_tail != memcpy_head);
+    memcpy_running = next;
+    DMA_Memcpy_Unlock(primask);
+
+#ifndef DMA_SIMULATION
+    tx_event_flags_set(&memcpy_events, DMA_MEMCPY_EVENT_DONE, TX_OR);
+#endif
+    DMA_Memcpy_Notify(done, param, handle);
+    if (next) {
+        DMA_Memcpy_Start(&memcpy_queue[memcpy_tail & (DMA_MEMCPY_QUEUE_SIZE - 1)]);
+    }
+}
+
+/* Done goes to the DEFER thread for both paths, inline only if the defer ring is full (or on a host) */
+static void DMA_Memcpy_Notify(tDMA_Memcpy_Done Done, void * Param, uint32_t Handle)
+{
+    if (Done == NULL) {
+        return;
+    }
+#ifndef DMA_SIMULATION
+    if (Defer_Post(Done, Param, Handle)) {
+        return;
+    }
+#endif
+    Done(Param, Handle);
+}
+
+/* Chunk finished: start the next one of the job or retire it */
+static void DMA_Memcpy_Chunk_Done(void)
+{
+    uint32_t start = DMA_MEMCPY_CYCLES();
+    tDMA_Memcpy_Job * job = &memcpy_queue[memcpy_tail & (DMA_MEMCPY_QUEUE_SIZE - 1)];
+
+    job->Dst += job->Chunk;
+    job->Src += job->Chunk;
+    job->Length -= job->Chunk;
+    if (job->Length > 0) {
+        DMA_Memcpy_Start(job);
+    } else {
+        DMA_Memcpy_Finish();
+    }
+    memcpy_isr_cycles += DMA_MEMCPY_CYCLES() - start;
+}
+
+#ifdef DMA_SIMULATION
+/* Hold chunks back as a busy channel would; releasing does not complete the one held */
+void DMA_Memcpy_Sim_Hold(bool Hold)
+{
+    sim_hold = Hold;
+}
+
+/**
+ * @brief: Plays the channel finishing the chunk it was given: copies it and runs the completion as
+ * the transfer-complete interrupt would.
+ *
+ * @return: false if no chunk was in flight
+ */
+bool DMA_Memcpy_Sim_Step(void)
+{
+    if (!sim_busy) {
+        return false;
+    }
+    tDMA_Memcpy_Job * job = &memcpy_queue[memcpy_tail & (DMA_MEMCPY_QUEUE_SIZE - 1)];
+    sim_busy = false;
+    memcpy(job->Dst, job->Src, job->Chunk);
+    DMA_Memcpy_Chunk_Done();
+    return true;
+}
+
+/* Bytes in the chunk most recently handed to the channel */
+uint32_t DMA_Memcpy_Sim_Last_Chunk(void)
+{
+    return sim_last_chunk;
+}
+#else
+/* Transfer error or a failed start: finish the job with the CPU so it still completes */
+static void DMA_Memcpy_Chunk_Error(void)
+{
+    tDMA_Memcpy_Job * job = &memcpy_queue[memcpy_tail & (DMA_MEMCPY_QUEUE_SIZE - 1)];
+
+    memcpy_stats.Errors++;
+    memcpy(job->Dst, job->Src, job->Length);
+    job->Length = 0;
+    DMA_Memcpy_Finish();
+}
+
+/* DMA interrupt: chunk finished */
+static void DMA_Memcpy_Transfer_Done(DMA_HandleTypeDef * hdma)
+{
+    UNUSED(hdma);
+    DMA_Memcpy_Chunk_Done();
+}
+
+/* DMA interrupt: transfer error */
+static void DMA_Memcpy_Transfer_Error(DMA_HandleTypeDef * hdma)
+{
+    UNUSED(hdma);
+    DMA_Memcpy_Chunk_Error();
+}
+
+/**
+ * @brief: "memcpy bench": for each size, CPU cycles of a plain memcpy against the CPU cycles a DMA
+ * copy costs (submit plus completion interrupt) and the cycles until it is done.
+ */
+static void DMA_Memcpy_Bench(void)
+{
+    static const uint32_t sizes[] = { 64, 256, 1024, DMA_MEMCPY_BENCH_MAX };
+    uint8_t * src = malloc(DMA_MEMCPY_BENCH_MAX);
+    uint8_t * dst = malloc(DMA_MEMCPY_BENCH_MAX);
+
+    if (src == NULL || dst == NULL) {
+        printd("memcpy bench: malloc failed\r\n");
+        free(src);
+        free(dst);
+        return;
+    }
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    memset(src, 0xA5, DMA_MEMCPY_BENCH_MAX);
+
+    printd("bytes   cpu copy   dma cpu   dma done  (cycles)\r\n");
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint32_t start = DWT->CYCCNT;
+        memcpy(dst, src, sizes[i]);
+        uint32_t cpu = DWT->CYCCNT - start;
+
+        uint32_t isr_before = memcpy_isr_cycles;
+        start = DWT->CYCCNT;
+        tDMA_Memcpy_Handle handle = DMA_Memcpy(dst, src, sizes[i], NULL, NULL);
+        uint32_t submit = DWT->CYCCNT - start;
+        while (!DMA_Memcpy_Is_Done(handle)) {
+        }
+        uint32_t done = DWT->CYCCNT - start;
+        uint32_t isr = memcpy_isr_cycles - isr_before;
+
+        printd("%5lu %10lu %9lu %10lu%s\r\n", (unsigned long)sizes[i], (unsigned long)cpu,
+               (unsigned long)(submit + isr), (unsigned long)done,
+               (handle == DMA_MEMCPY_DONE) ? "  (cpu path)" : "");
+    }
+    free(src);
+    free(dst);
+}
+
+static void DMA_Memcpy_Command(const char * args)
+{
+    while (*args == ' ') args++;
+
+    if (strcmp(args, "bench") == 0) {
+        DMA_Memcpy_Bench();
+        return;
+    } else if (*args != '\0') {
+        printd("usage: memcpy [bench]\r\n");
+        return;
+    }
+
+    tDMA_Memcpy_Stats stats;
+    DMA_Memcpy_Get_Stats(&stats);
+    printd("dma %lu copies (%lu bytes), cpu %lu, queue full %lu, errors %lu, high-water %lu/%u\r\n",
+           (unsigned long)stats.DMA_Copies, (unsigned long)stats.DMA_Bytes, (unsigned long)stats.CPU_Copies,
+           (unsigned long)stats.Queue_Full, (unsigned long)stats.Errors, (unsigned long)stats.High_Water,
+           DMA_MEMCPY_QUEUE_SIZE);
+}
+#endif /* DMA_SIMULATION */
@@ -0,0 +1,208 @@
+/*
+ * DMA_Memcpy_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ *
+ * Host test of the DMA_Memcpy queue, built against the simulated channel:
+ *   gcc -std=gnu11 -DDMA_SIMULATION -DDMA_MEMCPY_TEST_DEBUG Core/Firmware/DMA/DMA_Memcpy.c \
+ *       Core/Firmware/DMA/DMA_Memcpy_test.c -o dma_memcpy_test && ./dma_memcpy_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef DMA_MEMCPY_TEST_DEBUG
+
+#include "DMA_Memcpy.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static uint32_t done_order[DMA_MEMCPY_QUEUE_SIZE * 2];
+static uint32_t done_handles[DMA_MEMCPY_QUEUE_SIZE * 2];
+static uint32_t done_count = 0;
+
+static void Record_Done(void * Param, uint32_t Handle)
+{
+    done_order[done_count] = (uint32_t)(uintptr_t)Param;
+    done_handles[done_count] = Handle;
+    done_count++;
+}
+
+static void Fill(uint8_t * Buffer, uint32_t Length, uint8_t Seed)
+{
+    for (uint32_t i = 0; i < Length; i++) {
+        Buffer[i] = (uint8_t)(Seed + i * 7);
+    }
+}
+
+static void Drain(void)
+{
+    while (DMA_Memcpy_Sim_Step()) {
+    }
+}
+
+/* Below the threshold the copy is done before returning, Done still runs once */
+static void Test_CPU_Path(void)
+{
+    uint8_t src[64], dst[64];
+    tDMA_Memcpy_Stats before, after;
+
+    Fill(src, sizeof(src), 1);
+    memset(dst, 0, sizeof(dst));
+    done_count = 0;
+    DMA_Memcpy_Get_Stats(&before);
+
+    tDMA_Memcpy_Handle h = DMA_Memcpy(dst, src, sizeof(src), Record_Done, (void *)1);
+    DMA_Memcpy_Get_Stats(&after);
+
+    CHECK(h == DMA_MEMCPY_DONE);
+    CHECK(DMA_Memcpy_Is_Done(h));
+    CHECK(memcmp(dst, src, sizeof(src)) == 0);
+    CHECK(done_count == 1 && done_handles[0] == DMA_MEMCPY_DONE);
+    CHECK(after.CPU_Copies == before.CPU_Copies + 1);
+}
+
+/* Queued copies finish one at a time, in submission order, and their handles follow */
+static void Test_Ordering_And_Handles(void)
+{
+    static uint8_t src[3][512], dst[3][512];
+    tDMA_Memcpy_Handle h[3];
+
+    done_count = 0;
+    DMA_Memcpy_Sim_Hold(true);
+    for (uint32_t i = 0; i < 3; i++) {
+        Fill(src[i], sizeof(src[i]), (uint8_t)(10 + i));
+        memset(dst[i], 0, sizeof(dst[i]));
+        h[i] = DMA_Memcpy(dst[i], src[i], sizeof(src[i]), Record_Done, (void *)(uintptr_t)(100 + i));
+        CHECK(h[i] != DMA_MEMCPY_DONE);
+    }
+    CHECK(h[1] == h[0] + 1 && h[2] == h[1] + 1);
+    CHECK(!DMA_Memcpy_Is_Done(h[0]));
+    CHECK(!DMA_Memcpy_Wait(h[0], 0));
+    CHECK(done_count == 0);
+
+    for (uint32_t i = 0; i < 3; i++) {
+        CHECK(DMA_Memcpy_Sim_Step());
+        CHECK(DMA_Memcpy_Is_Done(h[i]));
+        CHECK(DMA_Memcpy_Wait(h[i], 0));
+        if (i < 2) {
+            CHECK(!DMA_Memcpy_Is_Done(h[i + 1]));
+        }
+        CHECK(memcmp(dst[i], src[i], sizeof(src[i])) == 0);
+        CHECK(done_count == i + 1);
+        CHECK(done_order[i] == 100 + i && done_handles[i] == h[i]);
+    }
+    CHECK(!DMA_Memcpy_Sim_Step());
+    /* an old handle stays done */
+    CHECK(DMA_Memcpy_Is_Done(h[0]));
+    DMA_Memcpy_Sim_Hold(false);
+}
+
+/* CNDTR holds 16 bits: a transfer moves at most 0xFFFF units, whatever the unit size */
+static void Test_Chunking(void)
+{
+    uint32_t length = 0xFFFF * 4 + 1000;
+    uint8_t * src = malloc(length + 4);
+    uint8_t * dst = malloc(length + 4);
+    tDMA_Memcpy_Handle h;
+
+    Fill(src, length + 4, 3);
+
+    /* word aligned: 0xFFFF words, then the rest */
+    DMA_Memcpy_Sim_Hold(true);
+    memset(dst, 0, length + 4);
+    h = DMA_Memcpy(dst, src, length, NULL, NULL);
+    CHECK(DMA_Memcpy_Sim_Last_Chunk() == 0xFFFF * 4);
+    CHECK(DMA_Memcpy_Sim_Step());
+    CHECK(!DMA_Memcpy_Is_Done(h));
+    CHECK(DMA_Memcpy_Sim_Last_Chunk() == 1000);
+    Drain();
+    CHECK(DMA_Memcpy_Is_Done(h));
+    CHECK(memcmp(dst, src, length) == 0);
+
+    /* odd address: byte units, so 0xFFFF bytes a chunk */
+    memset(dst, 0, length + 4);
+    h = DMA_Memcpy(dst + 1, src + 1, 0x10000 + 10, NULL, NULL);
+    CHECK(DMA_Memcpy_Sim_Last_Chunk() == 0xFFFF);
+    CHECK(DMA_Memcpy_Sim_Step());
+    /* both addresses are word aligned after it: two words, the last 3 bytes by the CPU */
+    CHECK(DMA_Memcpy_Sim_Last_Chunk() == 8);
+    Drain();
+    CHECK(DMA_Memcpy_Is_Done(h));
+    CHECK(memcmp(dst + 1, src + 1, 0x10000 + 10) == 0);
+    CHECK(dst[0] == 0 && dst[0x10000 + 11] == 0);
+
+    /* a tail shorter than the unit is finished by the CPU */
+    memset(dst, 0, length + 4);
+    h = DMA_Memcpy(dst, src, 514, NULL, NULL);
+    CHECK(DMA_Memcpy_Sim_Last_Chunk() == 512);
+    Drain();
+    CHECK(DMA_Memcpy_Is_Done(h));
+    CHECK(memcmp(dst, src, 514) == 0 && dst[514] == 0);
+    DMA_Memcpy_Sim_Hold(false);
+
+    free(src);
+    free(dst);
+}
+
+/* With every slot taken the copy falls back to the CPU, is counted, and the queue is untouched */
+static void Test_Queue_Full(void)
+{
+    static uint8_t src[DMA_MEMCPY_QUEUE_SIZE + 1][256], dst[DMA_MEMCPY_QUEUE_SIZE + 1][256];
+    tDMA_Memcpy_Handle h[DMA_MEMCPY_QUEUE_SIZE + 1];
+    tDMA_Memcpy_Stats before, after;
+
+    DMA_Memcpy_Get_Stats(&before);
+    done_count = 0;
+    DMA_Memcpy_Sim_Hold(true);
+    for (uint32_t i = 0; i <= DMA_MEMCPY_QUEUE_SIZE; i++) {
+        Fill(src[i], sizeof(src[i]), (uint8_t)(50 + i));
+        memset(dst[i], 0, sizeof(dst[i]));
+        h[i] = DMA_Memcpy(dst[i], src[i], sizeof(src[i]), Record_Done, (void *)(uintptr_t)i);
+    }
+    DMA_Memcpy_Get_Stats(&after);
+
+    for (uint32_t i = 0; i < DMA_MEMCPY_QUEUE_SIZE; i++) {
+        CHECK(h[i] != DMA_MEMCPY_DONE && !DMA_Memcpy_Is_Done(h[i]));
+    }
+    CHECK(h[DMA_MEMCPY_QUEUE_SIZE] == DMA_MEMCPY_DONE);
+    CHECK(memcmp(dst[DMA_MEMCPY_QUEUE_SIZE], src[DMA_MEMCPY_QUEUE_SIZE], 256) == 0);
+    CHECK(done_count == 1 && done_order[0] == DMA_MEMCPY_QUEUE_SIZE);
+    CHECK(after.Queue_Full == before.Queue_Full + 1);
+    CHECK(after.CPU_Copies == before.CPU_Copies);
+    CHECK(after.High_Water == DMA_MEMCPY_QUEUE_SIZE);
+
+    Drain();
+    for (uint32_t i = 0; i < DMA_MEMCPY_QUEUE_SIZE; i++) {
+        CHECK(DMA_Memcpy_Is_Done(h[i]));
+        CHECK(memcmp(dst[i], src[i], 256) == 0);
+        CHECK(done_order[i + 1] == i);
+    }
+    DMA_Memcpy_Sim_Hold(false);
+}
+
+int main(void)
+{
+    if (!DMA_Memcpy_Init()) {
+        printf("FAIL: init\n");
+        return 1;
+    }
+    Test_CPU_Path();
+    Test_Ordering_And_Handles();
+    Test_Chunking();
+    Test_Queue_Full();
+
+    printf("%s: %d failure(s)\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * DMA_Stream.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <string.h>
+#include "DMA_Stream.h"
+
+static uint32_t DMA_Stream_Update_Head(tDMA_Stream * Stream);
+
+/**
+ * @brief: Sets up a stream over Buffer. Call before the circular transfer is started (or restarted),
+ * the read cursor starts at the beginning of the buffer.
+ *
+ * @params: Stream, Buffer the DMA writes, Items transfer length, Item_Size bytes per item,
+ * Counter the channel's remaining-count register (&hdma->Instance->CNDTR).
+ * Items * Item_Size must be a power of two.
+ *
+ * @return: None
+ */
+void DMA_Stream_Init(tDMA_Stream * Stream, uint8_t * Buffer, uint32_t Items, uint8_t Item_Size,
+                     volatile const uint32_t * Counter)
+{
+    Ring_Init(&Stream->Ring, Buffer, Items * Item_Size);
+    Stream->Items = Items;
+    Stream->Item_Size = Item_Size;
+    Stream->Counter = Counter;
+    Stream->Callback = NULL;
+    Stream->Callback_Param = NULL;
+    DMA_Stream_Reset(Stream);
+}
+
+/* Back to the start of the buffer, for a transfer that is being restarted. Keeps the callback. */
+void DMA_Stream_Reset(tDMA_Stream * Stream)
+{
+    Stream->Laps = 0;
+    Ring_Reset(&Stream->Ring);
+    Stream->Overruns = 0;
+}
+
+void DMA_Stream_Set_Callback(tDMA_Stream * Stream, tDMA_Stream_Callback Callback, void * Param)
+{
+    Stream->Callback = NULL;
+    Stream->Callback_Param = Param;
+    Stream->Callback = Callback;
+}
+
+/* Half transfer interrupt: the first half of the buffer has been written */
+void DMA_Stream_Half_Complete(tDMA_Stream * Stream)
+{
+    if (Stream->Callback != NULL) {
+        Stream->Callback(Stream, eDMA_Stream_Half, Stream->Callback_Param);
+    }
+}
+
+/* Transfer complete interrupt: the second half has been written and the channel has wrapped */
+void DMA_Stream_Full_Complete(tDMA_Stream * Stream)
+{
+    Stream->Laps++;
+    if (Stream->Callback != NULL) {
+        Stream->Callback(Stream, eDMA_Stream_Full, Stream->Callback_Param);
+    }
+}
+
+/**
+ * @brief: Bytes written by the DMA and not read yet. If the reader fell more than a buffer behind,
+ * moves the cursor up to the oldest byte still in the buffer and counts the rest in Overruns.
+ *
+ * @params: Stream
+ *
+ * @return: bytes available, at most the buffer size
+ */
+uint32_t DMA_Stream_Available(tDMA_Stream * Stream)
+{
+    tRing * ring = &Stream->Ring;
+    uint32_t head = DMA_Stream_Update_Head(Stream);
+
+    if (head - ring->Tail > ring->Size) {
+        Stream->Overruns += head - ring->Tail - ring->Size;
+        ring->Tail = head - ring->Size;
+    }
+    return head - ring->Tail;
+}
+
+/**
+ * @brief: Copies up to Length new bytes to Data and moves the cursor past them.
+ *
+ * @params: Stream, Data destination, Length maximum bytes to copy
+ *
+ * @return: bytes copied
+ */
+uint32_t DMA_Stream_Read(tDMA_Stream * Stream, uint8_t * Data, uint32_t Length)
+{
+    DMA_Stream_Available(Stream);
+    return Ring_Read(&Stream->Ring, Data, Length);
+}
+
+/**
+ * @brief: Zero-copy access to the new bytes. Points Data at the cursor and returns how many bytes
+ * follow it without wrapping; call again after DMA_Stream_Consume for the part after the wrap.
+ *
+ * @params: Stream, Data set to the first unread byte
+ *
+ * @return: contiguous bytes available at Data
+ */
+uint32_t DMA_Stream_Peek(tDMA_Stream * Stream, const uint8_t ** Data)
+{
+    DMA_Stream_Available(Stream);
+    return Ring_Peek(&Stream->Ring, Data);
+}
+
+/* Moves the cursor past Length bytes, no further than the last write position seen */
+void DMA_Stream_Consume(tDMA_Stream * Stream, uint32_t Length)
+{
+    uint32_t available = Ring_Used(&Stream->Ring);
+    Ring_Consume(&Stream->Ring, (Length < available) ? Length : available);
+}
+
+/* Drops everything received so far; the next read starts with the next byte the DMA writes */
+void DMA_Stream_Skip(tDMA_Stream * Stream)
+{
+    Stream->Ring.Tail = DMA_Stream_Update_Head(Stream);
+}
+
+/**
+ * @brief: Turns the lap count and the channel counter into the free-running write position. The two
+ * are read until they agree, so a transfer complete interrupt in between is not torn. If the channel
+ * has wrapped but its interrupt has not run yet the position comes out a lap short - it would move
+ * backwards, so the missing lap is added here and Laps catches up when the interrupt runs. The
+ * reader stores the result as the ring's Head - it stands in for the DMA as the ring's producer.
+ */
+static uint32_t DMA_Stream_Update_Head(tDMA_Stream * Stream)
+{
+    uint32_t laps;
+    uint32_t remaining;
+
+    do {
+        laps = Stream->Laps;
+        remaining = *Stream->Counter;
+    } while (laps != Stream->Laps);
+
+    if (remaining > Stream->Items) {
+        remaining = Stream->Items;
+    }
+    uint32_t head = laps * Stream->Ring.Size + (Stream->Items - remaining) * Stream->Item_Size;
+    if ((int32_t)(head - Stream->Ring.Head) < 0) {
+        head += Stream->Ring.Size;
+    }
+    Stream->Ring.Head = head;
+    return head;
+}
+
+#ifdef DMA_SIMULATION
+/* Points the stream at the simulated counter and starts a lap, like HAL_DMA_Start in circular mode */
+void DMA_Sim_Start(tDMA_Sim_Channel * Channel, tDMA_Stream * Stream)
+{
+    Channel->Stream = Stream;
+    Channel->CNDTR = Stream->Items;
+    Channel->Hold_Full = false;
+    Channel->Held = 0;
+    Stream->Counter = &Channel->CNDTR;
+    DMA_Stream_Reset(Stream);
+}
+
+/**
+ * @brief: Plays the DMA hardware: writes Length bytes (whole items) at the channel position, counts
+ * CNDTR down, raises the half and full events where the hardware would and reloads CNDTR on wrap.
+ */
+void DMA_Sim_Transfer(tDMA_Sim_Channel * Channel, const uint8_t * Data, uint32_t Length)
+{
+    tDMA_Stream * stream = Channel->Stream;
+
+    for (uint32_t i = 0; i + stream->Item_Size <= Length; i += stream->Item_Size) {
+        uint32_t item = stream->Items - Channel->CNDTR;
+        memcpy(&stream->Ring.Buffer[item * stream->Item_Size], &Data[i], stream->Item_Size);
+        Channel->CNDTR--;
+        if (Channel->CNDTR == stream->Items - stream->Items / 2) {
+            DMA_Stream_Half_Complete(stream);
+        }
+        if (Channel->CNDTR == 0) {
+            Channel->CNDTR = stream->Items;
+            if (Channel->Hold_Full) {
+                Channel->Held++;
+            } else {
+                DMA_Stream_Full_Complete(stream);
+            }
+        }
+    }
+}
+
+/* Holds the transfer complete interrupt back; releasing runs the ones held, one per wrap */
+void DMA_Sim_Hold_Full(tDMA_Sim_Channel * Channel, bool Hold)
+{
+    Channel->Hold_Full = Hold;
+    while (!Hold && Channel->Held > 0) {
+        Channel->Held--;
+        DMA_Stream_Full_Complete(Channel->Stream);
+    }
+}
+#endif
@@ -0,0 +1,93 @@
+/*
+ * DMA_Stream.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef DMA_DMA_STREAM_H_
+#define DMA_DMA_STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../Middlewares/Ring/ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Consumer side of a circular (ping-pong) DMA reception. The DMA channel writes Buffer round and
+ * round; the stream turns its remaining-count register into a free-running write position (the Head
+ * of a tRing, see Ring/ring.h) so the reader gets "how many bytes are new" and a read cursor without
+ * keeping indices of its own.
+ * 1) DMA_Stream_Init(&stream, buffer, items, item_size, &hdma->Instance->CNDTR) before starting the
+ *    circular transfer (item_size 1 for UART/SPI bytes, 2 for ADC half-words).
+ * 2) The owning driver forwards the HAL half/full callbacks of that transfer (UART RxEvent, SPI
+ *    RxHalfCplt/RxCplt, ADC ConvHalfCplt/ConvCplt):
+ *      DMA_Stream_Half_Complete(&stream);  DMA_Stream_Full_Complete(&stream);
+ *    Full_Complete counts the lap and must be called for every wrap; Half_Complete only reports.
+ * 3) Streaming readers: DMA_Stream_Read copies new bytes, or DMA_Stream_Peek + DMA_Stream_Consume
+ *    work in place. Ping-pong readers: DMA_Stream_Set_Callback - the callback runs in the ISR with
+ *    eDMA_Stream_Half when the first half is ready and eDMA_Stream_Full when the second half is.
+ * 4) A reader that falls more than a buffer behind loses the overwritten bytes: the cursor jumps to
+ *    the oldest byte still held and Overruns counts the bytes skipped.
+ * One reader per stream. Nothing here touches the HAL, so with DMA_SIMULATION defined the file builds
+ * on a host and tDMA_Sim_Channel stands in for the DMA channel (DMA_Sim_Transfer plays the hardware,
+ * DMA_Stream_test.c drives it). DMA_Sim_Hold_Full() holds the transfer complete interrupt back, as a
+ * masked or late interrupt would, until it is released.
+ */
+
+typedef enum {
+    eDMA_Stream_Half = 0,
+    eDMA_Stream_Full,
+} eDMA_Stream_Event;
+
+typedef struct tDMA_Stream tDMA_Stream;
+
+/* Runs from the DMA interrupt - keep it short */
+typedef void (*tDMA_Stream_Callback)(tDMA_Stream * Stream, eDMA_Stream_Event Event, void * Param);
+
+struct tDMA_Stream {
+    tRing Ring;                         /* Head: DMA write position as last seen, Tail: read cursor */
+    uint32_t Items;                     /* transfer length programmed into the channel */
+    uint8_t Item_Size;
+    volatile const uint32_t * Counter;  /* channel CNDTR, items left in the current lap */
+    volatile uint32_t Laps;             /* completed laps, counted by DMA_Stream_Full_Complete */
+    uint32_t Overruns;                  /* bytes overwritten before they were read */
+    tDMA_Stream_Callback Callback;
+    void * Callback_Param;
+};
+
+void DMA_Stream_Init(tDMA_Stream * Stream, uint8_t * Buffer, uint32_t Items, uint8_t Item_Size,
+                     volatile const uint32_t * Counter);
+void DMA_Stream_Reset(tDMA_Stream * Stream);
+void DMA_Stream_Set_Callback(tDMA_Stream * Stream, tDMA_Stream_Callback Callback, void * Param);
+void DMA_Stream_Half_Complete(tDMA_Stream * Stream);
+void DMA_Stream_Full_Complete(tDMA_Stream * Stream);
+uint32_t DMA_Stream_Available(tDMA_Stream * Stream);
+uint32_t DMA_Stream_Read(tDMA_Stream * Stream, uint8_t * Data, uint32_t Length);
+uint32_t DMA_Stream_Peek(tDMA_Stream * Stream, const uint8_t ** Data);
+void DMA_Stream_Consume(tDMA_Stream * Stream, uint32_t Length);
+void DMA_Stream_Skip(tDMA_Stream * Stream);
+
+#ifdef DMA_SIMULATION
+/* Host stand-in for a circular DMA channel: CNDTR counts down and reloads like the hardware */
+typedef struct {
+    volatile uint32_t CNDTR;
+    tDMA_Stream * Stream;
+    bool Hold_Full;                     /* wraps are counted in Held, their interrupt not run yet */
+    uint32_t Held;
+} tDMA_Sim_Channel;
+
+void DMA_Sim_Start(tDMA_Sim_Channel * Channel, tDMA_Stream * Stream);
+void DMA_Sim_Transfer(tDMA_Sim_Channel * Channel, const uint8_t * Data, uint32_t Length);
+void DMA_Sim_Hold_Full(tDMA_Sim_Channel * Channel, bool Hold);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DMA_DMA_STREAM_H_ */
@@ -0,0 +1,191 @@
+/*
+ * DMA_Stream_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ *
+ * Host test of the DMA stream reader, built against the simulated channel:
+ *   gcc -std=gnu11 -DDMA_SIMULATION -DDMA_STREAM_TEST_DEBUG Core/Firmware/DMA/DMA_Stream.c \
+ *       Core/Middlewares/Ring/ring.c Core/Firmware/DMA/DMA_Stream_test.c -o dma_stream_test && ./dma_stream_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef DMA_STREAM_TEST_DEBUG
+
+#include "DMA_Stream.h"
+
+#define TEST_ITEMS          64
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static uint8_t buffer[TEST_ITEMS];
+static tDMA_Stream stream;
+static tDMA_Sim_Channel channel;
+static uint8_t next_out;                    /* value of the next byte the simulated peripheral sends */
+static uint32_t halves;
+static uint32_t fulls;
+
+static void Start(void)
+{
+    DMA_Stream_Init(&stream, buffer, TEST_ITEMS, 1, NULL);
+    DMA_Sim_Start(&channel, &stream);
+    next_out = 0;
+}
+
+/* The peripheral sends Length more bytes of the counting sequence */
+static void Send(uint32_t Length)
+{
+    uint8_t data[TEST_ITEMS * 4];
+
+    for (uint32_t i = 0; i < Length; i++) {
+        data[i] = next_out++;
+    }
+    DMA_Sim_Transfer(&channel, data, Length);
+}
+
+/* Data holds Length bytes of the counting sequence starting at First */
+static bool In_Sequence(const uint8_t * Data, uint32_t Length, uint8_t First)
+{
+    for (uint32_t i = 0; i < Length; i++) {
+        if (Data[i] != (uint8_t)(First + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void Count_Events(tDMA_Stream * Stream, eDMA_Stream_Event Event, void * Param)
+{
+    (void)Stream;
+    (void)Param;
+    if (Event == eDMA_Stream_Half) {
+        halves++;
+    } else {
+        fulls++;
+    }
+}
+
+/* Every wrap is one lap and one full event, the reader keeps up across all of them */
+static void Test_Laps(void)
+{
+    uint8_t out[TEST_ITEMS];
+    uint8_t expected = 0;
+
+    Start();
+    halves = 0;
+    fulls = 0;
+    DMA_Stream_Set_Callback(&stream, Count_Events, NULL);
+    for (int i = 0; i < 50; i++) {
+        Send(23);
+        uint32_t n = DMA_Stream_Read(&stream, out, sizeof(out));
+        CHECK(n == 23);
+        CHECK(In_Sequence(out, n, expected));
+        expected = (uint8_t)(expected + n);
+    }
+    CHECK(stream.Laps == 50 * 23 / TEST_ITEMS);
+    CHECK(fulls == stream.Laps);
+    CHECK(halves == stream.Laps + 1);       /* the last lap is past its half */
+    CHECK(stream.Overruns == 0);
+    CHECK(DMA_Stream_Available(&stream) == 0);
+    DMA_Stream_Set_Callback(&stream, NULL, NULL);
+}
+
+/* A reader more than a buffer behind gets the newest buffer's worth, the rest counted */
+static void Test_Overrun(void)
+{
+    uint8_t out[TEST_ITEMS];
+
+    Start();
+    Send(10);
+    CHECK(DMA_Stream_Read(&stream, out, 4) == 4);
+    Send(TEST_ITEMS + 20);
+    /* 6 + TEST_ITEMS + 20 unread, TEST_ITEMS of them still in the buffer */
+    CHECK(DMA_Stream_Available(&stream) == TEST_ITEMS);
+    CHECK(stream.Overruns == 26);
+    CHECK(DMA_Stream_Read(&stream, out, sizeof(out)) == TEST_ITEMS);
+    CHECK(In_Sequence(out, TEST_ITEMS, (uint8_t)(next_out - TEST_ITEMS)));
+    CHECK(DMA_Stream_Available(&stream) == 0);
+
+    /* exactly a buffer behind is not an overrun */
+    Send(TEST_ITEMS);
+    CHECK(DMA_Stream_Available(&stream) == TEST_ITEMS);
+    CHECK(stream.Overruns == 26);
+}
+
+/* In place reads split at the end of the buffer; Consume and Skip stop at the write position */
+static void Test_Peek_Consume_Skip(void)
+{
+    uint8_t out[TEST_ITEMS];
+    const uint8_t * data;
+
+    Start();
+    Send(TEST_ITEMS - 6);
+    CHECK(DMA_Stream_Read(&stream, out, sizeof(out)) == TEST_ITEMS - 6);
+    Send(20);
+    CHECK(DMA_Stream_Peek(&stream, &data) == 6);
+    CHECK(data == &buffer[TEST_ITEMS - 6]);
+    CHECK(In_Sequence(data, 6, TEST_ITEMS - 6));
+    DMA_Stream_Consume(&stream, 6);
+    CHECK(DMA_Stream_Peek(&stream, &data) == 14);
+    CHECK(data == &buffer[0]);
+    CHECK(In_Sequence(data, 14, TEST_ITEMS));
+    DMA_Stream_Consume(&stream, 100);
+    CHECK(DMA_Stream_Available(&stream) == 0);
+
+    Send(10);
+    DMA_Stream_Skip(&stream);
+    CHECK(DMA_Stream_Available(&stream) == 0);
+    Send(5);
+    CHECK(DMA_Stream_Read(&stream, out, sizeof(out)) == 5);
+    CHECK(In_Sequence(out, 5, (uint8_t)(next_out - 5)));
+    CHECK(stream.Overruns == 0);
+}
+
+/* The channel wraps before its transfer complete interrupt runs: the position must not move back */
+static void Test_Missed_Full(void)
+{
+    uint8_t out[TEST_ITEMS];
+
+    Start();
+    Send(40);
+    CHECK(DMA_Stream_Read(&stream, out, sizeof(out)) == 40);
+    DMA_Sim_Hold_Full(&channel, true);
+    Send(30);                               /* wraps to item 6, Laps still 0 */
+    CHECK(channel.Held == 1 && stream.Laps == 0);
+    CHECK(DMA_Stream_Available(&stream) == 30);
+    CHECK(stream.Overruns == 0);
+    CHECK(DMA_Stream_Read(&stream, out, 10) == 10);
+    CHECK(In_Sequence(out, 10, 40));
+
+    /* the interrupt catches up: same position, nothing read twice */
+    DMA_Sim_Hold_Full(&channel, false);
+    CHECK(stream.Laps == 1);
+    CHECK(DMA_Stream_Read(&stream, out, sizeof(out)) == 20);
+    CHECK(In_Sequence(out, 20, 50));
+    Send(3);
+    CHECK(DMA_Stream_Read(&stream, out, sizeof(out)) == 3);
+    CHECK(In_Sequence(out, 3, 70));
+    CHECK(stream.Overruns == 0);
+}
+
+int main(void)
+{
+    Test_Laps();
+    Test_Overrun();
+    Test_Peek_Consume_Skip();
+    Test_Missed_Full();
+
+    printf("%s: %d failure(s)\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
+
+#endif
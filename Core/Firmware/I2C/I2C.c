@@ -5,64 +5,223 @@
 
 #include "I2C.h"
 #include "../../Middlewares/Scheduler/Scheduler.h"
+#include "../../Middlewares/Log/log.h"
+#include "../../Middlewares/Console/Thread_Console.h"
+#include "../Registry/Registry.h"
+#include "../DMA/DMA.h"
+#include "../../Middlewares/Defer/defer.h"
 
+/* A pool block is the packet rounded up to ALIGN_TYPE plus the pointer ThreadX keeps in front of it */
+#define I2C_PACKET_BLOCK_SIZE   (((sizeof(tI2C_Packet) + sizeof(ALIGN_TYPE) - 1) & ~(sizeof(ALIGN_TYPE) - 1)) + sizeof(UCHAR *))
+
+static tI2C_Bus * i2c_buses[I2C_MAX_BUSES];
+static uint8_t i2c_bus_count = 0;
+
+static void I2C_Setup_Bus(tI2C_Bus * Bus);
+static tI2C_Packet * I2C_Packet_Alloc(tI2C * I2C);
+static void I2C_Packet_Free(tI2C_Bus * Bus, tI2C_Packet * Packet);
+static bool I2C_Submit(tI2C * I2C, tI2C_Packet * Packet);
+static void I2C_Drop_Packets(tI2C * I2C);
+static bool I2C_Claim(tI2C_Bus * Bus, eI2C_State From, eI2C_State To);
+static bool I2C_Bus_Acquire(tI2C_Bus * Bus, uint32_t Timeout);
+static bool I2C_Bus_Pending(tI2C_Bus * Bus);
+static tI2C * I2C_Bus_Pick(tI2C_Bus * Bus);
+static void I2C_Coalesce(tI2C_Bus * Bus, tI2C * I2C, tI2C_Packet * Head);
+static uint16_t I2C_Op_Size(const tI2C_Packet * Packet);
+static void I2C_Engine_Kick(tI2C_Bus * Bus);
+static void I2C_Engine_Next(tI2C_Bus * Bus);
+static void I2C_Engine_Finish(tI2C_Bus * Bus);
+static void I2C_Engine_Report(tI2C_Bus * Bus, bool OK);
+static HAL_StatusTypeDef I2C_Start_Op(tI2C_Bus * Bus, tI2C * I2C, tI2C_Packet * Packet);
+static void I2C_Engine_Complete(tI2C_Bus * Bus);
+static void I2C_Complete_Work(void * Arg, uint32_t Data);
+static tI2C_Packet * I2C_Take_Retry(tI2C * I2C);
+static void I2C_Bus_Check(tI2C_Bus * Bus);
+static void I2C_Bus_Recover(tI2C_Bus * Bus);
+static void I2C_Timer_Update(tI2C_Bus * Bus);
+static uint32_t I2C_Bit_Ns(I2C_HandleTypeDef * hi2c);
+static ULONG I2C_Op_Ticks(tI2C_Bus * Bus, uint32_t Size);
+static VOID I2C_Timer_Expired(ULONG Arg);
+static void I2C_Transfer_Done(I2C_HandleTypeDef * hi2c, bool OK);
+static bool I2C_Continuous_Start(tI2C * I2C);
+static void I2C_Continuous_Stop(tI2C * I2C);
+static void I2C_Continuous_Trigger(tI2C * I2C);
+static void I2C_Continuous_Done(tI2C_Bus * Bus, bool OK);
+static IRQn_Type I2C_Trigger_IRQn(const LPTIM_HandleTypeDef * Timer);
+static void I2C_Command(const char * args);
+
+CONSOLE_COMMAND("i2c", "I2C buses and devices: queues, counters, bus use", NULL, .Args_Function = I2C_Command);
+
+/**
+ * @brief: Creates the bus object for I2C_Handle: registers it for the HAL callbacks, sets up the
+ * interrupts and DMA, carves the packet pool and starts its task. Call it from init code to size
+ * the pool for the bus; otherwise Init_I2C creates the bus with I2C_BUS_PACKETS.
+ *
+ * @params: I2C_Handle, Packets number of packets that can be queued on the bus at once
+ *
+ * @return: the bus (the existing one if already created), NULL if it could not be created
+ */
+tI2C_Bus * I2C_Init_Bus(I2C_HandleTypeDef * I2C_Handle, uint16_t Packets){
+    tI2C_Bus * Bus = (tI2C_Bus *)Registry_Find(I2C_Handle->Instance, eRegistry_I2C);
+    if (Bus != NULL){
+        return Bus;
+    }
+    if (i2c_bus_count >= I2C_MAX_BUSES || Packets == 0){
+        return NULL;
+    }
+    // the only heap use of the bus: the object and its pool, once
+    Bus = (tI2C_Bus *)malloc(sizeof(tI2C_Bus));
+    ULONG pool_bytes = (ULONG)Packets * I2C_PACKET_BLOCK_SIZE;
+    void * pool_area = malloc(pool_bytes);
+    if (Bus == NULL || pool_area == NULL){
+        LOG_ERROR(I2C, "I2C_Init_Bus: malloc failed\r\n");
+        free(Bus);
+        free(pool_area);
+        return NULL;
+    }
+    memset(Bus, 0, sizeof(tI2C_Bus));
+    Bus->I2C_Handle = I2C_Handle;
+    Bus->State = eI2C_Idle;
+    Bus->Window_Start = DWT->CYCCNT;
+    Bus->Bit_Ns = I2C_Bit_Ns(I2C_Handle);
+    if (tx_block_pool_create(&Bus->Packet_Pool, "I2C packets", sizeof(tI2C_Packet), pool_area, pool_bytes) != TX_SUCCESS){
+        LOG_ERROR(I2C, "I2C_Init_Bus: packet pool create failed\r\n");
+        free(Bus);
+        free(pool_area);
+        return NULL;
+    }
+    Bus->Packets = (uint16_t)Bus->Packet_Pool.tx_block_pool_total;
+    Bus->Packets_Low = Bus->Packets;
+    if (tx_timer_create(&Bus->Timer, "I2C", I2C_Timer_Expired, (ULONG)Bus, 1, 0, TX_NO_ACTIVATE) != TX_SUCCESS){
+        LOG_ERROR(I2C, "I2C_Init_Bus: timer create failed\r\n");
+        tx_block_pool_delete(&Bus->Packet_Pool);
+        free(Bus);
+        free(pool_area);
+        return NULL;
+    }
+    if (!Registry_Add(I2C_Handle->Instance, eRegistry_I2C, Bus)){
+        LOG_ERROR(I2C, "I2C_Init_Bus: bus already owned\r\n");
+        tx_timer_delete(&Bus->Timer);
+        tx_block_pool_delete(&Bus->Packet_Pool);
+        free(Bus);
+        free(pool_area);
+        return NULL;
+    }
+    I2C_Setup_Bus(Bus);
+    Bus->Task_ID = Start_Task(I2C_Task, Bus, 0);
+    Set_Task_Name(Bus->Task_ID, "I2C Task"); // refer to Bus->Task_ID for task and match, don't peek name
+    i2c_buses[i2c_bus_count++] = Bus;
+    return Bus;
+}
+
+/**
+ * @brief: Adds a device at Device_Address to the bus of I2C_Handle. Devices are never removed.
+ *
+ * @params: I2C_Handle, Device_Address (HAL form, shifted left by one)
+ *
+ * @return: the device handle, NULL if the bus is full or out of memory
+ */
 tI2C * Init_I2C(I2C_HandleTypeDef * I2C_Handle, uint16_t Device_Address){
+    tI2C_Bus * Bus = I2C_Init_Bus(I2C_Handle, I2C_BUS_PACKETS);
+    if (Bus == NULL || Bus->Device_Count >= I2C_BUS_MAX_DEVICES){
+        LOG_ERROR(I2C, "Init_I2C: no room on the bus\r\n");
+        return NULL;
+    }
     tI2C * I2C = (tI2C *)malloc(sizeof(tI2C));
     if (I2C == NULL){
-        return NULL; 
+        LOG_ERROR(I2C, "Init_I2C: malloc failed\r\n");
+        return NULL;
     }
-    I2C->I2C_Handle = I2C_Handle; 
+    I2C->Bus = Bus;
+    I2C->I2C_Handle = I2C_Handle;
     I2C->Packet_Queue = Prep_Queue();
     I2C->Device_Address = Device_Address;
-    I2C->Busy_Flag = false;
+    I2C->Priority = I2C_PRIORITY_DEFAULT;
     I2C->Mode = eMode_Single;
-    I2C->Task_ID = Start_Task(I2C_Task, I2C, 0);
-    Set_Task_Name(I2C->Task_ID, "I2C Task"); // refer to I2C->Task_ID for task and match, don't peek name
     I2C->Continuous_Channel = NULL;
-    I2C->Current_Packet = NULL;
+    I2C->Packet_Wait = TX_NO_WAIT;
+    I2C->Coalesce = false;
+    I2C->Coalesce_Gap = 0;
+    I2C->Batch = false;
+    I2C->Retry_Packet = NULL;
+    I2C->Retry_Tick = 0;
+    I2C->Completed = 0;
+    I2C->Failed = 0;
+    I2C->Retries = 0;
+    if (tx_event_flags_create(&I2C->Events, "I2C") != TX_SUCCESS){
+        LOG_ERROR(I2C, "Init_I2C: event flags create failed\r\n");
+    }
+    tx_event_flags_set(&I2C->Events, I2C_EVENT_IDLE | I2C_EVENT_SPACE, TX_OR);
+
+    // the bus scans Devices[] without a lock, publish the device before the count that covers it
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Bus->Devices[Bus->Device_Count] = I2C;
+    Bus->Device_Count++;
+    __set_PRIMASK(primask);
     return I2C;
 }
 
-void Reset_I2C(tI2C * I2C){
-    Change_Single_Mode(I2C);  
+void I2C_Set_Priority(tI2C * I2C, uint8_t Priority){
+    I2C->Priority = Priority;
+}
 
-    if (!HAL_I2C_DeInit(I2C->I2C_Handle)){
-        return;
-    }
-	if (!HAL_I2C_Init(I2C->I2C_Handle)){
-        return;
-    }
+/* Ticks the queuing calls on this device wait for a free packet; TX_NO_WAIT (default) when they may
+ * run on the DEFER thread or an ISR, where waiting would hold up the completions that free packets */
+void I2C_Set_Packet_Wait(tI2C * I2C, ULONG Ticks){
+    I2C->Packet_Wait = Ticks;
+}
 
-    I2C->Busy_Flag = false;
+/**
+ * @brief: Lets the bus merge memory reads queued back to back on this device into one burst. The
+ * device must auto-increment its register address over a plain burst read.
+ *
+ * @params: I2C, Enable, Max_Gap registers between two reads the burst may read and throw away
+ *
+ * @return: None
+ */
+void I2C_Set_Coalescing(tI2C * I2C, bool Enable, uint8_t Max_Gap){
+    I2C->Coalesce_Gap = Max_Gap;
+    I2C->Coalesce = Enable;
+}
 
-    //handle the packet queue
-    while (I2C->Packet_Queue->Size > 0){
-        tI2C_Packet * Curr_Packet = (tI2C_Packet *)Dequeue(I2C->Packet_Queue);
-        free(Curr_Packet);
-        // curr_packet data and success flag will be freed by drivers independently
-        //i.e. if (flag_indic == true; else, free(data and flag))
-    }
-    free(I2C->Packet_Queue);
-    I2C->Packet_Queue = NULL;
-    I2C->Packet_Queue = Prep_Queue();
-    if (I2C->Packet_Queue == NULL){
-        return;
-    }    
+/* Holds the device's packets back from the bus, so a group queued next is there in full when the
+ * bus takes it and merges. I2C_Batch_End lets them go. */
+void I2C_Batch_Begin(tI2C * I2C){
+    I2C->Batch = true;
+}
 
-    if (I2C->Task_ID != NULL){
-        Halt_Task(I2C->Task_ID);
-        Delete_Task(I2C->Task_ID);
-    }
-    I2C->Task_ID = NULL;
-    I2C->Task_ID = Start_Task(I2C_Task, I2C, 0);
-    Set_Task_Name(I2C->Task_ID, "I2C Task"); // refer to I2C->Task_ID for task and match, don't peek name
+void I2C_Batch_End(tI2C * I2C){
+    I2C->Batch = false;
+    I2C_Engine_Kick(I2C->Bus);
+}
 
-    if (I2C->Task_ID != NULL){
-        return;
+/**
+ * @brief: Leaves continuous mode, drops the device's queued and parked packets and recovers the bus.
+ * The op on the bus, whichever device it belongs to, is reported failed. Other devices keep their
+ * queues. The bus recovers from errors and hangs by itself; this is for throwing a device's work away.
+ */
+void Reset_I2C(tI2C * I2C){
+    tI2C_Bus * Bus = I2C->Bus;
+
+    Change_Single_Mode(I2C);
+    I2C_Drop_Packets(I2C);
+
+    // a hung op never hands the bus back: after waiting, take it from the HAL
+    if (!I2C_Bus_Acquire(Bus, I2C_RESET_TICKS)){
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        Bus->State = eI2C_Starting;
+        __set_PRIMASK(primask);
+        LOG_WARN(I2C, "Reset_I2C: took the bus from a hung op\r\n");
     }
-    else {
-        return; //(need to try again)
+    I2C_Bus_Recover(Bus);
+
+    // the op that was running is gone with the peripheral state
+    if (Bus->Current_Packet != NULL){
+        I2C_Engine_Report(Bus, false);
     }
+    I2C_Engine_Next(Bus);
 }
 
 bool Change_Single_Mode(tI2C * I2C){
@@ -70,47 +229,158 @@ bool Change_Single_Mode(tI2C * I2C){
         return true;
     }
     else {
+        // stop the trigger while still in continuous mode, so a burst on the bus lands normally
+        I2C_Continuous_Stop(I2C);
         I2C->Mode = eMode_Single;
-        I2C->Busy_Flag = false;
-        
-        HAL_DMA_Abort(I2C->I2C_Handle->hdmatx);
-        HAL_DMA_Abort(I2C->I2C_Handle->hdmarx);
-        HAL_I2C_DMAStop(I2C->I2C_Handle);
-        HAL_DMA_DeInit(I2C->I2C_Handle->hdmarx);
-        HAL_DMA_DeInit(I2C->I2C_Handle->hdmatx);
-
-        HAL_DMA_Init(I2C->I2C_Handle->hdmarx);
-        HAL_DMA_Init(I2C->I2C_Handle->hdmatx);
-        __HAL_LINKDMA(I2C->I2C_Handle, hdmarx, *I2C->I2C_Handle->hdmarx);
-        __HAL_LINKDMA(I2C->I2C_Handle, hdmatx, *I2C->I2C_Handle->hdmatx);
-
-        __HAL_I2C_ENABLE_DMA(I2C->I2C_Handle);
 
         memset(I2C->Continuous_Channel->Data, 0, I2C->Continuous_Channel->Buffer_Size);
+        I2C_Engine_Kick(I2C->Bus);
         return true;
     }
 }
 
+/**
+ * @brief: Drops the device's queued packets and starts sampling with Channel: every tick of its
+ * trigger timer reads one register burst into the half of Data being filled. Other devices on the
+ * bus keep running their packets between bursts.
+ *
+ * @params: I2C, Channel set up with I2C_Continuous_Channel_Init
+ *
+ * @return: false if the channel is not set up or the timer cannot run at its rate
+ */
 bool Change_Continuous_Mode(tI2C * I2C, tI2C_Continuous_Channel * Channel){
     if (I2C->Mode == eMode_Continuous){
         return true;
     }
     else{
-        Reset_I2C(I2C);
-        I2C->Mode = eMode_Continuous;
+        if (Channel == NULL || Channel->Trigger_Timer == NULL || Channel->Half_Size == 0){
+            return false;
+        }
+        I2C_Drop_Packets(I2C);
         I2C->Continuous_Channel = Channel;
-        I2C->Busy_Flag = false;
-        I2C->Packet_Queue = Prep_Queue();
-        if (I2C->Packet_Queue == NULL){
+        Channel->Fill_Half = 0;
+        Channel->Fill_Count = 0;
+        Channel->Read_Idx = 0;
+        Channel->Buffer_Ready = false;
+        I2C->Mode = eMode_Continuous;
+        if (!I2C_Continuous_Start(I2C)){
+            I2C->Mode = eMode_Single;
             return false;
         }
         return true;
     }
 }
-    
 
+/**
+ * @brief: Sets up a continuous channel. Data is used as two halves of whole bursts; while the
+ * trigger fills one, the other is the consumer's.
+ *
+ * @params: Channel, Memory_Address / Memory_Address_Size first register of the burst,
+ * Burst_Size bytes read per trigger, Data / Buffer_Size the ping-pong buffer (at least two bursts),
+ * Trigger_Timer an LPTIM left to this channel, Rate_Hz bursts per second,
+ * Complete_CallBack called on the DEFER thread for every filled half (NULL for none)
+ *
+ * @return: false if the buffer cannot hold a burst per half
+ */
+bool I2C_Continuous_Channel_Init(tI2C_Continuous_Channel * Channel, uint16_t Memory_Address, uint16_t Memory_Address_Size,
+                                 uint16_t Burst_Size, uint8_t * Data, uint16_t Buffer_Size, LPTIM_HandleTypeDef * Trigger_Timer,
+                                 uint32_t Rate_Hz, void (*Complete_CallBack)(void *), void * CallBack_Data){
+    if (Data == NULL || Trigger_Timer == NULL || Burst_Size == 0 || Rate_Hz == 0 || Buffer_Size / 2 < Burst_Size){
+        return false;
+    }
+    memset(Channel, 0, sizeof(*Channel));
+    Channel->Memory_Address = Memory_Address;
+    Channel->Memory_Address_Size = Memory_Address_Size;
+    Channel->Data = Data;
+    Channel->Buffer_Size = Buffer_Size;
+    Channel->Burst_Size = Burst_Size;
+    Channel->Half_Size = (Buffer_Size / 2 / Burst_Size) * Burst_Size;
+    Channel->Trigger_Timer = Trigger_Timer;
+    Channel->Rate_Hz = Rate_Hz;
+    Channel->Complete_CallBack = Complete_CallBack;
+    Channel->CallBack_Data = CallBack_Data;
+    return true;
+}
+
+/* Consumer is done with the half at Read_Idx; the next filled half no longer counts an overrun */
+void I2C_Continuous_Release(tI2C_Continuous_Channel * Channel){
+    Channel->Buffer_Ready = false;
+}
+
+/**
+ * @brief: Runs the trigger timer at the channel rate. The LPTIM counter is 16 bits, so the smallest
+ * prescaler that fits the period is used; the rate is exact when the timer clock divides by it.
+ */
+static bool I2C_Continuous_Start(tI2C * I2C){
+    tI2C_Continuous_Channel * Channel = I2C->Continuous_Channel;
+    LPTIM_HandleTypeDef * timer = Channel->Trigger_Timer;
+    uint32_t clock = HAL_RCCEx_GetPeriphCLKFreq((timer->Instance == LPTIM2) ? RCC_PERIPHCLK_LPTIM2 : RCC_PERIPHCLK_LPTIM1);
+    uint32_t shift = 0;
+
+    while (shift < 7 && clock / (Channel->Rate_Hz << shift) > 0x10000U){
+        shift++;
+    }
+    uint32_t ticks = (clock + ((Channel->Rate_Hz << shift) / 2)) / (Channel->Rate_Hz << shift);
+    if (ticks < 2 || ticks > 0x10000U){
+        LOG_ERROR(I2C, "continuous rate %lu Hz out of timer range\r\n", Channel->Rate_Hz);
+        return false;
+    }
+    if (!Registry_Add(timer->Instance, eRegistry_I2C_Trigger, I2C)){
+        LOG_ERROR(I2C, "continuous trigger timer already in use\r\n");
+        return false;
+    }
+    Channel->Op_Ticks = I2C_Op_Ticks(I2C->Bus, Channel->Burst_Size);
+    timer->Init.Clock.Prescaler = shift << LPTIM_CFGR_PRESC_Pos;
+    if (HAL_LPTIM_Init(timer) != HAL_OK){
+        Registry_Remove(timer->Instance, I2C);
+        return false;
+    }
+    HAL_NVIC_SetPriority(I2C_Trigger_IRQn(timer), I2C_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(I2C_Trigger_IRQn(timer));
+    if (HAL_LPTIM_Counter_Start_IT(timer, ticks - 1) != HAL_OK){
+        HAL_NVIC_DisableIRQ(I2C_Trigger_IRQn(timer));
+        Registry_Remove(timer->Instance, I2C);
+        return false;
+    }
+    LOG_INFO(I2C, "addr 0x%02X continuous at %lu Hz (%lu ticks, prescaler %u)\r\n", I2C->Device_Address, (clock >> shift) / ticks, ticks, 1U << shift);
+    return true;
+}
+
+static void I2C_Continuous_Stop(tI2C * I2C){
+    tI2C_Continuous_Channel * Channel = I2C->Continuous_Channel;
+    tI2C_Bus * Bus = I2C->Bus;
+    if (Channel == NULL || Channel->Trigger_Timer == NULL){
+        return;
+    }
+    HAL_LPTIM_Counter_Stop_IT(Channel->Trigger_Timer);
+    HAL_NVIC_DisableIRQ(I2C_Trigger_IRQn(Channel->Trigger_Timer));
+    Registry_Remove(Channel->Trigger_Timer->Instance, I2C);
+
+    // let a burst already on the bus land in the buffer
+    for (uint8_t i = 0; i < I2C_CONTINUOUS_STOP_TICKS && Bus->Active == I2C && Bus->State == eI2C_Transfer
+                        && Bus->Current_Packet == NULL; i++){
+        tx_thread_sleep(1);
+    }
+    if (Bus->Active == I2C && Bus->State == eI2C_Transfer && Bus->Current_Packet == NULL){
+        LOG_WARN(I2C, "addr 0x%02X burst did not finish on stop, Reset_I2C frees the bus\r\n", I2C->Device_Address);
+    }
+}
+
+static IRQn_Type I2C_Trigger_IRQn(const LPTIM_HandleTypeDef * Timer){
+    return (Timer->Instance == LPTIM2) ? LPTIM2_IRQn : LPTIM1_IRQn;
+}
+
+/**
+ * @brief: Blocking ops for callers that cannot continue without the result (init code, the console).
+ * They take the bus like a queued packet, run the polling HAL op and hand the bus back, which starts
+ * whatever was queued meanwhile. Timeout covers the wait for the bus and the op, each in ms.
+ */
 bool I2C_Blocking_Write(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint32_t Timeout){
+    if (!I2C_Bus_Acquire(I2C->Bus, Timeout)){
+        return false;
+    }
     HAL_StatusTypeDef res = HAL_I2C_Master_Transmit(I2C->I2C_Handle, I2C->Device_Address, Data, Data_Size, Timeout);
+    I2C_Engine_Next(I2C->Bus);
     if (res != HAL_OK){
         return false;
     }
@@ -120,7 +390,11 @@ bool I2C_Blocking_Write(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint32_t
 }
 
 bool I2C_Blocking_Read(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint32_t Timeout){
+    if (!I2C_Bus_Acquire(I2C->Bus, Timeout)){
+        return false;
+    }
     HAL_StatusTypeDef res = HAL_I2C_Master_Receive(I2C->I2C_Handle, I2C->Device_Address, Data, Data_Size, Timeout);
+    I2C_Engine_Next(I2C->Bus);
     if (res != HAL_OK){
         return false;
     }
@@ -130,7 +404,11 @@ bool I2C_Blocking_Read(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint32_t
 }
 
 bool I2C_Blocking_Memory_Write(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint32_t Timeout){
+    if (!I2C_Bus_Acquire(I2C->Bus, Timeout)){
+        return false;
+    }
     HAL_StatusTypeDef res = HAL_I2C_Mem_Write(I2C->I2C_Handle, I2C->Device_Address, Memory_Address, Memory_Address_Size, Data, Data_Size, Timeout);
+    I2C_Engine_Next(I2C->Bus);
     if (res != HAL_OK){
         return false;
     }
@@ -140,7 +418,11 @@ bool I2C_Blocking_Memory_Write(tI2C * I2C, uint16_t Memory_Address, uint16_t Mem
 }
 
 bool I2C_Blocking_Memory_Read(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint32_t Timeout){
+    if (!I2C_Bus_Acquire(I2C->Bus, Timeout)){
+        return false;
+    }
     HAL_StatusTypeDef res = HAL_I2C_Mem_Read(I2C->I2C_Handle, I2C->Device_Address, Memory_Address, Memory_Address_Size, Data, Data_Size, Timeout);
+    I2C_Engine_Next(I2C->Bus);
     if (res != HAL_OK){
         return false;
     }
@@ -149,155 +431,957 @@ bool I2C_Blocking_Memory_Read(tI2C * I2C, uint16_t Memory_Address, uint16_t Memo
     }
 }
 
-bool I2C_Read(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success){
-    tI2C_Packet * Packet = (tI2C_Packet *)malloc(sizeof(tI2C_Packet));
+bool I2C_Regs_Read(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size){
+    return I2C_Blocking_Memory_Read((tI2C *)Device, Reg, I2C_MEMADD_SIZE_8BIT, Data, Size, I2C_REGS_TIMEOUT);
+}
+
+bool I2C_Regs_Write(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size){
+    return I2C_Blocking_Memory_Write((tI2C *)Device, Reg, I2C_MEMADD_SIZE_8BIT, Data, Size, I2C_REGS_TIMEOUT);
+}
+
+/**
+ * @brief: Fills a pool packet for I2C and queues it; what every queuing call comes down to.
+ *
+ * @params: I2C, Op_type, Memory_Address / Memory_Address_Size (memory ops), Data / Data_Size,
+ * Tries_timeout, Success (may be NULL), Txn handle completed with the packet (may be NULL)
+ *
+ * @return: false if the pool is empty or the queue refused the packet
+ */
+static bool I2C_Queue_Op(tI2C * I2C, eOp_Type Op_type, uint16_t Memory_Address, uint16_t Memory_Address_Size,
+                         uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success, tTxn * Txn){
+    tI2C_Packet * Packet = I2C_Packet_Alloc(I2C);
     if (Packet == NULL){
         return false;
     }
-    Packet->Op_type = eI2C_Read;
+    Packet->Op_type = Op_type;
+    Packet->Memory_Address = Memory_Address;
+    Packet->Memory_Address_Size = Memory_Address_Size;
     Packet->Data = Data;
     Packet->Data_Size = Data_Size;
     Packet->Complete_CallBack = NULL;
     Packet->CallBack_Data = NULL;
     Packet->Tries_timeout = Tries_timeout;
     Packet->Success = Success;
-    if (Enqueue(I2C->Packet_Queue, (void *)Packet)){
-        return true;
-    }
-    else {
-        return false;
-    }
-
+    Packet->Txn = Txn;
+    Packet->Finish_CallBack = NULL;
+    return I2C_Submit(I2C, Packet);
 }
 
+bool I2C_Read(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success){
+    return I2C_Queue_Op(I2C, eI2C_SingleRead, 0, 0, Data, Data_Size, Tries_timeout, Success, NULL);
+}
 
 bool I2C_Callback_Read(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success, void (*Complete_CallBack)(void *), void * CallBack_Data){
-    tI2C_Packet * Packet = (tI2C_Packet *)malloc(sizeof(tI2C_Packet));
+    tI2C_Packet * Packet = I2C_Packet_Alloc(I2C);
     if (Packet == NULL){
         return false;
     }
-    Packet->Op_type = eI2C_Read;
+    Packet->Op_type = eI2C_SingleRead;
     Packet->Data = Data;
     Packet->Data_Size = Data_Size;
-    Packet->Complete_CallBack = NULL;
-    Packet->CallBack_Data = NULL;
     Packet->Tries_timeout = Tries_timeout;
     Packet->Success = Success;
     Packet->Complete_CallBack = Complete_CallBack;
     Packet->CallBack_Data = CallBack_Data;
-    if (Enqueue(I2C->Packet_Queue, (void *)Packet)){
-        return true;
-    }
-    else { 
-        return false;
-    }
+    Packet->Txn = NULL;
+    Packet->Finish_CallBack = NULL;
+    return I2C_Submit(I2C, Packet);
 }
 
-bool I2C_Memory_Read(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success){
-    tI2C_Packet * Packet = (tI2C_Packet *)malloc(sizeof(tI2C_Packet));
+/**
+ * @brief: Queues an op whose Finish_CallBack runs when it is over either way - done, failed after
+ * its tries, or dropped - with OK telling which. For drivers that chain ops from completions, like
+ * the script executor (I2C_Script.h). The callback runs on the DEFER thread with the bus held:
+ * queuing the next op from it starts that op straight after, without waking any thread.
+ *
+ * @return: false if the pool is empty or the queue refused the packet (no callback then)
+ */
+bool I2C_Queue_Notify(tI2C * I2C, eOp_Type Op_type, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size,
+                      uint8_t Tries_timeout, void (*Finish_CallBack)(void *, bool), void * CallBack_Data){
+    tI2C_Packet * Packet = I2C_Packet_Alloc(I2C);
     if (Packet == NULL){
         return false;
     }
-    Packet->Op_type = eI2C_MemRead;
-    Packet->Memory_Address = Memory_Address;;
+    Packet->Op_type = Op_type;
+    Packet->Memory_Address = Memory_Address;
     Packet->Memory_Address_Size = Memory_Address_Size;
     Packet->Data = Data;
     Packet->Data_Size = Data_Size;
     Packet->Complete_CallBack = NULL;
-    Packet->CallBack_Data = NULL;
+    Packet->CallBack_Data = CallBack_Data;
     Packet->Tries_timeout = Tries_timeout;
-    Packet->Success = Success;
-    if (Enqueue(I2C->Packet_Queue, (void *)Packet)){
-        return true;
+    Packet->Success = NULL;
+    Packet->Txn = NULL;
+    Packet->Finish_CallBack = Finish_CallBack;
+    return I2C_Submit(I2C, Packet);
+}
+
+bool I2C_Memory_Read(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success){
+    return I2C_Queue_Op(I2C, eI2C_MemRead, Memory_Address, Memory_Address_Size, Data, Data_Size, Tries_timeout, Success, NULL);
+}
+
+bool I2C_Memory_Write(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success){
+    return I2C_Queue_Op(I2C, eI2C_MemWrite, Memory_Address, Memory_Address_Size, Data, Data_Size, Tries_timeout, Success, NULL);
+}
+
+/* Takes a handle of Set and queues the op with it; the handle goes back if the op is not queued */
+static tTxn * I2C_Queue_Txn(tI2C * I2C, tTxn_Set * Set, eOp_Type Op_type, uint16_t Memory_Address, uint16_t Memory_Address_Size,
+                            uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout){
+    tTxn * Txn = Txn_Open(Set);
+    if (Txn == NULL){
+        return NULL;
     }
-    else { 
-        return false;
+    if (!I2C_Queue_Op(I2C, Op_type, Memory_Address, Memory_Address_Size, Data, Data_Size, Tries_timeout, NULL, Txn)){
+        Txn_Complete(Txn, false);
+        Txn_Release(Txn);
+        return NULL;
     }
+    return Txn;
 }
 
-bool I2C_Memory_Write(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success){
-    tI2C_Packet * Packet = (tI2C_Packet *)malloc(sizeof(tI2C_Packet));
-    if (Packet == NULL){
+/**
+ * @brief: Queuing calls that return a handle to wait on (see Txn/txn.h) instead of taking a Success
+ * flag. The handle completes, waking its waiter, after Data holds the result; merged reads and
+ * retries behave as for the other calls.
+ *
+ * @return: the handle, NULL if Set has no free handle or the op could not be queued
+ */
+tTxn * I2C_Read_Txn(tI2C * I2C, tTxn_Set * Set, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout){
+    return I2C_Queue_Txn(I2C, Set, eI2C_SingleRead, 0, 0, Data, Data_Size, Tries_timeout);
+}
+
+tTxn * I2C_Write_Txn(tI2C * I2C, tTxn_Set * Set, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout){
+    return I2C_Queue_Txn(I2C, Set, eI2C_Write, 0, 0, Data, Data_Size, Tries_timeout);
+}
+
+tTxn * I2C_Memory_Read_Txn(tI2C * I2C, tTxn_Set * Set, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout){
+    return I2C_Queue_Txn(I2C, Set, eI2C_MemRead, Memory_Address, Memory_Address_Size, Data, Data_Size, Tries_timeout);
+}
+
+tTxn * I2C_Memory_Write_Txn(tI2C * I2C, tTxn_Set * Set, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout){
+    return I2C_Queue_Txn(I2C, Set, eI2C_MemWrite, Memory_Address, Memory_Address_Size, Data, Data_Size, Tries_timeout);
+}
+
+/**
+ * @brief: Scheduler task, one per bus. Packets are started and finished from the HAL callbacks, the
+ * DEFER thread and the bus timer, so this only finishes a completion the DEFER ring had no room for
+ * and runs the hang check and retries a lost timer post would have. It never waits on the bus.
+ */
+void I2C_Task(tI2C_Bus * Bus){
+    if (Bus->State == eI2C_Complete){
+        I2C_Engine_Complete(Bus);
+    }
+    I2C_Bus_Check(Bus);
+}
+
+/**
+ * @brief: Gives the bus its event/error interrupts and, where a channel is free, DMA for both
+ * directions. DMA handles already linked by CubeMX are kept; without a channel ops run on _IT.
+ */
+static void I2C_Setup_Bus(tI2C_Bus * Bus){
+    I2C_HandleTypeDef * hi2c = Bus->I2C_Handle;
+    IRQn_Type ev_irq;
+    IRQn_Type er_irq;
+    eDMA_Request rx_request;
+    eDMA_Request tx_request;
+
+    if (hi2c->Instance == I2C1){
+        ev_irq = I2C1_EV_IRQn;
+        er_irq = I2C1_ER_IRQn;
+        rx_request = eDMA_I2C1_RX;
+        tx_request = eDMA_I2C1_TX;
+        Bus->SCL_Port = GPIOB;
+        Bus->SCL_Pin = GPIO_PIN_8;
+        Bus->SDA_Port = GPIOB;
+        Bus->SDA_Pin = GPIO_PIN_7;
+    } else if (hi2c->Instance == I2C3){
+        ev_irq = I2C3_EV_IRQn;
+        er_irq = I2C3_ER_IRQn;
+        rx_request = eDMA_I2C3_RX;
+        tx_request = eDMA_I2C3_TX;
+        Bus->SCL_Port = GPIOC;
+        Bus->SCL_Pin = GPIO_PIN_0;
+        Bus->SDA_Port = GPIOC;
+        Bus->SDA_Pin = GPIO_PIN_1;
+    } else {
+        LOG_WARN(I2C, "no interrupts set up for bus at 0x%08lX\r\n", (uint32_t)hi2c->Instance);
+        return;
+    }
+
+    if (hi2c->hdmarx == NULL){
+        DMA_HandleTypeDef * rx = DMA_Allocate(rx_request, DMA_NORMAL, DMA_PRIORITY_MEDIUM);
+        if (rx != NULL){
+            __HAL_LINKDMA(hi2c, hdmarx, *rx);
+        }
+    }
+    if (hi2c->hdmatx == NULL){
+        DMA_HandleTypeDef * tx = DMA_Allocate(tx_request, DMA_NORMAL, DMA_PRIORITY_MEDIUM);
+        if (tx != NULL){
+            __HAL_LINKDMA(hi2c, hdmatx, *tx);
+        }
+    }
+    HAL_NVIC_SetPriority(ev_irq, I2C_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(ev_irq);
+    HAL_NVIC_SetPriority(er_irq, I2C_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(er_irq);
+}
+
+/**
+ * @brief: Takes a packet from the bus pool in constant time. An empty pool is backpressure, not an
+ * error: the device's I2C_EVENT_SPACE is cleared so the caller can sleep on it until a packet comes
+ * back, and Backpressure counts the refusals. Waits Packet_Wait ticks for a packet first (thread
+ * context only when non-zero).
+ */
+static tI2C_Packet * I2C_Packet_Alloc(tI2C * I2C){
+    tI2C_Bus * Bus = I2C->Bus;
+    tI2C_Packet * Packet = NULL;
+
+    if (tx_block_allocate(&Bus->Packet_Pool, (VOID **)&Packet, I2C->Packet_Wait) != TX_SUCCESS){
+        tx_event_flags_set(&I2C->Events, ~I2C_EVENT_SPACE, TX_AND);
+        Bus->Space_Wanted = true;
+        Bus->Backpressure++;
+        // a packet released between the failed allocate and the clear would leave the flag down
+        if (Bus->Packet_Pool.tx_block_pool_available > 0){
+            tx_event_flags_set(&I2C->Events, I2C_EVENT_SPACE, TX_OR);
+        }
+        return NULL;
+    }
+    Packet->Next = NULL;
+    Packet->Burst_Size = 0;
+    Packet->Attempts = 0;
+    uint16_t available = (uint16_t)Bus->Packet_Pool.tx_block_pool_available;
+    if (available < Bus->Packets_Low){
+        Bus->Packets_Low = available;
+    }
+    return Packet;
+}
+
+/* Back to the pool; devices turned away while it was empty get I2C_EVENT_SPACE */
+static void I2C_Packet_Free(tI2C_Bus * Bus, tI2C_Packet * Packet){
+    tx_block_release(Packet);
+    if (Bus->Space_Wanted){
+        Bus->Space_Wanted = false;
+        for (uint8_t i = 0; i < Bus->Device_Count; i++){
+            tx_event_flags_set(&Bus->Devices[i]->Events, I2C_EVENT_SPACE, TX_OR);
+        }
+    }
+}
+
+static bool I2C_Submit(tI2C * I2C, tI2C_Packet * Packet){
+    if (!Enqueue(I2C->Packet_Queue, (void *)Packet)){
+        I2C_Packet_Free(I2C->Bus, Packet);
         return false;
     }
-    Packet->Op_type = eI2C_MemWrite;
-    Packet->Memory_Address = Memory_Address;;
-    Packet->Memory_Address_Size = Memory_Address_Size;
-    Packet->Data = Data;
-    Packet->Data_Size = Data_Size;
-    Packet->Complete_CallBack = NULL;
-    Packet->CallBack_Data = NULL;
-    Packet->Tries_timeout = Tries_timeout;
-    Packet->Success = Success;
-    if (Enqueue(I2C->Packet_Queue, (void *)Packet)){
-        return true;
+    tx_event_flags_set(&I2C->Events, ~I2C_EVENT_IDLE, TX_AND);
+    I2C_Engine_Kick(I2C->Bus);
+    return true;
+}
+
+/* A packet thrown away unfinished: its waiter sees it failed */
+static void I2C_Packet_Dropped(tI2C_Bus * Bus, tI2C_Packet * Packet){
+    if (Packet->Finish_CallBack != NULL){
+        Packet->Finish_CallBack(Packet->CallBack_Data, false);
+    }
+    if (Packet->Txn != NULL){
+        Txn_Complete(Packet->Txn, false);
+    }
+    I2C_Packet_Free(Bus, Packet);
+}
+
+static void I2C_Drop_Packets(tI2C * I2C){
+    tI2C_Packet * Packet = I2C_Take_Retry(I2C);
+    // Data and Success belong to the callers; a parked retry may head a merged burst
+    while (Packet != NULL){
+        tI2C_Packet * next = Packet->Next;
+        I2C_Packet_Dropped(I2C->Bus, Packet);
+        Packet = next;
+    }
+    while ((Packet = (tI2C_Packet *)Dequeue(I2C->Packet_Queue)) != NULL){
+        I2C_Packet_Dropped(I2C->Bus, Packet);
+    }
+    tx_event_flags_set(&I2C->Events, I2C_EVENT_IDLE, TX_OR);
+}
+
+/* Moves State from From to To if it is still From. Whoever wins Idle -> Starting or
+ * Complete -> Starting holds the bus until it hands it to the HAL or back to Idle. */
+static bool I2C_Claim(tI2C_Bus * Bus, eI2C_State From, eI2C_State To){
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool claimed = (Bus->State == From);
+    if (claimed){
+        Bus->State = To;
+    }
+    __set_PRIMASK(primask);
+    return claimed;
+}
+
+/* Thread context: holds the bus (Starting) once it is idle. I2C_Engine_Next hands it back. */
+static bool I2C_Bus_Acquire(tI2C_Bus * Bus, uint32_t Timeout){
+    ULONG start = tx_time_get();
+    while (!I2C_Claim(Bus, eI2C_Idle, eI2C_Starting)){
+        if (tx_time_get() - start >= Timeout){
+            return false;
+        }
+        tx_thread_sleep(1);
     }
-    else { 
+    return true;
+}
+
+/* Unparks the device's retry; whoever gets it non-NULL owns it (engine or I2C_Drop_Packets) */
+static tI2C_Packet * I2C_Take_Retry(tI2C * I2C){
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    tI2C_Packet * Packet = I2C->Retry_Packet;
+    I2C->Retry_Packet = NULL;
+    __set_PRIMASK(primask);
+    return Packet;
+}
+
+/* In single mode, not holding a batch, and with a packet that may go now: a parked retry once its
+ * backoff has run out (the queue waits behind it), otherwise the head of the queue */
+static bool I2C_Device_Ready(tI2C * I2C, ULONG Now){
+    if (I2C->Mode != eMode_Single || I2C->Batch){
         return false;
     }
+    if (I2C->Retry_Packet != NULL){
+        return (LONG)(Now - I2C->Retry_Tick) >= 0;
+    }
+    return I2C->Packet_Queue->Size > 0;
 }
 
-void I2C_Task(tI2C * I2C){
-    if (I2C->Busy_Flag){
-        return;
+/* Some device has a packet that may go now */
+static bool I2C_Bus_Pending(tI2C_Bus * Bus){
+    ULONG now = tx_time_get();
+    for (uint8_t i = 0; i < Bus->Device_Count; i++){
+        if (I2C_Device_Ready(Bus->Devices[i], now)){
+            return true;
+        }
     }
-    if (I2C->Mode == eMode_Single){
-        if (I2C->Current_Packet == NULL){
-            if (I2C->Packet_Queue->Size > 0){
-                I2C->Busy_Flag = true;
-                I2C->Current_Packet = (tI2C_Packet *)Dequeue(I2C->Packet_Queue);
-                I2C->Busy_Flag = false;
+    return false;
+}
+
+/**
+ * @brief: Picks the device whose packet goes next: the lowest Priority value with a packet ready,
+ * and among equals the first one after the device served last, so a busy device cannot starve its
+ * peers. Devices in continuous mode, holding a batch or backing off are skipped.
+ */
+static tI2C * I2C_Bus_Pick(tI2C_Bus * Bus){
+    tI2C * pick = NULL;
+    uint8_t pick_index = 0;
+    ULONG now = tx_time_get();
+
+    for (uint8_t n = 1; n <= Bus->Device_Count; n++){
+        uint8_t index = (uint8_t)((Bus->Last_Served + n) % Bus->Device_Count);
+        tI2C * device = Bus->Devices[index];
+        if (!I2C_Device_Ready(device, now)){
+            continue;
+        }
+        if (pick == NULL || device->Priority < pick->Priority){
+            pick = device;
+            pick_index = index;
+        }
+    }
+    if (pick != NULL){
+        Bus->Last_Served = pick_index;
+    }
+    return pick;
+}
+
+static void I2C_Engine_Kick(tI2C_Bus * Bus){
+    if (I2C_Claim(Bus, eI2C_Idle, eI2C_Starting)){
+        I2C_Engine_Next(Bus);
+    }
+}
+
+/**
+ * @brief: Reports Current_Packet, and every read merged into its burst, to its device (Success,
+ * Complete_CallBack, Events, counters) and frees them. A merged burst is copied out of the bus
+ * buffer into each caller's Data first, bounded by the Burst_Size the head packet carries.
+ */
+static void I2C_Engine_Report(tI2C_Bus * Bus, bool OK){
+    tI2C * I2C = Bus->Active;
+    tI2C_Packet * Packet = Bus->Current_Packet;
+    bool merged = (Packet->Next != NULL);
+    uint16_t base = Packet->Memory_Address;
+    uint16_t burst = I2C_Op_Size(Packet);
+
+    while (Packet != NULL){
+        tI2C_Packet * next = Packet->Next;
+        bool ok = OK;
+        if (ok && merged){
+            // a read the burst did not cover fails rather than get stale buffer bytes
+            uint32_t offset = (uint32_t)(Packet->Memory_Address - base);
+            ok = (offset + Packet->Data_Size <= burst);
+            if (ok){
+                memcpy(Packet->Data, &Bus->Burst_Buffer[offset], Packet->Data_Size);
             }
+        }
+        if (Packet->Success != NULL){
+            *Packet->Success = ok;
+        }
+        if (ok && Packet->Complete_CallBack != NULL){
+            Packet->Complete_CallBack(Packet->CallBack_Data);
+        }
+        if (Packet->Finish_CallBack != NULL){
+            Packet->Finish_CallBack(Packet->CallBack_Data, ok);
+        }
+        if (Packet->Txn != NULL){
+            Txn_Complete(Packet->Txn, ok);
+        }
+        if (ok){
+            I2C->Completed++;
         } else {
-            switch (I2C->Current_Packet->Op_type){
-                I2C->Busy_Flag = true;
-                case eI2C_Write:
-                case eI2C_SingleRead:
-                case eI2C_MemWrite:
-                case eI2C_MemRead:
-                static uint8_t I2C_Single_Attempts = 0;
-                if (I2C_Single_Attempts < I2C->Current_Packet->Tries_timeout){
-                    I2C_Single_Attempts++;
-                    bool op_flag = false;
-                    if (I2C->Current_Packet->Op_type == eI2C_Write){
-                        if (HAL_I2C_Master_Transmit(I2C->I2C_Handle, I2C->Device_Address, I2C->Current_Packet->Data, I2C->Current_Packet->Data_Size, 1000) == HAL_OK){
-                            op_flag = true;
-                        }
-                    }
-                    else if (I2C->Current_Packet->Op_type == eI2C_SingleRead){
-                        if (HAL_I2C_Master_Receive_DMA(I2C->I2C_Handle, I2C->Device_Address, I2C->Current_Packet->Data, I2C->Current_Packet->Data_Size) == HAL_OK){
-                            op_flag = true;
-                        }
-                    } else if (I2C->Current_Packet->Op_type == eI2C_MemWrite){
-                        if (HAL_I2C_Mem_Write(I2C->I2C_Handle, I2C->Device_Address, I2C->Current_Packet->Memory_Address, I2C->Current_Packet->Memory_Address_Size, I2C->Current_Packet->Data, I2C->Current_Packet->Data_Size, 1000) == HAL_OK){
-                            op_flag = true;
-                        }
-                    } else if (I2C->Current_Packet->Op_type == eI2C_MemRead){
-                        if (HAL_I2C_Mem_Read(I2C->I2C_Handle, I2C->Device_Address, I2C->Current_Packet->Memory_Address, I2C->Current_Packet->Memory_Address_Size, I2C->Current_Packet->Data, I2C->Current_Packet->Data_Size, 1000) == HAL_OK){
-                            op_flag = true;
-                        }
-                    }
+            I2C->Failed++;
+        }
+        I2C_Packet_Free(Bus, Packet);
+        Packet = next;
+    }
+    Bus->Current_Packet = NULL;
+    tx_event_flags_set(&I2C->Events, OK ? I2C_EVENT_DONE : I2C_EVENT_ERROR, TX_OR);
+    if (I2C->Packet_Queue->Size == 0){
+        tx_event_flags_set(&I2C->Events, I2C_EVENT_IDLE, TX_OR);
+    }
+}
 
-                    if (op_flag){
-                        I2C_Single_Attempts = 0;
-                        I2C->Busy_Flag = false;
-                        I2C->Current_Packet->Success = true;
-                        if (I2C->Current_Packet->Complete_CallBack != NULL){
-                            I2C->Current_Packet->Complete_CallBack(I2C->Current_Packet->CallBack_Data);
-                        }
+/**
+ * @brief: Settles Current_Packet after an attempt. Errors that point at the bus rather than the
+ * device (bus error, lost arbitration, timeout, the line left busy) recover the bus first. A failure
+ * with tries left parks the packet on its device for I2C_RETRY_BACKOFF_TICKS, doubled for every
+ * attempt after the first, and leaves the bus to the others; the bus timer brings it back.
+ */
+static void I2C_Engine_Finish(tI2C_Bus * Bus){
+    tI2C * I2C = Bus->Active;
+    tI2C_Packet * Packet = Bus->Current_Packet;
+
+    if (!Bus->Transfer_OK){
+        LOG_TRACE(I2C, "addr 0x%02X op %d attempt %u failed, error 0x%08lX\r\n", I2C->Device_Address, Packet->Op_type, Packet->Attempts, Bus->Bus_Error);
+        if ((Bus->Bus_Error & (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO | HAL_I2C_ERROR_TIMEOUT)) != 0
+            || __HAL_I2C_GET_FLAG(Bus->I2C_Handle, I2C_FLAG_BUSY)){
+            I2C_Bus_Recover(Bus);
+        }
+        if (Packet->Attempts < Packet->Tries_timeout){
+            ULONG backoff = I2C_RETRY_BACKOFF_MAX;
+            if (Packet->Attempts <= 8){
+                backoff = (ULONG)I2C_RETRY_BACKOFF_TICKS << (Packet->Attempts - 1);
+            }
+            if (backoff > I2C_RETRY_BACKOFF_MAX){
+                backoff = I2C_RETRY_BACKOFF_MAX;
+            }
+            I2C->Retry_Tick = tx_time_get() + backoff;
+            I2C->Retry_Packet = Packet;
+            I2C->Retries++;
+            Bus->Current_Packet = NULL;
+            return;
+        }
+        LOG_WARN(I2C, "addr 0x%02X op %d gave up after %u tries\r\n", I2C->Device_Address, Packet->Op_type, Packet->Attempts);
+    }
+    I2C_Engine_Report(Bus, Bus->Transfer_OK);
+}
+
+/**
+ * @brief: Runs holding the bus (State Starting). Starts the next packet the scheduler picks - a
+ * device's parked retry goes before its queue - and leaves State at Transfer for the HAL callback;
+ * with nothing ready State goes back to Idle. Either way the bus timer is armed for the op deadline
+ * or the next retry. A start the HAL refuses counts as a failed attempt, like an error callback:
+ * State goes to Complete and the DEFER thread settles it (I2C_Task if the ring is full), so the
+ * retry, Bus_Recover and the callbacks never run in the thread that queued the packet.
+ */
+static void I2C_Engine_Next(tI2C_Bus * Bus){
+    while (true){
+        if (Bus->Current_Packet == NULL){
+            tI2C * device = I2C_Bus_Pick(Bus);
+            if (device != NULL){
+                Bus->Active = device;
+                Bus->Current_Packet = I2C_Take_Retry(device);
+                if (Bus->Current_Packet == NULL){
+                    Bus->Current_Packet = (tI2C_Packet *)Dequeue(device->Packet_Queue);
+                    if (Bus->Current_Packet != NULL && device->Coalesce){
+                        I2C_Coalesce(Bus, device, Bus->Current_Packet);
                     }
-                } else {
-                    I2C_Single_Attempts = 0;
-                    I2C->Busy_Flag = false;
-                    I2C->Current_Packet->Success = false;
-                    free(I2C->Current_Packet);
-                    I2C->Current_Packet = NULL;
                 }
-                break;
             }
         }
-    } else if (I2C->Mode == eMode_Continuous){
-        
-        // implement channel later if needed
+        if (Bus->Current_Packet == NULL){
+            Bus->State = eI2C_Idle;
+            I2C_Timer_Update(Bus);
+            // a packet queued while the bus was held found it busy and left the start to us
+            if (!I2C_Bus_Pending(Bus) || !I2C_Claim(Bus, eI2C_Idle, eI2C_Starting)){
+                return;
+            }
+            continue;
+        }
+
+        Bus->Current_Packet->Attempts++;
+        Bus->Transfers++;
+        Bus->Transfer_Start = DWT->CYCCNT;
+        Bus->Op_Tick = tx_time_get();
+        Bus->Op_Ticks = I2C_Op_Ticks(Bus, I2C_Op_Size(Bus->Current_Packet));
+        // set before the start, the callback can arrive before the HAL call returns
+        Bus->State = eI2C_Transfer;
+        if (I2C_Start_Op(Bus, Bus->Active, Bus->Current_Packet) == HAL_OK){
+            I2C_Timer_Update(Bus);
+            return;
+        }
+        // settled like an error callback, on the DEFER thread and not in the caller that queued it
+        Bus->Refused++;
+        Bus->Transfer_OK = false;
+        Bus->Bus_Error = HAL_I2C_GetError(Bus->I2C_Handle);
+        Bus->State = eI2C_Complete;
+        Defer_Post(I2C_Complete_Work, Bus, 0);
+        return;
+    }
+}
+
+/**
+ * @brief: Runs holding the bus, right after Head (a packet of I2C) came off its queue. Moves the
+ * memory reads queued behind Head onto its Next list while each starts no more than Coalesce_Gap
+ * registers past the end of the one before and the whole burst fits I2C_COALESCE_MAX. Only the
+ * front of the queue is looked at, so a write or any other op ends the burst and nothing is
+ * reordered. The queue lock is held across peek and dequeue, so Reset_I2C cannot free a packet
+ * in between. The burst is retried as long as the most patient of its reads allows.
+ */
+static void I2C_Coalesce(tI2C_Bus * Bus, tI2C * I2C, tI2C_Packet * Head){
+    Queue * queue = I2C->Packet_Queue;
+    tI2C_Packet * tail = Head;
+    uint32_t end = (uint32_t)Head->Memory_Address + Head->Data_Size;
+
+    if (Head->Op_type != eI2C_MemRead || queue->Size == 0 || tx_mutex_get(Queue_Get_Mutex(queue), TX_WAIT_FOREVER) != TX_SUCCESS){
+        return;
+    }
+    while (queue->Size > 0){
+        tI2C_Packet * next = (tI2C_Packet *)Queue_Peek_Unsafe(queue, 0);
+        if (next->Op_type != eI2C_MemRead || next->Memory_Address_Size != Head->Memory_Address_Size
+            || next->Memory_Address < end || next->Memory_Address - end > I2C->Coalesce_Gap
+            || (uint32_t)next->Memory_Address + next->Data_Size - Head->Memory_Address > I2C_COALESCE_MAX){
+            break;
+        }
+        // the lock is ours already, Dequeue takes it again nested
+        Dequeue(queue);
+        tail->Next = next;
+        tail = next;
+        end = (uint32_t)next->Memory_Address + next->Data_Size;
+        if (next->Tries_timeout > Head->Tries_timeout){
+            Head->Tries_timeout = next->Tries_timeout;
+        }
+        Bus->Merged++;
+    }
+    tx_mutex_put(Queue_Get_Mutex(queue));
+    // on the head, not the bus: a parked retry of the burst skips coalescing and still needs it
+    Head->Burst_Size = (uint16_t)(end - Head->Memory_Address);
+}
+
+/* Bytes an attempt at Packet moves: its merged burst if it heads one, its own Data otherwise */
+static uint16_t I2C_Op_Size(const tI2C_Packet * Packet){
+    return (Packet->Next != NULL) ? Packet->Burst_Size : Packet->Data_Size;
+}
+
+/* DMA for transfers of I2C_DMA_MIN_SIZE and up when the bus has a channel that way, _IT otherwise.
+ * A merged read burst goes to the bus buffer. */
+static HAL_StatusTypeDef I2C_Start_Op(tI2C_Bus * Bus, tI2C * I2C, tI2C_Packet * Packet){
+    I2C_HandleTypeDef * hi2c = Bus->I2C_Handle;
+    uint8_t * data = (Packet->Next != NULL) ? Bus->Burst_Buffer : Packet->Data;
+    uint16_t size = I2C_Op_Size(Packet);
+    bool rx_dma = (hi2c->hdmarx != NULL && size >= I2C_DMA_MIN_SIZE);
+    bool tx_dma = (hi2c->hdmatx != NULL && size >= I2C_DMA_MIN_SIZE);
+
+    switch (Packet->Op_type){
+        case eI2C_Write:
+            return tx_dma ? HAL_I2C_Master_Transmit_DMA(hi2c, I2C->Device_Address, Packet->Data, Packet->Data_Size)
+                          : HAL_I2C_Master_Transmit_IT(hi2c, I2C->Device_Address, Packet->Data, Packet->Data_Size);
+        case eI2C_SingleRead:
+            return rx_dma ? HAL_I2C_Master_Receive_DMA(hi2c, I2C->Device_Address, Packet->Data, Packet->Data_Size)
+                          : HAL_I2C_Master_Receive_IT(hi2c, I2C->Device_Address, Packet->Data, Packet->Data_Size);
+        case eI2C_MemWrite:
+            return tx_dma ? HAL_I2C_Mem_Write_DMA(hi2c, I2C->Device_Address, Packet->Memory_Address, Packet->Memory_Address_Size, Packet->Data, Packet->Data_Size)
+                          : HAL_I2C_Mem_Write_IT(hi2c, I2C->Device_Address, Packet->Memory_Address, Packet->Memory_Address_Size, Packet->Data, Packet->Data_Size);
+        case eI2C_MemRead:
+            return rx_dma ? HAL_I2C_Mem_Read_DMA(hi2c, I2C->Device_Address, Packet->Memory_Address, Packet->Memory_Address_Size, data, size)
+                          : HAL_I2C_Mem_Read_IT(hi2c, I2C->Device_Address, Packet->Memory_Address, Packet->Memory_Address_Size, data, size);
+        default:
+            // continuous reads are not queued as packets
+            return HAL_ERROR;
+    }
+}
+
+/* Thread side of a HAL callback: retry or report the packet, then start the next one */
+static void I2C_Engine_Complete(tI2C_Bus * Bus){
+    if (!I2C_Claim(Bus, eI2C_Complete, eI2C_Starting)){
+        return;
+    }
+    I2C_Engine_Finish(Bus);
+    I2C_Engine_Next(Bus);
+}
+
+static void I2C_Complete_Work(void * Arg, uint32_t Data){
+    (void)Data;
+    I2C_Engine_Complete((tI2C_Bus *)Arg);
+}
+
+static void I2C_Kick_Work(void * Arg, uint32_t Data){
+    (void)Data;
+    I2C_Engine_Kick((tI2C_Bus *)Arg);
+}
+
+static void I2C_Timer_Work(void * Arg, uint32_t Data){
+    (void)Data;
+    I2C_Bus_Check((tI2C_Bus *)Arg);
+}
+
+/* Timer thread: the work goes to the DEFER thread, I2C_Task catches it if the ring is full */
+static VOID I2C_Timer_Expired(ULONG Arg){
+    tI2C_Bus * Bus = (tI2C_Bus *)Arg;
+    Bus->Timer_Armed = false;
+    Defer_Post(I2C_Timer_Work, Bus, 0);
+}
+
+/**
+ * @brief: Arms the bus timer for the earliest of the running op's deadline and the parked retries.
+ * Left alone when it already fires sooner; firing early is harmless, I2C_Bus_Check re-arms.
+ */
+static void I2C_Timer_Update(tI2C_Bus * Bus){
+    bool armed = false;
+    ULONG due = 0;
+
+    if (Bus->State == eI2C_Transfer){
+        due = Bus->Op_Tick + Bus->Op_Ticks;
+        armed = true;
+    }
+    for (uint8_t i = 0; i < Bus->Device_Count; i++){
+        tI2C * device = Bus->Devices[i];
+        if (device->Retry_Packet != NULL && (!armed || (LONG)(device->Retry_Tick - due) < 0)){
+            due = device->Retry_Tick;
+            armed = true;
+        }
+    }
+    if (!armed || (Bus->Timer_Armed && (LONG)(Bus->Timer_Due - due) <= 0)){
+        return;
+    }
+    ULONG now = tx_time_get();
+    ULONG ticks = ((LONG)(due - now) > 0) ? due - now : 1;
+    tx_timer_deactivate(&Bus->Timer);
+    tx_timer_change(&Bus->Timer, ticks, 0);
+    Bus->Timer_Due = now + ticks;
+    Bus->Timer_Armed = true;
+    tx_timer_activate(&Bus->Timer);
+}
+
+/**
+ * @brief: SCL period the timing register gives: (SCLL + 1 + SCLH + 1) prescaled I2CCLK cycles. Rise
+ * times and the clock synchronisation add a little on top, left to I2C_OP_MARGIN_TICKS.
+ */
+static uint32_t I2C_Bit_Ns(I2C_HandleTypeDef * hi2c){
+    uint32_t clock_source = RCC_PERIPHCLK_I2C1;
+    if (hi2c->Instance == I2C2){
+        clock_source = RCC_PERIPHCLK_I2C2;
+    } else if (hi2c->Instance == I2C3){
+        clock_source = RCC_PERIPHCLK_I2C3;
+    }
+    uint32_t clock = HAL_RCCEx_GetPeriphCLKFreq(clock_source);
+    uint32_t timing = hi2c->Init.Timing;
+    uint32_t presc = ((timing & I2C_TIMINGR_PRESC) >> I2C_TIMINGR_PRESC_Pos) + 1;
+    uint32_t scll = (timing & I2C_TIMINGR_SCLL) >> I2C_TIMINGR_SCLL_Pos;
+    uint32_t sclh = (timing & I2C_TIMINGR_SCLH) >> I2C_TIMINGR_SCLH_Pos;
+
+    if (clock == 0){
+        // unknown clock: take the slowest standard bus
+        return 10000;
+    }
+    return (uint32_t)(((uint64_t)(scll + sclh + 2) * presc * 1000000000ULL) / clock);
+}
+
+/**
+ * @brief: Deadline of an op moving Size data bytes: 9 clocks a byte, with the address, up to two
+ * register bytes and the repeated address of a memory read on top, plus I2C_OP_MARGIN_TICKS.
+ *
+ * @return: ticks, at least I2C_OP_TIMEOUT_TICKS
+ */
+static ULONG I2C_Op_Ticks(tI2C_Bus * Bus, uint32_t Size){
+    uint64_t wire_ns = (uint64_t)(Size + 4) * 9 * Bus->Bit_Ns;
+    uint64_t tick_ns = 1000000000ULL / TX_TIMER_TICKS_PER_SECOND;
+    ULONG ticks = (ULONG)((wire_ns + tick_ns - 1) / tick_ns) + I2C_OP_MARGIN_TICKS;
+    return (ticks < I2C_OP_TIMEOUT_TICKS) ? I2C_OP_TIMEOUT_TICKS : ticks;
+}
+
+/**
+ * @brief: Bus timer work. An op with no callback after its Op_Ticks is taken from the HAL
+ * (a late callback then finds the bus no longer in Transfer), the bus is recovered and a packet op
+ * counts as a failed attempt. Then retries that are due are started and the timer re-armed.
+ */
+static void I2C_Bus_Check(tI2C_Bus * Bus){
+    if (Bus->State == eI2C_Transfer && tx_time_get() - Bus->Op_Tick >= Bus->Op_Ticks
+        && I2C_Claim(Bus, eI2C_Transfer, eI2C_Starting)){
+        Bus->Timeouts++;
+        LOG_WARN(I2C, "addr 0x%02X op hung, recovering the bus\r\n", Bus->Active->Device_Address);
+        if (Bus->Current_Packet != NULL){
+            Bus->Transfer_OK = false;
+            Bus->Bus_Error = HAL_I2C_ERROR_TIMEOUT;
+            I2C_Engine_Finish(Bus);
+        } else {
+            I2C_Bus_Recover(Bus);
+            Bus->Active->Continuous_Channel->Errors++;
+        }
+        I2C_Engine_Next(Bus);
+    }
+    I2C_Engine_Kick(Bus);
+    I2C_Timer_Update(Bus);
+}
+
+/* Busy-waits on the cycle counter, for the hand-clocked recovery */
+static void I2C_Delay_Us(uint32_t Us){
+    uint32_t start = DWT->CYCCNT;
+    uint32_t cycles = (SystemCoreClock / 1000000U) * Us;
+    while (DWT->CYCCNT - start < cycles){
+    }
+}
+
+/**
+ * @brief: Runs holding the bus. Stops the DMA and turns the peripheral off. A device cut off in the
+ * middle of a read keeps SDA low until it has clocked out the rest of its byte, so while SDA reads
+ * low SCL is pulsed by hand, up to nine times, and a STOP ends whatever the device thinks is going
+ * on. Then the peripheral is reinitialised (MspInit hands the pins back to it). Queues and parked
+ * retries are left as they are.
+ */
+static void I2C_Bus_Recover(tI2C_Bus * Bus){
+    I2C_HandleTypeDef * hi2c = Bus->I2C_Handle;
+
+    if (hi2c->hdmarx != NULL){
+        HAL_DMA_Abort(hi2c->hdmarx);
+    }
+    if (hi2c->hdmatx != NULL){
+        HAL_DMA_Abort(hi2c->hdmatx);
+    }
+    HAL_I2C_DeInit(hi2c);
+    Bus->Recoveries++;
+
+    if (Bus->SDA_Port != NULL){
+        GPIO_InitTypeDef gpio = {0};
+        gpio.Mode = GPIO_MODE_OUTPUT_OD;
+        gpio.Pull = GPIO_NOPULL;
+        gpio.Speed = GPIO_SPEED_FREQ_LOW;
+        HAL_GPIO_WritePin(Bus->SCL_Port, Bus->SCL_Pin, GPIO_PIN_SET);
+        HAL_GPIO_WritePin(Bus->SDA_Port, Bus->SDA_Pin, GPIO_PIN_SET);
+        gpio.Pin = Bus->SCL_Pin;
+        HAL_GPIO_Init(Bus->SCL_Port, &gpio);
+        gpio.Pin = Bus->SDA_Pin;
+        HAL_GPIO_Init(Bus->SDA_Port, &gpio);
+        I2C_Delay_Us(I2C_RECOVERY_HALF_US);
+
+        if (HAL_GPIO_ReadPin(Bus->SDA_Port, Bus->SDA_Pin) == GPIO_PIN_RESET){
+            Bus->Stuck_SDA++;
+            for (uint8_t i = 0; i < 9 && HAL_GPIO_ReadPin(Bus->SDA_Port, Bus->SDA_Pin) == GPIO_PIN_RESET; i++){
+                HAL_GPIO_WritePin(Bus->SCL_Port, Bus->SCL_Pin, GPIO_PIN_RESET);
+                I2C_Delay_Us(I2C_RECOVERY_HALF_US);
+                HAL_GPIO_WritePin(Bus->SCL_Port, Bus->SCL_Pin, GPIO_PIN_SET);
+                I2C_Delay_Us(I2C_RECOVERY_HALF_US);
+            }
+            if (HAL_GPIO_ReadPin(Bus->SDA_Port, Bus->SDA_Pin) == GPIO_PIN_RESET){
+                LOG_ERROR(I2C, "bus 0x%08lX: SDA still held low after 9 clocks\r\n", (uint32_t)hi2c->Instance);
+            }
+        }
+        // STOP: SDA rises while SCL is high
+        HAL_GPIO_WritePin(Bus->SCL_Port, Bus->SCL_Pin, GPIO_PIN_RESET);
+        HAL_GPIO_WritePin(Bus->SDA_Port, Bus->SDA_Pin, GPIO_PIN_RESET);
+        I2C_Delay_Us(I2C_RECOVERY_HALF_US);
+        HAL_GPIO_WritePin(Bus->SCL_Port, Bus->SCL_Pin, GPIO_PIN_SET);
+        I2C_Delay_Us(I2C_RECOVERY_HALF_US);
+        HAL_GPIO_WritePin(Bus->SDA_Port, Bus->SDA_Pin, GPIO_PIN_SET);
+        I2C_Delay_Us(I2C_RECOVERY_HALF_US);
+    }
+    if (HAL_I2C_Init(hi2c) != HAL_OK){
+        LOG_ERROR(I2C, "bus 0x%08lX: reinit after recovery failed\r\n", (uint32_t)hi2c->Instance);
+    }
+}
+
+/**
+ * @brief: ISR side of every completion and error callback. Records the result and hands the rest to
+ * the DEFER thread; if its ring is full, I2C_Task finishes the packet on its next run.
+ */
+static void I2C_Transfer_Done(I2C_HandleTypeDef * hi2c, bool OK){
+    tI2C_Bus * Bus = (tI2C_Bus *)Registry_Find(hi2c->Instance, eRegistry_I2C);
+    if (Bus == NULL || Bus->State != eI2C_Transfer){
+        return;
+    }
+    Bus->Busy_Cycles += DWT->CYCCNT - Bus->Transfer_Start;
+    if (Bus->Current_Packet == NULL){
+        I2C_Continuous_Done(Bus, OK);
+        return;
+    }
+    Bus->Transfer_OK = OK;
+    Bus->Bus_Error = OK ? 0 : HAL_I2C_GetError(hi2c);
+    Bus->State = eI2C_Complete;
+    Defer_Post(I2C_Complete_Work, Bus, 0);
+}
+
+/**
+ * @brief: Trigger timer tick. The burst starts here, in the interrupt, so each sample is taken at the
+ * timer edge plus interrupt latency whatever the threads are doing. A tick that finds the bus busy
+ * (another device's op, or the start refused) is counted in Missed and the slot is used by the next.
+ */
+static void I2C_Continuous_Trigger(tI2C * I2C){
+    tI2C_Continuous_Channel * Channel = I2C->Continuous_Channel;
+    tI2C_Bus * Bus = I2C->Bus;
+    I2C_HandleTypeDef * hi2c = Bus->I2C_Handle;
+
+    if (!I2C_Claim(Bus, eI2C_Idle, eI2C_Transfer)){
+        Channel->Missed++;
+        // the timer may be idle while bursts run, so a hung one is noticed here
+        if (Bus->State == eI2C_Transfer && tx_time_get() - Bus->Op_Tick >= Bus->Op_Ticks){
+            Defer_Post(I2C_Timer_Work, Bus, 0);
+        }
+        return;
+    }
+    uint8_t * slot = &Channel->Data[Channel->Fill_Half * Channel->Half_Size + Channel->Fill_Count * Channel->Burst_Size];
+    HAL_StatusTypeDef res;
+
+    Bus->Active = I2C;
+    Bus->Transfers++;
+    Bus->Transfer_Start = DWT->CYCCNT;
+    Bus->Op_Tick = tx_time_get();
+    Bus->Op_Ticks = Channel->Op_Ticks;
+    if (hi2c->hdmarx != NULL && Channel->Burst_Size >= I2C_DMA_MIN_SIZE){
+        res = HAL_I2C_Mem_Read_DMA(hi2c, I2C->Device_Address, Channel->Memory_Address, Channel->Memory_Address_Size, slot, Channel->Burst_Size);
+    } else {
+        res = HAL_I2C_Mem_Read_IT(hi2c, I2C->Device_Address, Channel->Memory_Address, Channel->Memory_Address_Size, slot, Channel->Burst_Size);
+    }
+    if (res != HAL_OK){
+        Channel->Missed++;
+        Bus->Refused++;
+        Bus->State = eI2C_Idle;
+    }
+}
+
+static void I2C_Continuous_Notify_Work(void * Arg, uint32_t Data){
+    (void)Data;
+    tI2C_Continuous_Channel * Channel = (tI2C_Continuous_Channel *)Arg;
+    Channel->Complete_CallBack(Channel->CallBack_Data);
+}
+
+/**
+ * @brief: Burst finished (ISR). Moves to the next slot; when a half is full the halves swap, Read_Idx
+ * points at the full one, Buffer_Ready is set and the consumer is told through I2C_EVENT_BUFFER_READY
+ * and Complete_CallBack - the only thread work per half. A half handed over while the consumer still
+ * had the previous one counts an overrun. Packets other devices queued during the burst are started
+ * from the DEFER thread.
+ */
+static void I2C_Continuous_Done(tI2C_Bus * Bus, bool OK){
+    tI2C * I2C = Bus->Active;
+    tI2C_Continuous_Channel * Channel = I2C->Continuous_Channel;
+
+    if (Channel->Success != NULL){
+        *Channel->Success = OK;
+    }
+    if (!OK){
+        Channel->Errors++;
+        Bus->Bus_Error = HAL_I2C_GetError(Bus->I2C_Handle);
+    } else {
+        Channel->Fill_Count++;
+        if ((uint32_t)Channel->Fill_Count * Channel->Burst_Size >= Channel->Half_Size){
+            if (Channel->Buffer_Ready){
+                Channel->Overruns++;
+            }
+            Channel->Read_Idx = Channel->Fill_Half * Channel->Half_Size;
+            Channel->Fill_Half ^= 1;
+            Channel->Fill_Count = 0;
+            Channel->Buffer_Ready = true;
+            tx_event_flags_set(&I2C->Events, I2C_EVENT_BUFFER_READY, TX_OR);
+            if (Channel->Complete_CallBack != NULL){
+                Defer_Post(I2C_Continuous_Notify_Work, Channel, 0);
+            }
+        }
+    }
+    Bus->State = eI2C_Idle;
+    if (I2C_Bus_Pending(Bus)){
+        Defer_Post(I2C_Kick_Work, Bus, 0);
     }
-}
\ No newline at end of file
+}
+
+void HAL_LPTIM_AutoReloadMatchCallback(LPTIM_HandleTypeDef *hlptim){
+    tI2C * I2C = (tI2C *)Registry_Find(hlptim->Instance, eRegistry_I2C_Trigger);
+    if (I2C != NULL && I2C->Mode == eMode_Continuous && I2C->Continuous_Channel != NULL){
+        I2C_Continuous_Trigger(I2C);
+    }
+}
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c){
+    I2C_Transfer_Done(hi2c, true);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c){
+    I2C_Transfer_Done(hi2c, true);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c){
+    I2C_Transfer_Done(hi2c, true);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c){
+    I2C_Transfer_Done(hi2c, true);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c){
+    I2C_Transfer_Done(hi2c, false);
+}
+
+void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c){
+    I2C_Transfer_Done(hi2c, false);
+}
+
+/**
+ * @brief: Console "i2c". Per bus: ops started, starts refused, share of time with an op on the bus
+ * since the last "i2c", packet pool use, reads merged into bursts, hangs and recoveries; per device: priority, mode, queued packets, completed and failed.
+ */
+static void I2C_Command(const char * args){
+    (void)args;
+    if (i2c_bus_count == 0){
+        printd("no I2C buses\r\n");
+        return;
+    }
+    for (uint8_t b = 0; b < i2c_bus_count; b++){
+        tI2C_Bus * Bus = i2c_buses[b];
+        uint32_t now = DWT->CYCCNT;
+        uint32_t window = now - Bus->Window_Start;
+        uint32_t busy = Bus->Busy_Cycles;
+        uint32_t permille = (window != 0) ? (uint32_t)(((uint64_t)busy * 1000U) / window) : 0;
+        Bus->Busy_Cycles = 0;
+        Bus->Window_Start = now;
+
+        printd("bus 0x%08lX  transfers %lu  refused %lu  busy %lu.%lu%%\r\n", (uint32_t)Bus->I2C_Handle->Instance,
+               Bus->Transfers, Bus->Refused, permille / 10U, permille % 10U);
+        printd("  packets %lu/%u free  low %u  backpressure %lu  merged %lu\r\n", Bus->Packet_Pool.tx_block_pool_available,
+               Bus->Packets, Bus->Packets_Low, Bus->Backpressure, Bus->Merged);
+        printd("  timeouts %lu  recoveries %lu  stuck sda %lu\r\n", Bus->Timeouts, Bus->Recoveries, Bus->Stuck_SDA);
+        for (uint8_t i = 0; i < Bus->Device_Count; i++){
+            tI2C * I2C = Bus->Devices[i];
+            printd("  addr 0x%02X  prio %u  %s  queued %lu  done %lu  failed %lu  retries %lu%s\r\n", I2C->Device_Address, I2C->Priority,
+                   (I2C->Mode == eMode_Continuous) ? "cont" : "single", I2C->Packet_Queue->Size, I2C->Completed, I2C->Failed,
+                   I2C->Retries, (I2C->Retry_Packet != NULL) ? "  backing off" : "");
+        }
+    }
+}
+
+static void I2C_IRQ(const I2C_TypeDef * Instance, bool Error){
+    tI2C_Bus * Bus = (tI2C_Bus *)Registry_Find(Instance, eRegistry_I2C);
+    if (Bus == NULL){
+        return;
+    }
+    if (Error){
+        HAL_I2C_ER_IRQHandler(Bus->I2C_Handle);
+    } else {
+        HAL_I2C_EV_IRQHandler(Bus->I2C_Handle);
+    }
+}
+
+void I2C1_EV_IRQHandler(void) { I2C_IRQ(I2C1, false); }
+void I2C1_ER_IRQHandler(void) { I2C_IRQ(I2C1, true); }
+void I2C3_EV_IRQHandler(void) { I2C_IRQ(I2C3, false); }
+void I2C3_ER_IRQHandler(void) { I2C_IRQ(I2C3, true); }
+
+static void I2C_Trigger_IRQ(const LPTIM_TypeDef * Instance){
+    tI2C * I2C = (tI2C *)Registry_Find(Instance, eRegistry_I2C_Trigger);
+    if (I2C != NULL && I2C->Continuous_Channel != NULL){
+        HAL_LPTIM_IRQHandler(I2C->Continuous_Channel->Trigger_Timer);
+    }
+}
+
+void LPTIM1_IRQHandler(void) { I2C_Trigger_IRQ(LPTIM1); }
+void LPTIM2_IRQHandler(void) { I2C_Trigger_IRQ(LPTIM2); }
@@ -10,8 +10,85 @@
 
 #include "main.h"
 #include "../../Middlewares/Queue/Queue.h"
+#include "../../Middlewares/Txn/txn.h"
 #include <stdbool.h>
 
+/**
+ * USAGE:
+ * Queued I2C transactions that run on interrupts and DMA; no call blocks on the bus except the
+ * I2C_Blocking_* helpers.
+ * 1) One tI2C_Bus per peripheral owns the handle, the state machine, the interrupts and DMA. Each
+ *    sensor gets a light device handle: Init_I2C(&hi2c1, addr) finds or creates the bus and adds the
+ *    device to it. I2C_Set_Priority orders devices on a bus (0 first, I2C_PRIORITY_DEFAULT otherwise).
+ * 2) I2C_Read / I2C_Callback_Read / I2C_Memory_Read / I2C_Memory_Write queue a packet on the device
+ *    and return. Data (and Success) must stay valid until the packet completes. Packets come from a
+ *    fixed block pool per bus (I2C_Init_Bus(&hi2c1, count) sizes it, I2C_BUS_PACKETS otherwise), so
+ *    queuing costs the same every time and never touches the heap. When the pool is empty the call
+ *    returns false and clears I2C_EVENT_SPACE on the device: that is backpressure, wait for the flag
+ *    and queue again (or I2C_Set_Packet_Wait to let the call block for a packet).
+ * 3) Whenever the bus frees up it takes the next packet from the device with the lowest priority
+ *    value that has one, round robin between equal priorities, and starts the _DMA variant of the
+ *    HAL op (_IT below I2C_DMA_MIN_SIZE or without a DMA channel). Only the bus touches the handle,
+ *    so devices never collide with HAL_BUSY; the blocking helpers take the bus the same way.
+ * 4) The HAL callbacks advance the state machine; the completion work (retry, Success,
+ *    Complete_CallBack, starting the next packet) runs on the DEFER thread, so queued packets go out
+ *    back to back without the scheduler. A failed attempt with tries left is parked on its device
+ *    for a backoff (I2C_RETRY_BACKOFF_TICKS, doubling per attempt up to I2C_RETRY_BACKOFF_MAX) while
+ *    the bus serves the other devices; the bus timer starts it again ahead of the device's queue.
+ *    A flaky sensor delays its own packets, not its neighbours'.
+ * 5) Each completed packet sets I2C_EVENT_DONE or I2C_EVENT_ERROR in the device's Events, and
+ *    I2C_EVENT_IDLE once its queue is empty. Threads wait on them with tx_event_flags_get. To wait
+ *    for particular packets, queue them with the *_Txn calls and a tTxn_Set of the thread:
+ *      a = I2C_Memory_Read_Txn(imu, &set, OUTX_L_A, I2C_MEMADD_SIZE_8BIT, acc, 6, 3);
+ *      g = I2C_Memory_Read_Txn(imu, &set, OUTX_L_G, I2C_MEMADD_SIZE_8BIT, gyr, 6, 3);
+ *      Txn_Wait_All((tTxn *[]){a, g}, 2, 10);   one wakeup when both are in; then Txn_Release each
+ * 6) The bus recovers itself. An op with no callback by its deadline, a bus error, lost arbitration
+ *    or a start refused with the line busy stops the DMA and the peripheral, clocks SCL by hand (up
+ *    to 9 pulses and a STOP) if a device holds SDA low, and reinitialises the peripheral. The op
+ *    counts as a failed attempt; queued packets are kept. Reset_I2C is only needed to throw a
+ *    device's packets away. The deadline is the op's bytes at the SCL period of Init.Timing plus
+ *    I2C_OP_MARGIN_TICKS, never under I2C_OP_TIMEOUT_TICKS, so long bursts on a slow bus are not
+ *    taken for hung ones.
+ * 7) I2C_Task, one per bus, only picks up a completion or a timer tick the DEFER ring had no room for.
+ * 8) Continuous mode samples a register burst at a fixed rate with no packets and no thread wakeups
+ *    per sample: I2C_Continuous_Channel_Init(&channel, reg, I2C_MEMADD_SIZE_8BIT, 12, buf, sizeof(buf),
+ *    &hlptim1, 1000, On_Half, ctx) then Change_Continuous_Mode(I2C, &channel). Each LPTIM tick starts
+ *    the burst from its interrupt; when a half of buf fills, Buffer_Ready is set, Read_Idx points at it,
+ *    I2C_EVENT_BUFFER_READY is set and On_Half runs on the DEFER thread. The consumer reads Half_Size
+ *    bytes at Data + Read_Idx and calls I2C_Continuous_Release. Packets queued on that device wait for
+ *    Change_Single_Mode; a tick that finds another device's op on the bus counts in Missed.
+ * 9) Coalescing: I2C_Set_Coalescing(I2C, true, gap) lets the bus fold memory reads queued back to back
+ *    on that device into one auto-increment burst when each starts at most gap registers after the
+ *    previous one ends (the gap is read and thrown away), up to I2C_COALESCE_MAX bytes. The burst
+ *    lands in the bus buffer and is copied to every caller's Data before its Success and callback;
+ *    a write in between ends the burst, so the device sees its ops in queue order. Only for devices
+ *    that auto-increment on a plain burst. Reads queued while the bus is busy merge on their own; to
+ *    merge a group from an idle bus, queue it between I2C_Batch_Begin and I2C_Batch_End.
+ * 10) Console "i2c" lists buses and devices with their queues, counters and bus utilisation.
+ */
+
+#define I2C_DMA_MIN_SIZE        4       /* shorter transfers use _IT, DMA setup costs more than the interrupts */
+#define I2C_IRQ_PRIORITY        0       /* same as the DMA channels that feed it */
+#define I2C_BUS_MAX_DEVICES     8
+#define I2C_MAX_BUSES           3       /* I2C1..I2C3 */
+#define I2C_PRIORITY_DEFAULT    8
+#define I2C_BUS_PACKETS         16      /* packet pool of a bus Init_I2C creates */
+#define I2C_COALESCE_MAX        32      /* longest merged read burst, size of the bus burst buffer */
+
+#define I2C_EVENT_DONE          0x01U   /* a packet completed */
+#define I2C_EVENT_ERROR         0x02U   /* a packet gave up after Tries_timeout attempts */
+#define I2C_EVENT_IDLE          0x04U   /* nothing left in the device queue */
+#define I2C_EVENT_BUFFER_READY  0x08U   /* continuous mode filled a half */
+#define I2C_EVENT_SPACE         0x10U   /* the bus packet pool has room again */
+
+#define I2C_CONTINUOUS_STOP_TICKS   10  /* how long Change_Single_Mode waits for the last burst */
+#define I2C_RESET_TICKS             20  /* how long Reset_I2C waits for the bus before taking it */
+#define I2C_OP_TIMEOUT_TICKS        10  /* shortest op deadline; a longer op gets its time on the wire + margin */
+#define I2C_OP_MARGIN_TICKS         5   /* on top of an op's time on the wire: stretching, latency */
+#define I2C_RETRY_BACKOFF_TICKS     1   /* wait before the first retry, doubled for every further one */
+#define I2C_RETRY_BACKOFF_MAX       64
+#define I2C_RECOVERY_HALF_US        5   /* half period of the hand-clocked SCL, 100 kHz */
+#define I2C_REGS_TIMEOUT            10  /* ms, blocking access of a register shadow (Regs/Regs.h) */
 
 typedef enum {
     eI2C_Write,
@@ -26,8 +103,15 @@ typedef enum {
     eMode_Continuous
 }eI2c_Mode;
 
+typedef enum {
+    eI2C_Idle = 0,          // nothing on the bus
+    eI2C_Starting,          // a thread holds the bus: picking / starting / finishing a packet, or a blocking op
+    eI2C_Transfer,          // HAL op running, waiting for its callback
+    eI2C_Complete,          // callback arrived, completion work pending
+} eI2C_State;
+
 // all dynamic alloc data independent of struct
-typedef struct {
+typedef struct tI2C_Packet {
     eOp_Type Op_type;
 	uint16_t Memory_Address;
 	uint16_t Memory_Address_Size;
@@ -36,51 +120,144 @@ typedef struct {
 	void(*Complete_CallBack)(void *);
 	void * CallBack_Data;
     uint8_t Tries_timeout;
+    uint8_t Attempts;               // tries used so far
     bool * Success;
+    tTxn * Txn;                     // completed with the packet, NULL for none
+    void(*Finish_CallBack)(void *, bool);   // done, failed or dropped, with CallBack_Data
+    struct tI2C_Packet * Next;      // reads merged into this packet's burst, in address order
+    uint16_t Burst_Size;            // bytes of that burst, from this packet's address; kept for its retries
 }tI2C_Packet;
 
 //all dynamic alloc data should be independent of struct
 typedef struct {
-    uint16_t Memory_Address;
+    uint16_t Memory_Address;        // first register of the burst
     uint16_t Memory_Address_Size;
-    uint8_t * Data;
+    uint8_t * Data;                 // ping-pong buffer: two halves of Half_Size bytes
     uint16_t Buffer_Size;
-    bool * Success;
-    bool Buffer_Ready; // when this flag is true, move data to the configured buffer.
-    void(*Complete_CallBack)(void *);
+    bool * Success;                 // result of the last burst
+    volatile bool Buffer_Ready; // when this flag is true, move data to the configured buffer.
+    void(*Complete_CallBack)(void *);   // DEFER thread, once per filled half
 	void * CallBack_Data;
     uint8_t Tries_timeout;
-    uint32_t Read_Idx;
+    volatile uint32_t Read_Idx;     // offset in Data of the half that is ready
+    uint16_t Burst_Size;            // bytes read per trigger
+    ULONG Op_Ticks;                 // deadline of one burst
+    uint16_t Half_Size;             // whole bursts
+    uint32_t Rate_Hz;
+    LPTIM_HandleTypeDef * Trigger_Timer;
+    volatile uint8_t Fill_Half;
+    volatile uint16_t Fill_Count;   // bursts in the half being filled
+    volatile uint32_t Missed;       // triggers that found the bus busy or could not start
+    volatile uint32_t Errors;       // bursts that failed on the bus
+    volatile uint32_t Overruns;     // halves handed over while the consumer still held the last one
 }tI2C_Continuous_Channel;
     
-typedef struct {
+typedef struct tI2C_Bus tI2C_Bus;
+
+// device handle: one per sensor, any number per bus
+typedef struct tI2C {
     eI2c_Mode Mode;
-    I2C_HandleTypeDef * I2C_Handle;
-    volatile bool Busy_Flag;
+    tI2C_Bus * Bus;
+    I2C_HandleTypeDef * I2C_Handle; // the bus peripheral
     Queue* Packet_Queue;
     uint16_t Device_Address;
-    uint32_t Task_ID;
+    uint8_t Priority;               // 0 served first, equal priorities take turns
+    ULONG Packet_Wait;              // ticks a queuing call waits for a free packet
+    bool Coalesce;                  // merge back to back memory reads into one burst
+    uint8_t Coalesce_Gap;           // registers a merged burst may skip between two reads
+    volatile bool Batch;            // between I2C_Batch_Begin and I2C_Batch_End: not served
+    tI2C_Packet * volatile Retry_Packet;    // failed attempt waiting out its backoff, goes before the queue
+    volatile ULONG Retry_Tick;      // when Retry_Packet may go again
     tI2C_Continuous_Channel * Continuous_Channel;
-    tI2C_Packet * Current_Packet;
+    TX_EVENT_FLAGS_GROUP Events;    // I2C_EVENT_*
+    uint32_t Completed;
+    uint32_t Failed;
+    uint32_t Retries;
 }tI2C;
 
+struct tI2C_Bus {
+    I2C_HandleTypeDef * I2C_Handle;
+    volatile eI2C_State State;
+    tI2C * Devices[I2C_BUS_MAX_DEVICES];
+    uint8_t Device_Count;
+    uint8_t Last_Served;            // round robin among equal priorities starts after this device
+    tI2C * volatile Active;         // device whose packet or burst is on the bus
+    tI2C_Packet * Current_Packet;   // NULL while a continuous burst runs
+    volatile bool Transfer_OK;      // result of the op reported by the last HAL callback
+    volatile uint32_t Bus_Error;    // HAL_I2C_GetError of the last failed op
+    uint32_t Task_ID;
+    uint32_t Transfers;             // ops started
+    uint32_t Refused;               // starts the HAL refused
+    volatile uint32_t Transfer_Start;   // DWT cycle count when the running op started
+    volatile ULONG Op_Tick;         // tick the running op started, for the hang check
+    volatile ULONG Op_Ticks;        // how long the running op may take before it counts as hung
+    uint32_t Bit_Ns;                // SCL period decoded from Init.Timing
+    volatile uint32_t Busy_Cycles;  // cycles with an op on the bus since Window_Start
+    uint32_t Window_Start;
+    TX_BLOCK_POOL Packet_Pool;      // every packet queued on the bus comes from here
+    uint16_t Packets;
+    uint16_t Packets_Low;           // fewest free packets seen
+    volatile bool Space_Wanted;     // a device was turned away since the pool last had room
+    uint32_t Backpressure;          // queuing calls turned away with the pool empty
+    uint32_t Merged;                // reads that rode on another read's burst
+    uint8_t Burst_Buffer[I2C_COALESCE_MAX];
+    TX_TIMER Timer;                 // one shot: next parked retry or the running op's deadline
+    volatile bool Timer_Armed;
+    ULONG Timer_Due;
+    GPIO_TypeDef * SCL_Port;        // pins for the hand-clocked recovery, NULL: reinit only
+    uint16_t SCL_Pin;
+    GPIO_TypeDef * SDA_Port;
+    uint16_t SDA_Pin;
+    uint32_t Timeouts;              // ops that never called back
+    uint32_t Recoveries;            // peripheral stop/reinit cycles
+    uint32_t Stuck_SDA;             // recoveries that found SDA held low
+};
+
+tI2C_Bus * I2C_Init_Bus(I2C_HandleTypeDef * I2C_Handle, uint16_t Packets);
 tI2C * Init_I2C(I2C_HandleTypeDef * I2C_Handle, uint16_t Device_Address);
+void I2C_Set_Priority(tI2C * I2C, uint8_t Priority);
+void I2C_Set_Packet_Wait(tI2C * I2C, ULONG Ticks);
+void I2C_Set_Coalescing(tI2C * I2C, bool Enable, uint8_t Max_Gap);
+void I2C_Batch_Begin(tI2C * I2C);
+void I2C_Batch_End(tI2C * I2C);
 void Reset_I2C(tI2C * I2C);
 
 bool Change_Single_Mode(tI2C * I2C);
 bool Change_Continuous_Mode(tI2C * I2C, tI2C_Continuous_Channel * Channel);
+bool I2C_Continuous_Channel_Init(tI2C_Continuous_Channel * Channel, uint16_t Memory_Address, uint16_t Memory_Address_Size,
+                                 uint16_t Burst_Size, uint8_t * Data, uint16_t Buffer_Size, LPTIM_HandleTypeDef * Trigger_Timer,
+                                 uint32_t Rate_Hz, void (*Complete_CallBack)(void *), void * CallBack_Data);
+void I2C_Continuous_Release(tI2C_Continuous_Channel * Channel);
 
 bool I2C_Blocking_Write(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint32_t Timeout);
 bool I2C_Blocking_Read(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint32_t Timeout);
 bool I2C_Blocking_Memory_Write(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint32_t Timeout);
 bool I2C_Blocking_Memory_Read(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint32_t Timeout);
+/* Register shadow backend (tRegs_Access), Device is the tI2C, 8-bit register addresses */
+bool I2C_Regs_Read(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size);
+bool I2C_Regs_Write(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size);
 
 bool I2C_Read(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success);
 bool I2C_Callback_Read(tI2C * I2C, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success, void (*Complete_CallBack)(void *), void * CallBack_Data);
 bool I2C_Memory_Read(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success);
 bool I2C_Memory_Write(tI2C * I2C, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout, bool * Success);
+bool I2C_Queue_Notify(tI2C * I2C, eOp_Type Op_type, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size,
+                      uint8_t Tries_timeout, void (*Finish_CallBack)(void *, bool), void * CallBack_Data);
+
+tTxn * I2C_Read_Txn(tI2C * I2C, tTxn_Set * Set, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout);
+tTxn * I2C_Write_Txn(tI2C * I2C, tTxn_Set * Set, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout);
+tTxn * I2C_Memory_Read_Txn(tI2C * I2C, tTxn_Set * Set, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout);
+tTxn * I2C_Memory_Write_Txn(tI2C * I2C, tTxn_Set * Set, uint16_t Memory_Address, uint16_t Memory_Address_Size, uint8_t * Data, uint16_t Data_Size, uint8_t Tries_timeout);
+
+void I2C_Task(tI2C_Bus * Bus);
 
-void I2C_Task(tI2C * I2C);
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_LPTIM_AutoReloadMatchCallback(LPTIM_HandleTypeDef *hlptim);
 #endif
 
 
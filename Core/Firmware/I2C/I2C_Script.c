@@ -0,0 +1,209 @@
+/*
+ * I2C_Script.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include "I2C_Script.h"
+#include "../../Middlewares/Log/log.h"
+#include "../../Middlewares/Defer/defer.h"
+
+static bool I2C_Script_Begin(tI2C_Script * Script, tI2C * I2C, const tI2C_Script_Step * Steps, uint16_t Address_Size,
+                             void (*Done_CallBack)(void *, bool), void * CallBack_Data, tTxn * Txn);
+static void I2C_Script_Continue(tI2C_Script * Script);
+static void I2C_Script_Op_Done(void * Data, bool OK);
+static VOID I2C_Script_Timer_Expired(ULONG Arg);
+
+/**
+ * @brief: Starts Steps on I2C. Returns at once; the steps run from the I2C completions and the
+ * script timer, Done_CallBack(CallBack_Data, ok) runs when the script ends.
+ *
+ * @params: Script run state (kept until the end), I2C, Steps ending in I2C_SCRIPT_END,
+ * Address_Size register address size, Done_CallBack (may be NULL) and its CallBack_Data
+ *
+ * @return: false if Script is still running or its timer cannot be created
+ */
+bool I2C_Script_Start(tI2C_Script * Script, tI2C * I2C, const tI2C_Script_Step * Steps, uint16_t Address_Size,
+                      void (*Done_CallBack)(void *, bool), void * CallBack_Data){
+    return I2C_Script_Begin(Script, I2C, Steps, Address_Size, Done_CallBack, CallBack_Data, NULL);
+}
+
+static void I2C_Script_Txn_Done(void * Data, bool OK){
+    tI2C_Script * Script = (tI2C_Script *)Data;
+    Txn_Complete(Script->Txn, OK);
+}
+
+/* I2C_Script_Start with a handle of Set that completes when the script ends, NULL if not started */
+tTxn * I2C_Script_Run(tI2C_Script * Script, tI2C * I2C, const tI2C_Script_Step * Steps, uint16_t Address_Size, tTxn_Set * Set){
+    tTxn * Txn = Txn_Open(Set);
+    if (Txn == NULL){
+        return NULL;
+    }
+    if (!I2C_Script_Begin(Script, I2C, Steps, Address_Size, I2C_Script_Txn_Done, Script, Txn)){
+        Txn_Complete(Txn, false);
+        Txn_Release(Txn);
+        return NULL;
+    }
+    return Txn;
+}
+
+/* Everything is set before the first op is queued: its completion can preempt the caller */
+static bool I2C_Script_Begin(tI2C_Script * Script, tI2C * I2C, const tI2C_Script_Step * Steps, uint16_t Address_Size,
+                             void (*Done_CallBack)(void *, bool), void * CallBack_Data, tTxn * Txn){
+    if (Script->Timer_Created && Script->Status == eI2C_Script_Running){
+        return false;
+    }
+    if (!Script->Timer_Created){
+        if (tx_timer_create(&Script->Timer, "I2C script", I2C_Script_Timer_Expired, (ULONG)Script, 1, 0, TX_NO_ACTIVATE) != TX_SUCCESS){
+            LOG_ERROR(I2C, "I2C_Script_Start: timer create failed\r\n");
+            return false;
+        }
+        Script->Timer_Created = true;
+    }
+    Script->I2C = I2C;
+    Script->Steps = Steps;
+    Script->Address_Size = Address_Size;
+    Script->Index = 0;
+    Script->Phase = 0;
+    Script->Step_Tick = tx_time_get();
+    Script->Failed_Step = 0;
+    Script->Done_CallBack = Done_CallBack;
+    Script->CallBack_Data = CallBack_Data;
+    Script->Txn = Txn;
+    Script->Status = eI2C_Script_Running;
+    I2C_Script_Continue(Script);
+    return true;
+}
+
+static void I2C_Script_End(tI2C_Script * Script, bool OK){
+    if (!OK){
+        Script->Failed_Step = Script->Index;
+        LOG_WARN(I2C, "addr 0x%02X script failed at step %u\r\n", Script->I2C->Device_Address, Script->Index);
+    }
+    Script->Status = OK ? eI2C_Script_Done : eI2C_Script_Failed;
+    if (Script->Done_CallBack != NULL){
+        Script->Done_CallBack(Script->CallBack_Data, OK);
+    }
+}
+
+static void I2C_Script_Next_Step(tI2C_Script * Script, uint16_t Skip){
+    Script->Index += 1 + Skip;
+    Script->Phase = 0;
+    Script->Step_Tick = tx_time_get();
+}
+
+static void I2C_Script_Sleep(tI2C_Script * Script, ULONG Ticks){
+    tx_timer_deactivate(&Script->Timer);
+    tx_timer_change(&Script->Timer, (Ticks > 0) ? Ticks : 1, 0);
+    tx_timer_activate(&Script->Timer);
+}
+
+static ULONG I2C_Script_Ticks(uint16_t Ms){
+    return ((ULONG)Ms * TX_TIMER_TICKS_PER_SECOND + 999U) / 1000U;
+}
+
+/* Queues the step's register op; an empty packet pool is waited out on the timer, not failed */
+static void I2C_Script_Queue(tI2C_Script * Script, eOp_Type Op_type, uint8_t * Data){
+    const tI2C_Script_Step * step = &Script->Steps[Script->Index];
+    if (!I2C_Queue_Notify(Script->I2C, Op_type, step->Reg, Script->Address_Size, Data, 1, I2C_SCRIPT_TRIES,
+                          I2C_Script_Op_Done, Script)){
+        I2C_Script_Sleep(Script, 1);
+    }
+}
+
+/**
+ * @brief: Runs steps from Index until one has to wait for the bus or the timer. Steps that need no
+ * bus (a decided If, a met Poll) follow on in the same call.
+ */
+static void I2C_Script_Continue(tI2C_Script * Script){
+    while (Script->Status == eI2C_Script_Running){
+        const tI2C_Script_Step * step = &Script->Steps[Script->Index];
+        bool match = ((Script->Read_Byte & step->Mask) == (step->Value & step->Mask));
+
+        switch ((eI2C_Script_Op)step->Op){
+            case eI2C_Script_End:
+                I2C_Script_End(Script, true);
+                return;
+            case eI2C_Script_Write:
+                // straight from the table, the HAL only reads it
+                I2C_Script_Queue(Script, eI2C_MemWrite, (uint8_t *)&step->Value);
+                return;
+            case eI2C_Script_Modify:
+                if (Script->Phase == 0){
+                    I2C_Script_Queue(Script, eI2C_MemRead, &Script->Read_Byte);
+                    return;
+                }
+                if (Script->Phase == 1){
+                    Script->Write_Byte = (uint8_t)((Script->Read_Byte & ~step->Mask) | (step->Value & step->Mask));
+                    Script->Phase = 2;
+                }
+                I2C_Script_Queue(Script, eI2C_MemWrite, &Script->Write_Byte);
+                return;
+            case eI2C_Script_Delay:
+                if (Script->Phase == 0){
+                    Script->Phase = 1;
+                    I2C_Script_Sleep(Script, I2C_Script_Ticks(step->Arg));
+                    return;
+                }
+                I2C_Script_Next_Step(Script, 0);
+                break;
+            case eI2C_Script_Poll:
+                if (Script->Phase == 0){
+                    I2C_Script_Queue(Script, eI2C_MemRead, &Script->Read_Byte);
+                    return;
+                }
+                if (match){
+                    I2C_Script_Next_Step(Script, 0);
+                    break;
+                }
+                if (tx_time_get() - Script->Step_Tick >= I2C_Script_Ticks(step->Arg)){
+                    I2C_Script_End(Script, false);
+                    return;
+                }
+                Script->Phase = 0;
+                I2C_Script_Sleep(Script, I2C_SCRIPT_POLL_TICKS);
+                return;
+            case eI2C_Script_If:
+                if (Script->Phase == 0){
+                    I2C_Script_Queue(Script, eI2C_MemRead, &Script->Read_Byte);
+                    return;
+                }
+                I2C_Script_Next_Step(Script, match ? 0 : step->Arg);
+                break;
+            default:
+                I2C_Script_End(Script, false);
+                return;
+        }
+    }
+}
+
+/* Finish callback of every op the script queues: DEFER thread, bus held */
+static void I2C_Script_Op_Done(void * Data, bool OK){
+    tI2C_Script * Script = (tI2C_Script *)Data;
+    const tI2C_Script_Step * step = &Script->Steps[Script->Index];
+
+    if (!OK){
+        I2C_Script_End(Script, false);
+        return;
+    }
+    if (step->Op == eI2C_Script_Write || (step->Op == eI2C_Script_Modify && Script->Phase == 2)){
+        I2C_Script_Next_Step(Script, 0);
+    } else {
+        Script->Phase = 1;
+    }
+    I2C_Script_Continue(Script);
+}
+
+static void I2C_Script_Timer_Work(void * Arg, uint32_t Data){
+    (void)Data;
+    I2C_Script_Continue((tI2C_Script *)Arg);
+}
+
+/* Timer thread: the step goes on on the DEFER thread, like the op completions */
+static VOID I2C_Script_Timer_Expired(ULONG Arg){
+    if (!Defer_Post(I2C_Script_Timer_Work, (void *)Arg, 0)){
+        // ring full: try again next tick rather than lose the script
+        I2C_Script_Sleep((tI2C_Script *)Arg, 1);
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * I2C_Script.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef I2C_I2C_SCRIPT_H_
+#define I2C_I2C_SCRIPT_H_
+
+#include "I2C.h"
+
+/**
+ * USAGE:
+ * Register init sequences as const tables (they stay in flash) that run on the I2C engine as one job.
+ * 1) Write the sequence with the step macros, ending in I2C_SCRIPT_END:
+ *      static const tI2C_Script_Step imu_init[] = {
+ *          I2C_SCRIPT_WRITE(CTRL3_C, 0x01),                  software reset
+ *          I2C_SCRIPT_POLL(CTRL3_C, 0x01, 0x00, 50),         until the reset bit clears, 50 ms at most
+ *          I2C_SCRIPT_IF(WHO_AM_I, 0xFF, 0x6C, 1),           next step only on the right part
+ *          I2C_SCRIPT_WRITE(CTRL1_XL, 0x60),
+ *          I2C_SCRIPT_MODIFY(CTRL3_C, 0x44, 0x44),           set BDU and IF_INC, keep the other bits
+ *          I2C_SCRIPT_DELAY(10),
+ *          I2C_SCRIPT_END
+ *      };
+ * 2) I2C_Script_Start(&script, imu, imu_init, I2C_MEMADD_SIZE_8BIT, On_Done, ctx) and carry on, or
+ *    I2C_Script_Run(&script, imu, imu_init, I2C_MEMADD_SIZE_8BIT, &set) for a handle to Txn_Wait on.
+ *    tI2C_Script holds the run state: zeroed before its first start (static, or memset), valid until
+ *    the script ends, reusable after.
+ * 3) Each step queues its op from the completion of the one before, on the DEFER thread while the
+ *    bus is still held, so the ops go out back to back with no thread woken in between. Delays and
+ *    poll intervals run on the script's timer and leave the bus to the other devices meanwhile.
+ * 4) I2C_SCRIPT_IF reads Reg and, unless (value & Mask) == Value, skips the next Skip steps.
+ *    I2C_SCRIPT_POLL fails the script when the condition is not met within its timeout.
+ * 5) The script stops at the first op that fails after I2C_SCRIPT_TRIES tries (or is dropped by
+ *    Reset_I2C); Failed_Step holds its index. On_Done(ctx, ok) runs on the DEFER thread.
+ */
+
+#define I2C_SCRIPT_TRIES        3   /* tries of every op a script queues */
+#define I2C_SCRIPT_POLL_TICKS   1   /* between reads of a poll step */
+
+typedef enum {
+    eI2C_Script_End = 0,
+    eI2C_Script_Write,          // Reg = Value
+    eI2C_Script_Modify,         // Reg = (Reg & ~Mask) | (Value & Mask)
+    eI2C_Script_Delay,          // wait Arg ms
+    eI2C_Script_Poll,           // read Reg until (Reg & Mask) == Value, for Arg ms at most
+    eI2C_Script_If,             // read Reg, skip Arg steps unless (Reg & Mask) == Value
+} eI2C_Script_Op;
+
+typedef enum {
+    eI2C_Script_Idle = 0,
+    eI2C_Script_Running,
+    eI2C_Script_Done,
+    eI2C_Script_Failed,
+} eI2C_Script_Status;
+
+typedef struct {
+    uint8_t Op;                 // eI2C_Script_Op, a byte to keep tables small
+    uint8_t Mask;
+    uint8_t Value;
+    uint16_t Reg;
+    uint16_t Arg;               // ms for Delay / Poll, steps to skip for If
+} tI2C_Script_Step;
+
+#define I2C_SCRIPT_WRITE(reg, value)                { eI2C_Script_Write, 0xFF, (value), (reg), 0 }
+#define I2C_SCRIPT_MODIFY(reg, mask, value)         { eI2C_Script_Modify, (mask), (value), (reg), 0 }
+#define I2C_SCRIPT_DELAY(ms)                        { eI2C_Script_Delay, 0, 0, 0, (ms) }
+#define I2C_SCRIPT_POLL(reg, mask, value, ms)       { eI2C_Script_Poll, (mask), (value), (reg), (ms) }
+#define I2C_SCRIPT_IF(reg, mask, value, skip)       { eI2C_Script_If, (mask), (value), (reg), (skip) }
+#define I2C_SCRIPT_END                              { eI2C_Script_End, 0, 0, 0, 0 }
+
+typedef struct {
+    tI2C * I2C;
+    const tI2C_Script_Step * Steps;
+    uint16_t Address_Size;          // I2C_MEMADD_SIZE_8BIT / _16BIT
+    uint16_t Index;                 // step running
+    uint8_t Phase;                  // 0 op to queue, 1 read in, 2 write of a modify queued
+    uint8_t Read_Byte;
+    uint8_t Write_Byte;
+    ULONG Step_Tick;                // when the step started, for poll timeouts
+    TX_TIMER Timer;                 // delays, poll intervals, a retry when the packet pool is empty
+    bool Timer_Created;
+    volatile eI2C_Script_Status Status;
+    uint16_t Failed_Step;
+    void (*Done_CallBack)(void *, bool);
+    void * CallBack_Data;
+    tTxn * Txn;
+} tI2C_Script;
+
+bool I2C_Script_Start(tI2C_Script * Script, tI2C * I2C, const tI2C_Script_Step * Steps, uint16_t Address_Size,
+                      void (*Done_CallBack)(void *, bool), void * CallBack_Data);
+tTxn * I2C_Script_Run(tI2C_Script * Script, tI2C * I2C, const tI2C_Script_Step * Steps, uint16_t Address_Size, tTxn_Set * Set);
+
+#endif /* I2C_I2C_SCRIPT_H_ */
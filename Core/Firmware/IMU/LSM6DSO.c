@@ -0,0 +1,652 @@
+/*
+ * LSM6DSO.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <string.h>
+#include "LSM6DSO.h"
+#ifndef LSM6DSO_SIMULATION
+#include "main.h"
+#include "../../Middlewares/Defer/defer.h"
+#include "../../Middlewares/Console/Thread_Console.h"
+#include "../../Middlewares/Log/log.h"
+#endif
+
+#define LSM6DSO_HAVE_ACCEL      0x01
+#define LSM6DSO_HAVE_GYRO       0x02
+
+_Static_assert((LSM6DSO_SAMPLES & (LSM6DSO_SAMPLES - 1)) == 0, "LSM6DSO_SAMPLES must be a power of two");
+
+/* Output rates by ODR code, 0.1 Hz */
+static const uint32_t lsm6dso_rates[] = { 0, 125, 260, 520, 1040, 2080, 4170, 8330, 16670, 33330, 66670 };
+
+static tLSM6DSO * lsm6dso_devices[LSM6DSO_MAX_DEVICES];
+static uint8_t lsm6dso_count;
+
+static void LSM6DSO_Int1(void * Param, uint32_t Time);
+static void LSM6DSO_Drain(void * Arg, uint32_t Data);
+static void LSM6DSO_Read_Status(tLSM6DSO * Imu);
+static void LSM6DSO_Status_Done(void * Data, bool OK);
+static void LSM6DSO_Burst_Done(void * Data, bool OK);
+static bool LSM6DSO_Listed(const tLSM6DSO * Imu);
+static bool LSM6DSO_Stop(tLSM6DSO * Imu);
+
+#ifdef LSM6DSO_SIMULATION
+/* Host: no log module, a failure shows in the return value */
+#define LOG_ERROR(Module, ...)  do { } while (0)
+
+/* The model answers at once; the completion runs inline, as DMA_SIMULATION does for copies */
+static bool LSM6DSO_Bus_Read(tLSM6DSO * Imu, uint8_t Reg, uint8_t * Data, uint16_t Size, void (*Done)(void *, bool))
+{
+    Done(Imu, LSM6DSO_Sim_Read(Imu->Bus, Reg, Data, Size));
+    return true;
+}
+
+/* No register shadow on a host (it takes a ThreadX mutex): straight to the model */
+static bool LSM6DSO_Reg_Read(tLSM6DSO * Imu, uint8_t Reg, uint8_t * Value)
+{
+    return LSM6DSO_Sim_Read(Imu->Bus, Reg, Value, 1);
+}
+
+static bool LSM6DSO_Reg_Write(tLSM6DSO * Imu, uint8_t Reg, uint8_t Value)
+{
+    return LSM6DSO_Sim_Write(Imu->Bus, Reg, &Value, 1);
+}
+
+static bool LSM6DSO_Reg_Modify(tLSM6DSO * Imu, uint8_t Reg, uint8_t Mask, uint8_t Value)
+{
+    uint8_t current;
+    return LSM6DSO_Reg_Read(Imu, Reg, &current) && LSM6DSO_Reg_Write(Imu, Reg, (uint8_t)((current & ~Mask) | (Value & Mask)));
+}
+#else
+static VOID LSM6DSO_Retry_Expired(ULONG Arg);
+static void LSM6DSO_Command(const char * args);
+
+CONSOLE_COMMAND("imu", "LSM6DSO FIFO: rate, interrupts, bursts, samples, losses", NULL, .Args_Function = LSM6DSO_Command);
+
+/* Queued on the I2C engine, Done runs on the DEFER thread with the bus still held */
+static bool LSM6DSO_Bus_Read(tLSM6DSO * Imu, uint8_t Reg, uint8_t * Data, uint16_t Size, void (*Done)(void *, bool))
+{
+    return I2C_Queue_Notify(Imu->Bus, eI2C_MemRead, Reg, I2C_MEMADD_SIZE_8BIT, Data, Size, LSM6DSO_TRIES, Done, Imu);
+}
+
+static bool LSM6DSO_Reg_Read(tLSM6DSO * Imu, uint8_t Reg, uint8_t * Value)
+{
+    return Regs_Read(&Imu->Regs, Reg, Value);
+}
+
+static bool LSM6DSO_Reg_Write(tLSM6DSO * Imu, uint8_t Reg, uint8_t Value)
+{
+    return Regs_Write(&Imu->Regs, Reg, Value);
+}
+
+static bool LSM6DSO_Reg_Modify(tLSM6DSO * Imu, uint8_t Reg, uint8_t Mask, uint8_t Value)
+{
+    return Regs_Modify(&Imu->Regs, Reg, Mask, Value);
+}
+#endif
+
+/* Interrupts off around the drain flags; a host build has no interrupts */
+static inline uint32_t LSM6DSO_Lock(void)
+{
+#ifdef LSM6DSO_SIMULATION
+    return 0;
+#else
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+#endif
+}
+
+static inline void LSM6DSO_Unlock(uint32_t Primask)
+{
+#ifdef LSM6DSO_SIMULATION
+    (void)Primask;
+#else
+    __set_PRIMASK(Primask);
+#endif
+}
+
+static void LSM6DSO_Signal(tLSM6DSO * Imu, uint32_t Flags)
+{
+#ifdef LSM6DSO_SIMULATION
+    Imu->Events |= Flags;
+#else
+    tx_event_flags_set(&Imu->Events, Flags, TX_OR);
+#endif
+}
+
+/* Hands a drain to the DEFER thread; false if its ring is full. Inline on a host. */
+static bool LSM6DSO_Post_Drain(tLSM6DSO * Imu)
+{
+#ifdef LSM6DSO_SIMULATION
+    LSM6DSO_Drain(Imu, 0);
+    return true;
+#else
+    return Defer_Post(LSM6DSO_Drain, Imu, 0);
+#endif
+}
+
+static void LSM6DSO_Arm_Retry(tLSM6DSO * Imu, uint32_t Ticks)
+{
+#ifdef LSM6DSO_SIMULATION
+    // the model never fails a read and the drain never waits for a DEFER slot
+    (void)Imu;
+    (void)Ticks;
+#else
+    tx_timer_deactivate(&Imu->Retry_Timer);
+    tx_timer_change(&Imu->Retry_Timer, Ticks, 0);
+    tx_timer_activate(&Imu->Retry_Timer);
+#endif
+}
+
+/* Waits out the software reset; the model resets at once */
+static bool LSM6DSO_Reset_Done(tLSM6DSO * Imu)
+{
+    uint8_t value = 0;
+#ifdef LSM6DSO_SIMULATION
+    return LSM6DSO_Reg_Read(Imu, LSM6DSO_CTRL3_C, &value) && !(value & LSM6DSO_CTRL3_SW_RESET);
+#else
+    for (ULONG start = tx_time_get(); ; tx_thread_sleep(1)) {
+        if (LSM6DSO_Reg_Read(Imu, LSM6DSO_CTRL3_C, &value) && !(value & LSM6DSO_CTRL3_SW_RESET)) {
+            return true;
+        }
+        if (tx_time_get() - start >= LSM6DSO_RESET_TICKS) {
+            return false;
+        }
+    }
+#endif
+}
+
+/* Input clock of the timestamp timer: PCLK1, doubled by the timer when APB1 is divided */
+static uint32_t LSM6DSO_Timer_Hz(const tLSM6DSO * Imu)
+{
+#ifdef LSM6DSO_SIMULATION
+    return Imu->Bus->Timer_Hz;
+#else
+    uint32_t hz = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) {
+        hz *= 2;
+    }
+    return hz / (Imu->Config.Timer->Instance->PSC + 1);
+#endif
+}
+
+/* SCL period of the bus the part is on */
+static uint32_t LSM6DSO_Bit_Ns(const tLSM6DSO * Imu)
+{
+#ifdef LSM6DSO_SIMULATION
+    return Imu->Bus->Bit_Ns;
+#else
+    return Imu->Bus->Bus->Bit_Ns;
+#endif
+}
+
+/**
+ * @brief: Words per burst so the burst stays within LSM6DSO_BURST_US on the wire: 9 clocks a byte,
+ * 4 bytes of address, register and repeated address on top. Whole samples (two words), at least
+ * one, at most LSM6DSO_BURST_WORDS.
+ */
+static uint16_t LSM6DSO_Burst_Words(const tLSM6DSO * Imu)
+{
+    uint32_t bit_ns = LSM6DSO_Bit_Ns(Imu);
+    uint32_t bytes = (bit_ns != 0) ? (uint32_t)(((uint64_t)LSM6DSO_BURST_US * 1000U) / (9U * bit_ns)) : UINT32_MAX;
+    uint32_t words = (bytes > 4) ? ((bytes - 4) / LSM6DSO_WORD_SIZE) & ~1U : 0;
+
+    if (words < 2) {
+        words = 2;
+    }
+    return (uint16_t)((words > LSM6DSO_BURST_WORDS) ? LSM6DSO_BURST_WORDS : words);
+}
+
+/* Configuration through the shadow: control and FIFO registers are write-through, the rest volatile */
+static bool LSM6DSO_Configure(tLSM6DSO * Imu)
+{
+    const tLSM6DSO_Config * config = &Imu->Config;
+    bool ok = true;
+
+#ifndef LSM6DSO_SIMULATION
+    tRegs * regs = &Imu->Regs;
+    Regs_Set_Policy(regs, LSM6DSO_FIFO_CTRL1, LSM6DSO_CTRL9_XL - LSM6DSO_FIFO_CTRL1 + 1, eRegs_Write_Through);
+    Regs_Set_Policy(regs, LSM6DSO_WHO_AM_I, 1, eRegs_Volatile);
+    // the FIFO block goes out as one burst on the flush
+    Regs_Set_Policy(regs, LSM6DSO_FIFO_CTRL1, 4, eRegs_Cached);
+#endif
+
+    ok &= LSM6DSO_Reg_Modify(Imu, LSM6DSO_CTRL3_C, LSM6DSO_CTRL3_BDU | LSM6DSO_CTRL3_IF_INC, LSM6DSO_CTRL3_BDU | LSM6DSO_CTRL3_IF_INC);
+    ok &= LSM6DSO_Reg_Modify(Imu, LSM6DSO_CTRL9_XL, LSM6DSO_CTRL9_I3C_DISABLE, LSM6DSO_CTRL9_I3C_DISABLE);
+    ok &= LSM6DSO_Reg_Write(Imu, LSM6DSO_FIFO_CTRL1, (uint8_t)Imu->Watermark_Words);
+    ok &= LSM6DSO_Reg_Write(Imu, LSM6DSO_FIFO_CTRL2, (uint8_t)(Imu->Watermark_Words >> 8));
+    ok &= LSM6DSO_Reg_Write(Imu, LSM6DSO_FIFO_CTRL3, (uint8_t)((config->Odr << 4) | config->Odr));
+    ok &= LSM6DSO_Reg_Write(Imu, LSM6DSO_FIFO_CTRL4, LSM6DSO_FIFO_MODE_STREAM);
+#ifndef LSM6DSO_SIMULATION
+    ok &= Regs_Flush(regs);
+#endif
+    ok &= LSM6DSO_Reg_Write(Imu, LSM6DSO_INT1_CTRL, LSM6DSO_INT1_FIFO_TH);
+    ok &= LSM6DSO_Reg_Write(Imu, LSM6DSO_CTRL1_XL, (uint8_t)((config->Odr << 4) | (config->Accel_Scale & 0x0C)));
+    ok &= LSM6DSO_Reg_Write(Imu, LSM6DSO_CTRL2_G, (uint8_t)((config->Odr << 4) | (config->Gyro_Scale & 0x0C)));
+    return ok;
+}
+
+/**
+ * @brief: Resets the LSM6DSO on Bus, configures both sensors at Config->Odr with the FIFO in
+ * continuous mode and its watermark on INT1, and starts taking samples. Thread context: the
+ * configuration uses the blocking bus helpers.
+ *
+ * @params: Imu (kept for as long as it runs), Bus the device handle, Config copied
+ *
+ * @return: false if the part does not answer as an LSM6DSO, the config is out of range, a
+ * resource cannot be created or the configuration fails; everything Init did is undone then
+ */
+bool LSM6DSO_Init(tLSM6DSO * Imu, tLSM6DSO_Bus * Bus, const tLSM6DSO_Config * Config)
+{
+    uint8_t value = 0;
+
+    if (Config->Watermark == 0 || Config->Watermark > LSM6DSO_WATERMARK_MAX
+        || Config->Odr < eLSM6DSO_Odr_104Hz || Config->Odr > eLSM6DSO_Odr_6666Hz
+        || lsm6dso_count >= LSM6DSO_MAX_DEVICES || LSM6DSO_Listed(Imu)) {
+        return false;
+    }
+    memset(Imu, 0, sizeof(*Imu));
+    Imu->Bus = Bus;
+    Imu->Config = *Config;
+    Imu->Watermark_Words = (uint16_t)(Config->Watermark * 2);
+    Imu->Burst_Words = LSM6DSO_Burst_Words(Imu);
+    Ring_Init(&Imu->Ring, (uint8_t *)Imu->Samples, sizeof(Imu->Samples));
+
+#ifndef LSM6DSO_SIMULATION
+    if (!Regs_Init(&Imu->Regs, "lsm6dso", I2C_Regs_Read, I2C_Regs_Write, Bus, 0, LSM6DSO_REG_COUNT, true)) {
+        return false;
+    }
+#endif
+    if (!LSM6DSO_Reg_Read(Imu, LSM6DSO_WHO_AM_I, &value) || value != LSM6DSO_WHO_AM_I_VALUE) {
+        LOG_ERROR(APP, "LSM6DSO: WHO_AM_I 0x%02X\r\n", value);
+        goto fail_regs;
+    }
+    LSM6DSO_Reg_Write(Imu, LSM6DSO_CTRL3_C, LSM6DSO_CTRL3_SW_RESET);
+    if (!LSM6DSO_Reset_Done(Imu)) {
+        LOG_ERROR(APP, "LSM6DSO: reset did not finish\r\n");
+        goto fail_regs;
+    }
+
+#ifdef LSM6DSO_SIMULATION
+    Bus->Int1_Handler = LSM6DSO_Int1;
+    Bus->Int1_Param = Imu;
+#else
+    Regs_Invalidate(&Imu->Regs);
+    if (tx_event_flags_create(&Imu->Events, "LSM6DSO") != TX_SUCCESS) {
+        goto fail_regs;
+    }
+    if (tx_timer_create(&Imu->Retry_Timer, "LSM6DSO retry", LSM6DSO_Retry_Expired, (ULONG)Imu,
+                        LSM6DSO_RETRY_TICKS, 0, TX_NO_ACTIVATE) != TX_SUCCESS) {
+        goto fail_events;
+    }
+    if (!(Config->Timer->Instance->CR1 & TIM_CR1_CEN)) {
+        HAL_TIM_Base_Start(Config->Timer);
+    }
+#endif
+    Imu->Timer_Hz = LSM6DSO_Timer_Hz(Imu);
+    Imu->Nominal_Q8 = (uint32_t)(((uint64_t)Imu->Timer_Hz * 10U << 8) / lsm6dso_rates[Config->Odr]);
+    Imu->Period_Q8 = Imu->Nominal_Q8;
+
+    // listed before INT1 is enabled: the first edge must find the device
+    uint32_t primask = LSM6DSO_Lock();
+    lsm6dso_devices[lsm6dso_count++] = Imu;
+    LSM6DSO_Unlock(primask);
+
+    if (!LSM6DSO_Configure(Imu)) {
+        LOG_ERROR(APP, "LSM6DSO: configuration failed\r\n");
+        if (!LSM6DSO_Stop(Imu)) {
+            // the drain still holds the objects; they cannot go from under it
+            LOG_ERROR(APP, "LSM6DSO: drain did not stop\r\n");
+            return false;
+        }
+        goto fail_timer;
+    }
+    return true;
+
+fail_timer:
+#ifndef LSM6DSO_SIMULATION
+    tx_timer_delete(&Imu->Retry_Timer);
+fail_events:
+    tx_event_flags_delete(&Imu->Events);
+#endif
+fail_regs:
+#ifndef LSM6DSO_SIMULATION
+    Regs_Deinit(&Imu->Regs);
+#endif
+    return false;
+}
+
+/* Imu is on the device list, so its INT1 edges are taken */
+static bool LSM6DSO_Listed(const tLSM6DSO * Imu)
+{
+    for (uint8_t i = 0; i < lsm6dso_count; i++) {
+        if (lsm6dso_devices[i] == Imu) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief: Takes a listed device down after a failed Init: off the list so no edge starts a drain,
+ * INT1 and both sensors off (best effort, the bus may be what failed), then waits for a drain in
+ * flight to end at its next step (LSM6DSO_Read_Status), which takes at most a retried bus read and
+ * a retry wait.
+ *
+ * @return: false if the drain was still running after LSM6DSO_STOP_TICKS
+ */
+static bool LSM6DSO_Stop(tLSM6DSO * Imu)
+{
+    uint32_t primask = LSM6DSO_Lock();
+    for (uint8_t i = 0; i < lsm6dso_count; i++) {
+        if (lsm6dso_devices[i] == Imu) {
+            lsm6dso_devices[i] = lsm6dso_devices[--lsm6dso_count];
+            break;
+        }
+    }
+    Imu->Stopping = true;
+    LSM6DSO_Unlock(primask);
+#ifdef LSM6DSO_SIMULATION
+    Imu->Bus->Int1_Handler = NULL;
+#endif
+
+    LSM6DSO_Reg_Write(Imu, LSM6DSO_INT1_CTRL, 0);
+    LSM6DSO_Reg_Write(Imu, LSM6DSO_CTRL1_XL, 0);
+    LSM6DSO_Reg_Write(Imu, LSM6DSO_CTRL2_G, 0);
+#ifndef LSM6DSO_SIMULATION
+    for (ULONG start = tx_time_get(); Imu->Draining; tx_thread_sleep(1)) {
+        if (tx_time_get() - start >= LSM6DSO_STOP_TICKS) {
+            return false;
+        }
+    }
+#endif
+    // a host drain runs inline from the edge, it is over by now
+    return !Imu->Draining;
+}
+
+/* Copies up to Count of the oldest samples out, returns how many. One consumer. */
+uint32_t LSM6DSO_Read(tLSM6DSO * Imu, tLSM6DSO_Sample * Samples, uint32_t Count)
+{
+    uint32_t available = Ring_Used(&Imu->Ring) / sizeof(tLSM6DSO_Sample);
+    if (Count > available) {
+        Count = available;
+    }
+    return Ring_Read(&Imu->Ring, (uint8_t *)Samples, Count * sizeof(tLSM6DSO_Sample)) / sizeof(tLSM6DSO_Sample);
+}
+
+uint32_t LSM6DSO_Available(tLSM6DSO * Imu)
+{
+    return Ring_Used(&Imu->Ring) / sizeof(tLSM6DSO_Sample);
+}
+
+#ifndef LSM6DSO_SIMULATION
+/* From HAL_GPIO_EXTI_Callback: the timer is read first so the edge time is as close as it gets */
+void LSM6DSO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    for (uint8_t i = 0; i < lsm6dso_count; i++) {
+        tLSM6DSO * imu = lsm6dso_devices[i];
+        if (imu->Config.Int1_Pin == GPIO_Pin) {
+            LSM6DSO_Int1(imu, imu->Config.Timer->Instance->CNT);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief: Watermark edge, interrupt context. An edge while no words are leaving the FIFO marks the
+ * arrival of the watermark-th unread sample at Time and is kept for the timestamps; one during a
+ * burst is only noted, so the drain goes round once more before it stops.
+ */
+static void LSM6DSO_Int1(void * Param, uint32_t Time)
+{
+    tLSM6DSO * Imu = (tLSM6DSO *)Param;
+
+    Imu->Interrupts++;
+    uint32_t primask = LSM6DSO_Lock();
+    if (!Imu->Burst_Active) {
+        Imu->Edge_Time = Time;
+        Imu->Edge_Valid = true;
+    }
+    bool start = !Imu->Draining;
+    Imu->Draining = true;
+    Imu->Pending = !start;
+    LSM6DSO_Unlock(primask);
+
+    if (start && !LSM6DSO_Post_Drain(Imu)) {
+        // ring full: the timer posts it, INT1 stays high until the FIFO is read anyway
+        LSM6DSO_Arm_Retry(Imu, 1);
+    }
+}
+
+static void LSM6DSO_Retry(tLSM6DSO * Imu)
+{
+    LSM6DSO_Signal(Imu, LSM6DSO_EVENT_ERROR);
+    LSM6DSO_Arm_Retry(Imu, LSM6DSO_RETRY_TICKS);
+}
+
+#ifndef LSM6DSO_SIMULATION
+static VOID LSM6DSO_Retry_Expired(ULONG Arg)
+{
+    tLSM6DSO * imu = (tLSM6DSO *)Arg;
+    if (!LSM6DSO_Post_Drain(imu)) {
+        tx_timer_change(&imu->Retry_Timer, 1, 0);
+        tx_timer_activate(&imu->Retry_Timer);
+    }
+}
+#endif
+
+/* DEFER thread: start of a drain, from an edge or the retry timer */
+static void LSM6DSO_Drain(void * Arg, uint32_t Data)
+{
+    (void)Data;
+    tLSM6DSO * imu = (tLSM6DSO *)Arg;
+
+    imu->Pending = false;
+    LSM6DSO_Read_Status(imu);
+}
+
+static void LSM6DSO_Read_Status(tLSM6DSO * Imu)
+{
+    // every step of a drain comes through here; LSM6DSO_Stop waits for this
+    if (Imu->Stopping) {
+        uint32_t primask = LSM6DSO_Lock();
+        Imu->Draining = false;
+        Imu->Pending = false;
+        LSM6DSO_Unlock(primask);
+        return;
+    }
+    if (!LSM6DSO_Bus_Read(Imu, LSM6DSO_FIFO_STATUS1, Imu->Status, sizeof(Imu->Status), LSM6DSO_Status_Done)) {
+        LSM6DSO_Retry(Imu);
+    }
+}
+
+/* The FIFO is under the watermark and a burst: stop, unless an edge came in since the last status read */
+static void LSM6DSO_Drain_End(tLSM6DSO * Imu)
+{
+    uint32_t primask = LSM6DSO_Lock();
+    bool again = Imu->Pending;
+    Imu->Pending = false;
+    Imu->Draining = again;
+    LSM6DSO_Unlock(primask);
+
+    if (again) {
+        LSM6DSO_Read_Status(Imu);
+    }
+}
+
+/**
+ * @brief: Places the last edge: sample (words read + watermark words - 1) / 2 arrived at its time.
+ * The period is the time between two placed edges over the samples between them, smoothed, and
+ * edges far off the nominal rate (a masked EXTI, a missed edge) are not used for it.
+ */
+static void LSM6DSO_Sync(tLSM6DSO * Imu)
+{
+    uint32_t index = (Imu->Words_Read + Imu->Watermark_Words - 1) / 2;
+    uint32_t time = Imu->Edge_Time;
+
+    Imu->Prev_Period_Q8 = Imu->Period_Q8;
+    if (Imu->Synced && index != Imu->Sync_Index) {
+        uint32_t measured = (uint32_t)(((uint64_t)(time - Imu->Sync_Time) << 8) / (index - Imu->Sync_Index));
+        if (measured > Imu->Nominal_Q8 - Imu->Nominal_Q8 / 4 && measured < Imu->Nominal_Q8 + Imu->Nominal_Q8 / 4) {
+            Imu->Period_Q8 = (uint32_t)((int32_t)Imu->Period_Q8 + ((int32_t)(measured - Imu->Period_Q8)) / 4);
+        }
+    }
+    Imu->Sync_Time = time;
+    Imu->Sync_Index = index;
+    Imu->Synced = true;
+    Imu->Edge_Placed = true;
+}
+
+static uint32_t LSM6DSO_Timestamp(const tLSM6DSO * Imu, uint32_t Index)
+{
+    int32_t offset = (int32_t)(Index - Imu->Sync_Index);
+    return Imu->Sync_Time + (uint32_t)(((int64_t)offset * Imu->Period_Q8) >> 8);
+}
+
+/* DEFER thread, bus held: FIFO_STATUS is in, queue the burst of the words waiting */
+static void LSM6DSO_Status_Done(void * Data, bool OK)
+{
+    tLSM6DSO * imu = (tLSM6DSO *)Data;
+
+    if (!OK) {
+        imu->Bus_Errors++;
+        LSM6DSO_Retry(imu);
+        return;
+    }
+    uint16_t level = (uint16_t)(imu->Status[0] | ((imu->Status[1] & LSM6DSO_STATUS2_DIFF_HIGH) << 8));
+    bool edge = imu->Edge_Valid;
+    imu->Edge_Valid = false;
+    imu->Edge_Placed = false;
+
+    if (imu->Status[1] & LSM6DSO_STATUS2_OVR_LATCHED) {
+        // words were lost: the index of the edge is not known, nor the pairing
+        imu->Overruns++;
+        imu->Synced = false;
+        imu->Have = 0;
+        LSM6DSO_Signal(imu, LSM6DSO_EVENT_ERROR);
+    } else if (edge) {
+        LSM6DSO_Sync(imu);
+    }
+    // full bursts while there are any; under the watermark INT1 is low again and the next edge comes
+    if (level < imu->Watermark_Words && level < imu->Burst_Words) {
+        LSM6DSO_Drain_End(imu);
+        return;
+    }
+    imu->Burst_Count = (level < imu->Burst_Words) ? level : imu->Burst_Words;
+    imu->Burst_Active = true;
+    if (!LSM6DSO_Bus_Read(imu, LSM6DSO_FIFO_DATA_OUT_TAG, imu->Burst, imu->Burst_Count * LSM6DSO_WORD_SIZE, LSM6DSO_Burst_Done)) {
+        imu->Burst_Active = false;
+        LSM6DSO_Retry(imu);
+    }
+}
+
+/**
+ * @brief: Pairs the gyro and accel words of each sample and queues the sample with its timestamp.
+ * The words of one sample share their time slot (TAG_CNT), so a word whose partner was lost is
+ * thrown away rather than paired with the next sample's.
+ */
+static void LSM6DSO_Parse(tLSM6DSO * Imu)
+{
+    uint32_t added = 0;
+
+    for (uint16_t w = 0; w < Imu->Burst_Count; w++) {
+        const uint8_t * word = &Imu->Burst[w * LSM6DSO_WORD_SIZE];
+        uint8_t tag = word[0] >> 3;
+        uint8_t slot = LSM6DSO_TAG_CNT(word[0]);
+        int16_t * axes;
+
+        if (Imu->Have != 0 && slot != Imu->Have_Slot) {
+            // the lost word still counts, so later words keep their sample index. The edge of this
+            // status read was placed without it: its period measurement is taken back and the next
+            // edge anchors the timestamps again.
+            Imu->Unpaired++;
+            Imu->Words_Read++;
+            if (Imu->Edge_Placed) {
+                Imu->Period_Q8 = Imu->Prev_Period_Q8;
+                Imu->Edge_Placed = false;
+            }
+            Imu->Synced = false;
+            Imu->Have = 0;
+        }
+        Imu->Have_Slot = slot;
+        uint32_t index = Imu->Words_Read++;
+        if (tag == LSM6DSO_TAG_GYRO) {
+            axes = Imu->Next.Gyro;
+            Imu->Have |= LSM6DSO_HAVE_GYRO;
+        } else if (tag == LSM6DSO_TAG_ACCEL) {
+            axes = Imu->Next.Accel;
+            Imu->Have |= LSM6DSO_HAVE_ACCEL;
+        } else {
+            continue;
+        }
+        for (uint8_t i = 0; i < 3; i++) {
+            axes[i] = (int16_t)(word[1 + 2 * i] | (word[2 + 2 * i] << 8));
+        }
+        if (Imu->Have != (LSM6DSO_HAVE_ACCEL | LSM6DSO_HAVE_GYRO)) {
+            continue;
+        }
+        Imu->Have = 0;
+        Imu->Next.Timestamp = LSM6DSO_Timestamp(Imu, index / 2);
+        if (Ring_Free(&Imu->Ring) >= sizeof(tLSM6DSO_Sample)) {
+            Ring_Write(&Imu->Ring, (const uint8_t *)&Imu->Next, sizeof(tLSM6DSO_Sample));
+            added++;
+        } else {
+            Imu->Dropped++;
+        }
+    }
+    Imu->Sample_Count += added;
+    if (added != 0) {
+        LSM6DSO_Signal(Imu, LSM6DSO_EVENT_DATA);
+    }
+}
+
+/* DEFER thread, bus held: the burst is in; parse it and check the FIFO again */
+static void LSM6DSO_Burst_Done(void * Data, bool OK)
+{
+    tLSM6DSO * imu = (tLSM6DSO *)Data;
+
+    if (!OK) {
+        // an unknown number of words left the FIFO: resync at the next edge
+        imu->Bus_Errors++;
+        imu->Synced = false;
+        imu->Have = 0;
+        imu->Burst_Active = false;
+        LSM6DSO_Retry(imu);
+        return;
+    }
+    imu->Bursts++;
+    LSM6DSO_Parse(imu);
+    imu->Burst_Active = false;
+    LSM6DSO_Read_Status(imu);
+}
+
+#ifndef LSM6DSO_SIMULATION
+static void LSM6DSO_Command(const char * args)
+{
+    (void)args;
+
+    if (lsm6dso_count == 0) {
+        printd("no LSM6DSO\r\n");
+        return;
+    }
+    for (uint8_t i = 0; i < lsm6dso_count; i++) {
+        const tLSM6DSO * imu = lsm6dso_devices[i];
+        uint32_t period_ns = (uint32_t)(((uint64_t)imu->Period_Q8 * 1000000000U) / ((uint64_t)imu->Timer_Hz << 8));
+        printd("imu%u: odr %lu.%lu Hz, watermark %u, period %lu ns (nominal %lu)%s\r\n", i,
+               (unsigned long)(lsm6dso_rates[imu->Config.Odr] / 10), (unsigned long)(lsm6dso_rates[imu->Config.Odr] % 10),
+               imu->Config.Watermark, (unsigned long)period_ns,
+               (unsigned long)(((uint64_t)imu->Nominal_Q8 * 1000000000U) / ((uint64_t)imu->Timer_Hz << 8)),
+               imu->Synced ? "" : ", not synced");
+        printd("  burst %u words\r\n", imu->Burst_Words);
+        printd("  interrupts %lu  bursts %lu  samples %lu  queued %lu\r\n", (unsigned long)imu->Interrupts,
+               (unsigned long)imu->Bursts, (unsigned long)imu->Sample_Count,
+               (unsigned long)(Ring_Used(&imu->Ring) / sizeof(tLSM6DSO_Sample)));
+        printd("  overruns %lu  dropped %lu  unpaired %lu  bus errors %lu\r\n", (unsigned long)imu->Overruns,
+               (unsigned long)imu->Dropped, (unsigned long)imu->Unpaired, (unsigned long)imu->Bus_Errors);
+    }
+}
+#endif
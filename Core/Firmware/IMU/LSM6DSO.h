@@ -0,0 +1,219 @@
+/*
+ * LSM6DSO.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef IMU_LSM6DSO_H_
+#define IMU_LSM6DSO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../Middlewares/Ring/ring.h"
+#ifdef LSM6DSO_SIMULATION
+#include "LSM6DSO_Sim.h"
+#else
+#include "tx_api.h"
+#include "../Regs/Regs.h"
+#include "../I2C/I2C.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * LSM6DSO accelerometer + gyroscope read through its hardware FIFO, so high output rates cost a
+ * few bus bursts and interrupts per second instead of one transfer and one wakeup per sample.
+ * 1) imu_bus = Init_I2C(&hi2c1, LSM6DSO_ADDRESS), then from a thread:
+ *      tLSM6DSO_Config config = { eLSM6DSO_Odr_1666Hz, LSM6DSO_XL_FS_8G, LSM6DSO_G_FS_2000DPS, 32,
+ *                                 GPIO_PIN_9, &htim2 };
+ *      LSM6DSO_Init(&imu, imu_bus, &config);
+ *    INT1 goes to a pin set up in CubeMX as EXTI rising edge, and HAL_GPIO_EXTI_Callback (main.c)
+ *    forwards to LSM6DSO_EXTI_Callback. Timer is a free-running 32-bit timer (TIM2); it is started
+ *    if it is not running.
+ * 2) Init resets the part, configures it through a register shadow (console "regs lsm6dso") and
+ *    starts the FIFO in continuous mode with the watermark interrupt on INT1. Both sensors are
+ *    batched at the output rate, so each sample is two FIFO words. An Init that fails undoes
+ *    everything it did (the sensors and INT1 are turned off, best effort), so it can be called again
+ *    with the same tLSM6DSO; one that succeeded cannot.
+ * 3) Each watermark edge takes the timer count in the EXTI interrupt and wakes the DEFER thread,
+ *    which reads FIFO_STATUS and then up to Burst_Words words in one DMA burst on the I2C engine, the
+ *    burst queued from the status completion while the bus is held. It repeats until the FIFO holds
+ *    less than the watermark and less than a burst. No thread is woken per sample.
+ * 4) Timestamps: the edge marks the arrival of the watermark-th unread sample, so every sample gets
+ *    edge time + (its index - that index) * sample period, the period tracked from the spacing of
+ *    edges (the part's ODR is only accurate to a few percent). Ticks of Timer.
+ * 5) Samples go into a ring of LSM6DSO_SAMPLES; the consumer waits for LSM6DSO_EVENT_DATA on Events
+ *    and takes them with LSM6DSO_Read. Samples the ring has no room for are counted in Dropped, FIFO
+ *    overruns in Overruns (timestamps re-anchor at the next edge after one). The two words of a
+ *    sample are paired by their TAG_CNT time slot; one whose partner was lost counts in Unpaired
+ *    and is thrown away, and the timestamps re-anchor as after an overrun.
+ * 6) Bus budget: Burst_Words is sized at Init from the SCL period of the bus so a burst spends at
+ *    most LSM6DSO_BURST_US on the wire, well inside the I2C engine's op deadline: 8 words at
+ *    100 kHz (the Timing 0x00303D5B both buses use), 44 at 400 kHz (0x0010061A at 16 MHz), never
+ *    more than LSM6DSO_BURST_WORDS. A sample pair is 14 bytes; with each burst's address bytes and
+ *    its FIFO_STATUS read spread over it, about 150 bits a sample at 100 kHz and 130 at 400 kHz.
+ *    100 kHz carries 416 Hz (about 60% of the bus), 1.66 kHz needs 400 kHz (about 55%).
+ * With LSM6DSO_SIMULATION defined the I2C engine, EXTI line and timer are replaced by the register
+ * model of LSM6DSO_Sim.h and the files need neither ThreadX nor the HAL, so the driver runs on a host
+ * against a simulated part (LSM6DSO_test.c): the configuration goes straight to the model instead of
+ * through a register shadow, Events is a plain word of LSM6DSO_EVENT_* bits the host clears, and the
+ * DEFER work runs inline from the edge. The model never fails a read, so no retry is armed.
+ */
+
+#define LSM6DSO_ADDRESS             (0x6A << 1)     /* SA0 low; 0x6B << 1 with SA0 high */
+#define LSM6DSO_WHO_AM_I_VALUE      0x6C
+
+/* Register map, the ones this driver and the simulation use */
+#define LSM6DSO_FIFO_CTRL1          0x07    /* WTM[7:0] */
+#define LSM6DSO_FIFO_CTRL2          0x08    /* WTM[8] */
+#define LSM6DSO_FIFO_CTRL3          0x09    /* BDR_GY[7:4] BDR_XL[3:0] */
+#define LSM6DSO_FIFO_CTRL4          0x0A    /* FIFO_MODE[2:0] */
+#define LSM6DSO_INT1_CTRL           0x0D
+#define LSM6DSO_WHO_AM_I            0x0F
+#define LSM6DSO_CTRL1_XL            0x10    /* ODR_XL[7:4] FS_XL[3:2] */
+#define LSM6DSO_CTRL2_G             0x11    /* ODR_G[7:4] FS_G[3:2] */
+#define LSM6DSO_CTRL3_C             0x12
+#define LSM6DSO_CTRL9_XL            0x18
+#define LSM6DSO_FIFO_STATUS1        0x3A    /* DIFF_FIFO[7:0] */
+#define LSM6DSO_FIFO_STATUS2        0x3B
+#define LSM6DSO_FIFO_DATA_OUT_TAG   0x78    /* then X_L..Z_H; a burst rolls back to the tag after 0x7E */
+#define LSM6DSO_REG_COUNT           0x80
+
+#define LSM6DSO_CTRL3_SW_RESET      0x01
+#define LSM6DSO_CTRL3_IF_INC        0x04
+#define LSM6DSO_CTRL3_BDU           0x40
+#define LSM6DSO_CTRL9_I3C_DISABLE   0x02
+#define LSM6DSO_INT1_FIFO_TH        0x08
+#define LSM6DSO_FIFO_MODE_BYPASS    0x00
+#define LSM6DSO_FIFO_MODE_STREAM    0x06    /* continuous: the oldest word is overwritten when full */
+#define LSM6DSO_STATUS2_WTM         0x80
+#define LSM6DSO_STATUS2_OVR_LATCHED 0x08
+#define LSM6DSO_STATUS2_DIFF_HIGH   0x03
+#define LSM6DSO_TAG_GYRO            0x01    /* FIFO_DATA_OUT_TAG[7:3] */
+#define LSM6DSO_TAG_ACCEL           0x02
+#define LSM6DSO_TAG_CNT(tag)        (((tag) >> 1) & 0x03)   /* time slot, the same for the words of a sample */
+#define LSM6DSO_WORD_SIZE           7       /* tag + X, Y, Z */
+
+#define LSM6DSO_XL_FS_2G            0x00
+#define LSM6DSO_XL_FS_16G           0x04
+#define LSM6DSO_XL_FS_4G            0x08
+#define LSM6DSO_XL_FS_8G            0x0C
+#define LSM6DSO_G_FS_250DPS         0x00
+#define LSM6DSO_G_FS_500DPS         0x04
+#define LSM6DSO_G_FS_1000DPS        0x08
+#define LSM6DSO_G_FS_2000DPS        0x0C
+
+#define LSM6DSO_MAX_DEVICES         2
+#define LSM6DSO_BURST_WORDS         64      /* most FIFO words per bus burst, 448 bytes, the burst buffer */
+#define LSM6DSO_BURST_US            6000    /* longest a burst may take on the wire, sizes Burst_Words */
+#define LSM6DSO_SAMPLES             256     /* ring of samples handed to the consumer, power of two */
+#define LSM6DSO_WATERMARK_MAX       (LSM6DSO_SAMPLES / 2)   /* samples; a drain must fit in the ring */
+#define LSM6DSO_TRIES               3       /* tries of every FIFO read */
+#define LSM6DSO_RETRY_TICKS         5       /* wait before draining again after a failed read */
+#define LSM6DSO_RESET_TICKS         10      /* how long Init waits for the software reset */
+#define LSM6DSO_STOP_TICKS          100     /* how long a failed Init waits for a drain in flight to end */
+
+#define LSM6DSO_EVENT_DATA          0x01U   /* samples added to the ring */
+#define LSM6DSO_EVENT_ERROR         0x02U   /* a FIFO read failed or the FIFO overran */
+
+typedef enum {
+    eLSM6DSO_Odr_104Hz = 4,                 /* ODR_XL / ODR_G / BDR codes */
+    eLSM6DSO_Odr_208Hz,
+    eLSM6DSO_Odr_416Hz,
+    eLSM6DSO_Odr_833Hz,
+    eLSM6DSO_Odr_1666Hz,
+    eLSM6DSO_Odr_3333Hz,
+    eLSM6DSO_Odr_6666Hz,
+} eLSM6DSO_Odr;
+
+#ifdef LSM6DSO_SIMULATION
+typedef tLSM6DSO_Sim tLSM6DSO_Bus;
+#else
+typedef tI2C tLSM6DSO_Bus;
+#endif
+
+typedef struct {
+    eLSM6DSO_Odr Odr;                       /* both sensors */
+    uint8_t Accel_Scale;                    /* LSM6DSO_XL_FS_x */
+    uint8_t Gyro_Scale;                     /* LSM6DSO_G_FS_x */
+    uint16_t Watermark;                     /* samples per interrupt, 1..LSM6DSO_WATERMARK_MAX */
+#ifndef LSM6DSO_SIMULATION
+    uint16_t Int1_Pin;                      /* GPIO_PIN_x of the EXTI line INT1 drives */
+    TIM_HandleTypeDef * Timer;              /* free-running 32-bit timer for timestamps */
+#endif
+} tLSM6DSO_Config;
+
+typedef struct {
+    uint32_t Timestamp;                     /* Timer ticks */
+    int16_t Accel[3];                       /* raw, X Y Z */
+    int16_t Gyro[3];
+} tLSM6DSO_Sample;
+
+typedef struct {
+    tLSM6DSO_Bus * Bus;
+    tLSM6DSO_Config Config;
+#ifdef LSM6DSO_SIMULATION
+    volatile uint32_t Events;               // LSM6DSO_EVENT_*
+#else
+    tRegs Regs;
+    TX_EVENT_FLAGS_GROUP Events;
+    TX_TIMER Retry_Timer;
+#endif
+    uint32_t Timer_Hz;
+    uint16_t Watermark_Words;
+    uint16_t Burst_Words;                   // FIFO words per burst, from the bus clock
+
+    // drain state: ISR and DEFER thread
+    volatile bool Draining;                 // a drain is queued or running
+    volatile bool Stopping;                 // a failed Init is taking the device down: the drain ends
+    volatile bool Pending;                  // an edge came in while draining
+    volatile bool Burst_Active;             // words are leaving the FIFO, an edge now cannot be placed
+    volatile bool Edge_Valid;
+    volatile uint32_t Edge_Time;
+    uint8_t Status[2];
+    uint16_t Burst_Count;
+    uint8_t Burst[LSM6DSO_BURST_WORDS * LSM6DSO_WORD_SIZE];
+
+    // timestamps: sample index = FIFO words read / 2
+    uint32_t Words_Read;
+    bool Synced;
+    uint32_t Sync_Index;                    // sample that arrived at Sync_Time
+    uint32_t Sync_Time;
+    uint32_t Period_Q8;                     // Timer ticks per sample << 8
+    uint32_t Prev_Period_Q8;                // before the last edge's update, undone if that edge was off
+    bool Edge_Placed;                       // the last FIFO_STATUS read placed an edge
+    uint32_t Nominal_Q8;
+
+    // sample being paired
+    uint8_t Have;
+    uint8_t Have_Slot;                      // TAG_CNT of the words in Next
+    tLSM6DSO_Sample Next;
+
+    tRing Ring;
+    tLSM6DSO_Sample Samples[LSM6DSO_SAMPLES];
+
+    uint32_t Interrupts;
+    uint32_t Bursts;
+    uint32_t Sample_Count;
+    uint32_t Overruns;
+    uint32_t Dropped;
+    uint32_t Unpaired;                      // words whose partner was lost
+    uint32_t Bus_Errors;
+} tLSM6DSO;
+
+bool LSM6DSO_Init(tLSM6DSO * Imu, tLSM6DSO_Bus * Bus, const tLSM6DSO_Config * Config);
+uint32_t LSM6DSO_Read(tLSM6DSO * Imu, tLSM6DSO_Sample * Samples, uint32_t Count);
+uint32_t LSM6DSO_Available(tLSM6DSO * Imu);
+#ifndef LSM6DSO_SIMULATION
+void LSM6DSO_EXTI_Callback(uint16_t GPIO_Pin);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMU_LSM6DSO_H_ */
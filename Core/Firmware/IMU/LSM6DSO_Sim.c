@@ -0,0 +1,222 @@
+/*
+ * LSM6DSO_Sim.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifdef LSM6DSO_SIMULATION
+
+#include <string.h>
+#include "LSM6DSO_Sim.h"
+#include "LSM6DSO.h"
+
+/* Output rates by ODR / BDR code, 0.1 Hz */
+static const uint32_t sim_rates[] = { 0, 125, 260, 520, 1040, 2080, 4170, 8330, 16670, 33330, 66670 };
+
+static void LSM6DSO_Sim_Reset(tLSM6DSO_Sim * Sim)
+{
+    memset(Sim->Reg, 0, sizeof(Sim->Reg));
+    Sim->Reg[LSM6DSO_WHO_AM_I] = LSM6DSO_WHO_AM_I_VALUE;
+    Sim->Reg[LSM6DSO_CTRL3_C] = LSM6DSO_CTRL3_IF_INC;
+    Sim->Reg[LSM6DSO_CTRL9_XL] = 0xE0;
+    Sim->Fifo_Head = 0;
+    Sim->Fifo_Level = 0;
+    Sim->Overrun = false;
+    Sim->Int1 = false;
+}
+
+void LSM6DSO_Sim_Init(tLSM6DSO_Sim * Sim, uint32_t Timer_Hz)
+{
+    memset(Sim, 0, sizeof(*Sim));
+    Sim->Timer_Hz = Timer_Hz;
+    Sim->Bit_Ns = 2500;
+    LSM6DSO_Sim_Reset(Sim);
+}
+
+static uint16_t LSM6DSO_Sim_Watermark(const tLSM6DSO_Sim * Sim)
+{
+    return (uint16_t)(Sim->Reg[LSM6DSO_FIFO_CTRL1] | ((Sim->Reg[LSM6DSO_FIFO_CTRL2] & 0x01) << 8));
+}
+
+/* INT1 follows the watermark flag; the driver hears the rising edge, like EXTI */
+static void LSM6DSO_Sim_Update_Int1(tLSM6DSO_Sim * Sim)
+{
+    uint16_t watermark = LSM6DSO_Sim_Watermark(Sim);
+    bool level = (Sim->Reg[LSM6DSO_INT1_CTRL] & LSM6DSO_INT1_FIFO_TH) && watermark != 0
+                 && Sim->Fifo_Level >= watermark;
+    bool edge = level && !Sim->Int1;
+
+    Sim->Int1 = level;
+    if (edge && Sim->Int1_Handler != NULL) {
+        Sim->Int1_Handler(Sim->Int1_Param, Sim->Time);
+    }
+}
+
+static void LSM6DSO_Sim_Push(tLSM6DSO_Sim * Sim, uint8_t Tag, const int16_t Axes[3])
+{
+    if (Sim->Fifo_Level == LSM6DSO_SIM_FIFO_WORDS) {
+        Sim->Fifo_Head = (Sim->Fifo_Head + 1) % LSM6DSO_SIM_FIFO_WORDS;
+        Sim->Fifo_Level--;
+        Sim->Overwritten++;
+        Sim->Overrun = true;
+    }
+    uint8_t * word = Sim->Fifo[(Sim->Fifo_Head + Sim->Fifo_Level) % LSM6DSO_SIM_FIFO_WORDS];
+    word[0] = (uint8_t)((Tag << 3) | ((Sim->Samples & 0x03) << 1));
+    for (uint8_t i = 0; i < 3; i++) {
+        word[1 + 2 * i] = (uint8_t)Axes[i];
+        word[2 + 2 * i] = (uint8_t)((uint16_t)Axes[i] >> 8);
+    }
+    Sim->Fifo_Level++;
+}
+
+/* Sample period in ticks << 16, 0 while nothing is batched */
+static uint64_t LSM6DSO_Sim_Period(const tLSM6DSO_Sim * Sim)
+{
+    uint8_t bdr_xl = Sim->Reg[LSM6DSO_FIFO_CTRL3] & 0x0F;
+    uint8_t bdr_gy = Sim->Reg[LSM6DSO_FIFO_CTRL3] >> 4;
+    uint8_t code = bdr_xl ? bdr_xl : bdr_gy;
+
+    if ((Sim->Reg[LSM6DSO_FIFO_CTRL4] & 0x07) == LSM6DSO_FIFO_MODE_BYPASS || code == 0
+        || code >= sizeof(sim_rates) / sizeof(sim_rates[0])) {
+        return 0;
+    }
+    uint64_t period = ((uint64_t)Sim->Timer_Hz * 10U << 16) / sim_rates[code];
+    return period * 1000000U / (uint64_t)(1000000 + Sim->Rate_PPM);
+}
+
+static void LSM6DSO_Sim_Sample(tLSM6DSO_Sim * Sim)
+{
+    int16_t accel[3] = { (int16_t)Sim->Samples, 0, 0 };
+    int16_t gyro[3] = { 0, 0, 0 };
+
+    if (Sim->Generate != NULL) {
+        Sim->Generate(Sim->Generate_Param, Sim->Samples, accel, gyro);
+    }
+    if ((Sim->Reg[LSM6DSO_FIFO_CTRL3] >> 4) && (Sim->Reg[LSM6DSO_CTRL2_G] >> 4)) {
+        LSM6DSO_Sim_Push(Sim, LSM6DSO_TAG_GYRO, gyro);
+    }
+    if ((Sim->Reg[LSM6DSO_FIFO_CTRL3] & 0x0F) && (Sim->Reg[LSM6DSO_CTRL1_XL] >> 4)) {
+        LSM6DSO_Sim_Push(Sim, LSM6DSO_TAG_ACCEL, accel);
+    }
+    Sim->Samples++;
+    LSM6DSO_Sim_Update_Int1(Sim);
+}
+
+void LSM6DSO_Sim_Advance(tLSM6DSO_Sim * Sim, uint32_t Ticks)
+{
+    uint64_t end = Sim->Clock + ((uint64_t)Ticks << 16);
+
+    for (;;) {
+        uint64_t period = LSM6DSO_Sim_Period(Sim);
+        if (period == 0) {
+            Sim->Next_Sample = 0;
+            break;
+        }
+        if (Sim->Next_Sample <= Sim->Clock) {
+            Sim->Next_Sample = Sim->Clock + period;
+        }
+        if (Sim->Next_Sample > end) {
+            break;
+        }
+        Sim->Clock = Sim->Next_Sample;
+        Sim->Time = (uint32_t)(Sim->Clock >> 16);
+        Sim->Next_Sample += period;
+        LSM6DSO_Sim_Sample(Sim);
+    }
+    Sim->Clock = end;
+    Sim->Time = (uint32_t)(end >> 16);
+}
+
+static uint8_t LSM6DSO_Sim_Read_Byte(tLSM6DSO_Sim * Sim, uint8_t Reg)
+{
+    uint16_t watermark = LSM6DSO_Sim_Watermark(Sim);
+    uint8_t value;
+
+    switch (Reg) {
+        case LSM6DSO_FIFO_STATUS1:
+            return (uint8_t)Sim->Fifo_Level;
+        case LSM6DSO_FIFO_STATUS2:
+            value = (uint8_t)((Sim->Fifo_Level >> 8) & LSM6DSO_STATUS2_DIFF_HIGH);
+            if (watermark != 0 && Sim->Fifo_Level >= watermark) {
+                value |= LSM6DSO_STATUS2_WTM;
+            }
+            if (Sim->Overrun) {
+                value |= LSM6DSO_STATUS2_OVR_LATCHED;
+                Sim->Overrun = false;       // cleared by the read
+            }
+            return value;
+        default:
+            break;
+    }
+    if (Reg >= LSM6DSO_FIFO_DATA_OUT_TAG && Reg < LSM6DSO_FIFO_DATA_OUT_TAG + LSM6DSO_WORD_SIZE) {
+        if (Sim->Fifo_Level == 0) {
+            return 0;
+        }
+        value = Sim->Fifo[Sim->Fifo_Head][Reg - LSM6DSO_FIFO_DATA_OUT_TAG];
+        if (Reg == LSM6DSO_FIFO_DATA_OUT_TAG + LSM6DSO_WORD_SIZE - 1) {
+            Sim->Fifo_Head = (Sim->Fifo_Head + 1) % LSM6DSO_SIM_FIFO_WORDS;
+            Sim->Fifo_Level--;
+            LSM6DSO_Sim_Update_Int1(Sim);
+        }
+        return value;
+    }
+    return (Reg < sizeof(Sim->Reg)) ? Sim->Reg[Reg] : 0;
+}
+
+static void LSM6DSO_Sim_Write_Byte(tLSM6DSO_Sim * Sim, uint8_t Reg, uint8_t Value)
+{
+    if (Reg >= sizeof(Sim->Reg) || Reg == LSM6DSO_WHO_AM_I || Reg == LSM6DSO_FIFO_STATUS1
+        || Reg == LSM6DSO_FIFO_STATUS2) {
+        return;
+    }
+    if (Reg == LSM6DSO_CTRL3_C && (Value & LSM6DSO_CTRL3_SW_RESET)) {
+        LSM6DSO_Sim_Reset(Sim);             // done at once, the bit reads back clear
+        return;
+    }
+    Sim->Reg[Reg] = Value;
+    if (Reg == LSM6DSO_FIFO_CTRL4 && (Value & 0x07) == LSM6DSO_FIFO_MODE_BYPASS) {
+        Sim->Fifo_Head = 0;
+        Sim->Fifo_Level = 0;
+    }
+    LSM6DSO_Sim_Update_Int1(Sim);
+}
+
+/* Address after a byte of a burst: FIFO_DATA_OUT rolls back to the tag, the rest follows IF_INC */
+static uint8_t LSM6DSO_Sim_Next(const tLSM6DSO_Sim * Sim, uint8_t Reg)
+{
+    if (Reg == LSM6DSO_FIFO_DATA_OUT_TAG + LSM6DSO_WORD_SIZE - 1) {
+        return LSM6DSO_FIFO_DATA_OUT_TAG;
+    }
+    return (Sim->Reg[LSM6DSO_CTRL3_C] & LSM6DSO_CTRL3_IF_INC) ? (uint8_t)(Reg + 1) : Reg;
+}
+
+/* tRegs_Access over the model, the driver's bus in simulation */
+bool LSM6DSO_Sim_Read(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size)
+{
+    tLSM6DSO_Sim * sim = (tLSM6DSO_Sim *)Device;
+    uint8_t reg = (uint8_t)Reg;
+
+    for (uint16_t i = 0; i < Size; i++) {
+        Data[i] = LSM6DSO_Sim_Read_Byte(sim, reg);
+        reg = LSM6DSO_Sim_Next(sim, reg);
+    }
+    return true;
+}
+
+bool LSM6DSO_Sim_Write(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size)
+{
+    tLSM6DSO_Sim * sim = (tLSM6DSO_Sim *)Device;
+    uint8_t reg = (uint8_t)Reg;
+
+    for (uint16_t i = 0; i < Size; i++) {
+        if (sim->Fail_Write_Reg != 0 && reg == sim->Fail_Write_Reg) {
+            return false;
+        }
+        LSM6DSO_Sim_Write_Byte(sim, reg, Data[i]);
+        reg = LSM6DSO_Sim_Next(sim, reg);
+    }
+    return true;
+}
+
+#endif /* LSM6DSO_SIMULATION */
@@ -0,0 +1,74 @@
+/*
+ * LSM6DSO_Sim.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef IMU_LSM6DSO_SIM_H_
+#define IMU_LSM6DSO_SIM_H_
+
+#ifdef LSM6DSO_SIMULATION
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Register-level stand-in for an LSM6DSO on its bus, for running the driver on a host.
+ * 1) LSM6DSO_Sim_Init(&sim, timer_hz) - registers at their reset values, time 0. Bit_Ns stands for
+ *    the bus clock the driver sizes its bursts from; set it before LSM6DSO_Init to change it.
+ * 2) Hand &sim to LSM6DSO_Init as the bus. The driver reads and writes it like the part: software
+ *    reset, auto-increment, FIFO_STATUS, bursts from FIFO_DATA_OUT that roll back to the tag.
+ * 3) LSM6DSO_Sim_Advance(&sim, ticks) moves time on: with the FIFO and both sensors on it batches a
+ *    gyro and an accel word every sample period (the ODR off by Rate_PPM if set), overwrites the
+ *    oldest when full (latching the overrun) and raises INT1 on the watermark edge, which calls
+ *    the driver's interrupt with the current time as the EXTI handler would. Call it from a thread
+ *    below the DEFER thread's priority: the drain then runs to its end at each edge, as it would
+ *    against a real part that is quick to read compared to the sample period.
+ * 4) Generate (optional) fills each sample; by default the accel X carries the sample number and the
+ *    rest is zero, so lost or repeated samples show. Samples and Overwritten count what the part did.
+ * 5) Fail_Write_Reg (0 for none) makes every write that reaches that register fail, as a NACK would,
+ *    for the driver's error paths.
+ */
+
+#define LSM6DSO_SIM_FIFO_WORDS      512
+
+typedef struct {
+    uint8_t Reg[0x80];
+    uint8_t Fifo[LSM6DSO_SIM_FIFO_WORDS][7];
+    uint16_t Fifo_Head;                 /* next word read */
+    uint16_t Fifo_Level;
+    bool Overrun;
+    bool Int1;                          /* INT1 line level */
+    uint32_t Time;                      /* timer ticks, wraps like the 32-bit counter */
+    uint64_t Clock;                     /* ticks << 16 */
+    uint32_t Timer_Hz;
+    uint32_t Bit_Ns;                    /* SCL period of the simulated bus, 2500 (400 kHz) by default */
+    int32_t Rate_PPM;                   /* ODR error of the simulated part */
+    uint64_t Next_Sample;               /* time of the next sample, ticks << 16 */
+    uint32_t Samples;
+    uint32_t Overwritten;
+    void (*Generate)(void * Param, uint32_t Index, int16_t Accel[3], int16_t Gyro[3]);
+    void * Generate_Param;
+    void (*Int1_Handler)(void * Param, uint32_t Time);  /* set by LSM6DSO_Init */
+    void * Int1_Param;
+    uint8_t Fail_Write_Reg;             /* writes reaching it fail, 0: none */
+} tLSM6DSO_Sim;
+
+void LSM6DSO_Sim_Init(tLSM6DSO_Sim * Sim, uint32_t Timer_Hz);
+void LSM6DSO_Sim_Advance(tLSM6DSO_Sim * Sim, uint32_t Ticks);
+bool LSM6DSO_Sim_Read(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size);
+bool LSM6DSO_Sim_Write(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LSM6DSO_SIMULATION */
+
+#endif /* IMU_LSM6DSO_SIM_H_ */
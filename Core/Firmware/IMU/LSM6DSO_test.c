@@ -0,0 +1,252 @@
+/*
+ * LSM6DSO_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ *
+ * Host test of the LSM6DSO FIFO driver against the simulated part:
+ *   gcc -std=gnu11 -DLSM6DSO_SIMULATION -DLSM6DSO_TEST_DEBUG Core/Firmware/IMU/LSM6DSO.c \
+ *       Core/Firmware/IMU/LSM6DSO_Sim.c Core/Middlewares/Ring/ring.c Core/Firmware/IMU/LSM6DSO_test.c \
+ *       -o lsm6dso_test && ./lsm6dso_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef LSM6DSO_TEST_DEBUG
+
+#include "LSM6DSO.h"
+
+#define TEST_TIMER_HZ       16000000U
+#define TEST_RATE_PPM       20000           /* the part runs 2% fast */
+#define TEST_STEP_TICKS     1600            /* 100 us between consumer polls */
+#define TEST_MAX_ERROR      4               /* timer ticks, once the period has settled */
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+typedef struct {
+    uint32_t Read;                          /* samples taken */
+    uint32_t Lost;                          /* sample numbers skipped */
+    uint32_t Bad_Pairs;                     /* gyro word of another sample than the accel word */
+    uint32_t Max_Error;                     /* ticks, samples from check_from on */
+    uint32_t Backwards;                     /* timestamps not after the one before, from check_from on */
+} tRun;
+
+static tLSM6DSO_Sim sim;
+static tLSM6DSO imu;
+static uint32_t next_index;                 /* sample number the consumer expects next */
+static uint32_t check_from;                 /* timestamps are checked from this sample on */
+static uint32_t last_time;
+
+/* Accel carries the sample number, gyro its complement: a mixed pair shows */
+static void Generate(void * Param, uint32_t Index, int16_t Accel[3], int16_t Gyro[3])
+{
+    (void)Param;
+    Accel[0] = (int16_t)Index;
+    Accel[1] = (int16_t)(Index >> 16);
+    Gyro[0] = (int16_t)~Index;
+    Gyro[1] = (int16_t)~(Index >> 16);
+}
+
+/* When the model batched sample Index: one period after the one before, the first one period in */
+static uint32_t True_Time(uint32_t Index, uint32_t Rate_dHz)
+{
+    uint64_t period = ((uint64_t)TEST_TIMER_HZ * 10U << 16) / Rate_dHz;
+    period = period * 1000000U / (uint64_t)(1000000 + TEST_RATE_PPM);
+    return (uint32_t)(((uint64_t)(Index + 1) * period) >> 16);
+}
+
+/* Moves the model on by Ms, taking every sample as it comes in if Consume */
+static void Run(uint32_t Ms, bool Consume, tRun * Result)
+{
+    tLSM6DSO_Sample samples[LSM6DSO_SAMPLES];
+
+    memset(Result, 0, sizeof(*Result));
+    for (uint32_t step = 0; step < Ms * 10; step++) {
+        LSM6DSO_Sim_Advance(&sim, TEST_STEP_TICKS);
+        if (!Consume) {
+            continue;
+        }
+        uint32_t n = LSM6DSO_Read(&imu, samples, LSM6DSO_SAMPLES);
+        for (uint32_t i = 0; i < n; i++) {
+            const tLSM6DSO_Sample * s = &samples[i];
+            uint32_t index = (uint16_t)s->Accel[0] | ((uint32_t)(uint16_t)s->Accel[1] << 16);
+            if (s->Gyro[0] != (int16_t)~s->Accel[0] || s->Gyro[1] != (int16_t)~s->Accel[1]) {
+                Result->Bad_Pairs++;
+            }
+            if (index > next_index) {
+                Result->Lost += index - next_index;
+            }
+            if (index >= check_from) {
+                if ((int32_t)(s->Timestamp - last_time) <= 0) {
+                    Result->Backwards++;
+                }
+                int32_t error = (int32_t)(s->Timestamp - True_Time(index, 16670));
+                uint32_t magnitude = (uint32_t)((error < 0) ? -error : error);
+                if (magnitude > Result->Max_Error) {
+                    Result->Max_Error = magnitude;
+                }
+            }
+            last_time = s->Timestamp;
+            next_index = index + 1;
+            Result->Read++;
+        }
+    }
+}
+
+/* Config checks, and the burst sized from the bus clock */
+static void Test_Init(void)
+{
+    static tLSM6DSO_Sim fast_sim;
+    static tLSM6DSO fast_imu;
+    tLSM6DSO_Config config = { eLSM6DSO_Odr_1666Hz, LSM6DSO_XL_FS_8G, LSM6DSO_G_FS_2000DPS, 32 };
+    tLSM6DSO_Config bad = config;
+
+    LSM6DSO_Sim_Init(&sim, TEST_TIMER_HZ);
+    sim.Bit_Ns = 9625;                      /* 100 kHz, Timing 0x00303D5B at 16 MHz */
+    sim.Rate_PPM = TEST_RATE_PPM;
+    sim.Generate = Generate;
+
+    bad.Watermark = 0;
+    CHECK(!LSM6DSO_Init(&imu, &sim, &bad));
+    bad.Watermark = LSM6DSO_WATERMARK_MAX + 1;
+    CHECK(!LSM6DSO_Init(&imu, &sim, &bad));
+
+    /* a configuration that fails is undone: off the list, INT1 and the sensors off, Init again works */
+    sim.Fail_Write_Reg = LSM6DSO_CTRL2_G;
+    CHECK(!LSM6DSO_Init(&imu, &sim, &config));
+    CHECK(sim.Int1_Handler == NULL);
+    CHECK(sim.Reg[LSM6DSO_INT1_CTRL] == 0 && sim.Reg[LSM6DSO_CTRL1_XL] == 0);
+    CHECK(!imu.Draining);
+    sim.Fail_Write_Reg = 0;
+
+    CHECK(LSM6DSO_Init(&imu, &sim, &config));
+    CHECK(!LSM6DSO_Init(&imu, &sim, &config));      /* already running */
+    CHECK(imu.Burst_Words == 8);
+    CHECK(imu.Watermark_Words == 64);
+    CHECK(sim.Reg[LSM6DSO_FIFO_CTRL1] == 64 && sim.Reg[LSM6DSO_FIFO_CTRL4] == LSM6DSO_FIFO_MODE_STREAM);
+    CHECK(sim.Reg[LSM6DSO_CTRL3_C] == (LSM6DSO_CTRL3_BDU | LSM6DSO_CTRL3_IF_INC));
+
+    /* 400 kHz: bigger bursts, still within LSM6DSO_BURST_US. The failed Init left its slot free. */
+    LSM6DSO_Sim_Init(&fast_sim, TEST_TIMER_HZ);
+    CHECK(LSM6DSO_Init(&fast_imu, &fast_sim, &config));
+    CHECK(fast_imu.Burst_Words == 36);
+    CHECK(fast_imu.Burst_Words * LSM6DSO_WORD_SIZE * 9U * fast_sim.Bit_Ns < LSM6DSO_BURST_US * 1000U);
+}
+
+/* Every sample arrives once, paired, in order, with its timestamp on the model's clock */
+static void Test_Stream(void)
+{
+    tRun run;
+
+    check_from = 1000;                      /* the period estimate has settled by then */
+    Run(2000, true, &run);
+
+    CHECK(run.Read > 3300 && run.Read <= sim.Samples);
+    CHECK(run.Lost == 0);
+    CHECK(run.Bad_Pairs == 0);
+    CHECK(run.Backwards == 0);
+    CHECK(run.Max_Error <= TEST_MAX_ERROR);
+    CHECK(imu.Overruns == 0 && imu.Dropped == 0 && imu.Unpaired == 0 && imu.Bus_Errors == 0);
+    CHECK(imu.Events & LSM6DSO_EVENT_DATA);
+    CHECK(!(imu.Events & LSM6DSO_EVENT_ERROR));
+    /* one interrupt per watermark, no burst longer than Burst_Words */
+    CHECK(imu.Interrupts >= run.Read / 32 && imu.Interrupts <= run.Read / 32 + 1);
+    CHECK(imu.Bursts * imu.Burst_Words >= imu.Sample_Count * 2);
+    printf("stream: %lu samples, %lu interrupts, %lu bursts, max error %lu ticks\n", (unsigned long)run.Read,
+           (unsigned long)imu.Interrupts, (unsigned long)imu.Bursts, (unsigned long)run.Max_Error);
+}
+
+/* A consumer that stops: the ring keeps the oldest, the rest is counted in Dropped */
+static void Test_Dropped(void)
+{
+    tRun run;
+    uint32_t paired = imu.Sample_Count + imu.Dropped;
+
+    Run(400, false, &run);
+    uint32_t arrived = imu.Sample_Count + imu.Dropped - paired;
+    CHECK(arrived > LSM6DSO_SAMPLES);
+    CHECK(LSM6DSO_Available(&imu) == LSM6DSO_SAMPLES);
+    CHECK(imu.Dropped == arrived - LSM6DSO_SAMPLES);
+    CHECK(imu.Overruns == 0);
+
+    /* the kept ones come out in order, then the stream goes on past the gap */
+    Run(100, true, &run);
+    CHECK(run.Lost == imu.Dropped);
+    CHECK(run.Bad_Pairs == 0 && run.Backwards == 0);
+    CHECK(run.Max_Error <= TEST_MAX_ERROR);
+    CHECK(LSM6DSO_Available(&imu) == 0);
+}
+
+/* INT1 masked long enough for the FIFO to wrap: counted, the pairs stay right and the timestamps
+ * re-anchor at the next edge */
+static void Test_Overrun(void)
+{
+    void (*handler)(void *, uint32_t) = sim.Int1_Handler;
+    tRun run;
+
+    sim.Int1_Handler = NULL;
+    LSM6DSO_Sim_Advance(&sim, True_Time(sim.Samples + 400, 16670) - sim.Time);
+    CHECK(sim.Overwritten > 0);
+
+    /* the line comes back low: the next sample raises it again */
+    sim.Int1_Handler = handler;
+    sim.Int1 = false;
+    imu.Events = 0;
+    check_from = sim.Samples + 200;
+    Run(1000, true, &run);
+
+    CHECK(imu.Overruns == 1);
+    CHECK(imu.Events & LSM6DSO_EVENT_ERROR);
+    CHECK(run.Bad_Pairs == 0 && run.Backwards == 0);
+    CHECK(run.Lost >= sim.Overwritten / 2);
+    CHECK(run.Max_Error <= TEST_MAX_ERROR);
+    CHECK(imu.Synced);
+    printf("overrun: %lu words overwritten, %lu samples lost, max error %lu ticks\n",
+           (unsigned long)sim.Overwritten, (unsigned long)run.Lost, (unsigned long)run.Max_Error);
+}
+
+/* A gyro word gone without an overrun, as after a failed burst: its accel word is not paired with
+ * the next sample's gyro, and the timestamps are right again from the next edge */
+static void Test_Lost_Word(void)
+{
+    void (*handler)(void *, uint32_t) = sim.Int1_Handler;
+    uint8_t word[LSM6DSO_WORD_SIZE];
+    uint32_t unpaired = imu.Unpaired;
+    tRun run;
+
+    sim.Int1_Handler = NULL;
+    LSM6DSO_Sim_Advance(&sim, True_Time(sim.Samples + 4, 16670) - sim.Time);
+    CHECK(LSM6DSO_Sim_Read(&sim, LSM6DSO_FIFO_DATA_OUT_TAG, word, sizeof(word)));
+    CHECK((word[0] >> 3) == LSM6DSO_TAG_GYRO);
+    sim.Int1_Handler = handler;
+
+    check_from = sim.Samples + 200;
+    Run(500, true, &run);
+    CHECK(imu.Unpaired == unpaired + 1);
+    CHECK(run.Lost == 1);
+    CHECK(imu.Synced);
+    CHECK(run.Bad_Pairs == 0 && run.Backwards == 0);
+    CHECK(run.Max_Error <= TEST_MAX_ERROR);
+}
+
+int main(void)
+{
+    Test_Init();
+    Test_Stream();
+    Test_Dropped();
+    Test_Overrun();
+    Test_Lost_Word();
+
+    printf("%s: %d failure(s)\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
+
+#endif
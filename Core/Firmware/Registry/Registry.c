@@ -0,0 +1,61 @@
+/*
+ * Registry.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include "Registry.h"
+
+tRegistry_Slot Registry_Slots[REGISTRY_SLOTS];
+
+/**
+ * @brief: Registers the driver object that owns a peripheral instance.
+ *
+ * @params: Instance peripheral registers (e.g. huart->Instance), Driver type, Object driver object
+ *
+ * @return: false if Instance is not an APB peripheral, or the slot already holds another object
+ */
+bool Registry_Add(const void * Instance, eRegistry_Driver Driver, void * Object)
+{
+    uint32_t slot = ((uint32_t)Instance - PERIPH_BASE) >> REGISTRY_SLOT_SHIFT;
+    bool added = false;
+
+    if (slot >= REGISTRY_SLOTS || Object == NULL || Driver == eRegistry_None) {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (Registry_Slots[slot].Object == NULL || Registry_Slots[slot].Object == Object) {
+        Registry_Slots[slot].Object = Object;
+        Registry_Slots[slot].Driver = (uint8_t)Driver;
+        added = true;
+    }
+    __set_PRIMASK(primask);
+    return added;
+}
+
+/**
+ * @brief: Frees the instance's slot if it still holds Object.
+ *
+ * @params: Instance peripheral registers, Object that was registered for it
+ *
+ * @return: None
+ */
+void Registry_Remove(const void * Instance, const void * Object)
+{
+    uint32_t slot = ((uint32_t)Instance - PERIPH_BASE) >> REGISTRY_SLOT_SHIFT;
+
+    if (slot >= REGISTRY_SLOTS) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (Registry_Slots[slot].Object == Object) {
+        Registry_Slots[slot].Driver = eRegistry_None;
+        Registry_Slots[slot].Object = NULL;
+    }
+    __set_PRIMASK(primask);
+}
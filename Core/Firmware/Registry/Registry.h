@@ -0,0 +1,67 @@
+/*
+ * Registry.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef REGISTRY_REGISTRY_H_
+#define REGISTRY_REGISTRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../Inc/main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Maps a peripheral instance (USART2, SPI1..3, I2C1/3, ...) to the driver object that owns it, so
+ * HAL callbacks find their driver in constant time without locks.
+ * 1) The driver's init registers its object: Registry_Add(huart->Instance, eRegistry_UART, uart).
+ * 2) A HAL callback looks it up: tUART * uart = Registry_Find(huart->Instance, eRegistry_UART);
+ *    NULL if nothing of that driver type is registered for the instance.
+ * 3) The slot index is (instance address - PERIPH_BASE) >> 10. APB1 and APB2 peripherals sit on
+ *    1 KB boundaries, so each gets its own slot; addresses outside REGISTRY_SLOTS are rejected.
+ * Registry_Find is an inline load and compare, safe from any ISR. Add and Remove mask interrupts
+ * for the two stores so a lookup never sees an object with the wrong driver type.
+ */
+
+#define REGISTRY_SLOT_SHIFT             10
+#define REGISTRY_SLOTS                  ((APB2PERIPH_BASE + 0x8000UL - PERIPH_BASE) >> REGISTRY_SLOT_SHIFT)
+
+typedef enum {
+    eRegistry_None = 0,
+    eRegistry_UART,
+    eRegistry_SPI,
+    eRegistry_Cloned_SPI,
+    eRegistry_I2C,                      /* tI2C_Bus */
+    eRegistry_I2C_Trigger,              /* LPTIM driving a continuous tI2C device */
+} eRegistry_Driver;
+
+typedef struct {
+    void * volatile Object;
+    volatile uint8_t Driver;            /* eRegistry_Driver */
+} tRegistry_Slot;
+
+extern tRegistry_Slot Registry_Slots[REGISTRY_SLOTS];
+
+bool Registry_Add(const void * Instance, eRegistry_Driver Driver, void * Object);
+void Registry_Remove(const void * Instance, const void * Object);
+
+static inline void * Registry_Find(const void * Instance, eRegistry_Driver Driver)
+{
+    uint32_t slot = ((uint32_t)Instance - PERIPH_BASE) >> REGISTRY_SLOT_SHIFT;
+    if (slot >= REGISTRY_SLOTS || Registry_Slots[slot].Driver != (uint8_t)Driver) {
+        return NULL;
+    }
+    return Registry_Slots[slot].Object;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REGISTRY_REGISTRY_H_ */
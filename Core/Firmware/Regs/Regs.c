@@ -0,0 +1,352 @@
+/*
+ * Regs.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "Regs.h"
+#include "main.h"
+#include "../../Middlewares/Console/Thread_Console.h"
+
+/* Flags byte of a register: policy in the low bits, then the shadow state */
+#define REGS_POLICY_MASK        0x03
+#define REGS_VALID              0x04    /* shadow holds the device's value */
+#define REGS_DIRTY              0x08    /* shadow newer than the device, Regs_Flush sends it */
+
+static tRegs * regs_list[REGS_MAX_SHADOWS];
+static uint8_t regs_count;
+
+static void Regs_Command(const char * args);
+
+CONSOLE_COMMAND("regs", "Register shadows: regs [<name>]", NULL, .Args_Function = Regs_Command);
+
+/**
+ * @brief: Sets up a shadow of Count registers from First, all eRegs_Volatile and not held, and adds
+ * it to the console list.
+ *
+ * @params: Regs, Name (kept, for the console), Read / Write bus backend, Device handed to them,
+ * First, Count (1..REGS_MAX_COUNT), Auto_Increment device steps the register address over a burst
+ *
+ * @return: false if the range is bad or the shadow or its mutex cannot be allocated
+ */
+bool Regs_Init(tRegs * Regs, const char * Name, tRegs_Access Read, tRegs_Access Write, void * Device,
+               uint16_t First, uint16_t Count, bool Auto_Increment)
+{
+    if (Count == 0 || Count > REGS_MAX_COUNT || (uint32_t)First + Count > 0x10000U) {
+        return false;
+    }
+    memset(Regs, 0, sizeof(*Regs));
+    Regs->Value = calloc(Count, 1);
+    Regs->Flags = calloc(Count, 1);
+    if (Regs->Value == NULL || Regs->Flags == NULL) {
+        free(Regs->Value);
+        free(Regs->Flags);
+        return false;
+    }
+    if (tx_mutex_create(&Regs->Lock, "Regs", TX_INHERIT) != TX_SUCCESS) {
+        free(Regs->Value);
+        free(Regs->Flags);
+        return false;
+    }
+    Regs->Name = Name;
+    Regs->Read = Read;
+    Regs->Write = Write;
+    Regs->Device = Device;
+    Regs->First = First;
+    Regs->Count = Count;
+    Regs->Auto_Increment = Auto_Increment;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (regs_count < REGS_MAX_SHADOWS) {
+        regs_list[regs_count++] = Regs;
+    }
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/* Undoes Regs_Init: off the console list, mutex deleted, shadow freed */
+void Regs_Deinit(tRegs * Regs)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t n = 0; n < regs_count; n++) {
+        if (regs_list[n] == Regs) {
+            // keep the order the console lists them in
+            memmove(&regs_list[n], &regs_list[n + 1], (size_t)(regs_count - n - 1) * sizeof(regs_list[0]));
+            regs_count--;
+            break;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    tx_mutex_delete(&Regs->Lock);
+    free(Regs->Value);
+    free(Regs->Flags);
+    Regs->Value = NULL;
+    Regs->Flags = NULL;
+    Regs->Count = 0;
+}
+
+static bool Regs_Index(const tRegs * Regs, uint16_t Reg, uint16_t * Index)
+{
+    if (Reg < Regs->First || Reg - Regs->First >= Regs->Count) {
+        return false;
+    }
+    *Index = Reg - Regs->First;
+    return true;
+}
+
+static eRegs_Policy Regs_Policy(const tRegs * Regs, uint16_t Index)
+{
+    return (eRegs_Policy)(Regs->Flags[Index] & REGS_POLICY_MASK);
+}
+
+/* Shadow value usable in place of a bus read */
+static bool Regs_Held(const tRegs * Regs, uint16_t Index)
+{
+    return Regs_Policy(Regs, Index) != eRegs_Volatile && (Regs->Flags[Index] & REGS_VALID);
+}
+
+/**
+ * @brief: Sets the policy of Count registers from Reg; registers outside the shadow are ignored.
+ * A register made volatile forgets its value unless it is dirty.
+ */
+void Regs_Set_Policy(tRegs * Regs, uint16_t Reg, uint16_t Count, eRegs_Policy Policy)
+{
+    tx_mutex_get(&Regs->Lock, TX_WAIT_FOREVER);
+    for (uint32_t reg = Reg; reg < (uint32_t)Reg + Count; reg++) {
+        uint16_t i;
+        if (!Regs_Index(Regs, (uint16_t)reg, &i)) {
+            continue;
+        }
+        uint8_t flags = (uint8_t)((Regs->Flags[i] & ~REGS_POLICY_MASK) | Policy);
+        if (Policy == eRegs_Volatile && !(flags & REGS_DIRTY)) {
+            flags &= ~REGS_VALID;
+        }
+        Regs->Flags[i] = flags;
+    }
+    tx_mutex_put(&Regs->Lock);
+}
+
+/**
+ * @brief: Reads Reg, from the shadow when it holds the value, else from the device (which fills the
+ * shadow of a non-volatile register).
+ *
+ * @return: false if the bus read failed
+ */
+bool Regs_Read(tRegs * Regs, uint16_t Reg, uint8_t * Value)
+{
+    uint16_t i;
+    bool ok = true;
+
+    tx_mutex_get(&Regs->Lock, TX_WAIT_FOREVER);
+    if (!Regs_Index(Regs, Reg, &i)) {
+        Regs->Bus_Reads++;
+        ok = Regs->Read(Regs->Device, Reg, Value, 1);
+    } else if (Regs_Held(Regs, i)) {
+        Regs->Hits++;
+        *Value = Regs->Value[i];
+    } else {
+        Regs->Bus_Reads++;
+        ok = Regs->Read(Regs->Device, Reg, Value, 1);
+        if (ok && Regs_Policy(Regs, i) != eRegs_Volatile) {
+            Regs->Value[i] = *Value;
+            Regs->Flags[i] |= REGS_VALID;
+        }
+    }
+    tx_mutex_put(&Regs->Lock);
+    return ok;
+}
+
+/**
+ * @brief: Writes Reg. A cached register only changes the shadow and is marked dirty; the others go
+ * to the device, and a write-through one keeps the value.
+ *
+ * @return: false if the bus write failed (the shadow of the register is then dropped)
+ */
+bool Regs_Write(tRegs * Regs, uint16_t Reg, uint8_t Value)
+{
+    uint16_t i;
+    bool ok = true;
+
+    tx_mutex_get(&Regs->Lock, TX_WAIT_FOREVER);
+    if (!Regs_Index(Regs, Reg, &i)) {
+        Regs->Bus_Writes++;
+        ok = Regs->Write(Regs->Device, Reg, &Value, 1);
+    } else if (Regs_Policy(Regs, i) == eRegs_Cached) {
+        Regs->Value[i] = Value;
+        Regs->Flags[i] |= REGS_VALID | REGS_DIRTY;
+    } else {
+        Regs->Bus_Writes++;
+        ok = Regs->Write(Regs->Device, Reg, &Value, 1);
+        Regs->Flags[i] &= ~(REGS_VALID | REGS_DIRTY);
+        if (ok && Regs_Policy(Regs, i) != eRegs_Volatile) {
+            Regs->Value[i] = Value;
+            Regs->Flags[i] |= REGS_VALID;
+        }
+    }
+    tx_mutex_put(&Regs->Lock);
+    return ok;
+}
+
+/**
+ * @brief: Reg = (Reg & ~Mask) | (Value & Mask). The old value comes from the shadow when it holds
+ * it, so a configured register costs one write instead of a read and a write; when the result
+ * equals what the shadow holds, nothing is written at all.
+ *
+ * @return: false if the read or the write failed
+ */
+bool Regs_Modify(tRegs * Regs, uint16_t Reg, uint8_t Mask, uint8_t Value)
+{
+    uint16_t i;
+    uint8_t old;
+    bool ok = false;
+
+    // the mutex is recursive for its owner: the read and the write stay one step for other threads
+    tx_mutex_get(&Regs->Lock, TX_WAIT_FOREVER);
+    if (Regs_Read(Regs, Reg, &old)) {
+        uint8_t new_value = (uint8_t)((old & ~Mask) | (Value & Mask));
+        if (new_value == old && Regs_Index(Regs, Reg, &i) && Regs_Held(Regs, i)) {
+            ok = true;
+        } else {
+            ok = Regs_Write(Regs, Reg, new_value);
+        }
+    }
+    tx_mutex_put(&Regs->Lock);
+    return ok;
+}
+
+/**
+ * @brief: Sends the dirty registers to the device. With Auto_Increment each run of adjacent dirty
+ * registers goes as one burst, else one write per register.
+ *
+ * @return: false if a write failed; its registers stay dirty for the next flush
+ */
+bool Regs_Flush(tRegs * Regs)
+{
+    bool ok = true;
+
+    tx_mutex_get(&Regs->Lock, TX_WAIT_FOREVER);
+    uint16_t i = 0;
+    while (i < Regs->Count) {
+        if (!(Regs->Flags[i] & REGS_DIRTY)) {
+            i++;
+            continue;
+        }
+        uint16_t run = 1;
+        while (Regs->Auto_Increment && i + run < Regs->Count && (Regs->Flags[i + run] & REGS_DIRTY)) {
+            run++;
+        }
+        Regs->Bus_Writes++;
+        if (Regs->Write(Regs->Device, Regs->First + i, &Regs->Value[i], run)) {
+            for (uint16_t r = i; r < i + run; r++) {
+                Regs->Flags[r] &= ~REGS_DIRTY;
+            }
+        } else {
+            ok = false;
+        }
+        i += run;
+    }
+    tx_mutex_put(&Regs->Lock);
+    return ok;
+}
+
+/**
+ * @brief: Fills the shadow of every non-volatile register it does not hold yet, reading runs of them
+ * as one burst with Auto_Increment. Call after the device is configured, or after Regs_Invalidate.
+ *
+ * @return: false if a read failed; those registers stay unknown
+ */
+bool Regs_Load(tRegs * Regs)
+{
+    bool ok = true;
+
+    tx_mutex_get(&Regs->Lock, TX_WAIT_FOREVER);
+    uint16_t i = 0;
+    while (i < Regs->Count) {
+        if (Regs_Policy(Regs, i) == eRegs_Volatile || (Regs->Flags[i] & REGS_VALID)) {
+            i++;
+            continue;
+        }
+        uint16_t run = 1;
+        while (Regs->Auto_Increment && i + run < Regs->Count && Regs_Policy(Regs, i + run) != eRegs_Volatile
+               && !(Regs->Flags[i + run] & REGS_VALID)) {
+            run++;
+        }
+        Regs->Bus_Reads++;
+        if (Regs->Read(Regs->Device, Regs->First + i, &Regs->Value[i], run)) {
+            for (uint16_t r = i; r < i + run; r++) {
+                Regs->Flags[r] |= REGS_VALID;
+            }
+        } else {
+            ok = false;
+        }
+        i += run;
+    }
+    tx_mutex_put(&Regs->Lock);
+    return ok;
+}
+
+/* Forgets every shadow value, dirty ones included: the device was reset or power cycled */
+void Regs_Invalidate(tRegs * Regs)
+{
+    tx_mutex_get(&Regs->Lock, TX_WAIT_FOREVER);
+    for (uint16_t i = 0; i < Regs->Count; i++) {
+        Regs->Flags[i] &= REGS_POLICY_MASK;
+    }
+    tx_mutex_put(&Regs->Lock);
+}
+
+/* Dump from RAM only: the console never touches the bus, so it is safe with the device in use */
+static void Regs_Dump(const tRegs * Regs)
+{
+    static const char policy_names[] = { 'v', 't', 'c' };
+
+    printd("%s: 0x%02X..0x%02X, policy v volatile t write-through c cached\r\n", Regs->Name,
+           Regs->First, Regs->First + Regs->Count - 1);
+    for (uint16_t row = 0; row < Regs->Count; row += 8) {
+        printd("%02X:", Regs->First + row);
+        for (uint16_t i = row; i < row + 8 && i < Regs->Count; i++) {
+            uint8_t flags = Regs->Flags[i];
+            char policy = policy_names[flags & REGS_POLICY_MASK];
+            if (flags & REGS_VALID) {
+                printd("  %c %02X%c", policy, Regs->Value[i], (flags & REGS_DIRTY) ? '*' : ' ');
+            } else {
+                printd("  %c -- ", policy);
+            }
+        }
+        printd("\r\n");
+    }
+}
+
+static void Regs_Command(const char * args)
+{
+    while (*args == ' ') args++;
+
+    for (uint8_t n = 0; n < regs_count; n++) {
+        const tRegs * regs = regs_list[n];
+        if (*args == '\0') {
+            uint16_t held = 0;
+            uint16_t dirty = 0;
+            for (uint16_t i = 0; i < regs->Count; i++) {
+                held += (regs->Flags[i] & REGS_VALID) ? 1 : 0;
+                dirty += (regs->Flags[i] & REGS_DIRTY) ? 1 : 0;
+            }
+            printd("%-8s 0x%02X..0x%02X  held %u dirty %u  bus reads %lu writes %lu  hits %lu\r\n", regs->Name,
+                   regs->First, regs->First + regs->Count - 1, held, dirty, (unsigned long)regs->Bus_Reads,
+                   (unsigned long)regs->Bus_Writes, (unsigned long)regs->Hits);
+        } else if (strcmp(args, regs->Name) == 0) {
+            Regs_Dump(regs);
+            return;
+        }
+    }
+    if (*args != '\0') {
+        printd("no register shadow '%s'\r\n", args);
+    } else if (regs_count == 0) {
+        printd("no register shadows\r\n");
+    }
+}
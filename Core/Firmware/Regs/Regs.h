@@ -0,0 +1,90 @@
+/*
+ * Regs.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef REGS_REGS_H_
+#define REGS_REGS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tx_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Shadow copy of a device's configuration registers, so reconfiguring and inspecting a sensor does not
+ * have to read registers the driver already knows.
+ * 1) Regs_Init(&imu_regs, "imu", I2C_Regs_Read, I2C_Regs_Write, imu, 0x00, 0x80, true) covers
+ *    registers 0x00..0x7F of the device behind imu. The access functions are the bus backend:
+ *    I2C_Regs_Read/Write (I2C.h) or SPI_Regs_Read/Write (SPI.h); Auto_Increment says the device
+ *    steps its register address over a burst. Every register starts eRegs_Volatile.
+ * 2) Regs_Set_Policy(&imu_regs, CTRL1_XL, 10, eRegs_Write_Through) for the configuration block:
+ *      eRegs_Volatile        every read and write goes to the device (status, data, self-clearing bits)
+ *      eRegs_Write_Through   reads come from the shadow once it holds the value, writes go to the
+ *                            device and the shadow
+ *      eRegs_Cached          as write-through for reads; writes only change the shadow and mark it
+ *                            dirty, Regs_Flush sends the dirty ones (runs of them as one burst)
+ * 3) Regs_Read / Regs_Write / Regs_Modify. Regs_Modify of a register the shadow holds is one write on
+ *    the bus instead of a read and a write. Regs_Load fills the shadow of every non-volatile register
+ *    in one pass; Regs_Invalidate forgets it all after a device reset.
+ * 4) Bus access goes through the blocking helpers of the bus driver, so call from a thread (not an
+ *    ISR or the DEFER thread). A mutex per shadow serialises the threads sharing a device. Registers
+ *    outside First..First + Count - 1 pass straight through to the device.
+ * 5) Changing a register's policy keeps a dirty value until it is flushed; Regs_Flush before
+ *    switching a cached block to volatile.
+ * 6) Console "regs" lists the shadows; "regs <name>" dumps one from RAM without touching the bus
+ *    (-- not held, * dirty).
+ * 7) Regs_Deinit takes a shadow off the list and frees it, for a driver whose init failed after
+ *    Regs_Init. Nothing may use the shadow after that.
+ */
+
+#define REGS_MAX_SHADOWS        8       /* shadows the console can list */
+#define REGS_MAX_COUNT          256
+
+typedef enum {
+    eRegs_Volatile = 0,
+    eRegs_Write_Through,
+    eRegs_Cached,
+} eRegs_Policy;
+
+/* Backend: Size registers from Reg, in or out of Data. Blocking, true if the bus transfer worked. */
+typedef bool (*tRegs_Access)(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size);
+
+typedef struct {
+    const char * Name;
+    tRegs_Access Read;
+    tRegs_Access Write;
+    void * Device;
+    uint16_t First;                 /* first register covered */
+    uint16_t Count;
+    bool Auto_Increment;
+    uint8_t * Value;                /* Count shadow bytes */
+    uint8_t * Flags;                /* Count x (policy | REGS_VALID | REGS_DIRTY) */
+    TX_MUTEX Lock;
+    uint32_t Bus_Reads;
+    uint32_t Bus_Writes;
+    uint32_t Hits;                  /* reads served from the shadow */
+} tRegs;
+
+bool Regs_Init(tRegs * Regs, const char * Name, tRegs_Access Read, tRegs_Access Write, void * Device,
+               uint16_t First, uint16_t Count, bool Auto_Increment);
+void Regs_Deinit(tRegs * Regs);
+void Regs_Set_Policy(tRegs * Regs, uint16_t Reg, uint16_t Count, eRegs_Policy Policy);
+bool Regs_Read(tRegs * Regs, uint16_t Reg, uint8_t * Value);
+bool Regs_Write(tRegs * Regs, uint16_t Reg, uint8_t Value);
+bool Regs_Modify(tRegs * Regs, uint16_t Reg, uint8_t Mask, uint8_t Value);
+bool Regs_Flush(tRegs * Regs);
+bool Regs_Load(tRegs * Regs);
+void Regs_Invalidate(tRegs * Regs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REGS_REGS_H_ */
@@ -7,22 +7,16 @@
 
 #include "SPI.h"
 #include "Scheduler/Scheduler.h"
+#include "../Registry/Registry.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
-static bool SPI_Callbacks_Initialized = false;
-static Queue SPI_Callback_Handles;
 static void SPI_Tasks(void * Task_Data);
+static int32_t SPI_Queue_Write(SPI * SPI_Handle, GPIO * nSS, uint8_t * Transmit_Data, uint16_t Transmit_Data_Size, void * Pre_Function_PTR, void * Post_Function_PTR, void * Function_Data, tTxn * Txn);
 
 SPI * Init_SPI(SPI_HandleTypeDef * SPI_Handle)
 {
-	if(!SPI_Callbacks_Initialized)
-	{
-		Prep_Queue(&SPI_Callback_Handles);
-		SPI_Callbacks_Initialized = true;
-	}
-
 	SPI * spi = (SPI *)malloc(sizeof(SPI));
 	if(spi)
 	{
@@ -36,8 +30,11 @@ SPI * Init_SPI(SPI_HandleTypeDef * SPI_Handle)
 		Set_Task_Name(spi->Task_ID, "SPI Task");
 		Task_Add_Heap_Size(spi->Task_ID, (void *) spi);
 
-		// Add the spi to the callback queue so we can handle HAl callbacks
-		Enqueue(&SPI_Callback_Handles, (void *)spi);
+		// Register the spi for its instance so we can handle HAL callbacks
+		if(!Registry_Add(SPI_Handle->Instance, eRegistry_SPI, spi))
+		{
+			printf("SPI instance already has a driver\r\n");
+		}
 	}
 	else
 	{
@@ -76,8 +73,16 @@ static void SPI_Tasks(void * Task_Data)
 		// Set the chip select low
 		Set_GPIO_State_Low(spi->Current_Task->nSS);
 
-		// Start the transmission
-		HAL_SPI_Transmit_DMA(spi->SPI_Handle, spi->Current_Task->Transmit_Data, spi->Current_Task->Transmit_Data_Size);
+		// Start the transmission, a refused start finishes the task as failed
+		if(HAL_SPI_Transmit_DMA(spi->SPI_Handle, spi->Current_Task->Transmit_Data, spi->Current_Task->Transmit_Data_Size) != HAL_OK)
+		{
+			Set_GPIO_State_High(spi->Current_Task->nSS);
+			if(spi->Current_Task->Txn != NULL)
+			{
+				Txn_Complete(spi->Current_Task->Txn, false);
+			}
+			spi->SPI_Busy = false;
+		}
 	}
 }
 
@@ -169,8 +174,42 @@ int32_t SPI_Addressed_Read(SPI * SPI_Handle, GPIO * nSS, uint8_t * Transmit_Data
 		return 0;
 }
 
+bool SPI_Regs_Read(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size)
+{
+	SPI_Regs_Device * device = (SPI_Regs_Device *)Device;
+	uint8_t address = (uint8_t)Reg | device->Read_Flag;
+	return SPI_Addressed_Read(device->SPI_Handle, device->nSS, &address, 1, Data, Size) == Size;
+}
+
+bool SPI_Regs_Write(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size)
+{
+	SPI_Regs_Device * device = (SPI_Regs_Device *)Device;
+	uint8_t address = (uint8_t)Reg & (uint8_t)~device->Read_Flag;
+	return SPI_Addressed_Write(device->SPI_Handle, device->nSS, &address, 1, Data, Size) == Size;
+}
+
 
 int32_t SPI_Write_DMA(SPI * SPI_Handle, GPIO * nSS, uint8_t * Transmit_Data, uint16_t Transmit_Data_Size, void * Pre_Function_PTR, void * Post_Function_PTR, void * Function_Data)
+{
+	return SPI_Queue_Write(SPI_Handle, nSS, Transmit_Data, Transmit_Data_Size, Pre_Function_PTR, Post_Function_PTR, Function_Data, NULL);
+}
+
+tTxn * SPI_Write_DMA_Txn(SPI * SPI_Handle, tTxn_Set * Set, GPIO * nSS, uint8_t * Transmit_Data, uint16_t Transmit_Data_Size)
+{
+	tTxn * txn = Txn_Open(Set);
+	if(txn == NULL)
+		return NULL;
+
+	if(SPI_Queue_Write(SPI_Handle, nSS, Transmit_Data, Transmit_Data_Size, NULL, NULL, NULL, txn) < 0)
+	{
+		Txn_Complete(txn, false);
+		Txn_Release(txn);
+		return NULL;
+	}
+	return txn;
+}
+
+static int32_t SPI_Queue_Write(SPI * SPI_Handle, GPIO * nSS, uint8_t * Transmit_Data, uint16_t Transmit_Data_Size, void * Pre_Function_PTR, void * Post_Function_PTR, void * Function_Data, tTxn * Txn)
 {
 	// Save all the data and queue to be processed when the bus is free
 	SPI_Task * task = (SPI_Task *)Task_malloc(SPI_Handle->Task_ID, sizeof(SPI_Task));
@@ -186,6 +225,7 @@ int32_t SPI_Write_DMA(SPI * SPI_Handle, GPIO * nSS, uint8_t * Transmit_Data, uin
 			task->Transmit_Data_Size = Transmit_Data_Size;
 			task->Type = eWrite_DMA;
 			task->nSS = nSS;
+			task->Txn = Txn;
 
 			Enqueue(&SPI_Handle->Task_Queue, (void *)task);
 
@@ -200,24 +240,40 @@ int32_t SPI_Write_DMA(SPI * SPI_Handle, GPIO * nSS, uint8_t * Transmit_Data, uin
 
 void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
 {
-	// Search for the correct spi handle
-	for(int c = 0; c < SPI_Callback_Handles.Size; c++)
+	// Find the spi the callback is for
+	SPI * spi = (SPI *)Registry_Find(hspi->Instance, eRegistry_SPI);
+	if(spi != NULL)
 	{
-		SPI * spi = (SPI *)Queue_Peek(&SPI_Callback_Handles, c);
-		if(spi->SPI_Handle == hspi)
-		{
-			// We have found the spi handle the callback is for
+		// Set the chip select high
+		Set_GPIO_State_High(spi->Current_Task->nSS);
 
-			// Set the chip select high
-			Set_GPIO_State_High(spi->Current_Task->nSS);
+		// The transmission is complete, call the post function pointer then set the bus to free
+		if(spi->Current_Task->Post_Function != NULL)
+		{
+			spi->Current_Task->Post_Function(spi->Current_Task->Function_Data);
+		}
+		if(spi->Current_Task->Txn != NULL)
+		{
+			Txn_Complete(spi->Current_Task->Txn, true);
+		}
 
-			// The transmission is complete, call the post function pointer then set the bus to free
-			if(spi->Current_Task->Post_Function != NULL)
-			{
-				spi->Current_Task->Post_Function(spi->Current_Task->Function_Data);
-			}
+		spi->SPI_Busy = false;
+	}
+}
 
-			spi->SPI_Busy = false;
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+	// Find the spi the callback is for
+	SPI * spi = (SPI *)Registry_Find(hspi->Instance, eRegistry_SPI);
+	if(spi != NULL && spi->Current_Task != NULL)
+	{
+		// The transfer is over, release the chip select and free the bus for the next task
+		Set_GPIO_State_High(spi->Current_Task->nSS);
+		if(spi->Current_Task->Txn != NULL)
+		{
+			Txn_Complete(spi->Current_Task->Txn, false);
 		}
+
+		spi->SPI_Busy = false;
 	}
 }
@@ -11,6 +11,7 @@
 #include "main.h"
 #include "GPIO/GPIO.h"
 #include "Queue/Queue.h"
+#include "Txn/txn.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -45,6 +46,7 @@ typedef struct
 	void (*Pre_Function)(void *);
 	void (*Post_Function)(void *);
 	void * Function_Data;
+	tTxn * Txn;
 }SPI_Task;
 
 typedef struct
@@ -58,6 +60,14 @@ typedef struct
 	uint32_t Task_ID;
 }SPI;
 
+/* Register shadow backend device (Regs/Regs.h): one byte of register address, Read_Flag or'd in for reads (0x80 on most sensors) */
+typedef struct
+{
+	SPI * SPI_Handle;
+	GPIO * nSS;
+	uint8_t Read_Flag;
+}SPI_Regs_Device;
+
 SPI * Init_SPI(SPI_HandleTypeDef * SPI_Handle);
 
 /* BLOCKING FUNCTION CALLS */
@@ -65,9 +75,13 @@ int32_t SPI_Write(SPI * SPI_Handle, GPIO * nSS, uint8_t * Transmit_Data, uint32_
 int32_t SPI_Read(SPI * SPI_Handle, GPIO * nSS, uint8_t * Return_Data, uint16_t Return_Data_Size);
 int32_t SPI_Addressed_Write(SPI * SPI_Handle, GPIO * nSS, uint8_t * Address_Data, uint16_t Address_Data_Size, uint8_t * Transmit_Data, uint16_t Transmit_Data_Size);
 int32_t SPI_Addressed_Read(SPI * SPI_Handle, GPIO * nSS, uint8_t * Transmit_Data, uint16_t Transmit_Data_Size, uint8_t * Return_Data, uint16_t Return_Data_Size);
+bool SPI_Regs_Read(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size);
+bool SPI_Regs_Write(void * Device, uint16_t Reg, uint8_t * Data, uint16_t Size);
 
 /* DMA FUNCTION CALLS */
 int32_t SPI_Write_DMA(SPI * SPI_Handle, GPIO * nSS, uint8_t * Transmit_Data, uint16_t Transmit_Data_Size, void * Pre_Function_PTR, void * Post_Function_PTR, void * Function_Data);
+/* Same, returning a handle of Set to wait on (see Txn/txn.h), NULL if it could not be queued */
+tTxn * SPI_Write_DMA_Txn(SPI * SPI_Handle, tTxn_Set * Set, GPIO * nSS, uint8_t * Transmit_Data, uint16_t Transmit_Data_Size);
 
 
 #ifdef __cplusplus
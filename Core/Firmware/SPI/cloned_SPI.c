@@ -7,30 +7,16 @@
 
 #include "cloned_SPI.h"
 #include "Scheduler/Scheduler.h"
+#include "../Registry/Registry.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
-static bool Cloned_SPI_Callbacks_Initialized = false;
-static Queue Cloned_SPI_Callback_Handles;
 static void Cloned_SPI_Tasks(void * Task_Data);
-
-/* Helper functions for circular buffer management */
-static uint32_t Circular_Buffer_Available_Space(volatile SPI_DMA_CircularBuffer * buffer);
-static uint32_t Circular_Buffer_Used_Space(volatile SPI_DMA_CircularBuffer * buffer);
-static void Circular_Buffer_Update_Write_Index(volatile SPI_DMA_CircularBuffer * buffer, uint32_t bytes_written);
-static uint32_t Circular_Buffer_Read_Data(volatile SPI_DMA_CircularBuffer * buffer, uint8_t * dest, uint32_t max_bytes);
-static void Circular_Buffer_Init(volatile SPI_DMA_CircularBuffer * buffer);
-static uint32_t Circular_Buffer_Read_From_Position(volatile SPI_DMA_CircularBuffer * buffer, uint32_t start_pos, uint8_t * dest, uint32_t bytes_to_read);
+static void Circular_Buffer_Init(SPI_DMA_CircularBuffer * buffer);
 
 Cloned_SPI * Init_Cloned_SPI(SPI_HandleTypeDef * SPI_Handle, DMA_HandleTypeDef * DMA_RX_Handle, DMA_HandleTypeDef * DMA_TX_Handle)
 {
-	if(!Cloned_SPI_Callbacks_Initialized)
-	{
-		Prep_Queue(&Cloned_SPI_Callback_Handles);
-		Cloned_SPI_Callbacks_Initialized = true;
-	}
-
 	Cloned_SPI * spi = (Cloned_SPI *)malloc(sizeof(Cloned_SPI));
 	if(spi)
 	{
@@ -50,8 +36,11 @@ Cloned_SPI * Init_Cloned_SPI(SPI_HandleTypeDef * SPI_Handle, DMA_HandleTypeDef *
 		Set_Task_Name(spi->Task_ID, "Cloned SPI Task");
 		Task_Add_Heap_Size(spi->Task_ID, (void *) spi);
 
-		/* Add the spi to the callback queue so we can handle HAL callbacks */
-		Enqueue(&Cloned_SPI_Callback_Handles, (void *)spi);
+		/* Register the spi for its instance so we can handle HAL callbacks */
+		if(!Registry_Add(SPI_Handle->Instance, eRegistry_Cloned_SPI, spi))
+		{
+			printf("Cloned SPI instance already has a driver\r\n");
+		}
 	}
 	else
 	{
@@ -93,17 +82,8 @@ void Cleanup_Cloned_SPI(Cloned_SPI * SPI_Handle)
 		Task_free(SPI_Handle->Task_ID, SPI_Handle->Current_Task);
 	}
 	
-	/* Remove from callback handles */
-	for(int i = 0; i < Cloned_SPI_Callback_Handles.Size; i++)
-	{
-		Cloned_SPI * spi = (Cloned_SPI *)Queue_Peek(&Cloned_SPI_Callback_Handles, i);
-		if(spi == SPI_Handle)
-		{
-			/* Remove this handle from the queue */
-			Queue_Remove_At_Index(&Cloned_SPI_Callback_Handles, i);
-			break;
-		}
-	}
+	/* Remove from the callback registry */
+	Registry_Remove(SPI_Handle->SPI_Handle->Instance, SPI_Handle);
 	
 	free(SPI_Handle);
 }
@@ -359,8 +339,8 @@ int32_t Cloned_SPI_Addressed_Read_Circular(Cloned_SPI * SPI_Handle, GPIO * nSS,
 			   (ret == HAL_TIMEOUT) ? eSPI_Timeout : eSPI_Failed;
 	}
 	
-	/* Mark the start position for reading from circular buffer */
-	uint32_t start_position = SPI_Handle->dma_buffer.write_index;
+	/* Drop what was clocked in before the address, the reply starts with the next byte */
+	DMA_Stream_Skip(&SPI_Handle->dma_buffer.stream);
 	
 	/* Wait for enough bytes to be received in circular buffer */
 	uint32_t timeout_counter = 0;
@@ -368,26 +348,10 @@ int32_t Cloned_SPI_Addressed_Read_Circular(Cloned_SPI * SPI_Handle, GPIO * nSS,
 	
 	while(timeout_counter < max_timeout)
 	{
-		uint32_t current_write_pos = SPI_Handle->dma_buffer.write_index;
-		uint32_t available_bytes;
-		
-		if(current_write_pos >= start_position)
-		{
-			available_bytes = current_write_pos - start_position;
-		}
-		else
-		{
-			/* Wrapped around */
-			available_bytes = (SPI_DMA_BUFFER_SIZE - start_position) + current_write_pos;
-		}
-		
-		if(available_bytes >= Expected_Read_Bytes)
+		if(DMA_Stream_Available(&SPI_Handle->dma_buffer.stream) >= Expected_Read_Bytes)
 		{
 			/* Enough data available, read it */
-			uint32_t bytes_read = Circular_Buffer_Read_From_Position(&SPI_Handle->dma_buffer, 
-																	start_position, 
-																	Return_Buffer, 
-																	Expected_Read_Bytes);
+			uint32_t bytes_read = DMA_Stream_Read(&SPI_Handle->dma_buffer.stream, Return_Buffer, Expected_Read_Bytes);
 			
 			Set_GPIO_State_High(nSS);
 			
@@ -417,9 +381,11 @@ int32_t Cloned_SPI_Start_Circular_Read(Cloned_SPI * SPI_Handle, GPIO * nSS)
 	if(!SPI_Handle || SPI_Handle->circular_read_active) 
 		return eSPI_Busy;
 		
-	/* Initialize the circular buffer */
+	/* Initialize the circular buffer, the RX DMA channel must be circular (DMA_Allocate(..., DMA_CIRCULAR, ...)) */
 	Circular_Buffer_Init(&SPI_Handle->dma_buffer);
 	SPI_Handle->dma_buffer.nSS = nSS;
+	DMA_Stream_Init(&SPI_Handle->dma_buffer.stream, SPI_Handle->dma_buffer.buffer, SPI_DMA_BUFFER_SIZE, 1,
+					&SPI_Handle->DMA_RX_Handle->Instance->CNDTR);
 	
 	/* Set CS low to start communication */
 	Set_GPIO_State_Low(nSS);
@@ -477,7 +443,7 @@ int32_t Cloned_SPI_Read_Available_Data(Cloned_SPI * SPI_Handle, uint8_t * buffer
 	if(!SPI_Handle->circular_read_active)
 		return 0;
 		
-	return Circular_Buffer_Read_Data(&SPI_Handle->dma_buffer, buffer, max_bytes);
+	return DMA_Stream_Read(&SPI_Handle->dma_buffer.stream, buffer, max_bytes);
 }
 
 bool Cloned_SPI_Is_Data_Available(Cloned_SPI * SPI_Handle)
@@ -485,7 +451,7 @@ bool Cloned_SPI_Is_Data_Available(Cloned_SPI * SPI_Handle)
 	if(!SPI_Handle || !SPI_Handle->circular_read_active) 
 		return false;
 		
-	return SPI_Handle->dma_buffer.data_available;
+	return DMA_Stream_Available(&SPI_Handle->dma_buffer.stream) > 0;
 }
 
 uint32_t Cloned_SPI_Get_Available_Bytes(Cloned_SPI * SPI_Handle)
@@ -493,218 +459,113 @@ uint32_t Cloned_SPI_Get_Available_Bytes(Cloned_SPI * SPI_Handle)
 	if(!SPI_Handle || !SPI_Handle->circular_read_active) 
 		return 0;
 		
-	return Circular_Buffer_Used_Space(&SPI_Handle->dma_buffer);
+	return DMA_Stream_Available(&SPI_Handle->dma_buffer.stream);
 }
 
 /* Circular Buffer Helper Functions */
-static void Circular_Buffer_Init(volatile SPI_DMA_CircularBuffer * buffer)
+static void Circular_Buffer_Init(SPI_DMA_CircularBuffer * buffer)
 {
-	memset((void*)buffer->buffer, 0, SPI_DMA_BUFFER_SIZE);
-	buffer->write_index = 0;
-	buffer->read_index = 0;
-	buffer->data_available = false;
-	buffer->overflow = false;
+	memset(buffer->buffer, 0, SPI_DMA_BUFFER_SIZE);
 	buffer->state = eSPI_DMA_Idle;
-	buffer->bytes_received = 0;
 	buffer->nSS = NULL;
 }
 
-static uint32_t Circular_Buffer_Available_Space(volatile SPI_DMA_CircularBuffer * buffer)
+
+/* DMA Callback Functions */
+void HAL_SPI_TxCpltCallback_Cloned(SPI_HandleTypeDef *hspi)
 {
-	if(buffer->write_index >= buffer->read_index)
-	{
-		return SPI_DMA_BUFFER_SIZE - (buffer->write_index - buffer->read_index) - 1;
-	}
-	else
+	/* Find the spi the callback is for */
+	Cloned_SPI * spi = (Cloned_SPI *)Registry_Find(hspi->Instance, eRegistry_Cloned_SPI);
+	if(spi == NULL)
 	{
-		return buffer->read_index - buffer->write_index - 1;
+		return;
 	}
-}
 
-static uint32_t Circular_Buffer_Used_Space(volatile SPI_DMA_CircularBuffer * buffer)
-{
-	if(buffer->write_index >= buffer->read_index)
+	/* Handle multi-phase addressed write operations */
+	if(spi->Current_Task->Type == eAddressed_Write_DMA)
 	{
-		return buffer->write_index - buffer->read_index;
+		if(spi->Current_Task->current_phase == eSPI_Task_Phase_Address)
+		{
+			/* Address phase complete, now transmit data */
+			spi->Current_Task->current_phase = eSPI_Task_Phase_Data;
+			HAL_SPI_Transmit_DMA(spi->SPI_Handle, spi->Current_Task->Transmit_Data, spi->Current_Task->Transmit_Data_Size);
+			return; /* Don't complete the task yet */
+		}
+		else if(spi->Current_Task->current_phase == eSPI_Task_Phase_Data)
+		{
+			/* Data phase complete, finish the task */
+			Set_GPIO_State_High(spi->Current_Task->nSS);
+
+			if(spi->Current_Task->Post_Function != NULL)
+			{
+				spi->Current_Task->Post_Function(spi->Current_Task->Function_Data);
+			}
+
+			spi->SPI_Busy = false;
+		}
 	}
 	else
 	{
-		return SPI_DMA_BUFFER_SIZE - (buffer->read_index - buffer->write_index);
-	}
-}
+		/* Single phase operation - complete normally */
+		Set_GPIO_State_High(spi->Current_Task->nSS);
 
-static void Circular_Buffer_Update_Write_Index(volatile SPI_DMA_CircularBuffer * buffer, uint32_t bytes_written)
-{
-	buffer->write_index = (buffer->write_index + bytes_written) % SPI_DMA_BUFFER_SIZE;
-	buffer->bytes_received += bytes_written;
-	
-	if(Circular_Buffer_Used_Space(buffer) > 0)
-	{
-		buffer->data_available = true;
-	}
-	
-	/* Check for overflow */
-	if(Circular_Buffer_Available_Space(buffer) == 0)
-	{
-		buffer->overflow = true;
+		/* The transmission is complete, call the post function pointer then set the bus to free */
+		if(spi->Current_Task->Post_Function != NULL)
+		{
+			spi->Current_Task->Post_Function(spi->Current_Task->Function_Data);
+		}
+
+		spi->SPI_Busy = false;
 	}
 }
 
-static uint32_t Circular_Buffer_Read_Data(volatile SPI_DMA_CircularBuffer * buffer, uint8_t * dest, uint32_t max_bytes)
+void HAL_SPI_RxHalfCpltCallback_Cloned(SPI_HandleTypeDef *hspi)
 {
-	uint32_t available = Circular_Buffer_Used_Space(buffer);
-	uint32_t to_read = (available < max_bytes) ? available : max_bytes;
-	uint32_t bytes_read = 0;
-	
-	while(bytes_read < to_read)
-	{
-		dest[bytes_read] = buffer->buffer[buffer->read_index];
-		buffer->read_index = (buffer->read_index + 1) % SPI_DMA_BUFFER_SIZE;
-		bytes_read++;
-	}
-	
-	/* Update data available flag */
-	if(Circular_Buffer_Used_Space(buffer) == 0)
-	{
-		buffer->data_available = false;
-	}
-	
-	/* Clear overflow flag if we've made space */
-	if(buffer->overflow && Circular_Buffer_Available_Space(buffer) > 0)
+	/* Find the spi the callback is for */
+	Cloned_SPI * spi = (Cloned_SPI *)Registry_Find(hspi->Instance, eRegistry_Cloned_SPI);
+
+	if(spi != NULL && spi->circular_read_active)
 	{
-		buffer->overflow = false;
+		DMA_Stream_Half_Complete(&spi->dma_buffer.stream);
+		spi->dma_buffer.state = eSPI_DMA_Half_Complete;
 	}
-	
-	return bytes_read;
 }
 
-static uint32_t Circular_Buffer_Read_From_Position(volatile SPI_DMA_CircularBuffer * buffer, uint32_t start_pos, uint8_t * dest, uint32_t bytes_to_read)
+void HAL_SPI_RxCpltCallback_Cloned(SPI_HandleTypeDef *hspi)
 {
-	uint32_t current_write_pos = buffer->write_index;
-	uint32_t available_bytes;
-	uint32_t bytes_read = 0;
-	uint32_t read_pos = start_pos;
-	
-	/* Calculate available bytes from start position to current write position */
-	if(current_write_pos >= start_pos)
-	{
-		available_bytes = current_write_pos - start_pos;
-	}
-	else
-	{
-		/* Wrapped around */
-		available_bytes = (SPI_DMA_BUFFER_SIZE - start_pos) + current_write_pos;
-	}
-	
-	/* Read only what's available and requested */
-	uint32_t to_read = (available_bytes < bytes_to_read) ? available_bytes : bytes_to_read;
-	
-	while(bytes_read < to_read)
+	/* Find the spi the callback is for */
+	Cloned_SPI * spi = (Cloned_SPI *)Registry_Find(hspi->Instance, eRegistry_Cloned_SPI);
+
+	/* Handle circular DMA read completion */
+	if(spi != NULL && spi->circular_read_active)
 	{
-		dest[bytes_read] = buffer->buffer[read_pos];
-		read_pos = (read_pos + 1) % SPI_DMA_BUFFER_SIZE;
-		bytes_read++;
+		/* Full buffer complete - the DMA wrapped, count the lap */
+		DMA_Stream_Full_Complete(&spi->dma_buffer.stream);
+		spi->dma_buffer.state = eSPI_DMA_Full_Complete;
 	}
-	
-	return bytes_read;
 }
 
 
-/* DMA Callback Functions */
-void HAL_SPI_TxCpltCallback_Cloned(SPI_HandleTypeDef *hspi)
+void HAL_SPI_ErrorCallback_Cloned(SPI_HandleTypeDef *hspi)
 {
-	/* Search for the correct spi handle */
-	for(int c = 0; c < Cloned_SPI_Callback_Handles.Size; c++)
+	/* Find the spi the callback is for */
+	Cloned_SPI * spi = (Cloned_SPI *)Registry_Find(hspi->Instance, eRegistry_Cloned_SPI);
+	if(spi == NULL)
 	{
-		Cloned_SPI * spi = (Cloned_SPI *)Queue_Peek(&Cloned_SPI_Callback_Handles, c);
-		if(spi->SPI_Handle == hspi)
-		{
-			/* We have found the spi handle the callback is for */
-
-			/* Handle multi-phase addressed write operations */
-			if(spi->Current_Task->Type == eAddressed_Write_DMA)
-			{
-				if(spi->Current_Task->current_phase == eSPI_Task_Phase_Address)
-				{
-					/* Address phase complete, now transmit data */
-					spi->Current_Task->current_phase = eSPI_Task_Phase_Data;
-					HAL_SPI_Transmit_DMA(spi->SPI_Handle, spi->Current_Task->Transmit_Data, spi->Current_Task->Transmit_Data_Size);
-					break; /* Don't complete the task yet */
-				}
-				else if(spi->Current_Task->current_phase == eSPI_Task_Phase_Data)
-				{
-					/* Data phase complete, finish the task */
-					Set_GPIO_State_High(spi->Current_Task->nSS);
-
-					if(spi->Current_Task->Post_Function != NULL)
-					{
-						spi->Current_Task->Post_Function(spi->Current_Task->Function_Data);
-					}
-
-					spi->SPI_Busy = false;
-				}
-			}
-			else
-			{
-				/* Single phase operation - complete normally */
-				Set_GPIO_State_High(spi->Current_Task->nSS);
-
-				/* The transmission is complete, call the post function pointer then set the bus to free */
-				if(spi->Current_Task->Post_Function != NULL)
-				{
-					spi->Current_Task->Post_Function(spi->Current_Task->Function_Data);
-				}
-
-				spi->SPI_Busy = false;
-			}
-			break;
-		}
+		return;
 	}
-}
 
-void HAL_SPI_RxCpltCallback_Cloned(SPI_HandleTypeDef *hspi)
-{
-	/* Search for the correct spi handle */
-	for(int c = 0; c < Cloned_SPI_Callback_Handles.Size; c++)
+	/* Handle error condition */
+	if(spi->circular_read_active)
 	{
-		Cloned_SPI * spi = (Cloned_SPI *)Queue_Peek(&Cloned_SPI_Callback_Handles, c);
-		if(spi->SPI_Handle == hspi)
-		{
-			/* Handle circular DMA read completion */
-			if(spi->circular_read_active)
-			{
-				/* Full buffer complete - update write index to full buffer */
-				Circular_Buffer_Update_Write_Index(&spi->dma_buffer, SPI_DMA_BUFFER_SIZE);
-				spi->dma_buffer.state = eSPI_DMA_Full_Complete;
-			}
-			break;
-		}
+		spi->dma_buffer.state = eSPI_DMA_Error;
+		/* Optionally restart or stop circular read on error */
+		Cloned_SPI_Stop_Circular_Read(spi);
 	}
-}
-
-
-void HAL_SPI_ErrorCallback_Cloned(SPI_HandleTypeDef *hspi)
-{
-	/* Search for the correct spi handle */
-	for(int c = 0; c < Cloned_SPI_Callback_Handles.Size; c++)
+	else if(spi->Current_Task)
 	{
-		Cloned_SPI * spi = (Cloned_SPI *)Queue_Peek(&Cloned_SPI_Callback_Handles, c);
-		if(spi->SPI_Handle == hspi)
-		{
-			/* Handle error condition */
-			if(spi->circular_read_active)
-			{
-				spi->dma_buffer.state = eSPI_DMA_Error;
-				/* Optionally restart or stop circular read on error */
-				Cloned_SPI_Stop_Circular_Read(spi);
-			}
-			else if(spi->Current_Task)
-			{
-				/* Set CS high and mark as not busy */
-				Set_GPIO_State_High(spi->Current_Task->nSS);
-				spi->SPI_Busy = false;
-			}
-			break;
-		}
+		/* Set CS high and mark as not busy */
+		Set_GPIO_State_High(spi->Current_Task->nSS);
+		spi->SPI_Busy = false;
 	}
 }
\ No newline at end of file
@@ -11,11 +11,12 @@
 #include "main.h"
 #include "GPIO/GPIO.h"
 #include "Queue/Queue.h"
+#include "../DMA/DMA_Stream.h"
 #include <stdint.h>
 #include <stdbool.h>
 
 #define MAX_SPI_WAIT_TIME		100
-#define SPI_DMA_BUFFER_SIZE		1024
+#define SPI_DMA_BUFFER_SIZE		1024	/* power of two, see DMA_Stream.h */
 #define SPI_DMA_HALF_BUFFER	(SPI_DMA_BUFFER_SIZE / 2)
 
 #ifdef __cplusplus
@@ -68,12 +69,8 @@ typedef struct
 typedef struct
 {
 	uint8_t buffer[SPI_DMA_BUFFER_SIZE];
-	volatile uint32_t write_index;
-	volatile uint32_t read_index;
-	volatile bool data_available;
-	volatile bool overflow;
+	tDMA_Stream stream;		/* read cursor over buffer, follows the circular RX DMA */
 	volatile SPI_DMA_State state;
-	volatile uint32_t bytes_received;
 	GPIO * nSS;
 }SPI_DMA_CircularBuffer;
 
@@ -119,6 +116,7 @@ int32_t Cloned_SPI_Addressed_Read_Circular(Cloned_SPI * SPI_Handle, GPIO * nSS,
 
 /* DMA Callback Functions */
 void HAL_SPI_TxCpltCallback_Cloned(SPI_HandleTypeDef *hspi);
+void HAL_SPI_RxHalfCpltCallback_Cloned(SPI_HandleTypeDef *hspi);
 void HAL_SPI_RxCpltCallback_Cloned(SPI_HandleTypeDef *hspi);
 void HAL_SPI_ErrorCallback_Cloned(SPI_HandleTypeDef *hspi);
 
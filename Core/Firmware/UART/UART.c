@@ -11,21 +11,24 @@
 #include <stdio.h>
 
 #include "UART.h"
+#include "../../Middlewares/Log/log.h"
+#include "../../Middlewares/Defer/defer.h"
+#include "../Registry/Registry.h"
 #include "../../Middlewares/Scheduler/Scheduler.h"
 #include "main.h"
 
-static bool UART_Callbacks_Initialized = false;
-static Queue * UART_Callback_Handles;
 static void UART_Task(tUART * UART);
-
-void Init_UART_CallBack_Queue(void){
-    UART_Callback_Handles = Prep_Queue();
-}
+static void UART_Start_RX(tUART * UART);
+static tUART * UART_Find_Handle(UART_HandleTypeDef * huart);
+static void UART_Latch(UART_HandleTypeDef * huart, uint8_t Pending);
+static void UART_Post_Pending(tUART * UART);
+static void UART_RX_Event_Work(void * Arg, uint32_t Data);
+static void UART_Error_Work(void * Arg, uint32_t Data);
 
 
 /** 
- *@brief: malloc a UART, and initialize UART struct members for a UART using DMA. Add it to the callback
- * handles queue for when you want to do a callback to match it, then start a task for transmitting the 
+ *@brief: malloc a UART, and initialize UART struct members for a UART using DMA. Register it for its
+ * USART instance so HAL callbacks can find it (Registry.h), then start a task for transmitting the 
  * UART (checking bufer and transmitting accordingly). Updates memory trackers for the UART task, and 
  * sets up the DMA Access. DMA never needs to be RX'd - it will automatically load into UART RX
  *
@@ -43,13 +46,17 @@ tUART * Init_DMA_UART(UART_HandleTypeDef * UART_Handle){
         UART->UART_Enabled = true;
         UART->TX_Buffer = NULL; //tracker to tell if transmission has happened before (flag)
         UART->Currently_Transmitting = false;
-        UART->RX_Buff_Head_Idx = 0;
-        UART->RX_Buff_Tail_Idx = 0;
+        UART->RX_Notify = NULL;
+        UART->RX_Notify_Params = NULL;
+        UART->Pending = 0;
+        UART->RX_Restart = false;
         UART->SUDO_Handler = NULL;
         UART->TX_Queue = Prep_Queue();
         
-        //enqueue it to the callback handles so we can find it when we need to do callbacks
-        Enqueue(UART_Callback_Handles, (void *)UART);
+        //register it for its instance so we can find it when we need to do callbacks
+        if (!Registry_Add(UART_Handle->Instance, eRegistry_UART, UART)){
+            LOG_ERROR(UART, "Init UART: instance already has a driver\r\n");
+        }
         //start a new task for checking this UART and handling it
         UART->Task_ID = Start_Task(UART_Task, (void*)UART, 0);  // timeout value is 0. that means 
                                                 // will always proc for new UART TX's. (Immediately)
@@ -59,14 +66,14 @@ tUART * Init_DMA_UART(UART_HandleTypeDef * UART_Handle){
         Task_Add_Heap_Usage(UART->Task_ID, (void*)UART);
         Set_Task_Name(UART->Task_ID, "UART RX/TX");
         //set up the DMA access
-        HAL_UART_Receive_DMA(UART_Handle, UART->RX_Buffer, UART_RX_BUFF_SIZE);
+        UART_Start_RX(UART);
         
 
         // init recieve function
         //return a pointer to the struct
         return UART;
     } else {
-        printf("func INIT UART: malloc failed");
+        LOG_ERROR(UART, "Init UART: malloc failed\r\n");
     }
 }
 
@@ -79,16 +86,21 @@ tUART * Init_DMA_UART(UART_HandleTypeDef * UART_Handle){
  * 
  * @returns: tUART struct initialized and malloc-ed
  * */
-tUART * Init_SUDO_UART(void * (*Transmit_Func_Ptr)(uint8_t*, uint8_t), void * (*Receive_Func_Ptr)(uint8_t*, uint8_t)){
+tUART * Init_SUDO_UART(void * (*Transmit_Func_Ptr)(tUART *, uint8_t *, uint16_t),
+                       void * (*Receive_Func_Ptr)(tUART *, uint8_t *, uint16_t *)){
     tUART * UART = (tUART*)malloc(sizeof(tUART));
-    if (UART != NULL){
+    SUDO_UART * SUDO_Handler = (SUDO_UART*)malloc(sizeof(SUDO_UART));
+    if (UART != NULL && SUDO_Handler != NULL){
         UART->UART_Handle = NULL;
         UART->Use_DMA = false;
         UART->UART_Enabled = true;
         UART->TX_Buffer = NULL;
         UART->Currently_Transmitting = false;
-        UART->RX_Buff_Head_Idx = 0;
-        UART->RX_Buff_Tail_Idx = 0;
+        UART->RX_Notify = NULL;
+        UART->RX_Notify_Params = NULL;
+        UART->Pending = 0;
+        UART->RX_Restart = false;
+        UART->SUDO_Handler = SUDO_Handler;
         UART->SUDO_Handler->SUDO_Transmit = Transmit_Func_Ptr;
         UART->SUDO_Handler->SUDO_Receive = Receive_Func_Ptr;
         UART->TX_Queue = Prep_Queue();
@@ -96,8 +108,11 @@ tUART * Init_SUDO_UART(void * (*Transmit_Func_Ptr)(uint8_t*, uint8_t), void * (*
 
         Task_Add_Heap_Usage(UART->Task_ID, (void*)UART);
         Set_Task_Name(UART->Task_ID, "SUDO UART RX/TX");
+        return UART;
     } else {
-        printf("func INIT UART: malloc failed");
+        free(UART);
+        free(SUDO_Handler);
+        LOG_ERROR(UART, "Init UART: malloc failed\r\n");
         return NULL;
     }    
 }
@@ -124,8 +139,20 @@ tUART * Init_SUDO_UART(void * (*Transmit_Func_Ptr)(uint8_t*, uint8_t), void * (*
  * @return: None 
  */
 void UART_Task(tUART * UART){
+    UART_Post_Pending(UART);
+
+    // claim the transmitter with interrupts off - UART_Add_Transmit kicks this task from thread context
+    // while the scheduler may also be polling it
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool claimed = !UART->Currently_Transmitting && UART->UART_Enabled && UART->TX_Queue->Size > 0;
+    if (claimed){
+        UART->Currently_Transmitting = true;
+    }
+    __set_PRIMASK(primask);
+
     // if ready to transmit
-    if (!UART->Currently_Transmitting && UART->UART_Enabled && UART->TX_Queue->Size > 0){
+    if (claimed){
         // clear out the previous buffer
         if (UART->TX_Buffer != NULL){
             Task_Free(UART->Task_ID, UART->TX_Buffer->Data); // can do this because malloc remembers size, when you malloc'd 
@@ -137,9 +164,8 @@ void UART_Task(tUART * UART){
         if(UART->Use_DMA){
 			HAL_UART_Transmit_DMA(UART->UART_Handle, UART->TX_Buffer->Data, UART->TX_Buffer->Data_Size);
         } else if (UART->SUDO_Handler != NULL){
-            UART->SUDO_Handler->SUDO_Transmit(UART->UART_Handle, UART->TX_Buffer->Data, UART->TX_Buffer->Data_Size);
+            UART->SUDO_Handler->SUDO_Transmit(UART, UART->TX_Buffer->Data, UART->TX_Buffer->Data_Size);
         }
-        UART->Currently_Transmitting = true;
     }
 } 
 
@@ -156,11 +182,10 @@ void Enable_UART(tUART * UART){
 	UART->TX_Queue = Prep_Queue();
 	UART->TX_Buffer = NULL;
 	UART->Currently_Transmitting = false;
-	UART->RX_Buff_Head_Idx = 0;
-	UART->RX_Buff_Tail_Idx = 0;
 	UART->UART_Enabled = true;
+	UART->RX_Restart = false;
 
-	HAL_UART_Receive_DMA(UART->UART_Handle, UART->RX_Buffer, UART_RX_BUFF_SIZE);
+	UART_Start_RX(UART);
 }
 
 /**
@@ -177,14 +202,9 @@ void Disable_UART(tUART * UART){
     // if using DMA
     if (UART->Use_DMA == true){
         if (UART->UART_Handle->RxState == HAL_UART_STATE_BUSY_RX){
-            // allow all recieving transmissions to go thru
-            printf("func Disable UART: Rx is busy, waiting for RX transmission to finish.\r\n");
-            while (UART->UART_Handle->RxState == HAL_UART_STATE_BUSY_RX){
-                HAL_Delay(1);
-            }
-            // then deactivate the UART DMA immeadiately
+            // RX is a continuous circular reception, so it never finishes on its own - stop it here
             HAL_UART_DMAStop(UART->UART_Handle);  // Stop the DMA reception
-            printf("func Disable UART: Rx finished. Disabling UART\r\n");
+            LOG_DEBUG(UART, "Disable UART: Rx stopped. Disabling UART\r\n");
         }
         // Deinit the UART
         HAL_UART_MspDeInit(UART->UART_Handle);
@@ -213,12 +233,12 @@ void Disable_UART(tUART * UART){
 int8_t UART_Add_Transmit(tUART * UART, uint8_t * Data, uint8_t Data_Size){
     // check if transmits are enabled
     if (!UART->UART_Enabled){
-        printf("Tried to transmit and failed. UART Disabled.\r\n");
+        LOG_WARN(UART, "Tried to transmit and failed. UART Disabled.\r\n");
         return 0;
     }
     // if data size is too big, return fail;
     if (Data_Size > MAX_TX_BUFF_SIZE){
-        printf("Tried to transmit and failed. Transmit Data is too big.\r\n");
+        LOG_WARN(UART, "Tried to transmit and failed. Transmit Data is too big.\r\n");
         return 0;
     }
     // create a new Tx node
@@ -232,52 +252,51 @@ int8_t UART_Add_Transmit(tUART * UART, uint8_t * Data, uint8_t Data_Size){
         // copy the data over to the node and enqueue the data:
             memcpy(data_To_Add, Data, Data_Size);
             to_Node->Data = data_To_Add;
+            to_Node->Data_Size = Data_Size;
             Enqueue(UART->TX_Queue, to_Node);
+            // start it now if the line is idle instead of waiting for the next task poll (keeps echo fast)
+            UART_Task(UART);
             return Data_Size;
         }
     }
     // or else, free the node and pointer (if malloc for data wasn't successful)
     free(to_Node);
-    printf("func UART_Add_Trasmit: malloc error.\r\n");
+    LOG_ERROR(UART, "UART_Add_Transmit: malloc error.\r\n");
     // return fail
     return -1;
 }
 
 /**
- * @brief: Recieves UART Data to the uint8_t data pointer from the Rx Buffer. If UART is not enabled, does not
- * do any recieving and returns false. If UART is busy, requeues the data entry and 
- * tries to recieve it again to the data buffer. Returns false anyways, but requeues 
- * so that the data is not lost. // needs updating - removed some functionality to make simpler
+ * @brief: Recieves UART Data to the uint8_t data pointer from the Rx Buffer. RX runs as a continuous
+ * circular DMA reception, so this copies everything the DMA wrote since the last call (RX_Stream,
+ * see DMA/DMA_Stream.h) and never waits. At most UINT8_MAX bytes are copied per call; call again
+ * while it returns a full buffer to drain the rest. Bytes overwritten before they were read are
+ * counted in RX_Stream.Overruns. After a UART error the RX DMA is left stopped and restarted here,
+ * by the reader, so RX_Stream is never reset under a read in progress.
  * 
  * Because of this, ALL UART Buffer DATA should be a STATIC or MALLOC STORAGE, not
  * temporary storage.
  * 
  * @params: tUART * UART Handle
- * @params: uint8t * Data buffer to store received data
+ * @params: uint8t * Data buffer to store received data, at least UINT8_MAX bytes
  * @params: uint8t * Ptr to buffer to hold the size of data received.
  * 
  * @return: size of data received. This should be matched to the size of the data
  * that should have been sent for sensitive applications such as GPS data, etc.
  */
 int8_t UART_Receive(tUART * UART, uint8_t * Data, uint8_t * Data_Size){
- // if busy
     *Data_Size = 0;
 
-    if (!UART->UART_Enabled){
+    if (!UART->UART_Enabled || !UART->Use_DMA){
         return 0;
     }
 
-    if (UART->UART_Handle->RxState == HAL_UART_STATE_BUSY_RX){
-        // do not need to worry about Data and Data_Size being dangling pointers because they are STATIC buffers
-        return 0;
-    } else {
-        while (UART->RX_Buff_Tail_Idx != (UART_RX_BUFF_SIZE - UART->UART_Handle->hdmarx->Instance->CNDTR)){
-            Data[*Data_Size++] = UART->RX_Buffer[UART->RX_Buff_Tail_Idx++];
-            if (UART->RX_Buff_Tail_Idx >= UART_RX_BUFF_SIZE){
-                UART->RX_Buff_Tail_Idx = 0;
-            }
-        }
+    if (UART->RX_Restart){
+        // cleared first: an error while restarting sets it again and the next call restarts once more
+        UART->RX_Restart = false;
+        UART_Start_RX(UART);
     }
+    *Data_Size = (uint8_t)DMA_Stream_Read(&UART->RX_Stream, Data, UINT8_MAX);
     return *Data_Size;
 }
 
@@ -295,12 +314,11 @@ void Modify_UART_Baudrate(tUART * UART, int32_t New_Baudrate){
 
 	// Stop the receiver DMA -> does DMA stop clear the RX Buffer?
 	HAL_UART_DMAStop(UART->UART_Handle);
-	UART->RX_Buff_Tail_Idx = 0;
 
     UART->UART_Handle->Init.BaudRate = New_Baudrate;
     HAL_UART_Init(UART->UART_Handle);
 
-    HAL_UART_Receive_DMA(UART->UART_Handle, UART->RX_Buffer, UART_RX_BUFF_SIZE);
+    UART_Start_RX(UART);
 }
 
 void UART_Flush_TX(tUART * uart)
@@ -315,18 +333,138 @@ void UART_Flush_TX(tUART * uart)
 	}
 }
 
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+/**
+ * @brief: Registers a function called whenever new RX bytes are available (line idle, half buffer
+ * or full buffer) and after a UART error. It runs on the DEFER thread (a little later, from
+ * UART_Task, if the defer ring was full), so keep it short - set an event flag or semaphore and read
+ * the bytes with UART_Receive from a thread.
+ *
+ * @params: UART, RX_Notify function (NULL to remove), RX_Notify_Params passed to it
+ *
+ * @return: None
+ */
+void UART_Set_RX_Notify(tUART * UART, void (*RX_Notify)(void *), void * RX_Notify_Params)
+{
+	UART->RX_Notify_Params = RX_Notify_Params;
+	UART->RX_Notify = RX_Notify;
+}
+
+/**
+ * @brief: Starts the continuous RX reception into RX_Buffer. The RX DMA channel is circular so the
+ * reception never completes; idle-line detection raises HAL_UARTEx_RxEventCallback as soon as a
+ * burst of bytes ends, so readers do not have to poll. RX_Stream restarts at the buffer start.
+ */
+static void UART_Start_RX(tUART * UART)
+{
+	DMA_Stream_Init(&UART->RX_Stream, UART->RX_Buffer, UART_RX_BUFF_SIZE, 1,
+	                &UART->UART_Handle->hdmarx->Instance->CNDTR);
+	HAL_UARTEx_ReceiveToIdle_DMA(UART->UART_Handle, UART->RX_Buffer, UART_RX_BUFF_SIZE);
+}
+
+/* Called from the DEFER thread, or from the ISR when a post fails - constant time and lock-free */
+static tUART * UART_Find_Handle(UART_HandleTypeDef * huart)
+{
+	return (tUART *)Registry_Find(huart->Instance, eRegistry_UART);
+}
+
+/*
+ * HAL callbacks only post to the DEFER thread (see Defer/defer.h); the handle lookup and the DMA
+ * stop run there. If the defer ring is full the ISR latches the work in Pending and UART_Task posts
+ * it again on its next poll, so no event is lost and none of it runs in the ISR.
+ */
+
+/* ISR: a post failed, leave the work for UART_Task */
+static void UART_Latch(UART_HandleTypeDef * huart, uint8_t Pending)
 {
-	// Find who the callback is for
-	int c = 0;
-	for(; c < UART_Callback_Handles->Size; c++)
+	tUART * uart = UART_Find_Handle(huart);
+	if (uart != NULL)
 	{
-		tUART * uart = (tUART *)Queue_Peek(&UART_Callback_Handles, c);
+		// the UART and its DMA channels interrupt at different priorities
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		uart->Pending |= Pending;
+		__set_PRIMASK(primask);
+	}
+}
 
-		if(uart->UART_Handle == huart)
+/* Task poll: posts latched work again, what still finds the ring full stays latched */
+static void UART_Post_Pending(tUART * UART)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint8_t pending = UART->Pending;
+	UART->Pending = 0;
+	__set_PRIMASK(primask);
+
+	if (pending == 0)
+	{
+		return;
+	}
+	if ((pending & UART_PENDING_ERROR) && Defer_Post(UART_Error_Work, UART->UART_Handle, 0))
+	{
+		pending &= (uint8_t)~UART_PENDING_ERROR;
+	}
+	if ((pending & UART_PENDING_RX_EVENT) && Defer_Post(UART_RX_Event_Work, UART->UART_Handle, 0))
+	{
+		pending &= (uint8_t)~UART_PENDING_RX_EVENT;
+	}
+	if (pending != 0)
+	{
+		UART_Latch(UART->UART_Handle, pending);
+	}
+}
+
+/* DEFER thread: TX DMA finished - free the line and start the next queued transmit right away */
+static void UART_TX_Done_Work(void * Arg, uint32_t Data)
+{
+	UNUSED(Data);
+	tUART * uart = UART_Find_Handle((UART_HandleTypeDef *)Arg);
+	if (uart != NULL)
+	{
+		uart->Currently_Transmitting = false;
+		UART_Task(uart);
+	}
+}
+
+/* DEFER thread: idle line or half/full buffer on RX */
+static void UART_RX_Event_Work(void * Arg, uint32_t Data)
+{
+	UNUSED(Data); // readers go through RX_Stream, Size is the same position
+	tUART * uart = UART_Find_Handle((UART_HandleTypeDef *)Arg);
+	if (uart != NULL && uart->RX_Notify != NULL)
+	{
+		uart->RX_Notify(uart->RX_Notify_Params);
+	}
+}
+
+/* DEFER thread: abort both DMA directions. Continuous RX is restarted by the reader (UART_Receive),
+ * which owns RX_Stream: resetting it here could pull Head and Tail out from under a read. */
+static void UART_Error_Work(void * Arg, uint32_t Data)
+{
+	UNUSED(Data);
+	tUART * uart = UART_Find_Handle((UART_HandleTypeDef *)Arg);
+	if (uart != NULL)
+	{
+		uart->Currently_Transmitting = false;
+		HAL_DMA_Abort_IT(uart->UART_Handle->hdmarx);
+		HAL_UART_DMAStop(uart->UART_Handle);
+		uart->RX_Restart = true;
+		if (uart->RX_Notify != NULL)
+		{
+			uart->RX_Notify(uart->RX_Notify_Params);
+		}
+	}
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if (!Defer_Post(UART_TX_Done_Work, huart, 0))
+	{
+		// only clear the flag here - starting the next transmit is left to the UART task poll
+		tUART * uart = UART_Find_Handle(huart);
+		if (uart != NULL)
 		{
 			uart->Currently_Transmitting = false;
-			return;
 		}
 	}
 }
@@ -336,21 +474,27 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 	UNUSED(huart);
 }
 
-void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 {
-	// Find who the callback is for
-	int c = 0;
-	for(; c < UART_Callback_Handles->Size; c++)
+	// a full buffer event is the DMA wrapping - count the lap here, not deferred, so RX_Stream stays exact
+	if (Size == UART_RX_BUFF_SIZE)
 	{
-		tUART * uart = (tUART *)Queue_Peek(&UART_Callback_Handles, c);
-
-		if(uart->UART_Handle == huart)
+		tUART * uart = UART_Find_Handle(huart);
+		if (uart != NULL)
 		{
-			uart->RX_Buff_Tail_Idx = 0;
-			uart->Currently_Transmitting = false;
-			HAL_DMA_Abort_IT(uart->UART_Handle->hdmarx);
-			HAL_UART_DMAStop(uart->UART_Handle);
-			HAL_UART_Receive_DMA(uart->UART_Handle, uart->RX_Buffer, UART_RX_BUFF_SIZE);
+			DMA_Stream_Full_Complete(&uart->RX_Stream);
 		}
 	}
+	if (!Defer_Post(UART_RX_Event_Work, huart, Size))
+	{
+		UART_Latch(huart, UART_PENDING_RX_EVENT);
+	}
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	if (!Defer_Post(UART_Error_Work, huart, 0))
+	{
+		UART_Latch(huart, UART_PENDING_ERROR);
+	}
 }
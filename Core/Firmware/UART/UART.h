@@ -10,6 +10,7 @@
 
 #include "../../Inc/main.h"
 #include "../../Middlewares/Queue/queue.h"
+#include "../DMA/DMA_Stream.h"
 #include "../../Middlewares/Console/console.h"
 
 
@@ -20,9 +21,13 @@ extern "C" {
 #endif
 
 // Default size in bytes for the received buffer.
-#define UART_RX_BUFF_SIZE		512 //why 512? 
+#define UART_RX_BUFF_SIZE		512 // power of two, RX_Stream wraps it with a mask
 #define MAX_TX_BUFF_SIZE        2048
 
+// tUART.Pending: HAL callback work the defer ring had no room for, UART_Task posts it again
+#define UART_PENDING_RX_EVENT   0x01
+#define UART_PENDING_ERROR      0x02
+
 typedef struct {
     uint8_t * Data; // data array in ascii
     uint8_t Data_Size; //need to fix; Data size should be fixed.
@@ -32,9 +37,12 @@ typedef struct {
     UART_HandleTypeDef * UART_Handle;
     bool Use_DMA;
     bool UART_Enabled;
-    uint8_t * RX_Buffer[UART_RX_BUFF_SIZE];
-    uint8_t RX_Buff_Tail_Idx;
-    uint8_t RX_Buff_Head_Idx;
+    uint8_t RX_Buffer[UART_RX_BUFF_SIZE];
+    tDMA_Stream RX_Stream;          // read cursor over RX_Buffer, follows the circular RX DMA
+    void (*RX_Notify)(void *);      // called on the DEFER thread when new RX bytes land in RX_Buffer
+    void * RX_Notify_Params;
+    volatile uint8_t Pending;       // UART_PENDING_xxx
+    volatile bool RX_Restart;       // RX stopped after an error, the reader restarts it and RX_Stream
     Queue * TX_Queue;
     TX_Node * TX_Buffer;
     volatile bool Currently_Transmitting;
@@ -49,9 +57,9 @@ typedef struct {
 } SUDO_UART;
 
 
-void Init_UART_CallBack_Queue(void);
 tUART * Init_DMA_UART(UART_HandleTypeDef * UART_Handle);
-tUART * Init_SUDO_UART(void * (*Transmit_Func_Ptr)(uint8_t*, uint8_t), void * (*Recieve_Func_Ptr)(uint8_t*, uint8_t));
+tUART * Init_SUDO_UART(void * (*Transmit_Func_Ptr)(tUART *, uint8_t *, uint16_t),
+                       void * (*Recieve_Func_Ptr)(tUART *, uint8_t *, uint16_t *));
 void Enable_UART(tUART * UART);
 void Disable_UART(tUART * UART);
 int8_t UART_Add_Transmit(tUART * UART, uint8_t * Data, uint8_t Data_Size);
@@ -59,9 +67,11 @@ int8_t UART_Receive(tUART * UART, uint8_t * Data, uint8_t * Data_Size);
 int8_t UART_SUDO_Recieve(tUART * UART, uint8_t * Data, uint8_t Data_Size);
 void Modify_UART_Baudrate(tUART * UART, int32_t New_Baudrate);
 void UART_Flush_TX(tUART * UART);
+void UART_Set_RX_Notify(tUART * UART, void (*RX_Notify)(void *), void * RX_Notify_Params);
 
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
 
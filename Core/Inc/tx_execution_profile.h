@@ -0,0 +1,28 @@
+/*
+ * tx_execution_profile.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef TX_EXECUTION_PROFILE_H
+#define TX_EXECUTION_PROFILE_H
+
+/**
+ * Pulled in by tx_api.h when TX_EXECUTION_PROFILE_ENABLE is defined (set for both the compiler and
+ * the assembler in the project settings - the port's PendSV and context save code call the hooks).
+ * Times are DWT cycle counts. The hooks are implemented in Core/Middlewares/Profile/profile.c.
+ */
+
+/* Accumulated time, wide enough not to wrap */
+typedef unsigned long long              EXECUTION_TIME;
+/* Raw DWT->CYCCNT sample */
+typedef ULONG                           EXECUTION_TIME_SOURCE_TYPE;
+
+VOID _tx_execution_initialize(VOID);
+VOID _tx_execution_thread_enter(VOID);
+VOID _tx_execution_thread_exit(VOID);
+VOID _tx_execution_isr_enter(VOID);
+VOID _tx_execution_isr_exit(VOID);
+
+#endif /* TX_EXECUTION_PROFILE_H */
@@ -0,0 +1,36 @@
+/*
+ * crc.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef CRC_CRC_H_
+#define CRC_CRC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Table driven CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, no reflection, no final xor) for
+ * framed formats on the device (binary console) so host tools only need one checksum. CRC16_Compute("123456789") == 0x29B1.
+ *   crc = CRC16_Compute(buf, len);                      one shot
+ *   crc = CRC16_Update(CRC16_INIT, hdr, hdr_len);       in pieces
+ *   crc = CRC16_Update(crc, payload, payload_len);
+ */
+
+/* Initial value for CRC16_Update */
+#define CRC16_INIT                      0xFFFF
+
+uint16_t CRC16_Update(uint16_t Crc, const uint8_t * Data, uint32_t Length);
+uint16_t CRC16_Compute(const uint8_t * Data, uint32_t Length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC_CRC_H_ */
@@ -0,0 +1,474 @@
+/*
+ * Console_Binary.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "Console_Binary.h"
+#include "Thread_Console.h"
+#include "../CRC/crc.h"
+#include "../Log/log.h"
+
+/* Request header after SOF: cmd u16, seq u16, len u16 */
+#define BINARY_HEADER_SIZE              6
+/* Response framing before the payload: SOF, cmd, seq, status, len */
+#define BINARY_RESPONSE_HEADER          (1 + 2 + 2 + 1 + 2)
+/* ... and the crc after it */
+#define BINARY_RESPONSE_OVERHEAD        (BINARY_RESPONSE_HEADER + 2)
+
+typedef enum {
+    eBinary_Wait_SOF = 0,
+    eBinary_Header,
+    eBinary_Payload,
+    eBinary_CRC,
+} eBinary_Parse_State;
+
+/* One request waiting for its response. The command's output is captured straight into the payload
+ * of the response frame. */
+typedef struct {
+    bool In_Use;
+    uint16_t Cmd;
+    uint16_t Seq;
+    uint16_t Length;
+    bool Truncated;
+    uint8_t Frame[CONSOLE_BINARY_MAX_PAYLOAD + BINARY_RESPONSE_OVERHEAD];
+} tBinary_Request;
+
+/* Only the console RX thread feeds the parser and dispatches, so no locking is needed for the parser.
+ * binary_active is read by other threads through Console_Binary_Output. */
+static volatile bool binary_active = false;
+static uint8_t magic_match = 0;
+
+static eBinary_Parse_State parse_state = eBinary_Wait_SOF;
+static uint8_t frame[BINARY_HEADER_SIZE + CONSOLE_BINARY_MAX_PAYLOAD + 2];
+static uint16_t frame_idx = 0;
+static uint16_t payload_len = 0;
+static ULONG last_byte_tick = 0;
+/* Last byte received or response sent, for the idle timeout */
+static volatile ULONG last_activity_tick = 0;
+
+/* Built-in requests and errors, answered by the RX thread before the next byte */
+static TX_THREAD * volatile builtin_owner = NULL;
+static tBinary_Request builtin;
+/* Commands running on the worker pool, answered by the worker when they finish. In_Use is taken and
+ * given back under console_mutex. */
+static tBinary_Request requests[CONSOLE_BINARY_MAX_PENDING];
+
+static void Binary_Dispatch(uint16_t Cmd, uint16_t Seq, const uint8_t * Payload, uint16_t Length);
+static void Binary_Run_Command(uint16_t Cmd, uint16_t Seq, const uint8_t * Payload, uint16_t Length);
+static void Binary_Job_Done(void * Param, bool Ran);
+static void Binary_Capture(tBinary_Request * Request, const uint8_t * Data, uint16_t Length);
+static void Binary_Send_Response(tBinary_Request * Request, uint8_t Status);
+static void Binary_Answer(uint16_t Cmd, uint16_t Seq, uint8_t Status);
+static bool Binary_Decode_Args(const uint8_t * Payload, uint16_t Length, char * Args, size_t Args_Size);
+static void Binary_Leave(void);
+
+static inline uint16_t Binary_Get_U16(const uint8_t * p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static inline void Binary_Put_U16(uint8_t * p, uint16_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+/**
+ * @brief: Watches the text RX stream for CONSOLE_BINARY_MAGIC and switches to binary mode when it
+ * completes. Bytes that are part of the sequence are consumed so they are never echoed.
+ *
+ * @params: Byte received in text mode
+ *
+ * @return: true if the byte was consumed
+ */
+bool Console_Binary_Match_Magic(uint8_t Byte)
+{
+    static const uint8_t magic[CONSOLE_BINARY_MAGIC_LEN] = CONSOLE_BINARY_MAGIC;
+
+    if (Byte != magic[magic_match]) {
+        /* a partial match is dropped; restart in case this byte begins a new sequence,
+         * otherwise it is ordinary text */
+        magic_match = (Byte == magic[0]) ? 1 : 0;
+        return magic_match != 0;
+    }
+    if (++magic_match < CONSOLE_BINARY_MAGIC_LEN) {
+        return true;
+    }
+
+    magic_match = 0;
+    parse_state = eBinary_Wait_SOF;
+    frame_idx = 0;
+    last_activity_tick = tx_time_get();
+    binary_active = true;
+    LOG_DEBUG(CONSOLE, "binary mode\r\n");
+    /* Unsolicited PING with seq 0 tells the rig the link is framed now */
+    Binary_Answer(CONSOLE_BINARY_CMD_PING, 0, eConsole_Binary_OK);
+    return true;
+}
+
+bool Console_Binary_Active(void)
+{
+    return binary_active;
+}
+
+/**
+ * @brief: Idle check, called by the console RX thread before it waits for input. Binary mode ends
+ * once nothing was received or answered for CONSOLE_BINARY_IDLE_TIMEOUT_MS and no request is
+ * running, so a rig that went away does not leave the console deaf to text.
+ *
+ * @return: ticks until the next check is due, TX_WAIT_FOREVER in text mode
+ */
+uint32_t Console_Binary_Poll(void)
+{
+    ULONG idle_ticks = (CONSOLE_BINARY_IDLE_TIMEOUT_MS * TX_TIMER_TICKS_PER_SECOND) / 1000;
+    bool pending = false;
+
+    if (!binary_active) {
+        return TX_WAIT_FOREVER;
+    }
+    if (tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT) == TX_SUCCESS) {
+        for (int i = 0; i < CONSOLE_BINARY_MAX_PENDING; i++) {
+            pending |= requests[i].In_Use;
+        }
+        tx_mutex_put(&console_mutex);
+    }
+
+    ULONG idle = tx_time_get() - last_activity_tick;
+    if (idle < idle_ticks) {
+        return idle_ticks - idle;
+    }
+    if (pending) {
+        return idle_ticks;
+    }
+    Binary_Leave();
+    return TX_WAIT_FOREVER;
+}
+
+static void Binary_Leave(void)
+{
+    binary_active = false;
+    parse_state = eBinary_Wait_SOF;
+    LOG_DEBUG(CONSOLE, "text mode\r\n");
+}
+
+/**
+ * @brief: Request frame parser, one byte at a time. Runs in the console RX thread and dispatches
+ * each complete frame before returning, so pipelined requests start in order.
+ *
+ * @params: Byte received in binary mode
+ *
+ * @return: None
+ */
+void Console_Binary_Feed(uint8_t Byte)
+{
+    ULONG now = tx_time_get();
+    ULONG timeout_ticks = (CONSOLE_BINARY_FRAME_TIMEOUT_MS * TX_TIMER_TICKS_PER_SECOND) / 1000;
+
+    /* A stalled partial frame is garbage - resync on the next SOF */
+    if (parse_state != eBinary_Wait_SOF && (now - last_byte_tick) > timeout_ticks) {
+        parse_state = eBinary_Wait_SOF;
+    }
+    last_byte_tick = now;
+    last_activity_tick = now;
+
+    switch (parse_state) {
+        case eBinary_Wait_SOF:
+            if (Byte == CONSOLE_BINARY_REQUEST_SOF) {
+                frame_idx = 0;
+                parse_state = eBinary_Header;
+            }
+            break;
+
+        case eBinary_Header:
+            frame[frame_idx++] = Byte;
+            if (frame_idx == BINARY_HEADER_SIZE) {
+                payload_len = Binary_Get_U16(&frame[4]);
+                if (payload_len > CONSOLE_BINARY_MAX_PAYLOAD) {
+                    Binary_Answer(Binary_Get_U16(&frame[0]), Binary_Get_U16(&frame[2]), eConsole_Binary_Bad_Payload);
+                    parse_state = eBinary_Wait_SOF;
+                } else {
+                    parse_state = (payload_len > 0) ? eBinary_Payload : eBinary_CRC;
+                }
+            }
+            break;
+
+        case eBinary_Payload:
+            frame[frame_idx++] = Byte;
+            if (frame_idx == BINARY_HEADER_SIZE + payload_len) {
+                parse_state = eBinary_CRC;
+            }
+            break;
+
+        case eBinary_CRC:
+            frame[frame_idx++] = Byte;
+            if (frame_idx == BINARY_HEADER_SIZE + payload_len + 2) {
+                uint16_t cmd = Binary_Get_U16(&frame[0]);
+                uint16_t seq = Binary_Get_U16(&frame[2]);
+                uint16_t crc = Binary_Get_U16(&frame[BINARY_HEADER_SIZE + payload_len]);
+                parse_state = eBinary_Wait_SOF;
+
+                if (CRC16_Compute(frame, BINARY_HEADER_SIZE + payload_len) != crc) {
+                    Binary_Answer(cmd, seq, eConsole_Binary_Bad_CRC);
+                } else {
+                    Binary_Dispatch(cmd, seq, &frame[BINARY_HEADER_SIZE], payload_len);
+                }
+            }
+            break;
+    }
+}
+
+/**
+ * @brief: Called by Console_Write for every piece of console text. In binary mode text printed while
+ * answering a request - by the RX thread for built-ins, by the worker running the command otherwise -
+ * is captured for its response; anything else is dropped so it cannot corrupt the framed stream.
+ *
+ * @params: Data, Length of text being written to the console
+ *
+ * @return: true if binary mode took the text, false to send it to the UART as usual
+ */
+bool Console_Binary_Output(const char * Data, uint16_t Length)
+{
+    tBinary_Request * request = NULL;
+
+    if (!binary_active) {
+        return false;
+    }
+    if (builtin_owner != NULL && builtin_owner == tx_thread_identify()) {
+        request = &builtin;
+    } else {
+        tConsole_Job * job = Console_Current_Job();
+        if (job != NULL && job->Done == Binary_Job_Done) {
+            request = (tBinary_Request *)job->Done_Param;
+        }
+    }
+    if (request != NULL) {
+        Binary_Capture(request, (const uint8_t *)Data, Length);
+    }
+    return true;
+}
+
+static void Binary_Capture(tBinary_Request * Request, const uint8_t * Data, uint16_t Length)
+{
+    uint16_t room = CONSOLE_BINARY_MAX_PAYLOAD - Request->Length;
+    if (Length > room) {
+        Length = room;
+        Request->Truncated = true;
+    }
+    memcpy(&Request->Frame[BINARY_RESPONSE_HEADER + Request->Length], Data, Length);
+    Request->Length += Length;
+}
+
+static void Binary_Dispatch(uint16_t Cmd, uint16_t Seq, const uint8_t * Payload, uint16_t Length)
+{
+    if (Cmd != CONSOLE_BINARY_CMD_PING && Cmd != CONSOLE_BINARY_CMD_LIST && Cmd != CONSOLE_BINARY_CMD_EXIT) {
+        Binary_Run_Command(Cmd, Seq, Payload, Length);
+        return;
+    }
+
+    builtin.Cmd = Cmd;
+    builtin.Seq = Seq;
+    builtin.Length = 0;
+    builtin.Truncated = false;
+
+    if (Cmd == CONSOLE_BINARY_CMD_PING) {
+        Binary_Capture(&builtin, Payload, Length);
+    }
+    else if (Cmd == CONSOLE_BINARY_CMD_LIST) {
+        uint32_t first = 0;
+        if (Length == 5 && Payload[0] == CONSOLE_BINARY_ARG_UINT32) {
+            first = (uint32_t)Payload[1] | ((uint32_t)Payload[2] << 8) | ((uint32_t)Payload[3] << 16) | ((uint32_t)Payload[4] << 24);
+        }
+        const tConsole_Command * command;
+        builtin_owner = tx_thread_identify();
+        for (uint32_t id = first; id < CONSOLE_BINARY_CMD_PING && (command = Console_Get_Command((uint16_t)id)) != NULL; id++) {
+            printd("%lu %s\n", (unsigned long)id, command->Command_Name);
+            if (builtin.Truncated) {
+                break;
+            }
+        }
+        builtin_owner = NULL;
+    }
+
+    Binary_Send_Response(&builtin, eConsole_Binary_OK | (builtin.Truncated ? CONSOLE_BINARY_STATUS_TRUNCATED : 0));
+
+    if (Cmd == CONSOLE_BINARY_CMD_EXIT) {
+        Binary_Leave();
+    }
+}
+
+/**
+ * @brief: Starts a console command. Stoppable commands are assumed long running and are answered at
+ * once with their job id. Every other command is answered by Binary_Job_Done when its job finishes,
+ * so the RX thread never runs command code and keeps parsing the pipeline.
+ */
+static void Binary_Run_Command(uint16_t Cmd, uint16_t Seq, const uint8_t * Payload, uint16_t Length)
+{
+    char args[MAX_CONSOLE_BUFF_SIZE];
+    uint8_t status = eConsole_Binary_OK;
+    uint8_t job_id = 0;
+    const tConsole_Command * command = Console_Get_Command(Cmd);
+
+    if (command == NULL) {
+        Binary_Answer(Cmd, Seq, eConsole_Binary_Unknown_Command);
+        return;
+    }
+    if (!Binary_Decode_Args(Payload, Length, args, sizeof(args))) {
+        Binary_Answer(Cmd, Seq, eConsole_Binary_Bad_Payload);
+        return;
+    }
+
+    tBinary_Request * request = NULL;
+    if (command->Stop_Function == NULL) {
+        if (tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT) == TX_SUCCESS) {
+            for (int i = 0; i < CONSOLE_BINARY_MAX_PENDING; i++) {
+                if (!requests[i].In_Use) {
+                    request = &requests[i];
+                    request->In_Use = true;
+                    break;
+                }
+            }
+            tx_mutex_put(&console_mutex);
+        }
+        if (request == NULL) {
+            Binary_Answer(Cmd, Seq, eConsole_Binary_Busy);
+            return;
+        }
+        request->Cmd = Cmd;
+        request->Seq = Seq;
+        request->Length = 0;
+        request->Truncated = false;
+    }
+
+    eConsole_Exec_Result result = Console_Execute_Command(command, args, request ? Binary_Job_Done : NULL,
+                                                          request, &job_id);
+    if (result == eConsole_Exec_Job_Queued && request != NULL) {
+        return;                             /* Binary_Job_Done answers */
+    }
+    if (request != NULL) {
+        tx_mutex_get(&console_mutex, TX_WAIT_FOREVER);
+        request->In_Use = false;
+        tx_mutex_put(&console_mutex);
+    }
+
+    switch (result) {
+        case eConsole_Exec_Done:            status = eConsole_Binary_OK; break;
+        case eConsole_Exec_Job_Queued:      status = eConsole_Binary_Job_Queued; break;
+        case eConsole_Exec_Repeat_Started:  status = eConsole_Binary_Repeat_Started; break;
+        case eConsole_Exec_Already_Running: status = eConsole_Binary_Already_Running; break;
+        case eConsole_Exec_No_Job_Slot:     status = eConsole_Binary_Busy; break;
+        case eConsole_Exec_Bad_Args:        status = eConsole_Binary_Bad_Payload; break;
+    }
+    builtin.Cmd = Cmd;
+    builtin.Seq = Seq;
+    builtin.Length = 0;
+    builtin.Truncated = false;
+    if (status == eConsole_Binary_Job_Queued) {
+        Binary_Capture(&builtin, &job_id, 1);
+    }
+    Binary_Send_Response(&builtin, status);
+}
+
+/* Runs on the worker once the command returns; its output is already in the frame */
+static void Binary_Job_Done(void * Param, bool Ran)
+{
+    tBinary_Request * request = (tBinary_Request *)Param;
+
+    if (!Ran) {
+        request->Length = 0;
+        request->Truncated = false;
+    }
+    /* A rig that left binary mode while this ran is back to text, a frame now would be garbage */
+    if (binary_active) {
+        Binary_Send_Response(request, Ran ? (eConsole_Binary_OK | (request->Truncated ? CONSOLE_BINARY_STATUS_TRUNCATED : 0))
+                                          : eConsole_Binary_Stopped);
+    }
+    last_activity_tick = tx_time_get();
+
+    tx_mutex_get(&console_mutex, TX_WAIT_FOREVER);
+    request->In_Use = false;
+    tx_mutex_put(&console_mutex);
+}
+
+/* Response without payload, from the RX thread */
+static void Binary_Answer(uint16_t Cmd, uint16_t Seq, uint8_t Status)
+{
+    builtin.Cmd = Cmd;
+    builtin.Seq = Seq;
+    builtin.Length = 0;
+    builtin.Truncated = false;
+    Binary_Send_Response(&builtin, Status);
+}
+
+/* Frames the payload already captured in Request->Frame and queues it on the UART */
+static void Binary_Send_Response(tBinary_Request * Request, uint8_t Status)
+{
+    uint8_t * response = Request->Frame;
+    uint16_t idx = 0;
+
+    response[idx++] = CONSOLE_BINARY_RESPONSE_SOF;
+    Binary_Put_U16(&response[idx], Request->Cmd);       idx += 2;
+    Binary_Put_U16(&response[idx], Request->Seq);       idx += 2;
+    response[idx++] = Status;
+    Binary_Put_U16(&response[idx], Request->Length);    idx += 2;
+    idx += Request->Length;
+    /* CRC over everything after SOF */
+    Binary_Put_U16(&response[idx], CRC16_Compute(&response[1], idx - 1));
+    idx += 2;
+
+    UART_Add_Transmit(Console_Get_UART(), response, (uint8_t)idx);
+}
+
+/**
+ * @brief: Converts typed arguments to the space separated text the command table expects.
+ *
+ * @return: false on a malformed payload or if the text does not fit Args
+ */
+static bool Binary_Decode_Args(const uint8_t * Payload, uint16_t Length, char * Args, size_t Args_Size)
+{
+    size_t used = 0;
+    uint16_t i = 0;
+
+    Args[0] = '\0';
+    while (i < Length) {
+        uint8_t tag = Payload[i++];
+        int written;
+
+        if (tag == CONSOLE_BINARY_ARG_INT32 || tag == CONSOLE_BINARY_ARG_UINT32) {
+            if (Length - i < 4) {
+                return false;
+            }
+            uint32_t value = (uint32_t)Payload[i] | ((uint32_t)Payload[i + 1] << 8) |
+                             ((uint32_t)Payload[i + 2] << 16) | ((uint32_t)Payload[i + 3] << 24);
+            i += 4;
+            if (tag == CONSOLE_BINARY_ARG_INT32) {
+                written = snprintf(&Args[used], Args_Size - used, " %ld", (long)(int32_t)value);
+            } else {
+                written = snprintf(&Args[used], Args_Size - used, " %lu", (unsigned long)value);
+            }
+        }
+        else if (tag == CONSOLE_BINARY_ARG_STRING) {
+            if (i >= Length) {
+                return false;
+            }
+            uint8_t str_len = Payload[i++];
+            if (Length - i < str_len) {
+                return false;
+            }
+            written = snprintf(&Args[used], Args_Size - used, " %.*s", (int)str_len, (const char *)&Payload[i]);
+            i += str_len;
+        }
+        else {
+            return false;
+        }
+
+        if (written < 0 || (size_t)written >= Args_Size - used) {
+            return false;
+        }
+        used += (size_t)written;
+    }
+    return true;
+}
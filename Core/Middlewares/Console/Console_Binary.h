@@ -0,0 +1,99 @@
+/*
+ * Console_Binary.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef CONSOLE_BINARY_H_
+#define CONSOLE_BINARY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Framed request/response mode on the console UART for automated test rigs. No echo, no line
+ * editing, and requests can be pipelined - each response carries the request's sequence number.
+ *
+ * 1) Send CONSOLE_BINARY_MAGIC (4 bytes) while the console is in text mode. The device answers with a
+ *    CONSOLE_BINARY_CMD_PING response (seq 0) once binary mode is active.
+ * 2) Send request frames, all fields little endian:
+ *      0xA5 | cmd u16 | seq u16 | len u16 | payload[len] | crc u16
+ *    crc is CRC16_Compute() (CRC-16/CCITT-FALSE, see CRC/crc.h) over cmd..payload.
+ * 3) Each request gets exactly one response:
+ *      0x5A | cmd u16 | seq u16 | status u8 | len u16 | payload[len] | crc u16
+ *    crc covers cmd..payload. The payload is the text the command printed (truncated to
+ *    CONSOLE_BINARY_MAX_PAYLOAD, status has CONSOLE_BINARY_STATUS_TRUNCATED set then), or for
+ *    eConsole_Binary_Job_Queued the job id as one byte.
+ * 4) cmd is a console command id - its index in the table printed by CONSOLE_BINARY_CMD_LIST (static
+ *    CONSOLE_COMMAND entries first, then runtime-added ones). Ids 0xFF00 and up are reserved below.
+ * 5) Request payload is a sequence of typed arguments, converted to the command's text arguments:
+ *      0x01 int32 (4 bytes) | 0x02 uint32 (4 bytes) | 0x03 string (len u8, then len bytes)
+ *    Only commands with an Args_Function accept arguments.
+ * 6) Every command runs on the console worker pool, never in the thread parsing requests. Commands
+ *    with a Stop_Function are assumed long running and are answered at once (status
+ *    eConsole_Binary_Job_Queued); everything else is answered when it finishes, with its output. Up
+ *    to CONSOLE_BINARY_MAX_PENDING of those run at once, more get eConsole_Binary_Busy. Workers run
+ *    side by side, so responses can come back out of order - match them by seq. Output from other
+ *    threads (logs, repeat commands, other jobs) is dropped while binary mode is active.
+ * 7) CONSOLE_BINARY_CMD_EXIT returns to the text console after its response; requests still running
+ *    then are not answered. So does CONSOLE_BINARY_IDLE_TIMEOUT_MS without a byte received or a
+ *    response sent while nothing is running, in case the rig went away.
+ */
+
+/* Entry sequence, detected by the text RX path. Starts with SYN (Ctrl-V) so it is not typed by accident. */
+#define CONSOLE_BINARY_MAGIC            "\x16" "BIN"
+#define CONSOLE_BINARY_MAGIC_LEN        4
+
+#define CONSOLE_BINARY_REQUEST_SOF      0xA5
+#define CONSOLE_BINARY_RESPONSE_SOF     0x5A
+/* Largest request or response payload. Keeps a whole response frame inside one UART_Add_Transmit. */
+#define CONSOLE_BINARY_MAX_PAYLOAD      240
+/* A frame that stalls longer than this between bytes is dropped and the parser resyncs on SOF */
+#define CONSOLE_BINARY_FRAME_TIMEOUT_MS 50
+/* Binary mode falls back to text after this long idle */
+#define CONSOLE_BINARY_IDLE_TIMEOUT_MS  10000
+/* Requests answered by a worker when they finish, waiting at once */
+#define CONSOLE_BINARY_MAX_PENDING      2
+
+/* Reserved command ids */
+#define CONSOLE_BINARY_CMD_PING         0xFF00  /* echoes the request payload */
+#define CONSOLE_BINARY_CMD_LIST         0xFF01  /* "<id> <name>" lines, optional uint32 first id */
+#define CONSOLE_BINARY_CMD_EXIT         0xFF02  /* back to the text console */
+
+/* Typed argument tags in request payloads */
+#define CONSOLE_BINARY_ARG_INT32        0x01
+#define CONSOLE_BINARY_ARG_UINT32       0x02
+#define CONSOLE_BINARY_ARG_STRING       0x03
+
+/* OR-ed into the status when the output did not fit the response */
+#define CONSOLE_BINARY_STATUS_TRUNCATED 0x80
+
+typedef enum {
+    eConsole_Binary_OK = 0,
+    eConsole_Binary_Job_Queued,
+    eConsole_Binary_Repeat_Started,
+    eConsole_Binary_Unknown_Command,
+    eConsole_Binary_Bad_Payload,
+    eConsole_Binary_Bad_CRC,
+    eConsole_Binary_Busy,               /* no free job slot */
+    eConsole_Binary_Already_Running,
+    eConsole_Binary_Stopped,            /* job stopped before it started */
+} eConsole_Binary_Status;
+
+bool Console_Binary_Match_Magic(uint8_t Byte);
+bool Console_Binary_Active(void);
+uint32_t Console_Binary_Poll(void);
+void Console_Binary_Feed(uint8_t Byte);
+bool Console_Binary_Output(const char * Data, uint16_t Length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONSOLE_BINARY_H_ */
@@ -0,0 +1,421 @@
+/*
+ * Console_Sink.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "Console_Sink.h"
+#include "Thread_Console.h"
+
+/* sink_events flags */
+#define CONSOLE_SINK_WRITE_FLAG         0x01
+
+static tConsole_Sink sinks[CONSOLE_MAX_SINKS];
+static uint8_t sink_count = 0;
+
+_Static_assert(CONSOLE_SINK_CHUNK_SIZE < UINT8_MAX, "sink chunks must fit one UART_Add_Transmit");
+
+static uint8_t uart_queues[CONSOLE_MAX_SINKS][CONSOLE_SINK_QUEUE_SIZE];
+static uint8_t uart_queue_count = 0;
+static uint8_t ram_log[CONSOLE_SINK_RAM_LOG_SIZE];
+
+static TX_EVENT_FLAGS_GROUP sink_events;
+static TX_THREAD sink_thread;
+static UCHAR sink_thread_stack[CONSOLE_SINK_THREAD_STACK_SIZE];
+static volatile bool sink_thread_ready = false;
+
+static VOID Console_Sink_Thread_Entry(ULONG thread_input);
+static bool Console_Sink_Drain_One(tConsole_Sink * Sink);
+static uint16_t Console_Sink_UART_Drain(tConsole_Sink * Sink, const uint8_t * Data, uint16_t Length);
+static void Console_Sink_Command(const char * args);
+
+CONSOLE_COMMAND("sinks", "Console outputs: sinks | sinks <on|off> <name> | sinks dump", NULL,
+                .Args_Function = Console_Sink_Command);
+
+/**
+ * @brief: Creates the CONSOLE_SINK thread that drains sink rings into their backends. Writes made
+ * before this only fill the rings and go out once the thread starts.
+ *
+ * @params: None
+ *
+ * @return: false if the thread or its event flags could not be created
+ */
+bool Console_Sink_Init(void)
+{
+    if (sink_thread_ready) {
+        return true;
+    }
+    if (tx_event_flags_create(&sink_events, "CONSOLE_SINK_EVENTS") != TX_SUCCESS) {
+        return false;
+    }
+    if (tx_thread_create(&sink_thread, "CONSOLE_SINK", Console_Sink_Thread_Entry, 0, sink_thread_stack,
+                         CONSOLE_SINK_THREAD_STACK_SIZE, CONSOLE_SINK_THREAD_PRIORITY, CONSOLE_SINK_THREAD_PRIORITY,
+                         TX_NO_TIME_SLICE, TX_AUTO_START) != TX_SUCCESS) {
+        tx_event_flags_delete(&sink_events);
+        return false;
+    }
+    sink_thread_ready = true;
+    return true;
+}
+
+/**
+ * @brief: Stops the CONSOLE_SINK thread and removes every sink, undoing Console_Sink_Init and the
+ * adds. Writes after this go nowhere until sinks are added again.
+ *
+ * @params: None
+ *
+ * @return: None
+ */
+void Console_Sink_Deinit(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    /* a writer already walking the table finishes on the static rings, which stay valid */
+    sink_count = 0;
+    uart_queue_count = 0;
+    __set_PRIMASK(primask);
+
+    if (sink_thread_ready) {
+        sink_thread_ready = false;
+        tx_thread_terminate(&sink_thread);
+        tx_thread_delete(&sink_thread);
+        tx_event_flags_delete(&sink_events);
+    }
+}
+
+/**
+ * @brief: Adds an output sink. Sinks are only removed all at once, by Console_Sink_Deinit - use
+ * Enabled to mute one.
+ *
+ * @params: Name shown by "sinks" (must stay valid), Buffer and Size (power of two) for the sink's ring,
+ * Policy when the ring is full, Drain backend or NULL to only keep the ring, Context for the backend
+ *
+ * @return: the sink, NULL if the table is full or Size is not a power of two
+ */
+tConsole_Sink * Console_Sink_Add(const char * Name, uint8_t * Buffer, uint32_t Size, eConsole_Sink_Policy Policy,
+                                 tConsole_Sink_Drain Drain, void * Context)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    tConsole_Sink * sink = NULL;
+    if (sink_count < CONSOLE_MAX_SINKS && Ring_Init(&sinks[sink_count].Ring, Buffer, Size)) {
+        sink = &sinks[sink_count];
+        sink->Name = Name;
+        sink->Dropped = 0;
+        sink->Policy = Policy;
+        sink->Drain = Drain;
+        sink->Context = Context;
+        sink->Enabled = true;
+        /* publish last - Console_Sink_Write walks sinks[0..sink_count) without the lock */
+        sink_count++;
+    }
+    __set_PRIMASK(primask);
+    return sink;
+}
+
+/**
+ * @brief: Adds a UART (DMA or SUDO) as a sink, with its ring taken from uart_queues.
+ *
+ * @params: Name shown by "sinks", UART from Init_DMA_UART or Init_SUDO_UART, Policy when its ring is full
+ *
+ * @return: the sink, NULL if UART is NULL or no ring is left
+ */
+tConsole_Sink * Console_Sink_Add_UART(const char * Name, tUART * UART, eConsole_Sink_Policy Policy)
+{
+    if (UART == NULL || uart_queue_count >= CONSOLE_MAX_SINKS) {
+        return NULL;
+    }
+    tConsole_Sink * sink = Console_Sink_Add(Name, uart_queues[uart_queue_count], CONSOLE_SINK_QUEUE_SIZE, Policy,
+                                            Console_Sink_UART_Drain, UART);
+    if (sink != NULL) {
+        uart_queue_count++;
+    }
+    return sink;
+}
+
+/**
+ * @brief: Adds the RAM log - a drop-oldest ring of the most recent output with no backend.
+ *
+ * @params: None
+ *
+ * @return: the sink, NULL if the table is full
+ */
+tConsole_Sink * Console_Sink_Add_RAM_Log(void)
+{
+    return Console_Sink_Add("ram", ram_log, sizeof(ram_log), eConsole_Sink_Drop_Oldest, NULL, NULL);
+}
+
+tConsole_Sink * Console_Sink_Find(const char * Name)
+{
+    for (uint8_t i = 0; i < sink_count; i++) {
+        if (strcmp(sinks[i].Name, Name) == 0) {
+            return &sinks[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief: Copies Data into every enabled sink's ring, applying each sink's drop policy, and wakes the
+ * CONSOLE_SINK thread. Never blocks. Interrupts are off for at most CONSOLE_SINK_LOCKED_COPY bytes
+ * of copying at a time; writes up to that size land in a ring as one piece, so concurrent writers do
+ * not interleave inside a line.
+ *
+ * @params: Data to send, Length in bytes
+ *
+ * @return: None
+ */
+void Console_Sink_Write(const uint8_t * Data, uint16_t Length)
+{
+    bool wake = false;
+
+    if (Length == 0) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < sink_count; i++) {
+        tConsole_Sink * sink = &sinks[i];
+        if (!sink->Enabled) {
+            continue;
+        }
+
+        tRing * ring = &sink->Ring;
+        const uint8_t * src = Data;
+        uint32_t len = Length;
+        uint32_t skipped = 0;
+        bool first = true;
+
+        /* Drop oldest: only the last Size bytes of this write can survive */
+        if (sink->Policy == eConsole_Sink_Drop_Oldest && len > ring->Size) {
+            skipped = len - ring->Size;
+            src += skipped;
+            len = ring->Size;
+        }
+
+        while (len > 0) {
+            uint32_t piece = (len > CONSOLE_SINK_LOCKED_COPY) ? CONSOLE_SINK_LOCKED_COPY : len;
+            /* several producers, and drop-oldest moves the tail too - so not the lock-free SPSC path */
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+
+            uint32_t space = Ring_Free(ring);
+            sink->Dropped += skipped;
+            skipped = 0;
+            if (sink->Policy == eConsole_Sink_Drop_Newest) {
+                /* the whole write has to fit up front; a later piece only misses room to a writer in between */
+                if ((first ? len : piece) > space) {
+                    sink->Dropped += len;
+                    __set_PRIMASK(primask);
+                    break;
+                }
+            } else if (piece > space) {
+                ring->Tail += piece - space;
+                sink->Dropped += piece - space;
+            }
+
+            Ring_Copy_In(ring, ring->Head, src, piece);
+            ring->Head += piece;
+
+            __set_PRIMASK(primask);
+            src += piece;
+            len -= piece;
+            first = false;
+            wake |= (sink->Drain != NULL);
+        }
+    }
+
+    if (wake && sink_thread_ready) {
+        tx_event_flags_set(&sink_events, CONSOLE_SINK_WRITE_FLAG, TX_OR);
+    }
+}
+
+/**
+ * @brief: For bulk output (dumps): waits until every enabled drop-newest sink with a backend has room
+ * for Length more bytes, so a long dump is paced by the slowest sink instead of being dropped.
+ * Thread context only.
+ *
+ * @params: Length about to be written, Timeout_Ticks to wait at most
+ *
+ * @return: false if a sink still had no room after Timeout_Ticks
+ */
+bool Console_Sink_Wait_Space(uint16_t Length, ULONG Timeout_Ticks)
+{
+    ULONG start = tx_time_get();
+
+    for (uint8_t i = 0; i < sink_count; i++) {
+        tConsole_Sink * sink = &sinks[i];
+        if (!sink->Enabled || sink->Drain == NULL || sink->Policy != eConsole_Sink_Drop_Newest) {
+            continue;
+        }
+        while (Ring_Free(&sink->Ring) < Length) {
+            if (tx_time_get() - start >= Timeout_Ticks) {
+                return false;
+            }
+            tx_thread_sleep(1);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief: Copies queued bytes out of a sink's ring without consuming them. Position is a free running
+ * ring position - start it at Sink->Ring.Tail. If older bytes were overwritten meanwhile, Position skips
+ * forward to the oldest byte still held.
+ *
+ * @params: Sink to read, Position to read from (updated), Data buffer, Length of Data
+ *
+ * @return: bytes copied, 0 once Position reaches the newest byte
+ */
+uint32_t Console_Sink_Read(tConsole_Sink * Sink, uint32_t * Position, uint8_t * Data, uint32_t Length)
+{
+    while (true) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint32_t tail = Sink->Ring.Tail;
+        uint32_t head = Sink->Ring.Head;
+        __set_PRIMASK(primask);
+
+        if ((int32_t)(tail - *Position) > 0) {
+            *Position = tail;
+        }
+        uint32_t count = head - *Position;
+        if (count == 0) {
+            return 0;
+        }
+        if (count > Length) {
+            count = Length;
+        }
+
+        Ring_Copy_Out(&Sink->Ring, *Position, Data, count);
+
+        /* a drop-oldest writer may have reused the bytes while they were copied - retry from the new tail */
+        if ((int32_t)(Sink->Ring.Tail - *Position) > 0) {
+            continue;
+        }
+        *Position += count;
+        return count;
+    }
+}
+
+/**
+ * @brief: CONSOLE_SINK thread. Drains every sink with a backend, then sleeps until the next write, or
+ * polls every CONSOLE_SINK_RETRY_TICKS while a backend is still full.
+ */
+static VOID Console_Sink_Thread_Entry(ULONG thread_input)
+{
+    (void)thread_input;
+    ULONG actual_flags;
+
+    while (1) {
+        bool backlog = false;
+        for (uint8_t i = 0; i < sink_count; i++) {
+            if (sinks[i].Drain != NULL) {
+                backlog |= Console_Sink_Drain_One(&sinks[i]);
+            }
+        }
+        tx_event_flags_get(&sink_events, CONSOLE_SINK_WRITE_FLAG, TX_OR_CLEAR, &actual_flags,
+                           backlog ? CONSOLE_SINK_RETRY_TICKS : TX_WAIT_FOREVER);
+    }
+}
+
+/**
+ * @brief: Hands a sink's queued bytes to its backend chunk by chunk until the ring is empty or the
+ * backend is full.
+ *
+ * @params: Sink to drain
+ *
+ * @return: true if bytes are left because the backend is full
+ */
+static bool Console_Sink_Drain_One(tConsole_Sink * Sink)
+{
+    uint8_t chunk[CONSOLE_SINK_CHUNK_SIZE];
+
+    while (true) {
+        uint32_t position = Sink->Ring.Tail;
+        uint32_t count = Console_Sink_Read(Sink, &position, chunk, sizeof(chunk));
+        if (count == 0) {
+            return false;
+        }
+        uint32_t start = position - count;
+
+        uint16_t taken = Sink->Drain(Sink, chunk, (uint16_t)count);
+        if (taken == 0) {
+            return true;
+        }
+
+        /* consume what was taken, unless drop-oldest already moved the tail past it */
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if ((int32_t)(start + taken - Sink->Ring.Tail) > 0) {
+            Sink->Ring.Tail = start + taken;
+        }
+        __set_PRIMASK(primask);
+    }
+}
+
+/**
+ * @brief: Backend for UART sinks. Keeps the UART's own TX queue short so the ring, with its drop
+ * policy, absorbs bursts instead of the heap.
+ */
+static uint16_t Console_Sink_UART_Drain(tConsole_Sink * Sink, const uint8_t * Data, uint16_t Length)
+{
+    tUART * uart = (tUART *)Sink->Context;
+
+    if (!uart->UART_Enabled || uart->TX_Queue->Size >= CONSOLE_SINK_UART_MAX_QUEUED) {
+        return 0;
+    }
+    /* UART_Add_Transmit reports the size as int8_t, so with chunks below UINT8_MAX only 0 and -1 are failures */
+    int8_t result = UART_Add_Transmit(uart, (uint8_t *)Data, (uint8_t)Length);
+    return (result == 0 || result == -1) ? 0 : Length;
+}
+
+static void Console_Sink_Command(const char * args)
+{
+    char action[8] = "";
+    char name[16] = "";
+    int parsed = (args != NULL) ? sscanf(args, "%7s %15s", action, name) : 0;
+
+    if (parsed <= 0) {
+        printd("%-8s %-4s %-6s %8s %8s\r\n", "name", "on", "policy", "queued", "dropped");
+        for (uint8_t i = 0; i < sink_count; i++) {
+            tConsole_Sink * sink = &sinks[i];
+            printd("%-8s %-4s %-6s %8lu %8lu\r\n", sink->Name, sink->Enabled ? "yes" : "no",
+                   sink->Policy == eConsole_Sink_Drop_Oldest ? "oldest" : "newest",
+                   (unsigned long)Ring_Used(&sink->Ring), (unsigned long)sink->Dropped);
+        }
+        return;
+    }
+
+    if (strcmp(action, "dump") == 0) {
+        tConsole_Sink * sink = Console_Sink_Find(parsed == 2 ? name : "ram");
+        if (sink == NULL) {
+            printd("No such sink\r\n");
+            return;
+        }
+        /* stop at the newest byte at the start, or the dump would keep reading its own output back */
+        uint32_t position = sink->Ring.Tail;
+        uint32_t end = sink->Ring.Head;
+        uint8_t chunk[64];
+        while ((int32_t)(end - position) > 0) {
+            uint32_t count = Console_Sink_Read(sink, &position, chunk,
+                                               (end - position) < sizeof(chunk) ? (end - position) : sizeof(chunk));
+            if (count == 0 || !Console_Sink_Wait_Space((uint16_t)count, CONSOLE_SINK_DUMP_TIMEOUT)) {
+                break;
+            }
+            Console_Write((const char *)chunk, (uint16_t)count);
+        }
+        printd("\r\n");
+        return;
+    }
+
+    tConsole_Sink * sink = (parsed == 2) ? Console_Sink_Find(name) : NULL;
+    if (sink == NULL || (strcmp(action, "on") != 0 && strcmp(action, "off") != 0)) {
+        printd("usage: sinks [<on|off> <name> | dump [<name>]]\r\n");
+        return;
+    }
+    sink->Enabled = (strcmp(action, "on") == 0);
+    printd("%s %s\r\n", sink->Name, sink->Enabled ? "on" : "off");
+}
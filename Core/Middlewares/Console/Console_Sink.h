@@ -0,0 +1,93 @@
+/*
+ * Console_Sink.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef CONSOLE_SINK_H_
+#define CONSOLE_SINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../Firmware/UART/UART.h"
+#include "../Ring/ring.h"
+#include "threadx_includes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Console output fan-out. printd, the log module, printf and putchar all end up in
+ * Console_Sink_Write, which copies the bytes into every enabled sink's own ring and returns - it never
+ * waits for a backend, so it is safe from any thread (and from interrupts, though output from an ISR
+ * should stay rare and short).
+ * 1) Thread_Console_Init adds the console UART and the RAM log. Other backends are added the same way,
+ *    e.g. a SUDO UART:
+ *      Console_Sink_Add_UART("sudo", Init_SUDO_UART(Tx_Func, Rx_Func), eConsole_Sink_Drop_Newest);
+ * 2) The CONSOLE_SINK thread drains each UART sink's ring into UART_Add_Transmit in chunks of up to
+ *    CONSOLE_SINK_CHUNK_SIZE bytes, keeping at most CONSOLE_SINK_UART_MAX_QUEUED chunks in that
+ *    UART's TX queue. A sink that falls behind fills its own ring and drops by its policy; the other
+ *    sinks and the producers are not affected.
+ *      eConsole_Sink_Drop_Newest - a write that does not fit is dropped whole (lines stay intact)
+ *      eConsole_Sink_Drop_Oldest - the oldest bytes are overwritten (keeps the most recent output)
+ *    Interrupts are only off for CONSOLE_SINK_LOCKED_COPY bytes at a time, so a longer write can have
+ *    another writer's output land in the middle of it.
+ * 3) The RAM log has no backend: it is a drop-oldest ring holding the last CONSOLE_SINK_RAM_LOG_SIZE
+ *    bytes of output, readable from a debugger or with "sinks dump".
+ * 4) Bulk output (dumps) calls Console_Sink_Wait_Space before each piece so it is paced by the
+ *    slowest sink rather than dropped.
+ * 5) Console "sinks" lists every sink with queued and dropped byte counts, "sinks <on|off> <name>"
+ *    enables or mutes one.
+ */
+
+#define CONSOLE_MAX_SINKS               4
+#define CONSOLE_SINK_QUEUE_SIZE         1024    /* ring per UART sink, power of two */
+#define CONSOLE_SINK_RAM_LOG_SIZE       4096    /* power of two */
+#define CONSOLE_SINK_CHUNK_SIZE         128     /* bytes per UART_Add_Transmit */
+#define CONSOLE_SINK_LOCKED_COPY        64      /* bytes copied into a ring per interrupts-off section */
+#define CONSOLE_SINK_UART_MAX_QUEUED    4       /* chunks waiting in a UART TX queue before the ring holds the rest */
+#define CONSOLE_SINK_RETRY_TICKS        2       /* poll interval while a backend is full */
+#define CONSOLE_SINK_DUMP_TIMEOUT       (2 * TX_TIMER_TICKS_PER_SECOND) /* bulk output gives up on a stuck sink */
+#define CONSOLE_SINK_THREAD_PRIORITY    3
+#define CONSOLE_SINK_THREAD_STACK_SIZE  512
+
+typedef enum {
+    eConsole_Sink_Drop_Newest = 0,
+    eConsole_Sink_Drop_Oldest,
+} eConsole_Sink_Policy;
+
+typedef struct tConsole_Sink tConsole_Sink;
+
+/* Hands up to Length bytes to the backend. Returns how many were taken, 0 if it is busy. Called
+ * from the CONSOLE_SINK thread only. */
+typedef uint16_t (*tConsole_Sink_Drain)(tConsole_Sink * Sink, const uint8_t * Data, uint16_t Length);
+
+struct tConsole_Sink {
+    const char * Name;
+    tRing Ring;                         /* Head moved by producers, Tail by the drain and drop-oldest */
+    volatile uint32_t Dropped;          /* bytes lost to the drop policy */
+    eConsole_Sink_Policy Policy;
+    volatile bool Enabled;
+    tConsole_Sink_Drain Drain;          /* NULL for a sink that only keeps the ring */
+    void * Context;
+};
+
+bool Console_Sink_Init(void);
+void Console_Sink_Deinit(void);
+tConsole_Sink * Console_Sink_Add(const char * Name, uint8_t * Buffer, uint32_t Size, eConsole_Sink_Policy Policy,
+                                 tConsole_Sink_Drain Drain, void * Context);
+tConsole_Sink * Console_Sink_Add_UART(const char * Name, tUART * UART, eConsole_Sink_Policy Policy);
+tConsole_Sink * Console_Sink_Add_RAM_Log(void);
+tConsole_Sink * Console_Sink_Find(const char * Name);
+void Console_Sink_Write(const uint8_t * Data, uint16_t Length);
+bool Console_Sink_Wait_Space(uint16_t Length, ULONG Timeout_Ticks);
+uint32_t Console_Sink_Read(tConsole_Sink * Sink, uint32_t * Position, uint8_t * Data, uint32_t Length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONSOLE_SINK_H_ */
@@ -8,6 +8,9 @@
 #include <string.h>
 #include <stdarg.h>
 #include "Thread_Console.h"
+#include "../Log/log.h"
+#include "Console_Binary.h"
+#include "Console_Sink.h"
 
 static tConsole console_data;
 static tConsole * console = &console_data;
@@ -15,15 +18,19 @@ static tConsole * console = &console_data;
 /* ThreadX thread objects and stacks */
 TX_THREAD rx_thread;
 TX_THREAD debug_thread;
-TX_THREAD complete_thread;
+TX_THREAD console_worker_threads[CONSOLE_WORKER_COUNT];
 static UCHAR rx_thread_stack[TX_APP_THREAD_STACK_SIZE];
 static UCHAR debug_thread_stack[TX_SMALL_APP_THREAD_STACK_SIZE];
-static UCHAR complete_thread_stack[TX_SMALL_APP_THREAD_STACK_SIZE];
+static UCHAR console_worker_stacks[CONSOLE_WORKER_COUNT][CONSOLE_WORKER_STACK_SIZE];
 
 /* ThreadX synchronization objects */
 TX_MUTEX console_mutex;
 TX_EVENT_FLAGS_GROUP console_events;
 
+/* Job ids waiting for a worker, one ULONG per message */
+static TX_QUEUE console_job_queue;
+static ULONG console_job_queue_storage[CONSOLE_MAX_JOBS];
+
 /* RX buffer for DMA */
 uint8_t data[UART_RX_BUFF_SIZE];
 uint8_t data_size;
@@ -31,43 +38,98 @@ uint8_t data_size;
 /* Static flags */
 static bool RX_Buff_MAX_SURPASSED = false;
 
+/* Edits a writer can publish to the running set */
+typedef enum {
+    eConsole_Running_Add = 0,
+    eConsole_Running_Remove,            /* Command NULL = all */
+    eConsole_Running_Pause,             /* Command NULL = all */
+    eConsole_Running_Unpause,           /* Command NULL = all */
+} eConsole_Running_Op;
+
+/* Debug thread's private per-command state, rebuilt from the running set on every new version */
+typedef struct {
+    const tConsole_Command * Command;
+    ULONG Last_Run_Tick;                /* tx_time_get() tick when command last ran; 0 = never */
+    bool Paused;
+} tConsole_Running_Command;
+
+static tConsole_Running_Command debug_tables[2][CONSOLE_MAX_RUNNING];
+static tConsole_Running_Command * debug_running = debug_tables[0];
+static uint8_t debug_running_count = 0;
+
 /* Private function declarations */
 static void Process_Commands(uint8_t * data_ptr, uint8_t command_size);
 static void Clear_Screen(void * unused);
-static void Null_Task(void * NULL_Ptr);
+static void Console_RX_Notify(void * unused);
+static const tConsole_Running_Set * Console_Running_Acquire(void);
+static void Console_Running_Release(const tConsole_Running_Set * set);
+static bool Console_Running_Publish(eConsole_Running_Op op, const tConsole_Command * command);
+static void Console_Debug_Sync(const tConsole_Running_Set * set);
+static void Console_Service_State(void);
+static const tConsole_Command * Console_Find_Command(const char * name, size_t name_len);
+static bool Console_Command_Running(const tConsole_Command * command);
+static void Console_Print_Help(const tConsole_Command * command);
+static tConsole_Job * Console_Find_Job(const tConsole_Command * command);
+static tConsole_Job * Console_Queue_Job(const tConsole_Command * command, const char * args, void (*hook)(void *),
+                                        void * hook_params, tConsole_Job_Done done, void * done_param);
+static void Console_Run_Hook(const tConsole_Command * command, void (*hook)(void *), void * params);
+static void Console_Jobs_Command(const char * args);
+
+/* Built-in commands */
+CONSOLE_COMMAND("clear", "Clear the screen", Clear_Screen);
+CONSOLE_COMMAND("jobs", "List jobs, or control one: jobs <halt|resume|stop> <id>", NULL,
+                .Args_Function = Console_Jobs_Command);
 
 
 void Thread_Console_Init(tUART * UART)
 {
     UINT status;
     
+    Log_Init();
+
     /* Initialize console data */
     console->UART_Handler = UART;
     console->RX_Buff_Idx = 0;
     console->Console_State = eConsole_Wait_For_Commands;
-    console->Complete_Task = Null_Task;
-    console->Complete_Params = NULL;
-    console->Complete_Need_Update = false;
+    memset(console->Jobs, 0, sizeof(console->Jobs));
+    memset(console->Running_Sets, 0, sizeof(console->Running_Sets));
+    console->Running = &console->Running_Sets[0];
     
     /* Create ThreadX synchronization objects */
     status = tx_mutex_create(&console_mutex, "CONSOLE_MUTEX", TX_INHERIT);
     if (status != TX_SUCCESS) {
-        printd("ERROR: Console mutex creation failed: %u\r\n", status);
+        LOG_ERROR(CONSOLE, "Console mutex creation failed: %u\r\n", status);
         return;
     }
     
     status = tx_event_flags_create(&console_events, "CONSOLE_EVENTS");
     if (status != TX_SUCCESS) {
-        printd("ERROR: Console events creation failed: %u\r\n", status);
+        LOG_ERROR(CONSOLE, "Console events creation failed: %u\r\n", status);
         goto cleanup_mutex;
     }
+    /* Output fan-out: the console UART and the RAM log. Other sinks can be added at any time. */
+    Console_Sink_Add_UART("uart", UART, eConsole_Sink_Drop_Newest);
+    Console_Sink_Add_RAM_Log();
+    if (!Console_Sink_Init()) {
+        LOG_ERROR(CONSOLE, "Console sink thread creation failed\r\n");
+        goto cleanup_sink;
+    }
+
+    /* RX thread sleeps until the UART RX interrupt reports input */
+    UART_Set_RX_Notify(console->UART_Handler, Console_RX_Notify, NULL);
     
     /* Initialize queues */
     console->Console_Commands = Prep_Queue();
-    console->Running_Repeat_Commands = Prep_Queue();
     
-    if (!console->Console_Commands || !console->Running_Repeat_Commands) {
-        printd("ERROR: Queue initialization failed\r\n");
+    if (!console->Console_Commands) {
+        LOG_ERROR(CONSOLE, "Queue initialization failed\r\n");
+        goto cleanup_sink;
+    }
+
+    status = tx_queue_create(&console_job_queue, "CONSOLE_JOBS", TX_1_ULONG,
+                             console_job_queue_storage, sizeof(console_job_queue_storage));
+    if (status != TX_SUCCESS) {
+        LOG_ERROR(CONSOLE, "Job queue creation failed: %u\r\n", status);
         goto cleanup_queues;
     }
     
@@ -76,42 +138,55 @@ void Thread_Console_Init(tUART * UART)
                              rx_thread_stack, TX_APP_THREAD_STACK_SIZE,
                              3, 3, TX_NO_TIME_SLICE, TX_AUTO_START);
     if (status != TX_SUCCESS) {
-        printd("ERROR: RX thread creation failed: %u\r\n", status);
-        goto cleanup_queues;
+        LOG_ERROR(CONSOLE, "RX thread creation failed: %u\r\n", status);
+        goto cleanup_job_queue;
     }
     
     status = tx_thread_create(&debug_thread, "CONSOLE_DEBUG", Debug_Thread_Entry, 0,
                              debug_thread_stack, TX_SMALL_APP_THREAD_STACK_SIZE,
                              5, 5, TX_NO_TIME_SLICE, TX_AUTO_START);
     if (status != TX_SUCCESS) {
-        printd("ERROR: Debug thread creation failed: %u\r\n", status);
+        LOG_ERROR(CONSOLE, "Debug thread creation failed: %u\r\n", status);
         goto cleanup_rx_thread;
     }
     
-    status = tx_thread_create(&complete_thread, "CONSOLE_CMD", Complete_Thread_Entry, 0,
-                             complete_thread_stack, TX_SMALL_APP_THREAD_STACK_SIZE,
-                             4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
-    if (status != TX_SUCCESS) {
-        printd("ERROR: Complete thread creation failed: %u\r\n", status);
-        goto cleanup_debug_thread;
+    /* Worker pool for full commands - all share one priority so none starves the others */
+    UINT workers_created;
+    for (workers_created = 0; workers_created < CONSOLE_WORKER_COUNT; workers_created++) {
+        status = tx_thread_create(&console_worker_threads[workers_created], "CONSOLE_WORKER", Console_Worker_Entry,
+                                 workers_created, console_worker_stacks[workers_created], CONSOLE_WORKER_STACK_SIZE,
+                                 CONSOLE_WORKER_PRIORITY, CONSOLE_WORKER_PRIORITY, TX_NO_TIME_SLICE, TX_AUTO_START);
+        if (status != TX_SUCCESS) {
+            LOG_ERROR(CONSOLE, "Worker thread creation failed: %u\r\n", status);
+            goto cleanup_workers;
+        }
     }
     
-    /* Add default commands */
-    Console_Add_Command("clear", "Clear the screen", Clear_Screen, NULL);
-    
     printd("\r\nThreadX Console Initialized\r\nInput Command: \r\n");
+    /* Pick up anything that arrived before the notify hook was installed */
+    tx_event_flags_set(&console_events, CONSOLE_RX_READY_FLAG, TX_OR);
     return;
 
-cleanup_debug_thread:
+cleanup_workers:
+    while (workers_created > 0) {
+        workers_created--;
+        tx_thread_terminate(&console_worker_threads[workers_created]);
+        tx_thread_delete(&console_worker_threads[workers_created]);
+    }
     tx_thread_terminate(&debug_thread);
     tx_thread_delete(&debug_thread);
 cleanup_rx_thread:
     tx_thread_terminate(&rx_thread);
     tx_thread_delete(&rx_thread);
+cleanup_job_queue:
+    tx_queue_delete(&console_job_queue);
 cleanup_queues:
-    if (console->Console_Commands) Free_Queue(console->Console_Commands);
-    if (console->Running_Repeat_Commands) Free_Queue(console->Running_Repeat_Commands);
-cleanup_events:
+    Free_Queue(console->Console_Commands);
+    console->Console_Commands = NULL;
+cleanup_sink:
+    /* nothing may keep draining into a console whose objects are about to go */
+    Console_Sink_Deinit();
+    UART_Set_RX_Notify(console->UART_Handler, NULL, NULL);
     tx_event_flags_delete(&console_events);
 cleanup_mutex:
     tx_mutex_delete(&console_mutex);
@@ -122,12 +197,18 @@ void Thread_Console_Shutdown(void)
     /* Terminate threads */
     tx_thread_terminate(&rx_thread);
     tx_thread_terminate(&debug_thread);
-    tx_thread_terminate(&complete_thread);
+    for (int i = 0; i < CONSOLE_WORKER_COUNT; i++) {
+        tx_thread_terminate(&console_worker_threads[i]);
+    }
     
     /* Delete threads */
     tx_thread_delete(&rx_thread);
     tx_thread_delete(&debug_thread);
-    tx_thread_delete(&complete_thread);
+    for (int i = 0; i < CONSOLE_WORKER_COUNT; i++) {
+        tx_thread_delete(&console_worker_threads[i]);
+    }
+    tx_queue_delete(&console_job_queue);
+    memset(console->Jobs, 0, sizeof(console->Jobs));
     
     /* Free all commands and their allocations */
     if (console->Console_Commands) {
@@ -137,8 +218,8 @@ void Thread_Console_Shutdown(void)
             for (int i = 0; i < console->Console_Commands->Size; i++) {
                 tConsole_Command *cmd = (tConsole_Command *)Queue_Peek_Unsafe(console->Console_Commands, i);
                 if (cmd) {
-                    if (cmd->Command_Name) Safe_Byte_Release(cmd->Command_Name);
-                    if (cmd->Description) Safe_Byte_Release(cmd->Description);
+                    if (cmd->Command_Name) Safe_Byte_Release((VOID *)cmd->Command_Name);
+                    if (cmd->Description) Safe_Byte_Release((VOID *)cmd->Description);
                     /* Don't free cmd itself - Free_Queue will do that */
                 }
             }
@@ -150,18 +231,14 @@ void Thread_Console_Shutdown(void)
         console->Console_Commands = NULL;
     }
     
-    if (console->Running_Repeat_Commands) {
-        /* Running commands are references to commands in Console_Commands, 
-           so just drain and delete the queue structure - don't free the command data */
-        while (Dequeue(console->Running_Repeat_Commands) != NULL) {
-            /* Just drain - don't free the command pointers */
-        }
-        tx_mutex_delete(Queue_Get_Mutex(console->Running_Repeat_Commands));
-        Safe_Block_Release(console->Running_Repeat_Commands);
-        console->Running_Repeat_Commands = NULL;
-    }
+    /* Running sets only reference commands (static or in Console_Commands) - nothing to free */
+    memset(console->Running_Sets, 0, sizeof(console->Running_Sets));
+    console->Running = &console->Running_Sets[0];
+    debug_running_count = 0;
     
     /* Delete synchronization objects */
+    Console_Sink_Deinit();
+    UART_Set_RX_Notify(console->UART_Handler, NULL, NULL);
     tx_mutex_delete(&console_mutex);
     tx_event_flags_delete(&console_events);
 }
@@ -175,31 +252,35 @@ tConsole_Command * Console_Add_Command(const char * command_Name, const char * D
     /* Allocate command structure */
     status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&new_Command, sizeof(tConsole_Command), TX_NO_WAIT);
     if (status != TX_SUCCESS) {
-        printd("ERROR: Command allocation failed\r\n");
+        LOG_ERROR(CONSOLE, "Command allocation failed\r\n");
         return NULL;
     }
     
     /* Allocate and copy command name */
     size_t name_len = strlen(command_Name) + 1;
-    status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&new_Command->Command_Name, name_len, TX_NO_WAIT);
+    char * name_copy = NULL;
+    status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&name_copy, name_len, TX_NO_WAIT);
     if (status != TX_SUCCESS) {
         Safe_Byte_Release(new_Command);
-        printd("ERROR: Command name allocation failed\r\n");
+        LOG_ERROR(CONSOLE, "Command name allocation failed\r\n");
         return NULL;
     }
-    strcpy(new_Command->Command_Name, command_Name);
+    strcpy(name_copy, command_Name);
+    new_Command->Command_Name = name_copy;
     
     /* Allocate and copy description if provided */
     if (Description != NULL) {
         size_t desc_len = strlen(Description) + 1;
-        status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&new_Command->Description, desc_len, TX_NO_WAIT);
+        char * desc_copy = NULL;
+        status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&desc_copy, desc_len, TX_NO_WAIT);
         if (status != TX_SUCCESS) {
-            Safe_Byte_Release(new_Command->Command_Name);
+            Safe_Byte_Release(name_copy);
             Safe_Byte_Release(new_Command);
-            printd("ERROR: Description allocation failed\r\n");
+            LOG_ERROR(CONSOLE, "Description allocation failed\r\n");
             return NULL;
         }
-        strcpy(new_Command->Description, Description);
+        strcpy(desc_copy, Description);
+        new_Command->Description = desc_copy;
     } else {
         new_Command->Description = NULL;
     }
@@ -215,14 +296,14 @@ tConsole_Command * Console_Add_Command(const char * command_Name, const char * D
     new_Command->Stop_Function = NULL;
     new_Command->Stop_Params = NULL;
     new_Command->Repeat_Time = 0;
-    new_Command->Last_Run_Tick = 0;
+    new_Command->Args_Function = NULL;
     
     /* Add to queue */
     if (!Enqueue(console->Console_Commands, new_Command)) {
-        if (new_Command->Description) Safe_Byte_Release(new_Command->Description);
-        Safe_Byte_Release(new_Command->Command_Name);
+        if (new_Command->Description) Safe_Byte_Release((VOID *)new_Command->Description);
+        Safe_Byte_Release(name_copy);
         Safe_Byte_Release(new_Command);
-        printd("ERROR: Failed to add command to queue\r\n");
+        LOG_ERROR(CONSOLE, "Failed to add command to queue\r\n");
         return NULL;
     }
     
@@ -247,31 +328,35 @@ tConsole_Command * Thread_Console_Add_Debug_Command(const char *command_Name,
     /* Allocate command structure */
     status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&new_Command, sizeof(tConsole_Command), TX_NO_WAIT);
     if (status != TX_SUCCESS) {
-        printd("ERROR: Debug command allocation failed\r\n");
+        LOG_ERROR(CONSOLE, "Debug command allocation failed\r\n");
         return NULL;
     }
     
     /* Allocate and copy command name */
     size_t name_len = strlen(command_Name) + 1;
-    status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&new_Command->Command_Name, name_len, TX_NO_WAIT);
+    char * name_copy = NULL;
+    status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&name_copy, name_len, TX_NO_WAIT);
     if (status != TX_SUCCESS) {
         Safe_Byte_Release(new_Command);
-        printd("ERROR: Debug command name allocation failed\r\n");
+        LOG_ERROR(CONSOLE, "Debug command name allocation failed\r\n");
         return NULL;
     }
-    strcpy(new_Command->Command_Name, command_Name);
+    strcpy(name_copy, command_Name);
+    new_Command->Command_Name = name_copy;
     
     /* Allocate and copy description if provided */
     if (Description) {
         size_t desc_len = strlen(Description) + 1;
-        status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&new_Command->Description, desc_len, TX_NO_WAIT);
+        char * desc_copy = NULL;
+        status = Safe_Byte_Allocate(&tx_app_byte_pool, (VOID **)&desc_copy, desc_len, TX_NO_WAIT);
         if (status != TX_SUCCESS) {
-            Safe_Byte_Release(new_Command->Command_Name);
+            Safe_Byte_Release(name_copy);
             Safe_Byte_Release(new_Command);
-            printd("ERROR: Debug description allocation failed\r\n");
+            LOG_ERROR(CONSOLE, "Debug description allocation failed\r\n");
             return NULL;
         }
-        strcpy(new_Command->Description, Description);
+        strcpy(desc_copy, Description);
+        new_Command->Description = desc_copy;
     } else {
         new_Command->Description = NULL;
     }
@@ -287,20 +372,37 @@ tConsole_Command * Thread_Console_Add_Debug_Command(const char *command_Name,
     new_Command->Stop_Function = Stop_Function;
     new_Command->Stop_Params = Stop_Params;
     new_Command->Repeat_Time = repeat_time;  // in milliseconds
-    new_Command->Last_Run_Tick = 0;
+    new_Command->Args_Function = NULL;
     
     /* Add to queue */
     if (!Enqueue(console->Console_Commands, new_Command)) {
-        if (new_Command->Description) Safe_Byte_Release(new_Command->Description);
-        Safe_Byte_Release(new_Command->Command_Name);
+        if (new_Command->Description) Safe_Byte_Release((VOID *)new_Command->Description);
+        Safe_Byte_Release(name_copy);
         Safe_Byte_Release(new_Command);
-        printd("ERROR: Failed to add debug command to queue\r\n");
+        LOG_ERROR(CONSOLE, "Failed to add debug command to queue\r\n");
         return NULL;
     }
     
     return new_Command;
 }
 
+/**
+ * @brief: Queues raw bytes for every console output sink without any formatting. Used by printd,
+ * printf and the log module once a line is fully formatted. Never blocks, see Console_Sink.h.
+ *
+ * @params: Data to send, Length in bytes
+ *
+ * @return: None
+ */
+void Console_Write(const char * Data, uint16_t Length)
+{
+    /* While a test rig holds the link in binary mode, text goes into the response or nowhere */
+    if (Console_Binary_Output(Data, Length)) {
+        return;
+    }
+    Console_Sink_Write((const uint8_t *)Data, Length);
+}
+
 void printd(const char* format, ...)
 {
     va_list args;
@@ -308,9 +410,7 @@ void printd(const char* format, ...)
     
     if (percent_sign == NULL) {
         /* Simple string, send directly */
-        size_t len = strlen(format);
-        if (len > UINT8_MAX) len = UINT8_MAX; /* Truncate to uint8_t max */
-        UART_Add_Transmit(console->UART_Handler, (uint8_t *)format, (uint8_t)len);
+        Console_Write(format, (uint16_t)strlen(format));
     } else {
         /* Formatted string, use block pool instead of malloc */
         char* buffer = NULL;
@@ -339,86 +439,305 @@ void printd(const char* format, ...)
         vsnprintf(buffer, needed_size, format, args);
         va_end(args);
         
-        size_t len = strlen(buffer);
-        if (len > UINT8_MAX) len = UINT8_MAX; /* Truncate to uint8_t max */
-        UART_Add_Transmit(console->UART_Handler, (uint8_t*)buffer, (uint8_t)len);
+        Console_Write(buffer, (uint16_t)strlen(buffer));
         Safe_Block_Release(buffer);
     }
 }
 
 int __io_putchar(int ch)
 {
-    HAL_UART_Transmit(console->UART_Handler, (uint8_t*)&ch, 1, PRINTF_DELAY_TIME);
+    char c = (char)ch;
+    Console_Write(&c, 1);
     return ch;
 }
 
+/* Replaces the weak per-character _write in syscalls.c so printf hands whole buffers to the sinks */
+int _write(int file, char * ptr, int len)
+{
+    (void)file;
+    int written = 0;
+    while (written < len) {
+        uint16_t chunk = (len - written > UINT16_MAX) ? UINT16_MAX : (uint16_t)(len - written);
+        Console_Write(ptr + written, chunk);
+        written += chunk;
+    }
+    return len;
+}
+
+
+/**
+ * @brief: Notify side of console RX. Registered with the console UART and called (from the DEFER
+ * thread, or the UART/DMA interrupt as a fallback) whenever received bytes are ready, so the RX
+ * thread only runs when there is input.
+ */
+static void Console_RX_Notify(void * unused)
+{
+    (void)unused;
+    tx_event_flags_set(&console_events, CONSOLE_RX_READY_FLAG, TX_OR);
+}
+
+/**
+ * @brief: Pins the published running set so it can be read without a lock. Must be paired with
+ * Console_Running_Release, and not held across Console_Running_Publish by the same thread.
+ *
+ * @return: published set, do not modify
+ */
+static const tConsole_Running_Set * Console_Running_Acquire(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    tConsole_Running_Set * set = console->Running;
+    set->Readers++;
+    __set_PRIMASK(primask);
+    return set;
+}
+
+static void Console_Running_Release(const tConsole_Running_Set * set)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ((tConsole_Running_Set *)set)->Readers--;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Buffer a writer may build the next version in - not published and pinned by no reader.
+ * Only the published set can gain readers, so an unpinned older set stays free.
+ */
+static tConsole_Running_Set * Console_Running_Free_Set(void)
+{
+    for (int i = 0; i < CONSOLE_RUNNING_VERSIONS; i++) {
+        tConsole_Running_Set * set = &console->Running_Sets[i];
+        if (set != console->Running && set->Readers == 0) {
+            return set;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief: Publishes a new version of the running set with one edit applied, then wakes the debug
+ * thread to act on it. Writers serialize on console_mutex, which is never held while user code runs.
+ *
+ * @params: op edit to apply, command it applies to (NULL = every entry, except for add)
+ *
+ * @return: true if a new version was published. Add fails when the command is already running or
+ * the set is full; the other edits fail when nothing matched.
+ */
+static bool Console_Running_Publish(eConsole_Running_Op op, const tConsole_Command * command)
+{
+    bool changed = false;
+
+    if (tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT) != TX_SUCCESS) {
+        LOG_ERROR(CONSOLE, "Failed to acquire console mutex for running set\r\n");
+        return false;
+    }
+
+    /* Grace period - with one slow reader there is always a free buffer, so this rarely waits */
+    tConsole_Running_Set * next;
+    while ((next = Console_Running_Free_Set()) == NULL) {
+        tx_thread_sleep(1);
+    }
+
+    const tConsole_Running_Set * curr = console->Running;
+    bool found = false;
+    next->Count = 0;
+    for (uint8_t i = 0; i < curr->Count; i++) {
+        tConsole_Running_Entry entry = curr->Entries[i];
+        bool match = (command == NULL || entry.Command == command);
+        found |= (entry.Command == command);
+
+        if (op == eConsole_Running_Remove && match) {
+            changed = true;
+            continue;
+        }
+        if (op == eConsole_Running_Pause && match && !entry.Paused) {
+            entry.Paused = true;
+            changed = true;
+        }
+        if (op == eConsole_Running_Unpause && match && entry.Paused) {
+            entry.Paused = false;
+            changed = true;
+        }
+        next->Entries[next->Count++] = entry;
+    }
+    if (op == eConsole_Running_Add && !found && next->Count < CONSOLE_MAX_RUNNING) {
+        next->Entries[next->Count].Command = command;
+        next->Entries[next->Count].Paused = false;
+        next->Count++;
+        changed = true;
+    }
+
+    if (changed) {
+        next->Version = curr->Version + 1;
+        __DMB();    /* contents visible before the pointer */
+        console->Running = next;
+    }
+    tx_mutex_put(&console_mutex);
+
+    if (changed) {
+        tx_event_flags_set(&console_events, CONSOLE_DEBUG_WAKE_FLAG, TX_OR);
+    }
+    return changed;
+}
+
+/**
+ * @brief: Brings the debug thread's private table up to a new version of the running set and calls
+ * the hooks for what changed: Stop_Function for removed commands, Halt_Function / Resume_Function
+ * for paused / unpaused ones. Runs in the debug thread between passes, so a hook never overlaps the
+ * command's own Call_Function. Hooks run after the set is released.
+ */
+static void Console_Debug_Sync(const tConsole_Running_Set * set)
+{
+    tConsole_Running_Command * prev = debug_running;
+    uint8_t prev_count = debug_running_count;
+    tConsole_Running_Command * next = (prev == debug_tables[0]) ? debug_tables[1] : debug_tables[0];
+    uint8_t next_count = 0;
+
+    for (uint8_t i = 0; i < set->Count; i++) {
+        next[next_count].Command = set->Entries[i].Command;
+        next[next_count].Paused = set->Entries[i].Paused;
+        next[next_count].Last_Run_Tick = 0;     /* new - due now */
+        for (uint8_t j = 0; j < prev_count; j++) {
+            if (prev[j].Command == next[next_count].Command) {
+                next[next_count].Last_Run_Tick = prev[j].Last_Run_Tick;
+                break;
+            }
+        }
+        next_count++;
+    }
+    debug_running = next;
+    debug_running_count = next_count;
+    Console_Running_Release(set);
+
+    /* Removed, halted and resumed commands */
+    for (uint8_t j = 0; j < prev_count; j++) {
+        const tConsole_Command * command = prev[j].Command;
+        const tConsole_Running_Command * now = NULL;
+        for (uint8_t i = 0; i < next_count; i++) {
+            if (next[i].Command == command) {
+                now = &next[i];
+                break;
+            }
+        }
+        if (now == NULL) {
+            if (command->Stop_Function) command->Stop_Function(command->Stop_Params);
+        } else if (now->Paused && !prev[j].Paused) {
+            if (command->Halt_Function) command->Halt_Function(command->Halt_Params);
+        } else if (!now->Paused && prev[j].Paused) {
+            if (command->Resume_Function) command->Resume_Function(command->Resume_Params);
+        }
+    }
+}
+
+/**
+ * @brief: Carries out a pending halt/resume/quit request. Runs in the RX thread whenever
+ * CONSOLE_STATE_CHANGE_FLAG is set, instead of waiting for the next received byte.
+ */
+static void Console_Service_State(void)
+{
+    UINT status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
+    if (status != TX_SUCCESS) {
+        LOG_ERROR(CONSOLE, "Failed to acquire console mutex in RX\r\n");
+        return;
+    }
+    eConsole_State state = console->Console_State;
+    tx_mutex_put(&console_mutex);
+
+    if (state == eConsole_Halting_Commands) {
+        /* Pause all running commands and the jobs */
+        Console_Running_Publish(eConsole_Running_Pause, NULL);
+        for (int i = 0; i < CONSOLE_MAX_JOBS; i++) {
+            Console_Job_Halt(&console->Jobs[i]);
+        }
+        /* Update state safely */
+        status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
+        if (status == TX_SUCCESS) {
+            console->Console_State = eConsole_Halted_Commands;
+            tx_mutex_put(&console_mutex);
+        }
+    }
+    else if (state == eConsole_Resume_Commands) {
+        /* Resume all running commands and the jobs */
+        Console_Running_Publish(eConsole_Running_Unpause, NULL);
+        for (int i = 0; i < CONSOLE_MAX_JOBS; i++) {
+            Console_Job_Resume(&console->Jobs[i]);
+        }
+        /* Update state safely */
+        status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
+        if (status == TX_SUCCESS) {
+            console->Console_State = eConsole_Servicing_Command;
+            tx_mutex_put(&console_mutex);
+        }
+    }
+    else if (state == eConsole_Quit_Commands) {
+        /* Drop all running commands (the debug thread stops them) and stop the jobs */
+        Console_Running_Publish(eConsole_Running_Remove, NULL);
+        for (int i = 0; i < CONSOLE_MAX_JOBS; i++) {
+            Console_Job_Stop(&console->Jobs[i]);
+        }
+        /* Update state safely */
+        status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
+        if (status == TX_SUCCESS) {
+            console->Console_State = eConsole_Wait_For_Commands;
+            tx_mutex_put(&console_mutex);
+        }
+    }
+}
 
-// need to make the following: UART feeding is critical;
+/**
+ * @brief: Console RX thread. Sleeps on console_events until the UART RX interrupt reports input or
+ * another thread requests a state change - no periodic wakeups while the console is idle in text mode.
+ */
 VOID RX_Thread_Entry(ULONG thread_input)
 {
     (void)thread_input;
     UINT status;
+    ULONG actual_flags;
     
     while (1) {
         static bool just_saw_cr = false;
 
-        /* Receive data from UART */
-        UART_Receive(console->UART_Handler, data, &data_size);
-        
-        if (data_size > 0) {
+        /* Binary mode needs a wakeup to notice an idle link and fall back to text */
+        ULONG wait_ticks = (ULONG)Console_Binary_Poll();
+        if (wait_ticks == TX_WAIT_FOREVER) {
+            wait_ticks = CONSOLE_RX_SEMAPHORE_WAIT;
+        }
+        tx_event_flags_get(&console_events, CONSOLE_RX_READY_FLAG | CONSOLE_STATE_CHANGE_FLAG,
+                           TX_OR_CLEAR, &actual_flags, wait_ticks);
+
+        Console_Service_State();
+
+        /* Drain everything received so far; UART_Receive hands out at most 255 bytes per call */
+        while (1) {
+            UART_Receive(console->UART_Handler, data, &data_size);
+            if (data_size == 0) {
+                break;
+            }
+
             /* Process received data */
             for (uint16_t counter = 0; counter < data_size; counter++) {
+                /* Binary framed mode bypasses echo, line editing and console states entirely */
+                if (Console_Binary_Active()) {
+                    Console_Binary_Feed(data[counter]);
+                    continue;
+                }
+                if (Console_Binary_Match_Magic(data[counter])) {
+                    continue;
+                }
+
                 /* Handle different console states - acquire mutex for each state check/action */
                 status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
                 if (status != TX_SUCCESS) {
-                    printd("ERROR: Failed to acquire console mutex in RX\r\n");
+                    LOG_ERROR(CONSOLE, "Failed to acquire console mutex in RX\r\n");
                     break;
                 }
                 
-                if (console->Console_State == eConsole_Halting_Commands) {
-                    tx_mutex_put(&console_mutex);
-                    /* Stop all running commands - guard iteration with queue mutex */
-                    TX_MUTEX *queue_mutex = Queue_Get_Mutex(console->Running_Repeat_Commands);
-                    if (queue_mutex && tx_mutex_get(queue_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
-                        for (int i = 0; i < console->Running_Repeat_Commands->Size; i++) {
-                            tConsole_Command * curr_Command = (tConsole_Command*)Queue_Peek_Unsafe(console->Running_Repeat_Commands, i);
-                            if (curr_Command && curr_Command->Stop_Function) {
-                                curr_Command->Stop_Function(curr_Command->Stop_Params);
-                            }
-                        }
-                        tx_mutex_put(queue_mutex);
-                    }
-                    /* Update state safely */
-                    status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
-                    if (status == TX_SUCCESS) {
-                        console->Console_State = eConsole_Halted_Commands;
-                        tx_mutex_put(&console_mutex);
-                    }
-                }
-                else if (console->Console_State == eConsole_Resume_Commands){
-                    tx_mutex_put(&console_mutex);
-                    /* Resume all running commands - guard iteration with queue mutex */
-                    TX_MUTEX *queue_mutex = Queue_Get_Mutex(console->Running_Repeat_Commands);
-                    if (queue_mutex && tx_mutex_get(queue_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
-                        for (int i = 0; i < console->Running_Repeat_Commands->Size; i++){
-                            tConsole_Command * curr_Command = (tConsole_Command*)Queue_Peek_Unsafe(console->Running_Repeat_Commands, i);
-                            if (curr_Command && curr_Command->Resume_Function) {
-                                curr_Command->Resume_Function(curr_Command->Resume_Params);
-                            }
-                        }
-                        tx_mutex_put(queue_mutex);
-                    }
-                    /* Update state safely */
-                    status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
-                    if (status == TX_SUCCESS) {
-                        console->Console_State = eConsole_Servicing_Command;
-                        tx_mutex_put(&console_mutex);
-                    }
-                }
-                else if (console->Console_State == eConsole_Servicing_Command) {
+                if (console->Console_State == eConsole_Servicing_Command) {
                     if (data[counter] == '\r') {
                         printd("Console paused.\r\n");
                         console->Console_State = eConsole_Halting_Commands;
+                        tx_event_flags_set(&console_events, CONSOLE_STATE_CHANGE_FLAG, TX_OR);
                     }
                     tx_mutex_put(&console_mutex);
                 }
@@ -491,109 +810,183 @@ VOID RX_Thread_Entry(ULONG thread_input)
                     just_saw_cr = (data[counter] == '\r');
                     tx_mutex_put(&console_mutex);
                 }
-                /* Handle quit state */
-                else if (console->Console_State == eConsole_Quit_Commands) {
-                    tx_mutex_put(&console_mutex);
-                    /* Stop all running commands - guard iteration with queue mutex */
-                    TX_MUTEX *queue_mutex = Queue_Get_Mutex(console->Running_Repeat_Commands);
-                    if (queue_mutex && tx_mutex_get(queue_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
-                        for (int i = 0; i < console->Running_Repeat_Commands->Size; i++) {
-                            tConsole_Command * curr_command = Queue_Peek_Unsafe(console->Running_Repeat_Commands, i);
-                            if (curr_command && curr_command->Stop_Function) {
-                                curr_command->Stop_Function(curr_command->Stop_Params);
-                            }
-                        }
-                        tx_mutex_put(queue_mutex);
-                    }
-                    /* Update state safely */
-                    status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
-                    if (status == TX_SUCCESS) {
-                        console->Console_State = eConsole_Wait_For_Commands;
-                        tx_mutex_put(&console_mutex);
-                    }
-                }
+                /* Halt/resume/quit requested mid-burst - carry it out before the next byte */
                 else {
-                    /* Unknown state - just release mutex */
                     tx_mutex_put(&console_mutex);
+                    Console_Service_State();
                 }
             }
             
             /* Clear receive buffer */
             memset(data, 0, UART_RX_BUFF_SIZE);
             data_size = 0;
-
         }
-        
-        tx_thread_sleep(CONSOLE_THREAD_SLEEP_MS);
     }
 }
 
 /**
- *  CANNOT use debug thread to add commands - will create ABBA deadlock 
+ *  Runs every repeat command and all of their halt/resume/stop hooks. Nothing is locked while they
+ *  run, so a slow or printing command cannot hold up the RX thread.
+ *
+ *  Sleeps until the next repeat command is due, or forever when nothing is running. Publishing a new
+ *  running set sets CONSOLE_DEBUG_WAKE_FLAG to wake it early.
  */
 
 VOID Debug_Thread_Entry(ULONG thread_input)
 {
     (void)thread_input;
+    ULONG actual_flags;
+    uint32_t seen_version = 0;
     
     while (1) {
-        /* Execute all running debug commands - guard entire iteration with queue mutex */
+        ULONG wait_ticks = TX_WAIT_FOREVER;
+
+        /* Pick up a new version of the running set - no lock, the set is only pinned while copied */
+        const tConsole_Running_Set * set = Console_Running_Acquire();
+        if (set->Version != seen_version) {
+            seen_version = set->Version;
+            Console_Debug_Sync(set);
+        } else {
+            Console_Running_Release(set);
+        }
+
+        /* Execute the running debug commands from the private table */
         ULONG now = tx_time_get();
-        TX_MUTEX *queue_mutex = Queue_Get_Mutex(console->Running_Repeat_Commands);
-        if (queue_mutex && tx_mutex_get(queue_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
-            for (int i = 0; i < console->Running_Repeat_Commands->Size; i++) {
-                tConsole_Command * curr_Command = (tConsole_Command *)Queue_Peek_Unsafe(console->Running_Repeat_Commands, i);
-                if (!curr_Command || !curr_Command->Call_Function) continue;
-
-                /* If Repeat_Time is zero, run every cycle. Otherwise check elapsed time. */
-                if (curr_Command->Repeat_Time == 0) {
-                    curr_Command->Call_Function(curr_Command->Call_Params);
-                    curr_Command->Last_Run_Tick = now;
-                    continue;
-                }
+        for (uint8_t i = 0; i < debug_running_count; i++) {
+            tConsole_Running_Command * entry = &debug_running[i];
+            const tConsole_Command * curr_Command = entry->Command;
+            if (entry->Paused || !curr_Command->Call_Function) continue;
+
+            /* If Repeat_Time is zero, run every cycle. Otherwise check elapsed time. */
+            if (curr_Command->Repeat_Time == 0) {
+                curr_Command->Call_Function(curr_Command->Call_Params);
+                entry->Last_Run_Tick = now;
+                if (wait_ticks > CONSOLE_DEBUG_CYCLE_TICKS) wait_ticks = CONSOLE_DEBUG_CYCLE_TICKS;
+                continue;
+            }
 
-                /* Convert Repeat_Time (ms) to ticks. Round up to avoid running too frequently. */
-                UINT ticks_needed = (UINT)((((uint64_t)curr_Command->Repeat_Time) * TX_TIMER_TICKS_PER_SECOND + 999) / 1000);
+            /* Convert Repeat_Time (ms) to ticks. Round up to avoid running too frequently. */
+            UINT ticks_needed = (UINT)((((uint64_t)curr_Command->Repeat_Time) * TX_TIMER_TICKS_PER_SECOND + 999) / 1000);
 
-                /* Calculate elapsed ticks handling wrap-around by unsigned subtraction. */
-                ULONG elapsed = now - curr_Command->Last_Run_Tick;
+            /* Calculate elapsed ticks handling wrap-around by unsigned subtraction. */
+            ULONG elapsed = now - entry->Last_Run_Tick;
 
-                if (curr_Command->Last_Run_Tick == 0 || elapsed >= ticks_needed) {
-                    curr_Command->Call_Function(curr_Command->Call_Params);
-                    curr_Command->Last_Run_Tick = now;
-                }
+            if (entry->Last_Run_Tick == 0 || elapsed >= ticks_needed) {
+                curr_Command->Call_Function(curr_Command->Call_Params);
+                entry->Last_Run_Tick = now;
+                elapsed = 0;
             }
-            tx_mutex_put(queue_mutex);
+
+            /* Sleep no longer than until this command is next due */
+            ULONG remaining = (ticks_needed > elapsed) ? (ticks_needed - elapsed) : 1;
+            if (remaining < wait_ticks) wait_ticks = remaining;
         }
 
-        tx_thread_sleep(200); /* 200ms debug cycle */
+        tx_event_flags_get(&console_events, CONSOLE_DEBUG_WAKE_FLAG, TX_OR_CLEAR, &actual_flags, wait_ticks);
     }
 }
 
-VOID Complete_Thread_Entry(ULONG thread_input)
+/**
+ * @brief: Worker pool thread. Takes job ids from console_job_queue and runs the job's command to
+ * completion. Several workers let long diagnostics run side by side instead of queueing behind
+ * one another.
+ */
+VOID Console_Worker_Entry(ULONG thread_input)
 {
     (void)thread_input;
-    UINT status;
+    ULONG job_id;
     
     while (1) {
-        /* Acquire console mutex */
-        status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
-        if (status == TX_SUCCESS) {
-            if (console->Complete_Need_Update && console->Complete_Task != NULL && console->Complete_Task != Null_Task) {
-                /* Run the task once */
-                console->Complete_Task(console->Complete_Params);
-                /* Reset flag, task, and params */
-                console->Complete_Need_Update = false;
-                console->Complete_Task = Null_Task;
-                console->Complete_Params = NULL;
-            }
+        if (tx_queue_receive(&console_job_queue, &job_id, TX_WAIT_FOREVER) != TX_SUCCESS || job_id >= CONSOLE_MAX_JOBS) {
+            continue;
+        }
+        tConsole_Job * job = &console->Jobs[job_id];
+
+        if (tx_mutex_get(&console_mutex, TX_WAIT_FOREVER) != TX_SUCCESS) {
+            continue;
+        }
+        bool run = (job->State == eConsole_Job_Queued);  /* may have been stopped while queued */
+        if (run) {
+            job->State = eConsole_Job_Running;
+            job->Worker = tx_thread_identify();
+        }
+        tx_mutex_put(&console_mutex);
+
+        if (run && job->Hook) {
+            job->Hook(job->Hook_Params);
+        } else if (run && job->Command->Args_Function) {
+            job->Command->Args_Function(job->Args);
+        } else if (run && job->Command->Call_Function) {
+            job->Command->Call_Function(job->Command->Call_Params);
+        }
+        if (job->Done) {
+            job->Done(job->Done_Param, run);
+        }
+
+        /* Job done - free the slot */
+        if (tx_mutex_get(&console_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
+            job->Worker = NULL;
+            job->Command = NULL;
+            job->Hook = NULL;
+            job->Done = NULL;
+            job->State = eConsole_Job_Free;
             tx_mutex_put(&console_mutex);
         }
-        
-        tx_thread_sleep(CONSOLE_THREAD_SLEEP_MS);
     }
 }
 
+/**
+ * @brief: Looks a command up by name, static table first, then the runtime-added commands.
+ * Commands are never removed while the console runs, so the pointer stays valid after the queue
+ * mutex is released.
+ *
+ * @params: name to match, name_len characters of name to compare (name need not be terminated)
+ *
+ * @return: matching command, NULL if none
+ */
+static const tConsole_Command * Console_Find_Command(const char * name, size_t name_len)
+{
+    for (const tConsole_Command * cmd = __console_cmds_start; cmd < __console_cmds_end; cmd++) {
+        if (strlen(cmd->Command_Name) == name_len && strncmp(cmd->Command_Name, name, name_len) == 0) {
+            return cmd;
+        }
+    }
+
+    const tConsole_Command * found = NULL;
+    TX_MUTEX *queue_mutex = Queue_Get_Mutex(console->Console_Commands);
+    if (queue_mutex && tx_mutex_get(queue_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
+        for (int i = 0; i < console->Console_Commands->Size; i++) {
+            tConsole_Command * curr_Command = (tConsole_Command *)Queue_Peek_Unsafe(console->Console_Commands, i);
+            if (curr_Command && strlen(curr_Command->Command_Name) == name_len &&
+                strncmp(curr_Command->Command_Name, name, name_len) == 0) {
+                found = curr_Command;
+                break;
+            }
+        }
+        tx_mutex_put(queue_mutex);
+    }
+    return found;
+}
+
+static bool Console_Command_Running(const tConsole_Command * command)
+{
+    bool running = false;
+    const tConsole_Running_Set * set = Console_Running_Acquire();
+    for (uint8_t i = 0; i < set->Count; i++) {
+        if (set->Entries[i].Command == command) {
+            running = true;
+            break;
+        }
+    }
+    Console_Running_Release(set);
+    return running;
+}
+
+static void Console_Print_Help(const tConsole_Command * command)
+{
+    printd("%s: %s\r\n", command->Command_Name, command->Description ? command->Description : "No description");
+}
+
 static void Process_Commands(uint8_t * data_ptr, uint8_t command_size)
 {
     char command[MAX_CONSOLE_BUFF_SIZE];
@@ -618,14 +1011,16 @@ static void Process_Commands(uint8_t * data_ptr, uint8_t command_size)
     /* Handle help command */
     if (strcmp(command, "help") == 0) {
         printd("\r\n");
+        for (const tConsole_Command * cmd = __console_cmds_start; cmd < __console_cmds_end; cmd++) {
+            Console_Print_Help(cmd);
+        }
         /* Guard iteration with queue mutex */
         TX_MUTEX *queue_mutex = Queue_Get_Mutex(console->Console_Commands);
         if (queue_mutex && tx_mutex_get(queue_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
             for (int i = 0; i < console->Console_Commands->Size; i++) {
                 tConsole_Command * curr_Command = (tConsole_Command *)Queue_Peek_Unsafe(console->Console_Commands, i);
                 if (curr_Command) {
-                    printd("%s: %s\r\n", curr_Command->Command_Name, 
-                                curr_Command->Description ? curr_Command->Description : "No description");
+                    Console_Print_Help(curr_Command);
                 }
             }
             tx_mutex_put(queue_mutex);
@@ -643,103 +1038,147 @@ static void Process_Commands(uint8_t * data_ptr, uint8_t command_size)
     }
     /* Handle prefixed commands (halt/stop/help <command>) */
     else if (flag_3 && strlen(command) > 5) {
-        char prompt_command[MAX_CONSOLE_BUFF_SIZE];
-        /* Safely copy command after prefix, with bounds checking */
-        snprintf(prompt_command, sizeof(prompt_command), "%s", command + 5);
-        
-        /* Guard iteration with queue mutex */
-        TX_MUTEX *queue_mutex = Queue_Get_Mutex(console->Console_Commands);
-        if (queue_mutex && tx_mutex_get(queue_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
-            for (int i = 0; i < console->Console_Commands->Size; i++) {
-                tConsole_Command * curr_Command = (tConsole_Command *)Queue_Peek_Unsafe(console->Console_Commands, i);
-                if (curr_Command && strcmp(prompt_command, curr_Command->Command_Name) == 0) {
-                    if (halt_flag && curr_Command->Halt_Function) {
-                        curr_Command->Halt_Function(curr_Command->Halt_Params);
-                    }
-                    if (stop_flag && curr_Command->Stop_Function) {
-                        curr_Command->Stop_Function(curr_Command->Stop_Params);
-                        Console_Quit_Commands();
-                    }
-                    if (help_flag) {
-                        printd("%s: %s\r\n", curr_Command->Command_Name, 
-                                    curr_Command->Description ? curr_Command->Description : "No description");
-                    }
-                    break;
-                }
+        const tConsole_Command * curr_Command = Console_Find_Command(command + 5, strlen(command + 5));
+        tConsole_Job * job = curr_Command ? Console_Find_Job(curr_Command) : NULL;
+        if (job) {
+            if (halt_flag) Console_Job_Halt(job);
+            if (stop_flag) Console_Job_Stop(job);
+            if (help_flag) Console_Print_Help(curr_Command);
+        }
+        else if (curr_Command && (halt_flag || stop_flag) && Console_Command_Running(curr_Command)) {
+            /* Running repeat command - the debug thread calls its hook when it sees the new set */
+            Console_Running_Publish(halt_flag ? eConsole_Running_Pause : eConsole_Running_Remove, curr_Command);
+        }
+        else if (curr_Command) {
+            if (halt_flag && curr_Command->Halt_Function) {
+                Console_Run_Hook(curr_Command, curr_Command->Halt_Function, curr_Command->Halt_Params);
+            }
+            if (stop_flag && curr_Command->Stop_Function) {
+                Console_Run_Hook(curr_Command, curr_Command->Stop_Function, curr_Command->Stop_Params);
+            }
+            if (help_flag) {
+                Console_Print_Help(curr_Command);
             }
-            tx_mutex_put(queue_mutex);
         }
     }
     /* Handle resume command */
     else if (resume_flag && strlen(command) > 7) {
-        char prompt_command[MAX_CONSOLE_BUFF_SIZE];
-        /* Safely copy command after prefix, with bounds checking */
-        snprintf(prompt_command, sizeof(prompt_command), "%s", command + 7);
-        
-        /* Guard iteration with queue mutex */
-        TX_MUTEX *queue_mutex = Queue_Get_Mutex(console->Console_Commands);
-        if (queue_mutex && tx_mutex_get(queue_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
-            for (int i = 0; i < console->Console_Commands->Size; i++) {
-                tConsole_Command * curr_Command = (tConsole_Command *)Queue_Peek_Unsafe(console->Console_Commands, i);
-                if (curr_Command && strcmp(prompt_command, curr_Command->Command_Name) == 0) {
-                    if (curr_Command->Resume_Function) {
-                        curr_Command->Resume_Function(curr_Command->Resume_Params);
-                    }
-                    break;
-                }
-            }
-            tx_mutex_put(queue_mutex);
+        const tConsole_Command * curr_Command = Console_Find_Command(command + 7, strlen(command + 7));
+        tConsole_Job * job = curr_Command ? Console_Find_Job(curr_Command) : NULL;
+        if (job) {
+            Console_Job_Resume(job);
+        }
+        else if (curr_Command && Console_Command_Running(curr_Command)) {
+            Console_Running_Publish(eConsole_Running_Unpause, curr_Command);
+        }
+        else if (curr_Command && curr_Command->Resume_Function) {
+            Console_Run_Hook(curr_Command, curr_Command->Resume_Function, curr_Command->Resume_Params);
         }
     }
     /* Handle regular commands */
     else {
-        /* Guard iteration with queue mutex */
-        TX_MUTEX *commands_mutex = Queue_Get_Mutex(console->Console_Commands);
-        if (commands_mutex && tx_mutex_get(commands_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
-            for (int i = 0; i < console->Console_Commands->Size; i++) {
-                tConsole_Command * curr_Command = (tConsole_Command *)Queue_Peek_Unsafe(console->Console_Commands, i);
-                if (curr_Command && strcmp(command, curr_Command->Command_Name) == 0) {
-                    /* Check if command is already running - need separate mutex for running commands */
-                    bool command_already_running = false;
-                    TX_MUTEX *running_mutex = Queue_Get_Mutex(console->Running_Repeat_Commands);
-                    if (running_mutex && tx_mutex_get(running_mutex, TX_WAIT_FOREVER) == TX_SUCCESS) {
-                        for (int c = 0; c < console->Running_Repeat_Commands->Size; c++) {
-                            tConsole_Command * curr_Running_Command = (tConsole_Command *)Queue_Peek_Unsafe(console->Running_Repeat_Commands, c);
-                            if (curr_Running_Command && strcmp(command, curr_Running_Command->Command_Name) == 0) {
-                                printd("Command Already Running\r\n");
-                                command_already_running = true;
-                                break;
-                            }
-                        }
-                        tx_mutex_put(running_mutex);
-                    }
-                    
-                    if (!command_already_running && curr_Command->Call_Function) {
-                        printd("Starting %s command.\r\n", curr_Command->Command_Name);
-                        
-                        /* Handle different command types */
-                        if (curr_Command->Command_Type == eConsole_Debug_Command) {
-                            /* Execute debug commands immediately and add to running list */
-                            curr_Command->Call_Function(curr_Command->Call_Params);
-                            Enqueue(console->Running_Repeat_Commands, curr_Command);
-                        }
-                        else if (curr_Command->Command_Type == eConsole_Full_Command) {
-                            /* Set up full commands to run in complete thread */
-                            UINT status = tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT);
-                            if (status == TX_SUCCESS) {
-                                console->Complete_Task = curr_Command->Call_Function;
-                                console->Complete_Params = curr_Command->Call_Params;
-                                console->Complete_Need_Update = true;
-                                tx_mutex_put(&console_mutex);
-                            }
-                        }
-                    }
-                    break;
+        /* Name is everything up to the first space; the rest is only used by Args_Function commands */
+        const char * args = strchr(command, ' ');
+        size_t name_len = args ? (size_t)(args - command) : strlen(command);
+        const tConsole_Command * curr_Command = Console_Find_Command(command, name_len);
+        uint8_t job_id = 0;
+
+        if (curr_Command == NULL) {
+            return;
+        }
+        switch (Console_Execute_Command(curr_Command, args, NULL, NULL, &job_id)) {
+            case eConsole_Exec_Already_Running:
+                printd("Command Already Running\r\n");
+                break;
+            case eConsole_Exec_No_Job_Slot:
+                printd("No free slot, try again later\r\n");
+                break;
+            case eConsole_Exec_Repeat_Started:
+                printd("Starting %s command.\r\n", curr_Command->Command_Name);
+                break;
+            case eConsole_Exec_Job_Queued:
+                /* Args_Function commands answer right away, only announce the ones that keep running */
+                if (curr_Command->Args_Function == NULL) {
+                    printd("Starting %s command. Job %u\r\n", curr_Command->Command_Name, job_id);
                 }
-            }
-            tx_mutex_put(commands_mutex);
+                break;
+            case eConsole_Exec_Bad_Args:
+                printd("Bad arguments\r\n");
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * @brief: Runs one command the way the console would. Shared by the text and binary front ends.
+ * Debug commands join the running set and are run by the debug thread. Full commands, Args_Function
+ * ones included, go to the worker pool, so nothing a command does holds up the thread receiving input.
+ *
+ * @params: Command to run, Args text after the name (NULL for none), Done / Done_Param completion
+ * hook of the job (optional, see Console_Submit_Job), Job_ID set when a job was queued
+ *
+ * @return: eConsole_Exec_Result
+ */
+eConsole_Exec_Result Console_Execute_Command(const tConsole_Command * Command, const char * Args,
+                                             tConsole_Job_Done Done, void * Done_Param, uint8_t * Job_ID)
+{
+    bool has_args = (Args != NULL && Args[strspn(Args, " ")] != '\0');
+
+    /* arguments given to a command that does not take any, or more than a job can hold */
+    if ((has_args && Command->Args_Function == NULL) || (Args != NULL && strlen(Args) >= CONSOLE_JOB_ARGS_SIZE)) {
+        return eConsole_Exec_Bad_Args;
+    }
+    if (Command->Call_Function == NULL && Command->Args_Function == NULL) {
+        return eConsole_Exec_Done;
+    }
+    /* Check if command is already running */
+    if (Console_Command_Running(Command) || Console_Find_Job(Command) != NULL) {
+        return eConsole_Exec_Already_Running;
+    }
+
+    /* Handle different command types */
+    if (Command->Command_Type == eConsole_Debug_Command && Command->Args_Function == NULL) {
+        /* Publish it to the running set - the debug thread runs it right away, then every Repeat_Time */
+        if (!Console_Running_Publish(eConsole_Running_Add, Command)) {
+            return eConsole_Exec_No_Job_Slot;
         }
+        return eConsole_Exec_Repeat_Started;
     }
+
+    /* Hand everything else to the worker pool */
+    tConsole_Job * job = Console_Submit_Job(Command, Args, Done, Done_Param);
+    if (job == NULL) {
+        return eConsole_Exec_No_Job_Slot;
+    }
+    if (Job_ID) {
+        *Job_ID = (uint8_t)(job - console->Jobs);
+    }
+    return eConsole_Exec_Job_Queued;
+}
+
+/**
+ * @brief: Command by id - static CONSOLE_COMMAND entries in link order first, then runtime-added
+ * commands in registration order. Ids stay stable until a command is added at runtime.
+ *
+ * @return: command, NULL when Index is past the end
+ */
+const tConsole_Command * Console_Get_Command(uint16_t Index)
+{
+    uint32_t static_count = (uint32_t)(__console_cmds_end - __console_cmds_start);
+    if (Index < static_count) {
+        return &__console_cmds_start[Index];
+    }
+    return (const tConsole_Command *)Queue_Peek(console->Console_Commands, Index - static_count);
+}
+
+/**
+ * @brief: UART the console runs on, for front ends that write to it directly
+ */
+tUART * Console_Get_UART(void)
+{
+    return console->UART_Handler;
 }
 
 static void Clear_Screen(void * unused)
@@ -754,6 +1193,7 @@ void Console_Pause_Commands(void)
     if (status == TX_SUCCESS) {
         console->Console_State = eConsole_Halting_Commands;
         tx_mutex_put(&console_mutex);
+        tx_event_flags_set(&console_events, CONSOLE_STATE_CHANGE_FLAG, TX_OR);
     }
 }
 
@@ -763,6 +1203,7 @@ void Console_Quit_Commands(void)
     if (status == TX_SUCCESS) {
         console->Console_State = eConsole_Quit_Commands;
         tx_mutex_put(&console_mutex);
+        tx_event_flags_set(&console_events, CONSOLE_STATE_CHANGE_FLAG, TX_OR);
     }
 }
 
@@ -772,12 +1213,231 @@ void Console_Resume_Commands(void)
     if (status == TX_SUCCESS) {
         console->Console_State = eConsole_Resume_Commands;
         tx_mutex_put(&console_mutex);
+        tx_event_flags_set(&console_events, CONSOLE_STATE_CHANGE_FLAG, TX_OR);
+    }
+}
+
+
+
+
+/**
+ * @brief: Queues a command to run on the worker pool.
+ *
+ * @params: Command to run. Its Args_Function (with Args, "" for NULL) or else its Call_Function runs
+ * once on whichever worker picks it up. Done (optional) is called with Done_Param on that worker once
+ * the job is over, also when it was stopped before it started, and before the slot is reused.
+ *
+ * @return: job handle, NULL if all CONSOLE_MAX_JOBS slots are in use or Args does not fit
+ */
+tConsole_Job * Console_Submit_Job(const tConsole_Command * Command, const char * Args,
+                                  tConsole_Job_Done Done, void * Done_Param)
+{
+    return Console_Queue_Job(Command, Args, NULL, NULL, Done, Done_Param);
+}
+
+static tConsole_Job * Console_Queue_Job(const tConsole_Command * command, const char * args, void (*hook)(void *),
+                                        void * hook_params, tConsole_Job_Done done, void * done_param)
+{
+    tConsole_Job * job = NULL;
+
+    if (args == NULL) {
+        args = "";
+    }
+    if (strlen(args) >= CONSOLE_JOB_ARGS_SIZE) {
+        return NULL;
+    }
+    if (tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT) != TX_SUCCESS) {
+        return NULL;
+    }
+    for (ULONG i = 0; i < CONSOLE_MAX_JOBS; i++) {
+        if (console->Jobs[i].State == eConsole_Job_Free) {
+            job = &console->Jobs[i];
+            job->Command = command;
+            job->Worker = NULL;
+            strcpy(job->Args, args);
+            job->Hook = hook;
+            job->Hook_Params = hook_params;
+            job->Done = done;
+            job->Done_Param = done_param;
+            job->State = eConsole_Job_Queued;
+            break;
+        }
+    }
+    tx_mutex_put(&console_mutex);
+
+    if (job != NULL) {
+        ULONG job_id = (ULONG)(job - console->Jobs);
+        /* Queue depth equals the slot count, so a free slot always has room in the queue */
+        if (tx_queue_send(&console_job_queue, &job_id, TX_NO_WAIT) != TX_SUCCESS) {
+            /* Hand the slot back under the lock allocation reads it under */
+            tx_mutex_get(&console_mutex, TX_WAIT_FOREVER);
+            job->Command = NULL;
+            job->Hook = NULL;
+            job->Done = NULL;
+            job->State = eConsole_Job_Free;
+            tx_mutex_put(&console_mutex);
+            LOG_ERROR(CONSOLE, "Job queue send failed\r\n");
+            return NULL;
+        }
+    }
+    return job;
+}
+
+/**
+ * @brief: Runs one of a command's halt/resume/stop hooks as a job, so user code never runs in the
+ * thread taking input. A hook must not be lost, so with every job slot taken it runs in the caller.
+ */
+static void Console_Run_Hook(const tConsole_Command * command, void (*hook)(void *), void * params)
+{
+    if (Console_Queue_Job(command, NULL, hook, params, NULL, NULL) == NULL) {
+        LOG_WARN(CONSOLE, "No job slot for a hook, running it inline\r\n");
+        hook(params);
+    }
+}
+
+/**
+ * @brief: Job the calling thread is running, for output that belongs to one request
+ *
+ * @return: job, NULL when not called from a worker running one
+ */
+tConsole_Job * Console_Current_Job(void)
+{
+    TX_THREAD * self = tx_thread_identify();
+
+    for (int i = 0; i < CONSOLE_MAX_JOBS; i++) {
+        if (console->Jobs[i].Worker == self && console->Jobs[i].State != eConsole_Job_Free) {
+            return &console->Jobs[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief: Pauses a running job through its command's Halt_Function. Jobs are cooperative - the
+ * command's own hooks decide what pausing means.
+ *
+ * @return: true if the job was running and has a Halt_Function
+ */
+bool Console_Job_Halt(tConsole_Job * Job)
+{
+    const tConsole_Command * command = NULL;
+
+    if (tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT) != TX_SUCCESS) {
+        return false;
+    }
+    if (Job->State == eConsole_Job_Running && Job->Command != NULL && Job->Command->Halt_Function != NULL) {
+        command = Job->Command;
+        Job->State = eConsole_Job_Paused;
+    }
+    tx_mutex_put(&console_mutex);
+
+    /* Hooks run as jobs, without the console mutex - they may print */
+    if (command != NULL) {
+        Console_Run_Hook(command, command->Halt_Function, command->Halt_Params);
+    }
+    return command != NULL;
+}
+
+bool Console_Job_Resume(tConsole_Job * Job)
+{
+    const tConsole_Command * command = NULL;
+
+    if (tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT) != TX_SUCCESS) {
+        return false;
+    }
+    if (Job->State == eConsole_Job_Paused && Job->Command != NULL) {
+        command = Job->Command;
+        Job->State = eConsole_Job_Running;
+    }
+    tx_mutex_put(&console_mutex);
+
+    if (command != NULL && command->Resume_Function) {
+        Console_Run_Hook(command, command->Resume_Function, command->Resume_Params);
+    }
+    return command != NULL;
+}
+
+/**
+ * @brief: Stops a job. A queued job is dropped before it starts; a running or paused job gets its
+ * Stop_Function and the slot frees itself when the Call_Function returns.
+ *
+ * @return: true if the job was queued, or running/paused with a Stop_Function
+ */
+bool Console_Job_Stop(tConsole_Job * Job)
+{
+    bool stopped = false;
+    const tConsole_Command * command = NULL;
+
+    if (tx_mutex_get(&console_mutex, CONSOLE_MUTEX_WAIT) != TX_SUCCESS) {
+        return false;
+    }
+    if (Job->State == eConsole_Job_Queued) {
+        Job->State = eConsole_Job_Stopping;     /* worker sees this and skips it */
+        stopped = true;
+    } else if ((Job->State == eConsole_Job_Running || Job->State == eConsole_Job_Paused) &&
+               Job->Command != NULL && Job->Command->Stop_Function != NULL) {
+        command = Job->Command;
+        Job->State = eConsole_Job_Stopping;
+        stopped = true;
+    }
+    tx_mutex_put(&console_mutex);
+
+    if (command != NULL) {
+        Console_Run_Hook(command, command->Stop_Function, command->Stop_Params);
+    }
+    return stopped;
+}
+
+static tConsole_Job * Console_Find_Job(const tConsole_Command * command)
+{
+    for (int i = 0; i < CONSOLE_MAX_JOBS; i++) {
+        /* hook jobs only borrow the command, they are not its job */
+        if (console->Jobs[i].State != eConsole_Job_Free && console->Jobs[i].Command == command &&
+            console->Jobs[i].Hook == NULL) {
+            return &console->Jobs[i];
+        }
     }
+    return NULL;
 }
 
-static void Null_Task(void * NULL_Ptr)
+/**
+ * @brief: "jobs" lists the job slots in use. "jobs <halt|resume|stop> <id>" controls one job.
+ */
+static void Console_Jobs_Command(const char * args)
 {
-    (void)NULL_Ptr;
-} 
+    static const char * const state_names[] = { "free", "queued", "running", "paused", "stopping" };
+    char op[8] = {0};
+    unsigned id;
 
+    while (*args == ' ') args++;
 
+    if (*args == '\0') {
+        for (int i = 0; i < CONSOLE_MAX_JOBS; i++) {
+            tConsole_Job * job = &console->Jobs[i];
+            const tConsole_Command * command = job->Command;
+            if (job->State != eConsole_Job_Free && command != NULL) {
+                printd("%d %-8s %s %s\r\n", i, state_names[job->State], command->Command_Name,
+                       job->Worker ? job->Worker->tx_thread_name : "-");
+            }
+        }
+        return;
+    }
+
+    if (sscanf(args, "%7s %u", op, &id) != 2 || id >= CONSOLE_MAX_JOBS) {
+        printd("usage: jobs [<halt|resume|stop> <id>]\r\n");
+        return;
+    }
+    tConsole_Job * job = &console->Jobs[id];
+    bool ok = false;
+    if (strcmp(op, "halt") == 0) {
+        ok = Console_Job_Halt(job);
+    } else if (strcmp(op, "resume") == 0) {
+        ok = Console_Job_Resume(job);
+    } else if (strcmp(op, "stop") == 0) {
+        ok = Console_Job_Stop(job);
+    } else {
+        printd("usage: jobs [<halt|resume|stop> <id>]\r\n");
+        return;
+    }
+    printd("Job %u: %s\r\n", id, ok ? "ok" : "not possible in this state");
+}
@@ -26,8 +26,23 @@ extern "C" {
 #define PRINTF_DELAY_TIME               100
 #define CONSOLE_RX_SEMAPHORE_WAIT       TX_WAIT_FOREVER
 #define CONSOLE_MUTEX_WAIT              100
-#define CONSOLE_COMMAND_READY_FLAG      0x01
-#define CONSOLE_THREAD_SLEEP_MS         100
+#define CONSOLE_DEBUG_CYCLE_TICKS       ((200 * TX_TIMER_TICKS_PER_SECOND) / 1000)   /* 200ms cycle for Repeat_Time == 0 commands */
+
+/* Full commands run as jobs on a pool of worker threads */
+#define CONSOLE_WORKER_COUNT            3
+#define CONSOLE_WORKER_PRIORITY         4
+#define CONSOLE_WORKER_STACK_SIZE       1024
+#define CONSOLE_MAX_JOBS                8       /* jobs queued or running at once */
+#define CONSOLE_JOB_ARGS_SIZE           64      /* argument text a job keeps for its Args_Function */
+
+/* Repeat (debug) commands */
+#define CONSOLE_MAX_RUNNING             8       /* repeat commands running at once */
+#define CONSOLE_RUNNING_VERSIONS        3       /* published set, one pinned by a slow reader, one being built */
+
+/* console_events flags */
+#define CONSOLE_RX_READY_FLAG           0x02    /* set from the UART RX interrupt */
+#define CONSOLE_STATE_CHANGE_FLAG       0x04    /* halt/resume/quit requested */
+#define CONSOLE_DEBUG_WAKE_FLAG         0x08    /* repeat command started or resumed */
 
 typedef enum{
     eConsole_Wait_For_Commands = 0,
@@ -45,8 +60,8 @@ typedef enum{
 
 typedef struct {
     eCommand_Type Command_Type;
-    char * Command_Name;
-    char * Description;
+    const char * Command_Name;
+    const char * Description;
     void (*Call_Function)(void *);
     void (*Halt_Function)(void *);
     void (*Resume_Function)(void *);
@@ -56,26 +71,109 @@ typedef struct {
     void * Resume_Params;
     void * Stop_Params;
     uint32_t Repeat_Time;
-    ULONG    Last_Run_Tick; /* tx_time_get() tick when command last ran; 0 = never */
+    /* Optional. When set the command also matches "<name> <args>" and this runs on the worker pool
+     * with the text after the name (may be empty or start with spaces) instead of Call_Function */
+    void (*Args_Function)(const char * Args);
 } tConsole_Command;
 
+/* One repeat command in a running set */
+typedef struct {
+    const tConsole_Command * Command;
+    bool Paused;
+} tConsole_Running_Entry;
+
+/* Set of running repeat commands. Read-mostly: a published set is never modified. Readers pin the
+ * published set (Readers) for as long as they look at it, without taking a lock. Writers copy it into a
+ * buffer nobody pins, edit the copy and publish it with Version + 1. Halt/resume/stop hooks and the
+ * command itself are only ever called by the debug thread, when it sees the new version. */
+typedef struct {
+    uint32_t Version;
+    uint8_t Count;
+    volatile uint8_t Readers;
+    tConsole_Running_Entry Entries[CONSOLE_MAX_RUNNING];
+} tConsole_Running_Set;
+
+typedef enum {
+    eConsole_Job_Free = 0,
+    eConsole_Job_Queued,
+    eConsole_Job_Running,
+    eConsole_Job_Paused,
+    eConsole_Job_Stopping,
+} eConsole_Job_State;
+
+/* Result of Console_Execute_Command */
+typedef enum {
+    eConsole_Exec_Done = 0,             /* nothing to run */
+    eConsole_Exec_Job_Queued,
+    eConsole_Exec_Repeat_Started,
+    eConsole_Exec_Already_Running,
+    eConsole_Exec_No_Job_Slot,          /* no free job or running slot */
+    eConsole_Exec_Bad_Args,             /* arguments given to a command without Args_Function, or too long */
+} eConsole_Exec_Result;
+
+/* Called by the worker once a job is over, Ran false if it was stopped before it started */
+typedef void (*tConsole_Job_Done)(void * Param, bool Ran);
+
+/* Handle of one command submitted to the worker pool. Index in tConsole.Jobs is the job id. */
+typedef struct {
+    const tConsole_Command * Command;
+    volatile eConsole_Job_State State;
+    TX_THREAD * Worker;             /* worker running it, NULL while queued */
+    char Args[CONSOLE_JOB_ARGS_SIZE];   /* for an Args_Function command */
+    void (*Hook)(void *);           /* set when the job runs one of Command's halt/resume/stop hooks */
+    void * Hook_Params;
+    tConsole_Job_Done Done;         /* optional, runs on the worker before the slot is freed */
+    void * Done_Param;
+} tConsole_Job;
+
+/**
+ * USAGE (static commands):
+ * CONSOLE_COMMAND("name", "description", Function);
+ * CONSOLE_COMMAND("name", "description", Function, .Call_Params = &my_data);
+ * CONSOLE_COMMAND("name", "description", Function, .Command_Type = eConsole_Debug_Command,
+ *                 .Stop_Function = My_Stop, .Repeat_Time = 500);
+ * CONSOLE_COMMAND("name", "description", NULL, .Args_Function = My_Args_Handler);
+ *
+ * Use at file scope, at most once per line. The descriptor is const and placed in the .console_cmds
+ * section (see the linker scripts), so it costs no RAM and no registration call at boot - the console
+ * walks __console_cmds_start..__console_cmds_end directly. Extra arguments are designated initializers
+ * for any other tConsole_Command field. Use Console_Add_Command / Thread_Console_Add_Debug_Command
+ * only for commands created at runtime.
+ */
+#define CONSOLE_CMD_CONCAT_(a, b)       a##b
+#define CONSOLE_CMD_CONCAT(a, b)        CONSOLE_CMD_CONCAT_(a, b)
+
+#define CONSOLE_COMMAND(name, desc, fn, ...)                                            \
+    static const tConsole_Command CONSOLE_CMD_CONCAT(Console_Static_Command_, __LINE__) \
+    __attribute__((used, section(".console_cmds"), aligned(4))) = {                    \
+        .Command_Type = eConsole_Full_Command,                                          \
+        .Command_Name = (name),                                                         \
+        .Description = (desc),                                                          \
+        .Call_Function = (fn),                                                          \
+        __VA_ARGS__                                                                     \
+    }
+
+/* Bounds of the static command table, provided by the linker script */
+extern const tConsole_Command __console_cmds_start[];
+extern const tConsole_Command __console_cmds_end[];
+
 typedef struct {
     tUART * UART_Handler;
     uint8_t RX_Buff[MAX_CONSOLE_BUFF_SIZE];
     uint32_t RX_Buff_Idx;
-    void (*Complete_Task)(void *);
-    void * Complete_Params;
-    bool Complete_Need_Update;
     eConsole_State Console_State;
     Queue * Console_Commands;
-    Queue * Running_Repeat_Commands;
+    tConsole_Running_Set Running_Sets[CONSOLE_RUNNING_VERSIONS];
+    tConsole_Running_Set * volatile Running;    /* published set */
+    tConsole_Job Jobs[CONSOLE_MAX_JOBS];
 } tConsole;
 
 /* ThreadX Objects */
 extern TX_THREAD rx_thread;
 extern TX_THREAD debug_thread;
-extern TX_THREAD complete_thread;
+extern TX_THREAD console_worker_threads[CONSOLE_WORKER_COUNT];
 extern TX_MUTEX console_mutex;
+extern TX_EVENT_FLAGS_GROUP console_events;
 
 /* Public Functions */
 void Thread_Console_Init(tUART * UART);
@@ -95,14 +193,25 @@ tConsole_Command * Thread_Console_Add_Debug_Command(const char *command_Name,
                                                 uint32_t repeat_time);
 
 void printd(const char* format, ...);
+void Console_Write(const char * Data, uint16_t Length);
 void Console_Pause_Commands(void);
 void Console_Resume_Commands(void);
 void Console_Quit_Commands(void);
+tConsole_Job * Console_Submit_Job(const tConsole_Command * Command, const char * Args,
+                                  tConsole_Job_Done Done, void * Done_Param);
+eConsole_Exec_Result Console_Execute_Command(const tConsole_Command * Command, const char * Args,
+                                             tConsole_Job_Done Done, void * Done_Param, uint8_t * Job_ID);
+tConsole_Job * Console_Current_Job(void);
+const tConsole_Command * Console_Get_Command(uint16_t Index);
+tUART * Console_Get_UART(void);
+bool Console_Job_Halt(tConsole_Job * Job);
+bool Console_Job_Resume(tConsole_Job * Job);
+bool Console_Job_Stop(tConsole_Job * Job);
 
 /* Thread Entry Functions */
 VOID RX_Thread_Entry(ULONG thread_input);
 VOID Debug_Thread_Entry(ULONG thread_input);
-VOID Complete_Thread_Entry(ULONG thread_input);
+VOID Console_Worker_Entry(ULONG thread_input);
 
 #ifdef __cplusplus
 }
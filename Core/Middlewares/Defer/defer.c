@@ -0,0 +1,221 @@
+/*
+ * defer.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <string.h>
+#include "defer.h"
+#include "main.h"
+#include "../Console/Thread_Console.h"
+#include "../Log/log.h"
+
+_Static_assert((DEFER_QUEUE_SIZE & (DEFER_QUEUE_SIZE - 1)) == 0, "DEFER_QUEUE_SIZE must be a power of two");
+
+/* Slot is free for position p when Seq == p, holds the item for p when Seq == p + 1 */
+typedef struct {
+    volatile uint32_t Seq;
+    tDefer_Function Function;
+    void * Arg;
+    uint32_t Data;
+    uint32_t Posted_Cycles;
+} tDefer_Item;
+
+static tDefer_Item defer_ring[DEFER_QUEUE_SIZE];
+static volatile uint32_t defer_head = 0;       /* next position to reserve, producers only */
+static uint32_t defer_tail = 0;                /* next position to run, DEFER thread only */
+static volatile bool defer_ring_ready = false;
+
+static TX_THREAD defer_thread;
+static UCHAR defer_thread_stack[DEFER_THREAD_STACK_SIZE];
+static TX_SEMAPHORE defer_semaphore;
+static volatile bool defer_thread_ready = false;
+static volatile bool defer_waiting = false;    /* DEFER thread is about to block, posts must wake it */
+
+static tDefer_Stats defer_stats;
+static volatile uint32_t defer_dropped = 0;
+
+static VOID Defer_Thread_Entry(ULONG thread_input);
+static void Defer_Ring_Init(void);
+static void Defer_Command(const char * args);
+
+CONSOLE_COMMAND("defer", "Deferred ISR work statistics: defer [reset]", NULL,
+                .Args_Function = Defer_Command);
+
+/**
+ * @brief: Creates the DEFER thread and its wake semaphore, and makes sure the DWT cycle counter runs
+ * for the latency timestamps.
+ *
+ * @params: None
+ *
+ * @return: false if the thread or semaphore could not be created
+ */
+bool Defer_Init(void)
+{
+    if (defer_thread_ready) {
+        return true;
+    }
+    Defer_Ring_Init();
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    if (tx_semaphore_create(&defer_semaphore, "DEFER_SEMAPHORE", 0) != TX_SUCCESS) {
+        return false;
+    }
+    if (tx_thread_create(&defer_thread, "DEFER", Defer_Thread_Entry, 0, defer_thread_stack,
+                         DEFER_THREAD_STACK_SIZE, DEFER_THREAD_PRIORITY, DEFER_THREAD_PRIORITY,
+                         TX_NO_TIME_SLICE, TX_AUTO_START) != TX_SUCCESS) {
+        tx_semaphore_delete(&defer_semaphore);
+        return false;
+    }
+    defer_thread_ready = true;
+    return true;
+}
+
+/**
+ * @brief: Queues Function(Arg, Data) to run on the DEFER thread. Safe from any interrupt priority and
+ * from threads. Only calls into the kernel when the DEFER thread is blocked waiting for work.
+ *
+ * @params: Function to run, Arg and Data passed to it
+ *
+ * @return: false if the ring was full - the item is dropped and counted
+ */
+bool Defer_Post(tDefer_Function Function, void * Arg, uint32_t Data)
+{
+    uint32_t pos;
+    tDefer_Item * item;
+
+    if (!defer_ring_ready) {
+        Defer_Ring_Init();
+    }
+
+    do {
+        pos = __LDREXW((uint32_t *)&defer_head);
+        item = &defer_ring[pos & (DEFER_QUEUE_SIZE - 1)];
+        if (item->Seq != pos) {
+            /* the slot still holds the item from one lap ago */
+            __CLREX();
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            defer_dropped++;
+            __set_PRIMASK(primask);
+            return false;
+        }
+    } while (__STREXW(pos + 1, (uint32_t *)&defer_head) != 0U);
+
+    item->Function = Function;
+    item->Arg = Arg;
+    item->Data = Data;
+    item->Posted_Cycles = DWT->CYCCNT;
+    __DMB();
+    item->Seq = pos + 1;
+
+    if (defer_waiting && defer_thread_ready) {
+        defer_waiting = false;
+        tx_semaphore_put(&defer_semaphore);
+    }
+    return true;
+}
+
+void Defer_Get_Stats(tDefer_Stats * Stats)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *Stats = defer_stats;
+    Stats->Dropped = defer_dropped;
+    __set_PRIMASK(primask);
+}
+
+void Defer_Reset_Stats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&defer_stats, 0, sizeof(defer_stats));
+    defer_dropped = 0;
+    __set_PRIMASK(primask);
+}
+
+/* Slot sequence numbers start at their own index. Runs once, from whichever comes first of
+ * Defer_Init and an early Defer_Post. */
+static void Defer_Ring_Init(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!defer_ring_ready) {
+        for (uint32_t i = 0; i < DEFER_QUEUE_SIZE; i++) {
+            defer_ring[i].Seq = i;
+        }
+        defer_ring_ready = true;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief: DEFER thread. Runs items strictly in post order. An item reserved but not yet published
+ * (its ISR was preempted mid-post) holds back the ones behind it until the ISR finishes.
+ */
+static VOID Defer_Thread_Entry(ULONG thread_input)
+{
+    (void)thread_input;
+
+    while (1) {
+        tDefer_Item * item = &defer_ring[defer_tail & (DEFER_QUEUE_SIZE - 1)];
+
+        if (item->Seq != defer_tail + 1) {
+            /* Announce the wait, then look again so a post that missed the flag is not slept through */
+            defer_waiting = true;
+            __DMB();
+            if (item->Seq != defer_tail + 1) {
+                tx_semaphore_get(&defer_semaphore, TX_WAIT_FOREVER);
+            }
+            defer_waiting = false;
+            continue;
+        }
+
+        tDefer_Function function = item->Function;
+        void * arg = item->Arg;
+        uint32_t data = item->Data;
+        uint32_t latency = DWT->CYCCNT - item->Posted_Cycles;
+        uint32_t pending = defer_head - defer_tail;
+
+        /* hand the slot back for the next lap before running, so a slow item does not shrink the ring */
+        item->Seq = defer_tail + DEFER_QUEUE_SIZE;
+        defer_tail++;
+
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        defer_stats.Executed++;
+        defer_stats.Last_Latency_Cycles = latency;
+        defer_stats.Total_Latency_Cycles += latency;
+        if (latency > defer_stats.Max_Latency_Cycles) defer_stats.Max_Latency_Cycles = latency;
+        if (pending > defer_stats.High_Water) defer_stats.High_Water = pending;
+        __set_PRIMASK(primask);
+
+        function(arg, data);
+    }
+}
+
+static void Defer_Command(const char * args)
+{
+    while (*args == ' ') args++;
+
+    if (strcmp(args, "reset") == 0) {
+        Defer_Reset_Stats();
+        printd("defer statistics cleared\r\n");
+        return;
+    } else if (*args != '\0') {
+        printd("usage: defer [reset]\r\n");
+        return;
+    }
+
+    tDefer_Stats stats;
+    Defer_Get_Stats(&stats);
+    uint32_t cycles_per_us = SystemCoreClock / 1000000U;
+    uint32_t average = stats.Executed ? (uint32_t)(stats.Total_Latency_Cycles / stats.Executed) : 0;
+    printd("executed %lu, dropped %lu, high-water %lu/%u\r\n", (unsigned long)stats.Executed,
+           (unsigned long)stats.Dropped, (unsigned long)stats.High_Water, DEFER_QUEUE_SIZE);
+    printd("latency us: last %lu, avg %lu, max %lu\r\n", (unsigned long)(stats.Last_Latency_Cycles / cycles_per_us),
+           (unsigned long)(average / cycles_per_us), (unsigned long)(stats.Max_Latency_Cycles / cycles_per_us));
+}
@@ -0,0 +1,57 @@
+/*
+ * defer.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef DEFER_DEFER_H_
+#define DEFER_DEFER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Deferred interrupt work (bottom halves). An ISR posts a function, a pointer and a word; the DEFER
+ * thread runs the items one at a time, in the order they were posted, at DEFER_THREAD_PRIORITY.
+ * 1) Defer_Init() once from rtos_objects_create. Items posted before that wait in the ring.
+ * 2) From an ISR (or a thread): Defer_Post(My_Work, handle, size). My_Work(handle, size) then runs in
+ *    thread context, so it may take mutexes, scan lists, log, and restart DMA.
+ * 3) Posting is lock-free (LDREX/STREX slot reservation, per-slot sequence numbers), so interrupts of
+ *    any priority may post concurrently and a post never waits. It only fails when all
+ *    DEFER_QUEUE_SIZE slots are pending; the failure is counted and Defer_Post returns false.
+ * 4) Every item is timestamped with the DWT cycle counter when posted. Console "defer" shows items
+ *    run, failed posts, queue high-water and post-to-start latency (last, average, max) in us.
+ *    "defer reset" clears the statistics.
+ */
+
+#define DEFER_QUEUE_SIZE                32      /* power of two */
+#define DEFER_THREAD_PRIORITY           0
+#define DEFER_THREAD_STACK_SIZE         1024
+
+typedef void (*tDefer_Function)(void * Arg, uint32_t Data);
+
+typedef struct {
+    uint32_t Executed;
+    uint32_t Dropped;                   /* posts refused because the ring was full */
+    uint32_t High_Water;                /* most items pending at once */
+    uint32_t Last_Latency_Cycles;
+    uint32_t Max_Latency_Cycles;
+    uint64_t Total_Latency_Cycles;
+} tDefer_Stats;
+
+bool Defer_Init(void);
+bool Defer_Post(tDefer_Function Function, void * Arg, uint32_t Data);
+void Defer_Get_Stats(tDefer_Stats * Stats);
+void Defer_Reset_Stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEFER_DEFER_H_ */
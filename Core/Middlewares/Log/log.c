@@ -0,0 +1,215 @@
+/*
+ * log.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "log.h"
+#include "../Console/Thread_Console.h"
+
+volatile uint8_t Log_Runtime_Level[eLog_Module_Count];
+
+/* Serializes log lines so two threads never interleave inside one line */
+static TX_MUTEX log_mutex;
+
+/* Indexed by eLog_Module - keep in the same order as the enum */
+static const char * const Log_Module_Names[eLog_Module_Count] = {
+    "uart", "i2c", "queue", "console", "app",
+};
+
+/* Compile-time level of each module, so the console can show what was compiled in */
+static const uint8_t Log_Compile_Levels[eLog_Module_Count] = {
+    LOG_COMPILE_LEVEL_UART,
+    LOG_COMPILE_LEVEL_I2C,
+    LOG_COMPILE_LEVEL_QUEUE,
+    LOG_COMPILE_LEVEL_CONSOLE,
+    LOG_COMPILE_LEVEL_APP,
+};
+
+/* Indexed by LOG_LEVEL_xxx */
+static const char * const Log_Level_Names[] = {
+    "none", "error", "warn", "info", "debug", "trace",
+};
+static const char Log_Level_Tags[] = { '-', 'E', 'W', 'I', 'D', 'T' };
+
+#define LOG_LEVEL_COUNT     (sizeof(Log_Level_Tags) / sizeof(Log_Level_Tags[0]))
+
+static int Log_Find_Name(const char * const * Names, uint32_t Count, const char * Name, size_t Name_Len);
+
+CONSOLE_COMMAND("log", "Show or set log levels: log [<module|all> <none|error|warn|info|debug|trace>]",
+                NULL, .Args_Function = Log_Console_Command);
+
+/**
+ * @brief: Sets every module to LOG_DEFAULT_RUNTIME_LEVEL, creates the log mutex and picks up the
+ * reset-persistent log ring. Lines logged before this runs are dropped.
+ *
+ * @params: None
+ *
+ * @return: None
+ */
+void Log_Init(void)
+{
+    for (uint32_t i = 0; i < eLog_Module_Count; i++) {
+        Log_Runtime_Level[i] = LOG_DEFAULT_RUNTIME_LEVEL;
+    }
+    tx_mutex_create(&log_mutex, "LOG_MUTEX", TX_INHERIT);
+    Log_Ring_Init();
+}
+
+/**
+ * @brief: Formats one line as "[L] module: message" and hands it to the console. Only reached when
+ * the LOG_ macro already passed the compile-time and runtime level checks. Calls from an ISR or
+ * fault handler are dropped here; at LOG_RING_LEVEL and below the LOG_ macro already put them in
+ * the log ring.
+ *
+ * @params: Level LOG_LEVEL_xxx, Module the line belongs to, printf style format and arguments
+ *
+ * @return: None
+ */
+void Log_Write(uint8_t Level, eLog_Module Module, const char * Format, ...)
+{
+    TX_THREAD * self;
+    bool locked = false;
+    char * line = NULL;
+    va_list args;
+
+    if (Level >= LOG_LEVEL_COUNT || Module >= eLog_Module_Count) {
+        return;
+    }
+
+    /* Handler mode first: in an ISR or fault handler tx_thread_identify returns the interrupted
+     * thread, and a waiting mutex get from there is not allowed */
+    if (__get_IPSR() != 0U) {
+        return;
+    }
+    self = tx_thread_identify();
+    if (self != NULL) {
+        /* Re-entered from inside the console write path (a queue or UART error raised while
+         * printing a log line). Drop it, otherwise the error recurses into itself. */
+        if (log_mutex.tx_mutex_owner == self) {
+            return;
+        }
+        if (tx_mutex_get(&log_mutex, LOG_MUTEX_WAIT) != TX_SUCCESS) {
+            return;
+        }
+        locked = true;
+    }
+
+    if (Safe_Block_Allocate(&tx_app_large_block_pool, (VOID **)&line, TX_NO_WAIT) == TX_SUCCESS) {
+        int prefix_len = snprintf(line, LOG_LINE_MAX_SIZE, "[%c] %s: ", Log_Level_Tags[Level], Log_Module_Names[Module]);
+        if (prefix_len > 0 && prefix_len < LOG_LINE_MAX_SIZE) {
+            va_start(args, Format);
+            vsnprintf(line + prefix_len, LOG_LINE_MAX_SIZE - prefix_len, Format, args);
+            va_end(args);
+            Console_Write(line, (uint16_t)strlen(line));
+        }
+        Safe_Block_Release(line);
+    }
+
+    if (locked) {
+        tx_mutex_put(&log_mutex);
+    }
+}
+
+/**
+ * @brief: Changes the runtime level of one module. Levels above the module's compile-time level are
+ * accepted but have no effect beyond the compile-time level, since those calls no longer exist.
+ *
+ * @params: Module to change, Level LOG_LEVEL_xxx
+ *
+ * @return: true if Module and Level were valid
+ */
+bool Log_Set_Level(eLog_Module Module, uint8_t Level)
+{
+    if (Module >= eLog_Module_Count || Level >= LOG_LEVEL_COUNT) {
+        return false;
+    }
+    Log_Runtime_Level[Module] = Level;
+    return true;
+}
+
+uint8_t Log_Get_Compile_Level(eLog_Module Module)
+{
+    return (Module < eLog_Module_Count) ? Log_Compile_Levels[Module] : LOG_LEVEL_NONE;
+}
+
+const char * Log_Get_Module_Name(eLog_Module Module)
+{
+    return (Module < eLog_Module_Count) ? Log_Module_Names[Module] : "?";
+}
+
+char Log_Get_Level_Tag(uint8_t Level)
+{
+    return (Level < LOG_LEVEL_COUNT) ? Log_Level_Tags[Level] : '?';
+}
+
+/**
+ * @brief: Console handler for "log [<module|all> <level>]". With no arguments prints the runtime
+ * and compile-time level of every module.
+ *
+ * @params: Args text after "log", may be empty or start with spaces
+ *
+ * @return: None
+ */
+void Log_Console_Command(const char * Args)
+{
+    while (*Args == ' ') Args++;
+
+    if (*Args == '\0') {
+        for (uint32_t i = 0; i < eLog_Module_Count; i++) {
+            printd("%-8s runtime=%-5s compiled=%s\r\n", Log_Module_Names[i],
+                   Log_Level_Names[Log_Runtime_Level[i]], Log_Level_Names[Log_Compile_Levels[i]]);
+        }
+        return;
+    }
+
+    const char * module_end = strchr(Args, ' ');
+    if (module_end == NULL) {
+        printd("usage: log <module|all> <none|error|warn|info|debug|trace>\r\n");
+        return;
+    }
+    const char * level_str = module_end;
+    while (*level_str == ' ') level_str++;
+
+    int level = Log_Find_Name(Log_Level_Names, LOG_LEVEL_COUNT, level_str, strlen(level_str));
+    if (level < 0) {
+        printd("Unknown log level: %s\r\n", level_str);
+        return;
+    }
+
+    size_t module_len = (size_t)(module_end - Args);
+    if (module_len == 3 && strncmp(Args, "all", 3) == 0) {
+        for (uint32_t i = 0; i < eLog_Module_Count; i++) {
+            Log_Set_Level((eLog_Module)i, (uint8_t)level);
+        }
+        printd("All modules set to %s\r\n", Log_Level_Names[level]);
+        return;
+    }
+
+    int module = Log_Find_Name(Log_Module_Names, eLog_Module_Count, Args, module_len);
+    if (module < 0) {
+        printd("Unknown log module\r\n");
+        return;
+    }
+    Log_Set_Level((eLog_Module)module, (uint8_t)level);
+    if (level > Log_Compile_Levels[module]) {
+        printd("%s set to %s (compiled up to %s only)\r\n", Log_Module_Names[module],
+               Log_Level_Names[level], Log_Level_Names[Log_Compile_Levels[module]]);
+    } else {
+        printd("%s set to %s\r\n", Log_Module_Names[module], Log_Level_Names[level]);
+    }
+}
+
+static int Log_Find_Name(const char * const * Names, uint32_t Count, const char * Name, size_t Name_Len)
+{
+    for (uint32_t i = 0; i < Count; i++) {
+        if (strlen(Names[i]) == Name_Len && strncmp(Names[i], Name, Name_Len) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,121 @@
+/*
+ * log.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef LOG_LOG_H_
+#define LOG_LOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * 1) Call Log_Init() once before any thread logs (Thread_Console_Init does this).
+ * 2) Log with LOG_ERROR/LOG_WARN/LOG_INFO/LOG_DEBUG/LOG_TRACE(MODULE, format, ...), where MODULE
+ *    is one of the eLog_Module names without the prefix, e.g. LOG_WARN(UART, "TX dropped\r\n").
+ * 3) A call below the module's compile-time level (LOG_COMPILE_LEVEL_<MODULE>) is a constant-false
+ *    branch and is removed by the compiler together with its format string. Override a module's
+ *    compile-time level with -DLOG_COMPILE_LEVEL_<MODULE>=LOG_LEVEL_xxx.
+ * 4) Calls that survive compilation are also filtered at runtime by Log_Runtime_Level[], settable
+ *    from the console with "log <module|all> <level>". "log" alone prints the current levels.
+ *    The runtime level can only narrow what was compiled in, never widen it.
+ * 5) Calls at or below LOG_RING_LEVEL are also recorded, unformatted and regardless of the runtime
+ *    level, in the reset-persistent ring of log_ring.h.
+ */
+
+/* Log levels. Lower is more severe. Used as both compile-time and runtime thresholds. */
+#define LOG_LEVEL_NONE                  0
+#define LOG_LEVEL_ERROR                 1
+#define LOG_LEVEL_WARN                  2
+#define LOG_LEVEL_INFO                  3
+#define LOG_LEVEL_DEBUG                 4
+#define LOG_LEVEL_TRACE                 5
+
+/* Default compile-time level for every module. Debug configuration (DEBUG defined by the IDE)
+ * keeps everything up to DEBUG, release keeps only errors and warnings. */
+#ifndef LOG_DEFAULT_COMPILE_LEVEL
+#ifdef DEBUG
+#define LOG_DEFAULT_COMPILE_LEVEL       LOG_LEVEL_DEBUG
+#else
+#define LOG_DEFAULT_COMPILE_LEVEL       LOG_LEVEL_WARN
+#endif
+#endif
+
+/* Per module compile-time levels */
+#ifndef LOG_COMPILE_LEVEL_UART
+#define LOG_COMPILE_LEVEL_UART          LOG_DEFAULT_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_I2C
+#define LOG_COMPILE_LEVEL_I2C           LOG_DEFAULT_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_QUEUE
+#define LOG_COMPILE_LEVEL_QUEUE         LOG_DEFAULT_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_CONSOLE
+#define LOG_COMPILE_LEVEL_CONSOLE       LOG_DEFAULT_COMPILE_LEVEL
+#endif
+#ifndef LOG_COMPILE_LEVEL_APP
+#define LOG_COMPILE_LEVEL_APP           LOG_DEFAULT_COMPILE_LEVEL
+#endif
+
+#include "log_ring.h"
+
+/* Runtime level every module starts at after Log_Init() */
+#define LOG_DEFAULT_RUNTIME_LEVEL       LOG_LEVEL_INFO
+/* Max formatted length of one log line including the level/module prefix */
+#define LOG_LINE_MAX_SIZE               TX_APP_LARGE_BLOCK_SIZE
+/* Wait for the log mutex; lines are dropped rather than blocking the caller longer */
+#define LOG_MUTEX_WAIT                  10
+
+typedef enum {
+    eLog_Module_UART = 0,
+    eLog_Module_I2C,
+    eLog_Module_QUEUE,
+    eLog_Module_CONSOLE,
+    eLog_Module_APP,
+    eLog_Module_Count
+} eLog_Module;
+
+/* Runtime level per module, indexed by eLog_Module. Read by every LOG_ macro - do not write
+ * directly, use Log_Set_Level(). */
+extern volatile uint8_t Log_Runtime_Level[eLog_Module_Count];
+
+#define LOG_AT(level, module, ...)                                                      \
+    do {                                                                                \
+        if ((level) <= LOG_COMPILE_LEVEL_##module) {                                    \
+            if ((level) <= LOG_RING_LEVEL) {                                            \
+                Log_Ring_Record((level), eLog_Module_##module,                          \
+                                LOG_RING_NARGS(__VA_ARGS__), __VA_ARGS__);              \
+            }                                                                           \
+            if ((level) <= Log_Runtime_Level[eLog_Module_##module]) {                   \
+                Log_Write((level), eLog_Module_##module, __VA_ARGS__);                  \
+            }                                                                           \
+        }                                                                               \
+    } while (0)
+
+#define LOG_ERROR(module, ...)          LOG_AT(LOG_LEVEL_ERROR, module, __VA_ARGS__)
+#define LOG_WARN(module, ...)           LOG_AT(LOG_LEVEL_WARN,  module, __VA_ARGS__)
+#define LOG_INFO(module, ...)           LOG_AT(LOG_LEVEL_INFO,  module, __VA_ARGS__)
+#define LOG_DEBUG(module, ...)          LOG_AT(LOG_LEVEL_DEBUG, module, __VA_ARGS__)
+#define LOG_TRACE(module, ...)          LOG_AT(LOG_LEVEL_TRACE, module, __VA_ARGS__)
+
+void Log_Init(void);
+void Log_Write(uint8_t Level, eLog_Module Module, const char * Format, ...);
+bool Log_Set_Level(eLog_Module Module, uint8_t Level);
+uint8_t Log_Get_Compile_Level(eLog_Module Module);
+const char * Log_Get_Module_Name(eLog_Module Module);
+char Log_Get_Level_Tag(uint8_t Level);
+void Log_Console_Command(const char * Args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_LOG_H_ */
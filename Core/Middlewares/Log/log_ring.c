@@ -0,0 +1,276 @@
+/*
+ * log_ring.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "log.h"
+#include "log_ring.h"
+#include "../CRC/crc.h"
+#include "../Console/Thread_Console.h"
+#include "../Console/Console_Sink.h"
+
+/* Commit word: (seq << 10) | (arg count << 8) | (module << 3) | level. 0 while a record is written. */
+#define LOG_RING_SEQ_SHIFT              10
+#define LOG_RING_SEQ_MASK               (0xFFFFFFFFUL >> LOG_RING_SEQ_SHIFT)
+#define LOG_RING_COMMIT(seq, argc, module, level) \
+    (((uint32_t)(seq) << LOG_RING_SEQ_SHIFT) | ((uint32_t)(argc) << 8) | (((uint32_t)(module) & 0x1F) << 3) | ((uint32_t)(level) & 0x07))
+
+/* RCC->CSR reset flags, bits 31..24: LPWR WWDG IWDG SFT BOR PIN OBL FW */
+#define LOG_RING_RESET_FLAGS_POS        24
+
+_Static_assert((LOG_RING_RECORDS & (LOG_RING_RECORDS - 1)) == 0, "LOG_RING_RECORDS must be a power of two");
+
+typedef struct {
+    volatile uint32_t Commit;
+    uint32_t Tick;
+    const char * Format;
+    uint32_t Args[LOG_RING_ARGS];
+} tLog_Ring_Record;
+
+typedef struct {
+    uint32_t Magic;
+    uint32_t Build;
+    uint32_t Record_Count;              /* LOG_RING_RECORDS, catches a resized ring */
+    uint32_t Boot_Seq;                  /* first sequence number of the current boot */
+    uint32_t Boot_Count;
+    uint16_t Crc;                       /* CRC16 over the fields above */
+    uint16_t Reserved;
+    volatile uint32_t Next_Seq;         /* not covered by the CRC, moves with every record */
+    tLog_Ring_Record Records[LOG_RING_RECORDS];
+} tLog_Ring;
+
+extern uint32_t _sidata;
+
+static tLog_Ring log_ring __attribute__((section(".noinit")));
+static volatile bool log_ring_ready = false;
+
+static void Log_Ring_Command(const char * args);
+static uint16_t Log_Ring_Header_Crc(void);
+static uint32_t Log_Ring_Build_Tag(void);
+static void Log_Ring_Print(uint32_t Seq, const tLog_Ring_Record * Record);
+
+CONSOLE_COMMAND("crashlog", "Log records kept across resets: crashlog [<count>|all|clear]", NULL,
+                .Args_Function = Log_Ring_Command);
+
+/**
+ * @brief: Validates the ring left over from before the reset, or clears it if it does not check
+ * out, starts a new boot in it and records the reset cause. Called from Log_Init.
+ *
+ * @params: None
+ *
+ * @return: None
+ */
+void Log_Ring_Init(void)
+{
+    bool valid = log_ring.Magic == LOG_RING_MAGIC &&
+                 log_ring.Record_Count == LOG_RING_RECORDS &&
+                 log_ring.Build == Log_Ring_Build_Tag() &&
+                 log_ring.Crc == Log_Ring_Header_Crc() &&
+                 (int32_t)(log_ring.Next_Seq - log_ring.Boot_Seq) >= 0;
+
+    if (!valid) {
+        memset(&log_ring, 0, sizeof(log_ring));
+        log_ring.Magic = LOG_RING_MAGIC;
+        log_ring.Record_Count = LOG_RING_RECORDS;
+        log_ring.Build = Log_Ring_Build_Tag();
+        log_ring.Next_Seq = 1;          /* a zero commit word always means "no record" */
+    }
+    log_ring.Boot_Seq = log_ring.Next_Seq;
+    log_ring.Boot_Count++;
+    log_ring.Crc = Log_Ring_Header_Crc();
+    log_ring_ready = true;
+
+    uint32_t reset_flags = RCC->CSR >> LOG_RING_RESET_FLAGS_POS;
+    __HAL_RCC_CLEAR_RESET_FLAGS();
+    if (valid) {
+        Log_Ring_Record(LOG_LEVEL_INFO, eLog_Module_APP, 2, "boot %lu, reset flags 0x%02lx\r\n",
+                        log_ring.Boot_Count, reset_flags);
+    } else {
+        Log_Ring_Record(LOG_LEVEL_INFO, eLog_Module_APP, 2, "boot %lu, reset flags 0x%02lx, ring was invalid\r\n",
+                        log_ring.Boot_Count, reset_flags);
+    }
+}
+
+/**
+ * @brief: Stores one record. Reached from the LOG_ macros; safe from threads and interrupts. The
+ * slot is reserved with LDREX/STREX, the commit word is cleared, the body stored, and the commit word
+ * written last - a record cut short by a reset keeps a zero commit and is skipped on dump.
+ *
+ * @params: Level LOG_LEVEL_xxx, Module eLog_Module, Arg_Count arguments after Format that were
+ * passed (LOG_RING_NARGS), Format string (must live in flash), arguments
+ *
+ * @return: None
+ */
+void Log_Ring_Record(uint8_t Level, uint8_t Module, uint8_t Arg_Count, const char * Format, ...)
+{
+    uint32_t seq;
+    va_list args;
+
+    if (!log_ring_ready) {
+        return;
+    }
+
+    do {
+        seq = __LDREXW((uint32_t *)&log_ring.Next_Seq);
+    } while (__STREXW(seq + 1, (uint32_t *)&log_ring.Next_Seq) != 0U);
+
+    tLog_Ring_Record * record = &log_ring.Records[seq & (LOG_RING_RECORDS - 1)];
+    record->Commit = 0;
+    record->Tick = tx_time_get();
+    record->Format = Format;
+    if (Arg_Count > LOG_RING_ARGS) {
+        Arg_Count = LOG_RING_ARGS;
+    }
+    va_start(args, Format);
+    for (uint8_t i = 0; i < Arg_Count; i++) {
+        record->Args[i] = va_arg(args, uint32_t);
+    }
+    va_end(args);
+    __DMB();
+    record->Commit = LOG_RING_COMMIT(seq, Arg_Count, Module, Level);
+}
+
+void Log_Ring_Clear(void)
+{
+    for (uint32_t i = 0; i < LOG_RING_RECORDS; i++) {
+        log_ring.Records[i].Commit = 0;
+    }
+}
+
+static uint16_t Log_Ring_Header_Crc(void)
+{
+    return CRC16_Compute((const uint8_t *)&log_ring, offsetof(tLog_Ring, Crc));
+}
+
+/* Changes with every build, so format pointers from another image are never followed */
+static uint32_t Log_Ring_Build_Tag(void)
+{
+    static const char build[] = __DATE__ " " __TIME__;
+    return ((uint32_t)&_sidata << 16) ^ CRC16_Compute((const uint8_t *)build, sizeof(build) - 1);
+}
+
+/**
+ * @brief: Console handler for "crashlog [<count>|all|clear]". Prints the newest count records
+ * (LOG_RING_DUMP_DEFAULT if not given) still held, oldest first, paced to the console sinks.
+ */
+static void Log_Ring_Command(const char * args)
+{
+    uint32_t count = LOG_RING_DUMP_DEFAULT;
+    unsigned long parsed;
+
+    while (*args == ' ') args++;
+
+    if (strcmp(args, "clear") == 0) {
+        Log_Ring_Clear();
+        printd("crashlog cleared\r\n");
+        return;
+    } else if (strcmp(args, "all") == 0) {
+        count = LOG_RING_RECORDS;
+    } else if (sscanf(args, "%lu", &parsed) == 1 && parsed > 0) {
+        count = (parsed < LOG_RING_RECORDS) ? (uint32_t)parsed : LOG_RING_RECORDS;
+    } else if (*args != '\0') {
+        printd("usage: crashlog [<count>|all|clear]\r\n");
+        return;
+    }
+
+    uint32_t next = log_ring.Next_Seq;
+    uint32_t seq = (next > count) ? next - count : 1;
+    printd("boot %lu, %lu records logged this boot\r\n", (unsigned long)log_ring.Boot_Count,
+           (unsigned long)(next - log_ring.Boot_Seq));
+    for (; seq != next; seq++) {
+        tLog_Ring_Record copy = log_ring.Records[seq & (LOG_RING_RECORDS - 1)];
+        /* skip empty, torn and since overwritten slots */
+        if ((copy.Commit >> LOG_RING_SEQ_SHIFT) != (seq & LOG_RING_SEQ_MASK) ||
+            copy.Commit != log_ring.Records[seq & (LOG_RING_RECORDS - 1)].Commit) {
+            continue;
+        }
+        if (!Console_Sink_Wait_Space(LOG_LINE_MAX_SIZE, CONSOLE_SINK_DUMP_TIMEOUT)) {
+            break;
+        }
+        Log_Ring_Print(seq, &copy);
+    }
+}
+
+/**
+ * @brief: Formats one record as "<[tick] L module: message". Integer and char conversions take the
+ * recorded words, anything else is shown as a placeholder.
+ */
+static void Log_Ring_Print(uint32_t Seq, const tLog_Ring_Record * Record)
+{
+    char line[LOG_LINE_MAX_SIZE];
+    char spec[12];
+    uint8_t level = Record->Commit & 0x07;
+    uint8_t module = (Record->Commit >> 3) & 0x1F;
+    uint8_t arg_count = (Record->Commit >> 8) & 0x03;
+    uint8_t arg = 0;
+    int pos;
+
+    if (module >= eLog_Module_Count || level > LOG_LEVEL_TRACE) {
+        return;
+    }
+    pos = snprintf(line, sizeof(line), "%c[%8lu] %c %s: ", (int32_t)(Seq - log_ring.Boot_Seq) < 0 ? '<' : ' ',
+                   (unsigned long)Record->Tick, Log_Get_Level_Tag(level), Log_Get_Module_Name((eLog_Module)module));
+
+    const char * f = Record->Format;
+    if ((uint32_t)f < FLASH_BASE || (uint32_t)f > FLASH_END) {
+        f = "<bad format>\r\n";
+    }
+
+    while (*f != '\0' && pos < (int)sizeof(line) - 1) {
+        if (*f != '%') {
+            line[pos++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            line[pos++] = '%';
+            f += 2;
+            continue;
+        }
+
+        /* copy the conversion without length modifiers - every recorded argument is one 32-bit word */
+        uint8_t spec_len = 0;
+        spec[spec_len++] = *f++;
+        while (*f != '\0' && strchr("-+ #0123456789.hljzt", *f) != NULL) {
+            if (strchr("hljzt", *f) == NULL && spec_len < sizeof(spec) - 2) {
+                spec[spec_len++] = *f;
+            }
+            f++;
+        }
+        char conversion = *f;
+        if (conversion != '\0') {
+            f++;
+        }
+
+        const char * text = NULL;
+        int written = 0;
+        if (arg >= arg_count) {
+            text = "<?>";
+        } else if (strchr("diouxXc", conversion) != NULL) {
+            spec[spec_len++] = conversion;
+            spec[spec_len] = '\0';
+            written = snprintf(&line[pos], sizeof(line) - pos, spec, (unsigned int)Record->Args[arg]);
+        } else if (conversion == 'p') {
+            written = snprintf(&line[pos], sizeof(line) - pos, "0x%08lx", (unsigned long)Record->Args[arg]);
+        } else {
+            text = (conversion == 's') ? "<str>" : "<?>";
+        }
+        arg++;
+        if (text != NULL) {
+            written = snprintf(&line[pos], sizeof(line) - pos, "%s", text);
+        }
+        if (written > 0) {
+            pos += written;
+        }
+    }
+    if (pos > (int)sizeof(line) - 1) {
+        pos = sizeof(line) - 1;
+    }
+    line[pos] = '\0';
+    Console_Write(line, (uint16_t)pos);
+}
@@ -0,0 +1,56 @@
+/*
+ * log_ring.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef LOG_LOG_RING_H_
+#define LOG_LOG_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Binary log ring that survives resets. It lives in the .noinit section (SRAM2, see
+ * STM32L476RGTX_FLASH.ld), which the startup code neither zeroes nor loads.
+ * 1) Every LOG_ call at or below LOG_RING_LEVEL is recorded here before the runtime level check,
+ *    including calls from interrupts. Nothing is formatted: a record is the tick, level, module, the
+ *    format string pointer and the first LOG_RING_ARGS arguments as raw 32-bit words, so a record
+ *    costs a slot reservation and a handful of stores.
+ * 2) Log_Ring_Init (from Log_Init) keeps the ring if its magic, header CRC and build tag match,
+ *    otherwise clears it, then records the reset cause. Records made before that are dropped.
+ * 3) Console "crashlog [<count>|all]" prints the newest records oldest first, formatted on the fly;
+ *    records from before the last reset are marked with '<'. "crashlog clear" empties the ring.
+ * Limitations: %s arguments are shown as <str> (the pointer is not followed), float/double
+ * arguments are not decoded. Reflashing a different image clears the ring, since format pointers
+ * would be stale. SRAM2 keeps its content across resets unless the SRAM2_RST option bit is cleared.
+ */
+
+#ifndef LOG_RING_LEVEL
+#define LOG_RING_LEVEL                  LOG_LEVEL_INFO
+#endif
+#define LOG_RING_RECORDS                256     /* 24 bytes each */
+#define LOG_RING_ARGS                   3
+#define LOG_RING_DUMP_DEFAULT           32      /* records printed by "crashlog" without a count */
+#define LOG_RING_MAGIC                  0x4C4F4752  /* "LOGR" */
+
+/* Number of arguments after the format, saturating at LOG_RING_ARGS. Lets Log_Ring_Record read
+ * only arguments that were actually passed. */
+#define LOG_RING_NARGS(...)             LOG_RING_NARGS_(__VA_ARGS__, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 2, 1, 0)
+#define LOG_RING_NARGS_(fmt, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, n, ...) n
+
+void Log_Ring_Init(void);
+void Log_Ring_Record(uint8_t Level, uint8_t Module, uint8_t Arg_Count, const char * Format, ...);
+void Log_Ring_Clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_LOG_RING_H_ */
@@ -0,0 +1,330 @@
+/*
+ * profile.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include "profile.h"
+#include "main.h"
+#include "tx_thread.h"
+#include "../Console/Thread_Console.h"
+
+#define PROFILE_NOW()                   ((EXECUTION_TIME_SOURCE_TYPE)DWT->CYCCNT)
+
+#define TOP_STOP_FLAG                   0x01
+
+/* Hook state. Only touched by the hooks and getters below, always with interrupts off. */
+static EXECUTION_TIME profile_idle_time = 0;
+static EXECUTION_TIME profile_isr_time = 0;
+static EXECUTION_TIME_SOURCE_TYPE profile_idle_start = 0;
+static EXECUTION_TIME_SOURCE_TYPE profile_isr_start = 0;
+static bool profile_idle = false;           /* no thread scheduled since the last thread exit */
+static ULONG profile_isr_nesting = 0;
+static TX_THREAD * profile_isr_preempted = NULL;   /* thread whose slice the outermost ISR paused */
+
+/* top state - one instance at a time, the console will not start a running command again */
+typedef struct {
+    TX_THREAD * Thread;
+    uint64_t Time;
+} tProfile_Sample;
+
+static tProfile_Sample top_samples[PROFILE_MAX_THREADS];
+static uint8_t top_sample_count = 0;
+static volatile bool top_running = false;
+static TX_EVENT_FLAGS_GROUP top_events;
+static bool top_events_created = false;
+
+/* Indexed by TX_THREAD tx_thread_state */
+static const char * const Profile_State_Names[] = {
+    "ready", "completed", "terminated", "suspended", "sleep", "queue", "semaphore",
+    "event", "block", "byte", "io", "file", "tcp_ip", "mutex", "prio_chg",
+};
+
+static void Profile_Top(void * unused);
+static void Profile_Top_Stop(void * unused);
+
+CONSOLE_COMMAND("top", "Per-thread CPU share, state, run count and stack high-water, until 'stop top'",
+                Profile_Top, .Stop_Function = Profile_Top_Stop);
+
+/**
+ * @brief: Called by ThreadX right before the scheduler starts. Enables the DWT cycle counter.
+ */
+VOID _tx_execution_initialize(VOID)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /* Nothing runs until the first thread is scheduled */
+    profile_idle = true;
+    profile_idle_start = PROFILE_NOW();
+}
+
+/**
+ * @brief: Called from PendSV when _tx_thread_current_ptr starts (or resumes) running.
+ */
+VOID _tx_execution_thread_enter(VOID)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    EXECUTION_TIME_SOURCE_TYPE now = PROFILE_NOW();
+    TX_THREAD * thread = _tx_thread_current_ptr;
+
+    if (profile_idle) {
+        profile_idle_time += (EXECUTION_TIME_SOURCE_TYPE)(now - profile_idle_start);
+        profile_idle = false;
+    }
+    if (thread != TX_NULL) {
+        thread->tx_thread_execution_time_last_start = now;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Called from PendSV before switching away from _tx_thread_current_ptr. The time until the
+ * next thread enters counts as idle. Also called from the idle loop with no current thread.
+ */
+VOID _tx_execution_thread_exit(VOID)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    EXECUTION_TIME_SOURCE_TYPE now = PROFILE_NOW();
+    TX_THREAD * thread = _tx_thread_current_ptr;
+
+    if (thread != TX_NULL) {
+        if (thread->tx_thread_execution_time_last_start != 0) {
+            thread->tx_thread_execution_time_total += (EXECUTION_TIME_SOURCE_TYPE)(now - thread->tx_thread_execution_time_last_start);
+            thread->tx_thread_execution_time_last_start = 0;
+        }
+        profile_idle = true;
+        profile_idle_start = now;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Called on entry of ISRs that take part in profiling. Pauses the thread or idle clock.
+ */
+VOID _tx_execution_isr_enter(VOID)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (profile_isr_nesting++ == 0) {
+        EXECUTION_TIME_SOURCE_TYPE now = PROFILE_NOW();
+        TX_THREAD * thread = _tx_thread_current_ptr;
+
+        profile_isr_preempted = NULL;
+        if (thread != TX_NULL && thread->tx_thread_execution_time_last_start != 0) {
+            thread->tx_thread_execution_time_total += (EXECUTION_TIME_SOURCE_TYPE)(now - thread->tx_thread_execution_time_last_start);
+            thread->tx_thread_execution_time_last_start = 0;
+            profile_isr_preempted = thread;
+        }
+        if (profile_idle) {
+            profile_idle_time += (EXECUTION_TIME_SOURCE_TYPE)(now - profile_idle_start);
+        }
+        profile_isr_start = now;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Called on exit of profiled ISRs. Restarts whichever clock the outermost ISR paused.
+ */
+VOID _tx_execution_isr_exit(VOID)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (profile_isr_nesting > 0 && --profile_isr_nesting == 0) {
+        EXECUTION_TIME_SOURCE_TYPE now = PROFILE_NOW();
+
+        profile_isr_time += (EXECUTION_TIME_SOURCE_TYPE)(now - profile_isr_start);
+        if (profile_isr_preempted != NULL) {
+            profile_isr_preempted->tx_thread_execution_time_last_start = now;
+            profile_isr_preempted = NULL;
+        }
+        if (profile_idle) {
+            profile_idle_start = now;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Total cycles Thread has run, including its current slice
+ *
+ * @params: Thread to read
+ *
+ * @return: cycles
+ */
+uint64_t Profile_Get_Thread_Time(TX_THREAD * Thread)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t total = Thread->tx_thread_execution_time_total;
+    if (Thread->tx_thread_execution_time_last_start != 0) {
+        total += (EXECUTION_TIME_SOURCE_TYPE)(PROFILE_NOW() - Thread->tx_thread_execution_time_last_start);
+    }
+    __set_PRIMASK(primask);
+    return total;
+}
+
+uint64_t Profile_Get_Idle_Time(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t total = profile_idle_time;
+    if (profile_idle && profile_isr_nesting == 0) {
+        total += (EXECUTION_TIME_SOURCE_TYPE)(PROFILE_NOW() - profile_idle_start);
+    }
+    __set_PRIMASK(primask);
+    return total;
+}
+
+uint64_t Profile_Get_ISR_Time(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t total = profile_isr_time;
+    if (profile_isr_nesting != 0) {
+        total += (EXECUTION_TIME_SOURCE_TYPE)(PROFILE_NOW() - profile_isr_start);
+    }
+    __set_PRIMASK(primask);
+    return total;
+}
+
+/* Tenths of a percent of Part in Whole, capped at 100.0 */
+static uint32_t Profile_Permille(uint64_t Part, uint64_t Whole)
+{
+    if (Whole == 0) {
+        return 0;
+    }
+    uint64_t permille = (Part * 1000) / Whole;
+    return (permille > 1000) ? 1000 : (uint32_t)permille;
+}
+
+/**
+ * @brief: Cycles Thread ran since the previous refresh. The first refresh after a thread appears
+ * has no baseline and returns false.
+ */
+static bool Profile_Top_Delta(TX_THREAD * Thread, uint64_t Time, uint64_t * Delta)
+{
+    for (uint8_t i = 0; i < top_sample_count; i++) {
+        if (top_samples[i].Thread == Thread) {
+            *Delta = Time - top_samples[i].Time;
+            top_samples[i].Time = Time;
+            return true;
+        }
+    }
+    if (top_sample_count < PROFILE_MAX_THREADS) {
+        top_samples[top_sample_count].Thread = Thread;
+        top_samples[top_sample_count].Time = Time;
+        top_sample_count++;
+    }
+    return false;
+}
+
+/**
+ * @brief: Prints one screen. Walks the created thread list from the calling thread, which is
+ * always in it.
+ */
+static void Profile_Top_Print(uint32_t Elapsed, uint64_t Idle_Delta, uint64_t ISR_Delta)
+{
+    TX_THREAD * start = tx_thread_identify();
+    TX_THREAD * thread = start;
+    uint32_t permille;
+
+    printd("\033[H\033[2J");
+    permille = Profile_Permille(Idle_Delta, Elapsed);
+    printd("top - idle %lu.%lu%%", (unsigned long)(permille / 10), (unsigned long)(permille % 10));
+    permille = Profile_Permille(ISR_Delta, Elapsed);
+    printd("  isr %lu.%lu%%  (%u ms)\r\n", (unsigned long)(permille / 10), (unsigned long)(permille % 10),
+           (unsigned)PROFILE_TOP_REFRESH_MS);
+    printd("NAME             PRI STATE        CPU%%     RUNS  STACK USED/SIZE\r\n");
+
+    do {
+        CHAR * name;
+        UINT state;
+        ULONG run_count;
+        UINT priority;
+        TX_THREAD * next;
+        uint64_t delta;
+
+        if (tx_thread_info_get(thread, &name, &state, &run_count, &priority, TX_NULL, TX_NULL, &next, TX_NULL) != TX_SUCCESS) {
+            break;
+        }
+
+        /* Refreshes tx_thread_stack_highest_ptr from the stack fill pattern */
+        _tx_thread_stack_analyze(thread);
+        ULONG stack_used = (ULONG)((UCHAR *)thread->tx_thread_stack_end - (UCHAR *)thread->tx_thread_stack_highest_ptr) + 1;
+        ULONG stack_size = thread->tx_thread_stack_size;
+        bool stack_warn = (stack_used * 100) >= (stack_size * PROFILE_STACK_WARN_PERCENT);
+        const char * state_name = (state < sizeof(Profile_State_Names) / sizeof(Profile_State_Names[0])) ?
+                                  Profile_State_Names[state] : "?";
+
+        printd("%-16.16s %3u %-10s ", name ? name : "", priority, state_name);
+        if (Profile_Top_Delta(thread, Profile_Get_Thread_Time(thread), &delta)) {
+            permille = Profile_Permille(delta, Elapsed);
+            printd("%3lu.%lu", (unsigned long)(permille / 10), (unsigned long)(permille % 10));
+        } else {
+            printd("    -");
+        }
+        printd(" %8lu  %5lu/%-5lu%s\r\n", (unsigned long)run_count, (unsigned long)stack_used,
+               (unsigned long)stack_size, stack_warn ? " !" : "");
+
+        thread = next;
+    } while (thread != NULL && thread != start);
+}
+
+/**
+ * @brief: "top" - runs on a console worker (its stack is large enough for the printing) and
+ * refreshes every PROFILE_TOP_REFRESH_MS until Profile_Top_Stop.
+ */
+static void Profile_Top(void * unused)
+{
+    (void)unused;
+    ULONG actual_flags;
+
+    if (!top_events_created) {
+        if (tx_event_flags_create(&top_events, "TOP_EVENTS") != TX_SUCCESS) {
+            printd("top: event flags create failed\r\n");
+            return;
+        }
+        top_events_created = true;
+    }
+    tx_event_flags_set(&top_events, (ULONG)~TOP_STOP_FLAG, TX_AND);
+
+    top_running = true;
+    top_sample_count = 0;
+
+    uint32_t last_cycles = PROFILE_NOW();
+    uint64_t last_idle = Profile_Get_Idle_Time();
+    uint64_t last_isr = Profile_Get_ISR_Time();
+
+    while (top_running) {
+        if (tx_event_flags_get(&top_events, TOP_STOP_FLAG, TX_OR_CLEAR, &actual_flags,
+                               (PROFILE_TOP_REFRESH_MS * TX_TIMER_TICKS_PER_SECOND) / 1000) == TX_SUCCESS) {
+            break;
+        }
+
+        uint32_t now_cycles = PROFILE_NOW();
+        uint64_t idle = Profile_Get_Idle_Time();
+        uint64_t isr = Profile_Get_ISR_Time();
+
+        Profile_Top_Print(now_cycles - last_cycles, idle - last_idle, isr - last_isr);
+
+        last_cycles = now_cycles;
+        last_idle = idle;
+        last_isr = isr;
+    }
+    top_running = false;
+}
+
+static void Profile_Top_Stop(void * unused)
+{
+    (void)unused;
+    top_running = false;
+    if (top_events_created) {
+        tx_event_flags_set(&top_events, TOP_STOP_FLAG, TX_OR);
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * profile.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef PROFILE_PROFILE_H_
+#define PROFILE_PROFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "threadx_includes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Per-thread CPU accounting from the ThreadX execution profile hooks (TX_EXECUTION_PROFILE_ENABLE),
+ * timed with the DWT cycle counter. All times are CPU cycles.
+ * 1) Profile_Get_Thread_Time(thread) - total time the thread has been running, including the
+ *    current slice if it is running now.
+ * 2) Profile_Get_Idle_Time() - time with no thread scheduled. Profile_Get_ISR_Time() - time in
+ *    interrupts that call _tx_execution_isr_enter/exit (only the ThreadX tick in this tree, other
+ *    ISRs are charged to the thread they interrupt).
+ * 3) Console "top" prints per-thread CPU share, priority, state or suspend reason, run count and
+ *    stack high-water every PROFILE_TOP_REFRESH_MS until "stop top". Rows whose stack use reached
+ *    PROFILE_STACK_WARN_PERCENT are marked with '!'.
+ * Slices longer than one DWT wrap (~53 s at 80 MHz) without a context switch or tick are undercounted.
+ */
+
+#define PROFILE_TOP_REFRESH_MS          1000
+#define PROFILE_MAX_THREADS             16      /* threads tracked by top */
+#define PROFILE_STACK_WARN_PERCENT      90
+
+uint64_t Profile_Get_Thread_Time(TX_THREAD * Thread);
+uint64_t Profile_Get_Idle_Time(void);
+uint64_t Profile_Get_ISR_Time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILE_PROFILE_H_ */
@@ -5,6 +5,7 @@
  */
 
  #include "queue.h"
+ #include "../Log/log.h"
 
  /* @brief: creates a dynamically allocated Node;
   *
@@ -15,7 +16,7 @@
  static Node *Create_Node(void *data) {
      Node *node = NULL;
      if (tx_block_allocate(&tx_app_block_pool, (VOID **)&node, TX_NO_WAIT) != TX_SUCCESS) {
-         printd("malloc error\r\n");
+         LOG_ERROR(QUEUE, "malloc error\r\n");
          return NULL;
      }
      node->Data = data;
@@ -36,11 +37,11 @@
      }
      if (node->Data != NULL) {
          if (tx_byte_release(node->Data) != TX_SUCCESS) {
-             printd("Failed to release memory\r\n");
+             LOG_WARN(QUEUE, "Failed to release memory\r\n");
          }
      }
      if (tx_block_release(node) != TX_SUCCESS) {
-         printd("Failed to release node memory\r\n");
+         LOG_WARN(QUEUE, "Failed to release node memory\r\n");
          return false;
      }
      return true;
@@ -56,14 +57,14 @@
  Queue *Prep_Queue(void) {
      Queue *que = NULL;
      if (tx_block_allocate(&tx_app_large_block_pool, (VOID **)&que, TX_NO_WAIT) != TX_SUCCESS) {
-         printd("Prep_Queue allocate error\r\n");
+         LOG_ERROR(QUEUE, "Prep_Queue allocate error\r\n");
          return NULL;
      }
      que->Head = NULL;
      que->Tail = NULL;
      que->Size = 0;
      if (tx_mutex_create(&que->Lock, "QueueLock", TX_INHERIT) != TX_SUCCESS) {
-         printd("Prep_Queue mutex_create error\r\n");
+         LOG_ERROR(QUEUE, "Prep_Queue mutex_create error\r\n");
          tx_block_release(que);
          return NULL;
      }
@@ -83,11 +84,11 @@
      }
      Node *node = Create_Node(data);
      if (node == NULL) {
-     	 printd("Enqueue malloc error\r\n"); 
+     	 LOG_ERROR(QUEUE, "Enqueue malloc error\r\n");
          return false;
      }
      if (tx_mutex_get(&que->Lock, TX_WAIT_FOREVER) != TX_SUCCESS) {
-         printd("Enqueue mutex_get error\r\n");
+         LOG_ERROR(QUEUE, "Enqueue mutex_get error\r\n");
          tx_block_release(node);
          return false;
      }
@@ -115,7 +116,7 @@
          return NULL;
      }
      if (tx_mutex_get(&que->Lock, TX_WAIT_FOREVER) != TX_SUCCESS) {
-         printd("Dequeue mutex_get error\r\n");
+         LOG_ERROR(QUEUE, "Dequeue mutex_get error\r\n");
          return NULL;
      }
      if (que->Size == 0) {
@@ -132,7 +133,7 @@
  
      /* Free only the node; data is returned to caller */
      if (tx_block_release(node) != TX_SUCCESS) {
-         printd("tx_byte_release error\r\n");
+         LOG_WARN(QUEUE, "tx_byte_release error\r\n");
      }
      return data;
  }
@@ -150,7 +151,7 @@
          return false;
      }
      if (tx_byte_release(data) != TX_SUCCESS) {
-         printd("tx_byte_release error\r\n");
+         LOG_WARN(QUEUE, "tx_byte_release error\r\n");
      }
      return true;
  }
@@ -179,11 +180,11 @@
          return NULL;
      }
      if (tx_mutex_get(&que->Lock, TX_WAIT_FOREVER) != TX_SUCCESS) {
-         printd("Queue_Node_Peek mutex_get error\r\n");
+         LOG_ERROR(QUEUE, "Queue_Node_Peek mutex_get error\r\n");
          return NULL;
      }
      if (index >= que->Size) {
-         printd("Queue_Node_Peek index out of range\r\n");
+         LOG_DEBUG(QUEUE, "Queue_Node_Peek index out of range\r\n");
          tx_mutex_put(&que->Lock);
          return NULL;
      }
@@ -211,13 +212,13 @@
      void *data;
      while ((data = Dequeue(que)) != NULL) {
          if (tx_byte_release(data) != TX_SUCCESS) {
-             printd("tx_byte_release error\r\n");
+             LOG_WARN(QUEUE, "tx_byte_release error\r\n");
          }
      }
      /* Delete the mutex and free the queue object */
      tx_mutex_delete(&que->Lock);
      if (tx_block_release(que) != TX_SUCCESS) {
-         printd("tx_byte_release error\r\n");
+         LOG_WARN(QUEUE, "tx_byte_release error\r\n");
      }
      return true;
  }
@@ -248,7 +249,7 @@ Node *Queue_Node_Peek_Unsafe(Queue *que, uint32_t index) {
         return NULL;
     }
     if (index >= que->Size) {
-        printd("Queue_Node_Peek_Unsafe index out of range\r\n");
+        LOG_DEBUG(QUEUE, "Queue_Node_Peek_Unsafe index out of range\r\n");
         return NULL;
     }
     Node *trav = que->Head;
@@ -0,0 +1,145 @@
+/*
+ * ring.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <string.h>
+#include "ring.h"
+
+/* The other side's counter: acquire, so the bytes it covers are read after it */
+#define RING_LOAD_ACQUIRE(counter)          __atomic_load_n(&(counter), __ATOMIC_ACQUIRE)
+/* Our own counter: release, so the bytes it covers are stored before it */
+#define RING_STORE_RELEASE(counter, value)  __atomic_store_n(&(counter), (value), __ATOMIC_RELEASE)
+
+/**
+ * @brief: Sets up an empty ring over Buffer.
+ *
+ * @params: Ring, Buffer, Size of Buffer in bytes, a power of two
+ *
+ * @return: false if Size is not a power of two
+ */
+bool Ring_Init(tRing * Ring, uint8_t * Buffer, uint32_t Size)
+{
+    if (Buffer == NULL || Size == 0 || (Size & (Size - 1)) != 0) {
+        return false;
+    }
+    Ring->Buffer = Buffer;
+    Ring->Size = Size;
+    Ring_Reset(Ring);
+    return true;
+}
+
+/* Empties the ring. Neither side may be using it. */
+void Ring_Reset(tRing * Ring)
+{
+    Ring->Head = 0;
+    Ring->Tail = 0;
+}
+
+/**
+ * @brief: Producer. Copies as much of Data as fits and publishes it.
+ *
+ * @params: Ring, Data, Length in bytes
+ *
+ * @return: bytes written, less than Length if the ring filled up
+ */
+uint32_t Ring_Write(tRing * Ring, const uint8_t * Data, uint32_t Length)
+{
+    uint32_t head = Ring->Head;
+    uint32_t space = Ring->Size - (head - RING_LOAD_ACQUIRE(Ring->Tail));
+
+    if (Length > space) {
+        Length = space;
+    }
+    Ring_Copy_In(Ring, head, Data, Length);
+    RING_STORE_RELEASE(Ring->Head, head + Length);
+    return Length;
+}
+
+/**
+ * @brief: Consumer. Copies up to Length queued bytes to Data and frees their space.
+ *
+ * @params: Ring, Data, Length in bytes
+ *
+ * @return: bytes read, 0 if the ring is empty
+ */
+uint32_t Ring_Read(tRing * Ring, uint8_t * Data, uint32_t Length)
+{
+    uint32_t tail = Ring->Tail;
+    uint32_t used = RING_LOAD_ACQUIRE(Ring->Head) - tail;
+
+    if (Length > used) {
+        Length = used;
+    }
+    Ring_Copy_Out(Ring, tail, Data, Length);
+    RING_STORE_RELEASE(Ring->Tail, tail + Length);
+    return Length;
+}
+
+/**
+ * @brief: Producer, zero copy. Points Data at the free space after Head and returns how much of it
+ * is contiguous. Fill it, then Ring_Commit the bytes written.
+ */
+uint32_t Ring_Write_Space(tRing * Ring, uint8_t ** Data)
+{
+    uint32_t head = Ring->Head;
+    uint32_t space = Ring->Size - (head - RING_LOAD_ACQUIRE(Ring->Tail));
+    uint32_t offset = head & (Ring->Size - 1);
+    uint32_t contiguous = Ring->Size - offset;
+
+    *Data = &Ring->Buffer[offset];
+    return (space < contiguous) ? space : contiguous;
+}
+
+void Ring_Commit(tRing * Ring, uint32_t Length)
+{
+    RING_STORE_RELEASE(Ring->Head, Ring->Head + Length);
+}
+
+/**
+ * @brief: Consumer, zero copy. Points Data at the oldest queued byte and returns how many follow it
+ * without wrapping. Use them, then Ring_Consume; call again for the part after the wrap.
+ */
+uint32_t Ring_Peek(tRing * Ring, const uint8_t ** Data)
+{
+    uint32_t tail = Ring->Tail;
+    uint32_t used = RING_LOAD_ACQUIRE(Ring->Head) - tail;
+    uint32_t offset = tail & (Ring->Size - 1);
+    uint32_t contiguous = Ring->Size - offset;
+
+    *Data = &Ring->Buffer[offset];
+    return (used < contiguous) ? used : contiguous;
+}
+
+void Ring_Consume(tRing * Ring, uint32_t Length)
+{
+    RING_STORE_RELEASE(Ring->Tail, Ring->Tail + Length);
+}
+
+/* Raw copy of Length (at most Size) bytes into the ring at free-running Position. No counters move. */
+void Ring_Copy_In(tRing * Ring, uint32_t Position, const uint8_t * Data, uint32_t Length)
+{
+    uint32_t offset = Position & (Ring->Size - 1);
+    uint32_t first = Ring->Size - offset;
+
+    if (first > Length) {
+        first = Length;
+    }
+    memcpy(&Ring->Buffer[offset], Data, first);
+    memcpy(Ring->Buffer, Data + first, Length - first);
+}
+
+/* Raw copy of Length (at most Size) bytes out of the ring from free-running Position. No counters move. */
+void Ring_Copy_Out(const tRing * Ring, uint32_t Position, uint8_t * Data, uint32_t Length)
+{
+    uint32_t offset = Position & (Ring->Size - 1);
+    uint32_t first = Ring->Size - offset;
+
+    if (first > Length) {
+        first = Length;
+    }
+    memcpy(Data, &Ring->Buffer[offset], first);
+    memcpy(Data + first, Ring->Buffer, Length - first);
+}
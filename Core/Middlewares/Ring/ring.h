@@ -0,0 +1,69 @@
+/*
+ * ring.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef RING_RING_H_
+#define RING_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Byte ring over a caller-owned, power-of-two sized buffer. Head and Tail are free-running byte
+ * counters: Head - Tail is the fill level (0 empty, Size full - the two never look alike), the
+ * buffer index is the counter masked with Size - 1, and no % or wrap branches are needed.
+ * 1) Ring_Init(&ring, buffer, sizeof(buffer)) - false if the size is not a power of two.
+ * 2) Single producer / single consumer without locks:
+ *      producer: Ring_Write, or Ring_Write_Space + fill + Ring_Commit (zero copy)
+ *      consumer: Ring_Read, or Ring_Peek + use + Ring_Consume (zero copy)
+ *    Only the producer stores Head and only the consumer stores Tail. Each side loads the other's
+ *    counter with acquire and publishes its own with release, so the bytes are in memory before the
+ *    counter that hands them over (a DMB on the Cortex-M4). Either side may be an ISR.
+ * 3) Bulk copies are at most two memcpy calls, split at the end of the buffer.
+ * 4) Owners that need more than SPSC (several producers, a producer that drops old bytes) take their
+ *    own lock and use Ring_Copy_In / Ring_Copy_Out at explicit positions - see Console_Sink.c.
+ * Nothing here depends on the HAL or ThreadX, so the file builds and runs on a host (ring_test.c). Console
+ * "ring bench" (ring_bench.c) measures throughput on the target.
+ */
+
+typedef struct {
+    uint8_t * Buffer;
+    uint32_t Size;                      /* power of two */
+    volatile uint32_t Head;             /* free running, bytes ever written - producer only */
+    volatile uint32_t Tail;             /* free running, bytes ever read - consumer only */
+} tRing;
+
+bool Ring_Init(tRing * Ring, uint8_t * Buffer, uint32_t Size);
+void Ring_Reset(tRing * Ring);
+uint32_t Ring_Write(tRing * Ring, const uint8_t * Data, uint32_t Length);
+uint32_t Ring_Read(tRing * Ring, uint8_t * Data, uint32_t Length);
+uint32_t Ring_Write_Space(tRing * Ring, uint8_t ** Data);
+void Ring_Commit(tRing * Ring, uint32_t Length);
+uint32_t Ring_Peek(tRing * Ring, const uint8_t ** Data);
+void Ring_Consume(tRing * Ring, uint32_t Length);
+void Ring_Copy_In(tRing * Ring, uint32_t Position, const uint8_t * Data, uint32_t Length);
+void Ring_Copy_Out(const tRing * Ring, uint32_t Position, uint8_t * Data, uint32_t Length);
+
+static inline uint32_t Ring_Used(const tRing * Ring)
+{
+    return Ring->Head - Ring->Tail;
+}
+
+static inline uint32_t Ring_Free(const tRing * Ring)
+{
+    return Ring->Size - (Ring->Head - Ring->Tail);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RING_RING_H_ */
@@ -0,0 +1,76 @@
+/*
+ * ring_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "ring.h"
+#include "main.h"
+#include "../Console/Thread_Console.h"
+
+/* Target-only companion of ring.c, which stays free of HAL and console dependencies */
+
+#define RING_BENCH_RING_SIZE            1024
+#define RING_BENCH_BYTES                (64 * 1024)
+static const uint16_t ring_bench_chunks[] = { 1, 16, 64, 256 };
+
+static void Ring_Bench_Command(const char * args);
+
+CONSOLE_COMMAND("ring", "Ring buffer throughput: ring bench", NULL, .Args_Function = Ring_Bench_Command);
+
+/**
+ * @brief: Pushes RING_BENCH_BYTES through a RING_BENCH_RING_SIZE ring, writing and reading in
+ * chunks of each size, and prints cycles per byte and throughput. Interrupts stay on, so run it
+ * on an idle console for repeatable numbers.
+ */
+static void Ring_Bench(void)
+{
+    uint8_t * storage = malloc(RING_BENCH_RING_SIZE);
+    uint8_t * chunk = malloc(256);
+    tRing ring;
+
+    if (storage == NULL || chunk == NULL || !Ring_Init(&ring, storage, RING_BENCH_RING_SIZE)) {
+        printd("ring bench: malloc failed\r\n");
+        free(storage);
+        free(chunk);
+        return;
+    }
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    memset(chunk, 0x5A, 256);
+
+    printd("chunk  cycles/byte  KB/s\r\n");
+    for (uint32_t i = 0; i < sizeof(ring_bench_chunks) / sizeof(ring_bench_chunks[0]); i++) {
+        uint16_t size = ring_bench_chunks[i];
+        uint32_t moved = 0;
+
+        Ring_Reset(&ring);
+        uint32_t start = DWT->CYCCNT;
+        while (moved < RING_BENCH_BYTES) {
+            Ring_Write(&ring, chunk, size);
+            moved += Ring_Read(&ring, chunk, size);
+        }
+        uint32_t cycles = DWT->CYCCNT - start;
+
+        uint32_t per_byte_x100 = (uint32_t)(((uint64_t)cycles * 100U) / moved);
+        uint32_t kb_per_s = (uint32_t)(((uint64_t)moved * SystemCoreClock) / cycles / 1024U);
+        printd("%5u  %7lu.%02lu  %lu\r\n", size, (unsigned long)(per_byte_x100 / 100U),
+               (unsigned long)(per_byte_x100 % 100U), (unsigned long)kb_per_s);
+    }
+    free(storage);
+    free(chunk);
+}
+
+static void Ring_Bench_Command(const char * args)
+{
+    while (*args == ' ') args++;
+
+    if (strcmp(args, "bench") == 0) {
+        Ring_Bench();
+    } else {
+        printd("usage: ring bench\r\n");
+    }
+}
@@ -0,0 +1,209 @@
+/*
+ * ring_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ *
+ * Host test of tRing:
+ *   gcc -std=gnu11 -DRING_TEST_DEBUG Core/Middlewares/Ring/ring.c Core/Middlewares/Ring/ring_test.c \
+ *       -o ring_test && ./ring_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef RING_TEST_DEBUG
+
+#include "ring.h"
+
+#define TEST_RING_SIZE      16
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static void Fill(uint8_t * Buffer, uint32_t Length, uint8_t Seed)
+{
+    for (uint32_t i = 0; i < Length; i++) {
+        Buffer[i] = (uint8_t)(Seed + i);
+    }
+}
+
+/* Only powers of two are accepted */
+static void Test_Init(void)
+{
+    uint8_t buffer[TEST_RING_SIZE];
+    tRing ring;
+
+    CHECK(!Ring_Init(&ring, buffer, 0));
+    CHECK(!Ring_Init(&ring, buffer, 12));
+    CHECK(!Ring_Init(&ring, NULL, TEST_RING_SIZE));
+    CHECK(Ring_Init(&ring, buffer, TEST_RING_SIZE));
+    CHECK(Ring_Used(&ring) == 0 && Ring_Free(&ring) == TEST_RING_SIZE);
+}
+
+/* Bytes come out in order as the counters run past the end of the buffer many times */
+static void Test_Wrap_Around(void)
+{
+    uint8_t buffer[TEST_RING_SIZE];
+    uint8_t in[5], out[5];
+    tRing ring;
+    uint8_t seed = 0;
+
+    Ring_Init(&ring, buffer, TEST_RING_SIZE);
+    for (int i = 0; i < 100; i++) {
+        Fill(in, sizeof(in), seed);
+        CHECK(Ring_Write(&ring, in, sizeof(in)) == sizeof(in));
+        memset(out, 0, sizeof(out));
+        CHECK(Ring_Read(&ring, out, sizeof(out)) == sizeof(out));
+        CHECK(memcmp(in, out, sizeof(in)) == 0);
+        seed += sizeof(in);
+    }
+    /* 500 bytes through a 16 byte ring: the index is the counter masked, not the counter */
+    CHECK(ring.Head == 500 && ring.Tail == 500);
+    CHECK((ring.Head & (TEST_RING_SIZE - 1)) == 500 % TEST_RING_SIZE);
+    CHECK(Ring_Used(&ring) == 0);
+}
+
+/* Head - Tail tells full from empty even though both leave the same buffer index */
+static void Test_Full_Empty(void)
+{
+    uint8_t buffer[TEST_RING_SIZE];
+    uint8_t in[TEST_RING_SIZE + 4], out[TEST_RING_SIZE];
+    tRing ring;
+
+    Ring_Init(&ring, buffer, TEST_RING_SIZE);
+    Fill(in, sizeof(in), 1);
+
+    CHECK(Ring_Read(&ring, out, 1) == 0);
+    CHECK(Ring_Write(&ring, in, sizeof(in)) == TEST_RING_SIZE);
+    CHECK(Ring_Used(&ring) == TEST_RING_SIZE && Ring_Free(&ring) == 0);
+    CHECK((ring.Head & (TEST_RING_SIZE - 1)) == (ring.Tail & (TEST_RING_SIZE - 1)));
+    CHECK(Ring_Write(&ring, in, 1) == 0);
+
+    CHECK(Ring_Read(&ring, out, sizeof(out)) == TEST_RING_SIZE);
+    CHECK(memcmp(in, out, TEST_RING_SIZE) == 0);
+    CHECK(Ring_Used(&ring) == 0 && Ring_Free(&ring) == TEST_RING_SIZE);
+    CHECK(ring.Head == ring.Tail && ring.Head == TEST_RING_SIZE);
+}
+
+/* The counters wrap past UINT32_MAX; the differences, and so the fill level, stay right */
+static void Test_Counter_Overflow(void)
+{
+    uint8_t buffer[TEST_RING_SIZE];
+    uint8_t in[10], out[10];
+    tRing ring;
+
+    Ring_Init(&ring, buffer, TEST_RING_SIZE);
+    ring.Head = UINT32_MAX - 3;
+    ring.Tail = UINT32_MAX - 3;
+
+    Fill(in, sizeof(in), 40);
+    CHECK(Ring_Write(&ring, in, sizeof(in)) == sizeof(in));
+    CHECK(ring.Head == 6);                      /* wrapped */
+    CHECK(Ring_Used(&ring) == sizeof(in));
+    CHECK(Ring_Free(&ring) == TEST_RING_SIZE - sizeof(in));
+
+    /* more than fits: only the free space is taken */
+    CHECK(Ring_Write(&ring, in, sizeof(in)) == TEST_RING_SIZE - sizeof(in));
+    CHECK(Ring_Free(&ring) == 0);
+
+    CHECK(Ring_Read(&ring, out, sizeof(out)) == sizeof(out));
+    CHECK(memcmp(in, out, sizeof(in)) == 0);
+    CHECK(ring.Tail == 6);
+    CHECK(Ring_Used(&ring) == TEST_RING_SIZE - sizeof(in));
+}
+
+/* Ring_Copy_In / Ring_Copy_Out split a copy across the end of the buffer */
+static void Test_Copy_Split(void)
+{
+    uint8_t buffer[TEST_RING_SIZE];
+    uint8_t in[TEST_RING_SIZE], out[TEST_RING_SIZE];
+    tRing ring;
+
+    Ring_Init(&ring, buffer, TEST_RING_SIZE);
+    memset(buffer, 0, sizeof(buffer));
+    Fill(in, sizeof(in), 100);
+
+    /* 10 bytes from index 12: 4 at the end, 6 at the start */
+    Ring_Copy_In(&ring, 12, in, 10);
+    CHECK(memcmp(&buffer[12], in, 4) == 0);
+    CHECK(memcmp(&buffer[0], in + 4, 6) == 0);
+    CHECK(buffer[6] == 0 && buffer[11] == 0);
+
+    memset(out, 0, sizeof(out));
+    Ring_Copy_Out(&ring, 12, out, 10);
+    CHECK(memcmp(out, in, 10) == 0);
+
+    /* the same from a position many laps on, and past UINT32_MAX */
+    memset(out, 0, sizeof(out));
+    Ring_Copy_Out(&ring, 12 + 7 * TEST_RING_SIZE, out, 10);
+    CHECK(memcmp(out, in, 10) == 0);
+    memset(buffer, 0, sizeof(buffer));
+    Ring_Copy_In(&ring, UINT32_MAX - 3, in, 10);    /* index 12 */
+    memset(out, 0, sizeof(out));
+    Ring_Copy_Out(&ring, 12, out, 10);
+    CHECK(memcmp(out, in, 10) == 0);
+
+    /* a whole ring from the middle */
+    Ring_Copy_In(&ring, 5, in, TEST_RING_SIZE);
+    Ring_Copy_Out(&ring, 5, out, TEST_RING_SIZE);
+    CHECK(memcmp(out, in, TEST_RING_SIZE) == 0);
+
+    /* nothing at all */
+    Ring_Copy_In(&ring, 3, in, 0);
+    Ring_Copy_Out(&ring, 3, out, 0);
+}
+
+/* Zero-copy access hands out the part before the wrap, then the rest */
+static void Test_Zero_Copy(void)
+{
+    uint8_t buffer[TEST_RING_SIZE];
+    uint8_t in[TEST_RING_SIZE], out[TEST_RING_SIZE];
+    uint8_t * space;
+    const uint8_t * data;
+    tRing ring;
+
+    Ring_Init(&ring, buffer, TEST_RING_SIZE);
+    Fill(in, sizeof(in), 7);
+    ring.Head = ring.Tail = 10;
+
+    CHECK(Ring_Write_Space(&ring, &space) == TEST_RING_SIZE - 10);
+    CHECK(space == &buffer[10]);
+    memcpy(space, in, 6);
+    Ring_Commit(&ring, 6);
+    CHECK(Ring_Write_Space(&ring, &space) == 10);
+    CHECK(space == &buffer[0]);
+    memcpy(space, in + 6, 4);
+    Ring_Commit(&ring, 4);
+
+    CHECK(Ring_Peek(&ring, &data) == 6);
+    CHECK(data == &buffer[10]);
+    memcpy(out, data, 6);
+    Ring_Consume(&ring, 6);
+    CHECK(Ring_Peek(&ring, &data) == 4);
+    memcpy(out + 6, data, 4);
+    Ring_Consume(&ring, 4);
+    CHECK(memcmp(out, in, 10) == 0);
+    CHECK(Ring_Peek(&ring, &data) == 0);
+}
+
+int main(void)
+{
+    Test_Init();
+    Test_Wrap_Around();
+    Test_Full_Empty();
+    Test_Counter_Overflow();
+    Test_Copy_Split();
+    Test_Zero_Copy();
+
+    printf("%s: %d failure(s)\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * txn.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include "txn.h"
+#include "main.h"
+
+static void Txn_Free(tTxn * Txn);
+
+bool Txn_Set_Init(tTxn_Set * Set, CHAR * Name)
+{
+    if (tx_event_flags_create(&Set->Flags, Name) != TX_SUCCESS) {
+        return false;
+    }
+    Set->Used = 0;
+    for (uint32_t i = 0; i < TXN_SET_SIZE; i++) {
+        Set->Txns[i].Set = Set;
+        Set->Txns[i].Bit = 1UL << i;
+        Set->Txns[i].Status = eTxn_Pending;
+        Set->Txns[i].Orphaned = false;
+    }
+    return true;
+}
+
+/**
+ * @brief: Driver side: takes a free handle of Set for a transfer about to be queued. Its flag is
+ * cleared, so a wait sleeps until Txn_Complete.
+ *
+ * @params: Set of the thread that will wait
+ *
+ * @return: the handle, NULL if all TXN_SET_SIZE are in use
+ */
+tTxn * Txn_Open(tTxn_Set * Set)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ULONG free = ~Set->Used;
+    if (free == 0) {
+        __set_PRIMASK(primask);
+        return NULL;
+    }
+    uint32_t index = (uint32_t)__builtin_ctzl(free);
+    Set->Used |= 1UL << index;
+    __set_PRIMASK(primask);
+
+    tTxn * Txn = &Set->Txns[index];
+    Txn->Status = eTxn_Pending;
+    Txn->Orphaned = false;
+    tx_event_flags_set(&Set->Flags, ~Txn->Bit, TX_AND);
+    return Txn;
+}
+
+/**
+ * @brief: Driver side: the transfer has finished. Sets the status and the flag, waking the waiter;
+ * a handle released while pending is freed instead. Safe from ISRs. Status and flag are set with
+ * interrupts off, so a Txn_Release and Txn_Open in between cannot see the flag of the old transfer.
+ */
+void Txn_Complete(tTxn * Txn, bool OK)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (Txn->Orphaned) {
+        Txn_Free(Txn);
+    } else {
+        Txn->Status = OK ? eTxn_Done : eTxn_Failed;
+        tx_event_flags_set(&Txn->Set->Flags, Txn->Bit, TX_OR);
+    }
+    __set_PRIMASK(primask);
+}
+
+/* Hands the handle back; a pending one is left for Txn_Complete to free */
+void Txn_Release(tTxn * Txn)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (Txn->Status == eTxn_Pending) {
+        Txn->Orphaned = true;
+    } else {
+        Txn_Free(Txn);
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief: Sleeps until the transfer finishes or Timeout ticks pass.
+ *
+ * @params: Txn, Timeout in ticks (TX_WAIT_FOREVER, TX_NO_WAIT)
+ *
+ * @return: eTxn_Done or eTxn_Failed, eTxn_Pending if it timed out
+ */
+eTxn_Status Txn_Wait(tTxn * Txn, ULONG Timeout)
+{
+    ULONG actual;
+
+    if (Txn->Status == eTxn_Pending) {
+        tx_event_flags_get(&Txn->Set->Flags, Txn->Bit, TX_AND, &actual, Timeout);
+    }
+    return Txn->Status;
+}
+
+bool Txn_Poll(const tTxn * Txn)
+{
+    return Txn->Status != eTxn_Pending;
+}
+
+eTxn_Status Txn_Status(const tTxn * Txn)
+{
+    return Txn->Status;
+}
+
+/**
+ * @brief: Sleeps until every handle in Txns has finished. The handles of the first set in the list
+ * are waited for together, with one tx_event_flags_get on all their flags, so a thread that queued
+ * its reads on one set wakes once. Handles of other sets follow one by one with the time left.
+ *
+ * @params: Txns list of handles (NULL entries are skipped), Count, Timeout in ticks for the whole list
+ *
+ * @return: true if all finished (done or failed, check each with Txn_Status), false on timeout
+ */
+bool Txn_Wait_All(tTxn * const * Txns, uint32_t Count, ULONG Timeout)
+{
+    tTxn_Set * first = NULL;
+    ULONG mask = 0;
+    ULONG actual;
+    ULONG start = tx_time_get();
+
+    for (uint32_t i = 0; i < Count; i++) {
+        if (Txns[i] == NULL) {
+            continue;
+        }
+        if (first == NULL) {
+            first = Txns[i]->Set;
+        }
+        if (Txns[i]->Set == first && Txns[i]->Status == eTxn_Pending) {
+            mask |= Txns[i]->Bit;
+        }
+    }
+    if (mask != 0 && tx_event_flags_get(&first->Flags, mask, TX_AND, &actual, Timeout) != TX_SUCCESS) {
+        return false;
+    }
+    for (uint32_t i = 0; i < Count; i++) {
+        if (Txns[i] == NULL || Txns[i]->Set == first || Txns[i]->Status != eTxn_Pending) {
+            continue;
+        }
+        ULONG left = Timeout;
+        if (Timeout != TX_WAIT_FOREVER) {
+            ULONG spent = tx_time_get() - start;
+            left = (spent < Timeout) ? Timeout - spent : TX_NO_WAIT;
+        }
+        if (Txn_Wait(Txns[i], left) == eTxn_Pending) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Interrupts off: clears the flag and gives the slot back */
+static void Txn_Free(tTxn * Txn)
+{
+    tTxn_Set * Set = Txn->Set;
+
+    tx_event_flags_set(&Set->Flags, ~Txn->Bit, TX_AND);
+    Txn->Orphaned = false;
+    Txn->Status = eTxn_Pending;
+    Set->Used &= ~Txn->Bit;
+}
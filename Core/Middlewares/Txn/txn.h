@@ -0,0 +1,74 @@
+/*
+ * txn.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef TXN_TXN_H_
+#define TXN_TXN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tx_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Handles for queued bus transactions, so a thread can sleep until its transfers are done instead of
+ * polling a bool or doing its work in a driver callback.
+ * 1) Each waiting thread owns a tTxn_Set (static or in its context) and calls Txn_Set_Init once. A
+ *    set is one event flags group; each of its TXN_SET_SIZE handles is one flag.
+ * 2) The *_Txn calls of the drivers (I2C_Memory_Read_Txn, SPI_Write_DMA_Txn, ...) take the set, queue
+ *    the transfer and return a handle, NULL when the set has no free handle or the queuing failed.
+ * 3) Txn_Wait(txn, ticks) sleeps until the transfer finishes and returns its status (eTxn_Pending
+ *    when the wait timed out). Txn_Poll tells whether it has finished, Txn_Status how; neither blocks.
+ *    Txn_Wait_All(list, n, ticks) sleeps until every handle in the list is finished: handles of one
+ *    set are waited for with a single tx_event_flags_get, so the thread wakes once, when the last
+ *    completes.
+ * 4) Txn_Release hands the handle back. Releasing one still pending is allowed: the driver frees it
+ *    when the transfer ends, the data buffer must stay valid until then.
+ * Drivers: Txn_Open when queuing, Txn_Complete when done (any context, ISRs included).
+ */
+
+#define TXN_SET_SIZE        32      /* handles per set, one event flag each */
+
+typedef enum {
+    eTxn_Pending = 0,
+    eTxn_Done,
+    eTxn_Failed,
+} eTxn_Status;
+
+typedef struct tTxn_Set tTxn_Set;
+
+typedef struct {
+    tTxn_Set * Set;
+    ULONG Bit;                      /* this handle's flag in Set->Flags */
+    volatile eTxn_Status Status;
+    volatile bool Orphaned;         /* released while pending, Txn_Complete frees it */
+} tTxn;
+
+struct tTxn_Set {
+    TX_EVENT_FLAGS_GROUP Flags;
+    volatile ULONG Used;            /* handles given out */
+    tTxn Txns[TXN_SET_SIZE];
+};
+
+bool Txn_Set_Init(tTxn_Set * Set, CHAR * Name);
+tTxn * Txn_Open(tTxn_Set * Set);
+void Txn_Complete(tTxn * Txn, bool OK);
+void Txn_Release(tTxn * Txn);
+
+eTxn_Status Txn_Wait(tTxn * Txn, ULONG Timeout);
+bool Txn_Poll(const tTxn * Txn);
+eTxn_Status Txn_Status(const tTxn * Txn);
+bool Txn_Wait_All(tTxn * const * Txns, uint32_t Count, ULONG Timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TXN_TXN_H_ */
@@ -0,0 +1,436 @@
+/*
+ * watch.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "watch.h"
+#include "main.h"
+#include "../Console/Thread_Console.h"
+#include "../CRC/crc.h"
+#include "../Log/log.h"
+
+extern TIM_HandleTypeDef htim1;
+
+/* Frame layout sizes, see USAGE in watch.h */
+#define WATCH_FRAME_HEADER_SIZE         5       /* sync x2, kind, len u16 */
+#define WATCH_FRAME_MAX_SIZE            UINT8_MAX   /* one UART_Add_Transmit */
+#define WATCH_FRAME_MAX_PAYLOAD         (WATCH_FRAME_MAX_SIZE - WATCH_FRAME_HEADER_SIZE - 2)
+#define WATCH_SAMPLES_HEADER_SIZE       5       /* first_seq u32, samples u8 */
+#define WATCH_MAX_SAMPLE_SIZE           (WATCH_MAX_STREAM_VARS * 4)
+
+/* watch_events flags */
+#define WATCH_START_FLAG                0x01
+#define WATCH_SAMPLES_FLAG              0x02
+
+typedef struct {
+    const char * Name;
+    const volatile void * Address;
+    eWatch_Type Type;
+    float Scale;
+} tWatch_Var;
+
+static const uint8_t Watch_Type_Sizes[] = { 1, 1, 2, 2, 4, 4, 4 };
+static const char * const Watch_Type_Names[] = { "u8", "i8", "u16", "i16", "u32", "i32", "float" };
+
+static tWatch_Var watch_vars[WATCH_MAX_VARS];
+static uint8_t watch_var_count = 0;
+
+/* Current stream. Only changed while the timer is stopped. */
+static const tWatch_Var * stream_vars[WATCH_MAX_STREAM_VARS];
+static uint8_t stream_count = 0;
+static uint8_t stream_sample_size = 0;
+static uint8_t stream_batch = 1;            /* samples per frame */
+static uint32_t stream_period_us = 0;
+static volatile bool watch_running = false;
+
+/* Sample ring, single producer (TIM1 ISR) single consumer (WATCH thread) */
+static uint8_t ring[WATCH_RING_SAMPLES][WATCH_MAX_SAMPLE_SIZE];
+static uint32_t ring_seq[WATCH_RING_SAMPLES];
+static volatile uint32_t ring_head = 0;     /* written by the ISR */
+static volatile uint32_t ring_tail = 0;     /* written by the thread */
+static volatile uint32_t sample_seq = 0;    /* every timer tick, including dropped samples */
+
+static TX_THREAD watch_thread;
+static UCHAR watch_thread_stack[WATCH_THREAD_STACK_SIZE];
+static TX_EVENT_FLAGS_GROUP watch_events;
+static bool watch_thread_created = false;
+
+static uint8_t frame[WATCH_FRAME_MAX_SIZE];
+
+static void Watch_Console_Command(const char * Args);
+static VOID Watch_Thread_Entry(ULONG thread_input);
+
+CONSOLE_COMMAND("watch", "Stream variables: watch <var> [<var>...] [@ <rate>[Hz|kHz]] | watch stop | watch",
+                NULL, .Args_Function = Watch_Console_Command);
+
+/**
+ * @brief: Adds a variable that can be watched. Registering a name again replaces it.
+ *
+ * @params: Name shown on the console and sent to the host, Address of the variable, Type of the
+ * variable, Scale raw-to-units factor applied by the host
+ *
+ * @return: false when the table is full
+ */
+bool Watch_Register(const char * Name, const volatile void * Address, eWatch_Type Type, float Scale)
+{
+    uint8_t i;
+    for (i = 0; i < watch_var_count; i++) {
+        if (strcmp(watch_vars[i].Name, Name) == 0) {
+            break;
+        }
+    }
+    if (i == WATCH_MAX_VARS) {
+        LOG_WARN(APP, "Watch table full, %s not registered\r\n", Name);
+        return false;
+    }
+    watch_vars[i].Name = Name;
+    watch_vars[i].Address = Address;
+    watch_vars[i].Type = Type;
+    watch_vars[i].Scale = Scale;
+    if (i == watch_var_count) {
+        watch_var_count++;
+    }
+    return true;
+}
+
+static const tWatch_Var * Watch_Find(const char * Name)
+{
+    for (uint8_t i = 0; i < watch_var_count; i++) {
+        if (strcmp(watch_vars[i].Name, Name) == 0) {
+            return &watch_vars[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief: TIM1 update interrupt. Copies one sample of every watched variable into the ring, or
+ * drops it when the ring is full. Wakes the WATCH thread once a frame's worth is waiting.
+ */
+void Watch_Timer_ISR(void)
+{
+    if (!watch_running) {
+        return;
+    }
+    uint32_t seq = sample_seq++;
+    uint32_t head = ring_head;
+    if (head - ring_tail >= WATCH_RING_SAMPLES) {
+        /* dropped - the gap shows up in first_seq. Wake the thread anyway, a full ring is a frame's worth. */
+        tx_event_flags_set(&watch_events, WATCH_SAMPLES_FLAG, TX_OR);
+        return;
+    }
+
+    uint8_t * slot = ring[head & (WATCH_RING_SAMPLES - 1)];
+    for (uint8_t i = 0; i < stream_count; i++) {
+        const volatile void * addr = stream_vars[i]->Address;
+        switch (Watch_Type_Sizes[stream_vars[i]->Type]) {
+            case 1: {
+                uint8_t v = *(const volatile uint8_t *)addr;
+                *slot++ = v;
+                break;
+            }
+            case 2: {
+                uint16_t v = *(const volatile uint16_t *)addr;
+                memcpy(slot, &v, 2);
+                slot += 2;
+                break;
+            }
+            default: {
+                uint32_t v = *(const volatile uint32_t *)addr;
+                memcpy(slot, &v, 4);
+                slot += 4;
+                break;
+            }
+        }
+    }
+    ring_seq[head & (WATCH_RING_SAMPLES - 1)] = seq;
+    ring_head = head + 1;
+
+    if (ring_head - ring_tail >= stream_batch) {
+        tx_event_flags_set(&watch_events, WATCH_SAMPLES_FLAG, TX_OR);
+    }
+}
+
+static void Watch_Put_U16(uint8_t * p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void Watch_Put_U32(uint8_t * p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* Adds the header and CRC around the Length payload bytes already in frame[] and queues it */
+static void Watch_Send_Frame(uint8_t Kind, uint16_t Length)
+{
+    frame[0] = WATCH_SYNC_0;
+    frame[1] = WATCH_SYNC_1;
+    frame[2] = Kind;
+    Watch_Put_U16(&frame[3], Length);
+    Watch_Put_U16(&frame[WATCH_FRAME_HEADER_SIZE + Length], CRC16_Compute(&frame[2], Length + 3));
+    UART_Add_Transmit(Console_Get_UART(), frame, (uint8_t)(WATCH_FRAME_HEADER_SIZE + Length + 2));
+}
+
+static void Watch_Send_Descriptor(void)
+{
+    uint8_t * p = &frame[WATCH_FRAME_HEADER_SIZE];
+    uint8_t * end = &frame[WATCH_FRAME_HEADER_SIZE + WATCH_FRAME_MAX_PAYLOAD];
+
+    Watch_Put_U32(p, stream_period_us);
+    p += 4;
+    *p++ = stream_count;
+    for (uint8_t i = 0; i < stream_count; i++) {
+        size_t name_len = strlen(stream_vars[i]->Name);
+        if (name_len > 32) {
+            name_len = 32;
+        }
+        if (p + 6 + name_len > end) {
+            break;  /* cannot happen with WATCH_MAX_STREAM_VARS names of 32 characters */
+        }
+        *p++ = (uint8_t)stream_vars[i]->Type;
+        memcpy(p, &stream_vars[i]->Scale, 4);
+        p += 4;
+        *p++ = (uint8_t)name_len;
+        memcpy(p, stream_vars[i]->Name, name_len);
+        p += name_len;
+    }
+    Watch_Send_Frame(WATCH_FRAME_DESCRIPTOR, (uint16_t)(p - &frame[WATCH_FRAME_HEADER_SIZE]));
+}
+
+/**
+ * @brief: Packs up to stream_batch consecutive samples from the ring into one frame. A gap in
+ * the sequence (dropped samples) ends the frame early.
+ */
+static void Watch_Send_Samples(void)
+{
+    uint8_t * payload = &frame[WATCH_FRAME_HEADER_SIZE];
+    uint8_t * p = payload + WATCH_SAMPLES_HEADER_SIZE;
+    uint32_t tail = ring_tail;
+    uint32_t available = ring_head - tail;
+    uint32_t first_seq = ring_seq[tail & (WATCH_RING_SAMPLES - 1)];
+    uint8_t samples = 0;
+
+    while (samples < available && samples < stream_batch) {
+        uint32_t idx = (tail + samples) & (WATCH_RING_SAMPLES - 1);
+        if (ring_seq[idx] != first_seq + samples) {
+            break;
+        }
+        memcpy(p, ring[idx], stream_sample_size);
+        p += stream_sample_size;
+        samples++;
+    }
+    ring_tail = tail + samples;
+
+    Watch_Put_U32(payload, first_seq);
+    payload[4] = samples;
+    Watch_Send_Frame(WATCH_FRAME_SAMPLES, (uint16_t)(p - payload));
+}
+
+/**
+ * @brief: WATCH thread. Sleeps until the ISR has a frame's worth of samples, and sends frames as
+ * long as the UART keeps up. When it does not, the ring fills and the ISR drops samples instead
+ * of the TX queue growing without bound; the thread then polls every WATCH_TX_RETRY_TICKS until
+ * the queue has room, since the UART does not signal it.
+ */
+static VOID Watch_Thread_Entry(ULONG thread_input)
+{
+    (void)thread_input;
+    ULONG actual_flags;
+    ULONG wait_ticks = TX_WAIT_FOREVER;
+
+    while (1) {
+        actual_flags = 0;
+        tx_event_flags_get(&watch_events, WATCH_START_FLAG | WATCH_SAMPLES_FLAG, TX_OR_CLEAR,
+                           &actual_flags, wait_ticks);
+        if (actual_flags & WATCH_START_FLAG) {
+            Watch_Send_Descriptor();
+        }
+        while (watch_running && (ring_head - ring_tail) >= stream_batch &&
+               Console_Get_UART()->TX_Queue->Size < WATCH_MAX_QUEUED_FRAMES) {
+            Watch_Send_Samples();
+        }
+        /* Left samples behind for a full TX queue - come back for them without waiting on the ISR */
+        wait_ticks = (watch_running && (ring_head - ring_tail) >= stream_batch) ? WATCH_TX_RETRY_TICKS
+                                                                               : TX_WAIT_FOREVER;
+    }
+}
+
+/* TIM1 runs from PCLK2, doubled when the APB2 prescaler divides */
+static uint32_t Watch_Timer_Clock(void)
+{
+    uint32_t clock = HAL_RCC_GetPCLK2Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE2_2) != 0) {
+        clock *= 2;
+    }
+    return clock;
+}
+
+/**
+ * @brief: Starts streaming the named variables, replacing any running stream.
+ *
+ * @params: Names of registered variables, Count of names, Rate_Hz sample rate
+ *
+ * @return: false on an unknown name, a bad rate or if the WATCH thread could not be created
+ */
+bool Watch_Start(const char * const * Names, uint8_t Count, uint32_t Rate_Hz)
+{
+    if (Count == 0 || Count > WATCH_MAX_STREAM_VARS || Rate_Hz == 0 || Rate_Hz > WATCH_MAX_RATE_HZ) {
+        return false;
+    }
+
+    if (!watch_thread_created) {
+        if (tx_event_flags_create(&watch_events, "WATCH_EVENTS") != TX_SUCCESS) {
+            return false;
+        }
+        if (tx_thread_create(&watch_thread, "WATCH", Watch_Thread_Entry, 0, watch_thread_stack,
+                             WATCH_THREAD_STACK_SIZE, WATCH_THREAD_PRIORITY, WATCH_THREAD_PRIORITY,
+                             TX_NO_TIME_SLICE, TX_AUTO_START) != TX_SUCCESS) {
+            tx_event_flags_delete(&watch_events);
+            return false;
+        }
+        watch_thread_created = true;
+    }
+
+    Watch_Stop();
+
+    uint8_t sample_size = 0;
+    for (uint8_t i = 0; i < Count; i++) {
+        stream_vars[i] = Watch_Find(Names[i]);
+        if (stream_vars[i] == NULL) {
+            return false;
+        }
+        sample_size += Watch_Type_Sizes[stream_vars[i]->Type];
+    }
+    stream_count = Count;
+    stream_sample_size = sample_size;
+
+    /* About WATCH_FRAMES_PER_SECOND full frames, never more than fit in a frame or half the ring */
+    uint32_t batch = Rate_Hz / WATCH_FRAMES_PER_SECOND;
+    uint32_t max_batch = (WATCH_FRAME_MAX_PAYLOAD - WATCH_SAMPLES_HEADER_SIZE) / sample_size;
+    if (max_batch > WATCH_RING_SAMPLES / 2) max_batch = WATCH_RING_SAMPLES / 2;
+    if (batch > max_batch) batch = max_batch;
+    if (batch == 0) batch = 1;
+    stream_batch = (uint8_t)batch;
+
+    /* 1 MHz timer tick down to 100 Hz, 10 kHz tick below so the 16-bit period still fits */
+    uint32_t tick_hz = (Rate_Hz >= 100) ? 1000000 : 10000;
+    uint32_t period = tick_hz / Rate_Hz;
+    stream_period_us = period * (1000000 / tick_hz);
+
+    ring_head = 0;
+    ring_tail = 0;
+    sample_seq = 0;
+
+    __HAL_TIM_SET_PRESCALER(&htim1, (Watch_Timer_Clock() / tick_hz) - 1);
+    __HAL_TIM_SET_AUTORELOAD(&htim1, period - 1);
+    __HAL_TIM_SET_COUNTER(&htim1, 0);
+    HAL_TIM_GenerateEvent(&htim1, TIM_EVENTSOURCE_UPDATE);     /* load the prescaler now */
+    __HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+
+    watch_running = true;
+    tx_event_flags_set(&watch_events, WATCH_START_FLAG, TX_OR);
+    HAL_TIM_Base_Start_IT(&htim1);
+    return true;
+}
+
+void Watch_Stop(void)
+{
+    HAL_TIM_Base_Stop_IT(&htim1);
+    watch_running = false;
+}
+
+static uint32_t Watch_Parse_Rate(const char * Text)
+{
+    char * end;
+    uint32_t rate = (uint32_t)strtoul(Text, &end, 10);
+    if (end == Text) {
+        return 0;
+    }
+    if (*end == 'k' || *end == 'K') {
+        rate *= 1000;
+        end++;
+    }
+    if (*end != '\0' && strcmp(end, "Hz") != 0 && strcmp(end, "hz") != 0) {
+        return 0;
+    }
+    return rate;
+}
+
+/**
+ * @brief: "watch" console command. Lists variables, stops, or starts a stream.
+ */
+static void Watch_Console_Command(const char * Args)
+{
+    char buffer[MAX_CONSOLE_BUFF_SIZE];
+    const char * names[WATCH_MAX_STREAM_VARS];
+    uint8_t count = 0;
+    uint32_t rate = WATCH_DEFAULT_RATE_HZ;
+    bool rate_next = false;
+
+    strncpy(buffer, Args, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    for (char * token = strtok(buffer, " "); token != NULL; token = strtok(NULL, " ")) {
+        if (rate_next) {
+            rate = Watch_Parse_Rate(token);
+            rate_next = false;
+        } else if (token[0] == '@') {
+            if (token[1] != '\0') {
+                rate = Watch_Parse_Rate(token + 1);
+            } else {
+                rate_next = true;
+            }
+        } else if (count < WATCH_MAX_STREAM_VARS) {
+            names[count++] = token;
+        } else {
+            printd("At most %u variables\r\n", (unsigned)WATCH_MAX_STREAM_VARS);
+            return;
+        }
+    }
+
+    if (count == 0) {
+        for (uint8_t i = 0; i < watch_var_count; i++) {
+            printd("%-16s %-5s\r\n", watch_vars[i].Name, Watch_Type_Names[watch_vars[i].Type]);
+        }
+        printd("%u variables, %s\r\n", (unsigned)watch_var_count, watch_running ? "streaming" : "idle");
+        return;
+    }
+    if (count == 1 && strcmp(names[0], "stop") == 0) {
+        Watch_Stop();
+        printd("watch stopped\r\n");
+        return;
+    }
+    if (rate == 0 || rate > WATCH_MAX_RATE_HZ) {
+        printd("Rate must be 1..%lu Hz\r\n", (unsigned long)WATCH_MAX_RATE_HZ);
+        return;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (Watch_Find(names[i]) == NULL) {
+            printd("Unknown variable %s\r\n", names[i]);
+            return;
+        }
+    }
+    if (!Watch_Start(names, count, rate)) {
+        printd("watch failed to start\r\n");
+        return;
+    }
+
+    /* Payload plus per-frame overhead against what the UART can carry (10 bits per byte) */
+    uint32_t frames_per_s = (rate + stream_batch - 1) / stream_batch;
+    uint32_t need = rate * stream_sample_size + frames_per_s * (WATCH_FRAME_HEADER_SIZE + WATCH_SAMPLES_HEADER_SIZE + 2);
+    uint32_t have = Console_Get_UART()->UART_Handle->Init.BaudRate / 10;
+    printd("watching %u variables every %lu us, %lu B/s of %lu B/s\r\n", (unsigned)count,
+           (unsigned long)stream_period_us, (unsigned long)need, (unsigned long)have);
+    if (need > have) {
+        printd("UART too slow for this rate - samples will be dropped\r\n");
+    }
+}
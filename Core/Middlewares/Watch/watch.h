@@ -0,0 +1,75 @@
+/*
+ * watch.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: jason.peng
+ */
+
+#ifndef WATCH_WATCH_H_
+#define WATCH_WATCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USAGE:
+ * Fixed-rate sampling of registered variables, streamed as packed binary frames on the console UART.
+ * 1) Register variables once, e.g. from the owning module's init:
+ *      Watch_Register("accel_x", &accel_x, eWatch_I16, 0.061f);     raw * scale = value in units
+ *    The name and variable must stay valid for the life of the program.
+ * 2) From the console: "watch accel_x gyro_z @ 1kHz" (rate as <n>, <n>Hz or <n>kHz, default
+ *    WATCH_DEFAULT_RATE_HZ). "watch" lists the registered variables, "watch stop" ends the stream.
+ * 3) TIM1 fires at the requested rate and its update interrupt copies every watched variable into a
+ *    ring (Watch_Timer_ISR, called from HAL_TIM_PeriodElapsedCallback), so sample timing only depends
+ *    on the timer. The WATCH thread packs samples into frames and queues them on the UART.
+ * 4) Frames, little endian, crc is CRC16_Compute over kind..payload (see CRC/crc.h):
+ *      0x57 0xA7 | kind u8 | len u16 | payload[len] | crc u16
+ *    kind WATCH_FRAME_DESCRIPTOR, sent when a stream starts:
+ *      period_us u32 | count u8 | count x (type u8 | scale f32 | name_len u8 | name)
+ *    kind WATCH_FRAME_SAMPLES:
+ *      first_seq u32 | samples u8 | samples x (one raw value per variable, in descriptor order)
+ *    Samples that do not fit in the ring (UART too slow) are dropped; first_seq jumps over them.
+ *    Text printed on the console meanwhile appears between frames - the host resyncs on the marker.
+ * 5) Tools/watch_plot.py parses the stream and plots it.
+ */
+
+#define WATCH_MAX_VARS                  16      /* registered variables */
+#define WATCH_MAX_STREAM_VARS           8       /* variables in one stream */
+#define WATCH_DEFAULT_RATE_HZ           100
+#define WATCH_MAX_RATE_HZ               10000
+#define WATCH_RING_SAMPLES              64      /* power of two */
+#define WATCH_MAX_QUEUED_FRAMES         4       /* frames waiting in the UART TX queue before sampling drops */
+#define WATCH_TX_RETRY_TICKS            2       /* recheck of a full UART TX queue while samples wait */
+#define WATCH_FRAMES_PER_SECOND         20      /* target frame rate - fewer, fuller frames at high sample rates */
+#define WATCH_THREAD_PRIORITY           4
+#define WATCH_THREAD_STACK_SIZE         1024
+
+#define WATCH_SYNC_0                    0x57
+#define WATCH_SYNC_1                    0xA7
+#define WATCH_FRAME_DESCRIPTOR          0x01
+#define WATCH_FRAME_SAMPLES             0x02
+
+typedef enum {
+    eWatch_U8 = 0,
+    eWatch_I8,
+    eWatch_U16,
+    eWatch_I16,
+    eWatch_U32,
+    eWatch_I32,
+    eWatch_Float,
+} eWatch_Type;
+
+bool Watch_Register(const char * Name, const volatile void * Address, eWatch_Type Type, float Scale);
+bool Watch_Start(const char * const * Names, uint8_t Count, uint32_t Rate_Hz);
+void Watch_Stop(void);
+void Watch_Timer_ISR(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WATCH_WATCH_H_ */
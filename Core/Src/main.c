@@ -22,6 +22,9 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "../Middlewares/Watch/watch.h"
+#include "../Firmware/DMA/DMA.h"
+#include "../Firmware/IMU/LSM6DSO.h"
 
 /* USER CODE END Includes */
 
@@ -133,7 +136,9 @@ int main(void)
   /* Initialize interrupts */
   MX_NVIC_Init();
   /* USER CODE BEGIN 2 */
-
+  // the USART2 channels are set up by CubeMX; tell the DMA manager so it allocates around them
+  DMA_Adopt(&hdma_usart2_rx);
+  DMA_Adopt(&hdma_usart2_tx);
 
   /* USER CODE END 2 */
 
@@ -777,6 +782,10 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  LSM6DSO_EXTI_Callback(GPIO_Pin);
+}
 
 /* USER CODE END 4 */
 
@@ -797,6 +806,9 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     HAL_IncTick();
   }
   /* USER CODE BEGIN Callback 1 */
+  if (htim->Instance == TIM1) {
+    Watch_Timer_ISR();
+  }
 
   /* USER CODE END Callback 1 */
 }
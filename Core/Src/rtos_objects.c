@@ -1,4 +1,6 @@
 #include "rtos_objects.h"
+#include "../Middlewares/Defer/defer.h"
+#include "../Firmware/DMA/DMA_Memcpy.h"
 
 // Define the block pools, thread, and queue
 TX_BLOCK_POOL tx_app_block_pool;
@@ -42,6 +44,8 @@ void rtos_objects_create(VOID *first_unused_memory){
 
     tx_thread_create(&tx_app_thread, "App Thread", app_thread_entry, NULL, tx_app_thread_stack, TX_APP_THREAD_STACK_SIZE, 1, 1, TX_NO_TIME_SLICE, TX_AUTO_START);
     // put threads here in initialization
+    Defer_Init();
+    DMA_Memcpy_Init();
 }
 
 /**
@@ -22,6 +22,7 @@
 #include "stm32l4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "../Middlewares/Log/log.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -90,7 +91,8 @@ void NMI_Handler(void)
 void HardFault_Handler(void)
 {
   /* USER CODE BEGIN HardFault_IRQn 0 */
-
+  /* Only reaches the reset-persistent log ring - the console is not usable from here */
+  LOG_ERROR(APP, "HardFault CFSR 0x%08lx HFSR 0x%08lx BFAR 0x%08lx\r\n", SCB->CFSR, SCB->HFSR, SCB->BFAR);
   /* USER CODE END HardFault_IRQn 0 */
   while (1)
   {
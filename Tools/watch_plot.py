@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""
+watch_plot.py
+
+Reads the binary stream started by the console "watch" command (see Core/Middlewares/Watch/watch.h)
+and plots it live, or writes it as CSV.
+
+    python3 watch_plot.py /dev/ttyACM0 --start "watch accel_x gyro_z @ 1kHz"
+    python3 watch_plot.py /dev/ttyACM0 --csv out.csv
+
+Needs pyserial, and matplotlib unless --csv is used. Console text between frames is printed as is.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+SYNC = b"\x57\xA7"
+FRAME_DESCRIPTOR = 0x01
+FRAME_SAMPLES = 0x02
+
+# eWatch_Type: struct format and size
+TYPES = {0: "B", 1: "b", 2: "H", 3: "h", 4: "I", 5: "i", 6: "f"}
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, same as CRC16_Compute on the device."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class WatchStream:
+    """Splits the raw byte stream into frames, decodes descriptors and samples."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.period_us = 0
+        self.names = []
+        self.scales = []
+        self.sample_format = ""
+        self.next_seq = None
+        self.dropped = 0
+
+    def feed(self, data):
+        """Returns (text, samples) - text outside frames, samples as (seq, [values]) in units."""
+        self.buffer += data
+        text = bytearray()
+        samples = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                # keep a trailing first sync byte, it may be the start of a frame
+                keep = 1 if self.buffer.endswith(SYNC[:1]) else 0
+                text += self.buffer[:len(self.buffer) - keep]
+                del self.buffer[:len(self.buffer) - keep]
+                break
+            text += self.buffer[:start]
+            del self.buffer[:start]
+            if len(self.buffer) < 5:
+                break
+            kind = self.buffer[2]
+            length = struct.unpack_from("<H", self.buffer, 3)[0]
+            if length > 250 or kind not in (FRAME_DESCRIPTOR, FRAME_SAMPLES):
+                text += self.buffer[:1]
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < 5 + length + 2:
+                break
+            payload = bytes(self.buffer[5:5 + length])
+            crc = struct.unpack_from("<H", self.buffer, 5 + length)[0]
+            if crc16(self.buffer[2:5 + length]) != crc:
+                text += self.buffer[:1]
+                del self.buffer[:1]
+                continue
+            del self.buffer[:5 + length + 2]
+            if kind == FRAME_DESCRIPTOR:
+                self._descriptor(payload)
+            elif self.sample_format:
+                samples += self._samples(payload)
+        return bytes(text), samples
+
+    def _descriptor(self, payload):
+        self.period_us, count = struct.unpack_from("<IB", payload, 0)
+        offset = 5
+        self.names, self.scales, fmt = [], [], "<"
+        for _ in range(count):
+            var_type, scale, name_len = struct.unpack_from("<BfB", payload, offset)
+            offset += 6
+            self.names.append(payload[offset:offset + name_len].decode(errors="replace"))
+            offset += name_len
+            self.scales.append(scale)
+            fmt += TYPES[var_type]
+        self.sample_format = fmt
+        self.next_seq = None
+
+    def _samples(self, payload):
+        first_seq, count = struct.unpack_from("<IB", payload, 0)
+        if self.next_seq is not None and first_seq != self.next_seq:
+            self.dropped += (first_seq - self.next_seq) & 0xFFFFFFFF
+        self.next_seq = first_seq + count
+        size = struct.calcsize(self.sample_format)
+        out = []
+        for i in range(count):
+            raw = struct.unpack_from(self.sample_format, payload, 5 + i * size)
+            out.append((first_seq + i, [r * s for r, s in zip(raw, self.scales)]))
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port")
+    parser.add_argument("--baud", type=int, default=4800)
+    parser.add_argument("--start", help='console command to send first, e.g. "watch x y @ 100Hz"')
+    parser.add_argument("--csv", help="write samples to this file instead of plotting")
+    parser.add_argument("--window", type=float, default=5.0, help="seconds shown in the plot")
+    args = parser.parse_args()
+
+    link = serial.Serial(args.port, args.baud, timeout=0.05)
+    if args.start:
+        link.write(args.start.encode() + b"\r")
+
+    stream = WatchStream()
+
+    def poll():
+        text, samples = stream.feed(link.read(4096))
+        if text:
+            sys.stdout.write(text.decode(errors="replace"))
+            sys.stdout.flush()
+        return samples
+
+    try:
+        if args.csv:
+            with open(args.csv, "w") as out:
+                header_for = None
+                while True:
+                    for seq, values in poll():
+                        if header_for != stream.names:
+                            header_for = list(stream.names)
+                            out.write("t_s," + ",".join(header_for) + "\n")
+                        out.write("%.6f,%s\n" % (seq * stream.period_us / 1e6, ",".join("%g" % v for v in values)))
+        else:
+            plot(poll, stream, args.window)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if args.start:
+            link.write(b"watch stop\r")
+        print("\ndropped samples: %d" % stream.dropped, file=sys.stderr)
+
+
+def plot(poll, stream, window):
+    import matplotlib.pyplot as plt
+
+    plt.ion()
+    figure, axis = plt.subplots()
+    lines, times, series, names = [], [], [], None
+    while plt.fignum_exists(figure.number):
+        for seq, values in poll():
+            if names != stream.names:
+                names = list(stream.names)
+                axis.clear()
+                times, series = [], [[] for _ in names]
+                lines = [axis.plot([], [], label=n)[0] for n in names]
+                axis.legend(loc="upper left")
+            times.append(seq * stream.period_us / 1e6)
+            for column, value in zip(series, values):
+                column.append(value)
+        if times:
+            while times[-1] - times[0] > window:
+                times.pop(0)
+                for column in series:
+                    column.pop(0)
+            for line, column in zip(lines, series):
+                line.set_data(times, column)
+            axis.relim()
+            axis.autoscale_view()
+        plt.pause(0.05)
+        time.sleep(0)
+
+
+if __name__ == "__main__":
+    main()